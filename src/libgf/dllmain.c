@@ -5,17 +5,23 @@
 /*!
 ** @file libgf/dllmain.c
 ** @brief DLL main.
+**
+** On the other systems than Windows, the library is initialized and cleaned
+** up by the constructor and the destructor of the shared object.
 */
 #include <libgf/config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 
 #include <libgf/gf_error.h>
 #include <libgf/gf_global.h>
 
+#if defined(_WIN32)
 BOOL WINAPI
 DllMain(HINSTANCE hInst, DWORD fdwReason, LPVOID lpReserved) {
   BOOL ret = TRUE;
@@ -41,3 +47,14 @@ DllMain(HINSTANCE hInst, DWORD fdwReason, LPVOID lpReserved) {
 
   return ret;
 }
+#else
+__attribute__((constructor)) static void
+dll_init(void) {
+  (void)gf_global_init();
+}
+
+__attribute__((destructor)) static void
+dll_clean(void) {
+  (void)gf_global_clean();
+}
+#endif
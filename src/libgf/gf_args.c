@@ -674,7 +674,7 @@ gf_args_print_help(const gf_args* args) {
     for (size_t i = 0; i < args->used; i++) {
       const gf_args_entry* e = args->entries[i];
 
-      sprintf_s(
+      snprintf(
         name, 1024, "%s%c%s%s%s",
         e->opt_short ? "-" : "",
         e->opt_short ? e->opt_short : '\0',
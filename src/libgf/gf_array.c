@@ -7,6 +7,7 @@
 ** @brief Variable array module.
 */
 #include <assert.h>
+#include <stdlib.h>
 
 #include <libgf/gf_swap.h>
 #include <libgf/gf_memory.h>
@@ -181,7 +182,7 @@ gf_array_resize(gf_array* ary, gf_size_t size) {
   old_size = ary->size;
   if (old_size < size) {
     /* Extend */
-    _(gf_realloc((gf_ptr*)ary->data, sizeof(gf_any) * size));
+    _(gf_realloc((gf_ptr*)&ary->data, sizeof(gf_any) * size));
     for (gf_size_t i = old_size; i < size; i++) {
       ary->data[i].data = 0;
     }
@@ -219,6 +220,24 @@ gf_array_add(gf_array* ary, gf_any value) {
   return GF_SUCCESS;
 }
 
+gf_status
+gf_array_insert(gf_array* ary, gf_size_t index, gf_any value) {
+  gf_validate(ary);
+  gf_validate(index <= ary->used);
+
+  if (ary->used >= ary->size) {
+    _(gf_array_resize(ary, ary->size + ARRAY_CHUNK_SIZE));
+  }
+  /* Shift */
+  for (gf_size_t i = ary->used; i > index; i--) {
+    ary->data[i].data = ary->data[i - 1].data;
+  }
+  ary->data[index].data = value.data;
+  ary->used += 1;
+
+  return GF_SUCCESS;
+}
+
 gf_status
 gf_array_set(gf_array* ary, gf_size_t index, gf_any value) {
   gf_validate(ary);
@@ -261,6 +280,19 @@ gf_array_remove(gf_array* ary, gf_size_t index) {
   return GF_SUCCESS;
 }
 
+gf_status
+gf_array_sort(gf_array* ary, gf_array_compare_fn fn) {
+  gf_validate(ary);
+  gf_validate(fn);
+
+  if (ary->used > 1) {
+    qsort(ary->data, ary->used, sizeof(gf_any),
+          (int (*)(const void*, const void*))fn);
+  }
+
+  return GF_SUCCESS;
+}
+
 gf_size_t
 gf_array_size(const gf_array* ary) {
   if (!ary) {
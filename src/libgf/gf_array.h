@@ -32,6 +32,8 @@ typedef void (*gf_array_free_fn)(gf_any* any);
 
 typedef gf_status (*gf_array_copy_fn)(gf_any* dst, const gf_any* src);
 
+typedef int (*gf_array_compare_fn)(const gf_any* lhs, const gf_any* rhs);
+
 /*!
 ** @brief Create a new array object
 **
@@ -105,12 +107,38 @@ extern gf_status gf_array_resize(gf_array* ary, gf_size_t size);
 
 extern gf_status gf_array_add(gf_array* ary, gf_any value);
 
+/*!
+** @brief Insert an element before the element of the index
+**
+** @param [in, out] ary   The array object
+** @param [in]      index The index of the new element (up to the size)
+** @param [in]      value The value of the new element
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_array_insert(gf_array* ary, gf_size_t index, gf_any value);
+
 extern gf_status gf_array_set(gf_array* ary, gf_size_t index, gf_any value);
 
 extern gf_status gf_array_get(const gf_array* ary, gf_size_t index, gf_any* value);
 
 extern gf_status gf_array_remove(gf_array* ary, gf_size_t index);
 
+/*
+** @brief Sort the elements of the array
+**
+** The callback returns a negative value, zero or a positive value as in
+** qsort(3). The order of elements which compare equal is unspecified.
+**
+** @param [in, out] ary The array object to be sorted
+** @param [in]      fn  The comparison function
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_array_sort(gf_array* ary, gf_array_compare_fn fn);
+
 extern gf_size_t gf_array_size(const gf_array* ary);
 
 extern gf_size_t gf_array_buffer_size(const gf_array* ary);
@@ -35,6 +35,7 @@ gf_cmd_base_init(gf_cmd_base* cmd) {
   cmd->conf_path   = NULL;
   cmd->conf_file   = NULL;
   cmd->site_path   = NULL;
+  cmd->db_path     = NULL;
   cmd->build_path  = NULL;
   cmd->style_path  = NULL;
   cmd->src_path    = NULL;
@@ -176,6 +177,16 @@ cmd_base_init_paths(gf_cmd_base* cmd) {
     _(gf_path_append_string(&cmd->site_path, cmd->conf_path, GF_SITE_FILE_NAME));
   }
 
+  /* The site database path */
+  if (cmd->db_path) {
+    gf_path_free(cmd->db_path);
+    cmd->db_path = NULL;
+  }
+  if (!gf_path_is_empty(cmd->conf_path)) {
+    _(gf_path_append_string(
+        &cmd->db_path, cmd->conf_path, GF_SITE_DB_FILE_NAME));
+  }
+
   return GF_SUCCESS;
 }
 
@@ -225,6 +236,9 @@ gf_cmd_base_clear(gf_cmd_base* cmd) {
     if (cmd->site_path) {
       gf_path_free(cmd->site_path);
     }
+    if (cmd->db_path) {
+      gf_path_free(cmd->db_path);
+    }
     if (cmd->build_path) {
       gf_path_free(cmd->build_path);
     }
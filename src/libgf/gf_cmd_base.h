@@ -51,6 +51,7 @@ struct gf_cmd_base {
   gf_path*          conf_path;   ///< The directory in which config file located
   gf_path*          conf_file;   ///< The local config file path 
   gf_path*          site_path;   ///< The path of the `site file'
+  gf_path*          db_path;     ///< The path of the site database
   gf_path*          build_path;  ///< The path of the intermediate files.
   gf_path*          style_path;  ///< The path of the XSLT stylesheets.
   gf_path*          src_path;    ///< The root path of the source files
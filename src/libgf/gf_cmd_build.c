@@ -11,12 +11,20 @@
 #include <libgf/gf_countof.h>
 #include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
+#include <libgf/gf_array.h>
 #include <libgf/gf_path.h>
 #include <libgf/gf_cmd_config.h>
+#include <libgf/gf_config.h>
 #include <libgf/gf_site.h>
 #include <libgf/gf_system.h>
 #include <libgf/gf_shell.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_hash.h>
+#include <libgf/gf_job.h>
 #include <libgf/gf_xslt.h>
+#include <libgf/gf_manifest.h>
+#include <libgf/gf_cmd_update.h>
 #include <libgf/gf_cmd_build.h>
 
 #include "gf_local.h"
@@ -27,13 +35,38 @@ struct gf_cmd_build {
   gf_xslt*    xslt;
 };
 
+/*!
+** @brief The state shared by the steps of a build
+*/
+
+typedef struct build_context {
+  const gf_cmd_base* cmd;
+  gf_xslt_cache*     cache;     ///< The compiled stylesheets
+  gf_manifest*       manifest;  ///< NULL: every unit is built, not recorded
+  gf_8u              site_hash[GF_HASH_BUFSIZE_MAX];  ///< site.xml digest
+  gf_int             threads;   ///< The threads of the jobs (0: one per core)
+  gf_bool            fail_fast; ///< Start no job after a failure
+  gf_mutex           lock;      ///< Guards the manifest while the jobs run
+} build_context;
+
+/*!
+** @brief The fingerprint of the inputs of a unit being computed
+*/
+
+typedef struct build_digest {
+  const gf_hash_provider* provider;
+  gf_hash_context         ctx;
+  gf_bool                 valid;  ///< GF_FALSE if an input is unknown
+} build_digest;
+
 /*!
 ** @brief
 **
 */
 
 enum {
-  OPT_BUILD_OPTIONS,
+  OPT_FULL,
+  OPT_FAIL_FAST,
 };
 
 static const gf_cmd_base_info info_ = {
@@ -46,6 +79,22 @@ static const gf_cmd_base_info info_ = {
     .execute     = gf_cmd_build_execute,
   },
   .options = {
+    {
+      .key         = OPT_FULL,
+      .opt_short   = 'f',
+      .opt_long    = "full",
+      .opt_count   = 0,
+      .usage       = "-f, --full",
+      .description = "Build the whole site instead of the changed outputs.",
+    },
+    {
+      .key         = OPT_FAIL_FAST,
+      .opt_short   = '\0',
+      .opt_long    = "fail-fast",
+      .opt_count   = 0,
+      .usage       = "--fail-fast",
+      .description = "Start no more jobs after a job has failed.",
+    },
     /* Terminate */
     GF_OPTION_NULL,
   },
@@ -119,87 +168,62 @@ gf_cmd_build_free(gf_cmd_base* cmd) {
 }
 
 static gf_status
-build_prepare_output_path(gf_cmd_build* cmd) {
+build_prepare_output_path(const gf_cmd_base* cmd, gf_bool evacuate) {
   gf_validate(cmd);
 
-  _(gf_path_evacuate(GF_CMD_BASE_CAST(cmd)->dst_path));
-  if (!gf_path_file_exists(GF_CMD_BASE_CAST(cmd)->build_path)) {
-    _(gf_shell_make_directory(GF_CMD_BASE_CAST(cmd)->build_path));
+  if (evacuate) {
+    _(gf_path_evacuate(cmd->dst_path));
+  }
+  if (!gf_path_file_exists(cmd->build_path)) {
+    _(gf_shell_make_directory(cmd->build_path));
   }
   
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Get the output directory of an entry.
+*/
+
 static gf_status
-build_create_directory(const gf_path* path, gf_entry* entry) {
+build_get_directory_path(
+  gf_path** dir_path, const gf_entry* entry, const gf_path* root) {
   gf_status rc = 0;
-  gf_path* local_path = NULL;
-  gf_size_t cnt = 0;
-  
-  gf_validate(path);
+  gf_path* path = NULL;
+
+  gf_validate(dir_path);
   gf_validate(entry);
-  
-  local_path = gf_entry_get_local_path(entry, path);
-  if (!local_path) {
+  gf_validate(root);
+
+  path = gf_entry_get_local_path(entry, root);
+  if (!path) {
     gf_raise(GF_E_STATE, "Failed to build a path.");
   }
-  rc = gf_path_append(local_path, GF_PATH_PARENT);
-  if (rc != GF_SUCCESS) {
-    gf_path_free(local_path);
-    gf_throw(rc);
-  }
-  rc = gf_path_absolute_path(local_path);
-  if (rc != GF_SUCCESS) {
-    gf_path_free(local_path);
-    gf_throw(rc);
+  rc = gf_path_append(path, GF_PATH_PARENT);
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_absolute_path(path);
   }
-  rc = gf_path_create_directory(local_path);
-  gf_path_free(local_path);
   if (rc != GF_SUCCESS) {
+    gf_path_free(path);
     gf_throw(rc);
   }
-
-  cnt = gf_entry_count_children(entry);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_entry* child = NULL;
-
-    rc = gf_entry_get_child(entry, i, &child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
-    rc = build_create_directory(path, child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
-  }
+  *dir_path = path;
 
   return GF_SUCCESS;
 }
 
-static gf_status
-build_create_directory_set(gf_cmd_build* cmd) {
-  gf_status rc = 0;
-  gf_entry *entry = NULL;
-  gf_size_t cnt = 0;
-  
-  gf_validate(cmd);
+/*!
+** @brief Create an output directory unless it exists.
+**
+** The parent directory must exist.
+*/
 
-  _(gf_site_get_root_entry(cmd->site, &entry));
-  if (!entry) {
-    gf_raise(GF_E_STATE, "The root entry was not found.");
-  }
-  // The root directory must exist. We process the children.
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_entry* child = NULL;
+static gf_status
+build_make_directory(const gf_path* path) {
+  gf_validate(path);
 
-    rc = gf_entry_get_child(entry, i, &child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
-    rc = build_create_directory(GF_CMD_BASE_CAST(cmd)->dst_path, child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
+  if (!gf_path_is_directory(path)) {
+    _(gf_path_create_directory(path));
   }
 
   return GF_SUCCESS;
@@ -243,10 +267,9 @@ build_get_static_path(
 }
 
 static gf_status
-build_copy_static_file(
+build_copy_static_file_low(
   gf_entry* entry, const gf_path* src, const gf_path* dst) {
   gf_status rc = 0;
-  gf_size_t cnt = 0;
   gf_path* src_path = NULL;
   gf_path* dst_path = NULL;
 
@@ -265,43 +288,228 @@ build_copy_static_file(
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* Process children */
-  cnt = gf_entry_count_children(entry);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Check whether a file of an entry is in its static directory ('_').
+*/
+
+static gf_bool
+build_is_static_file(const gf_entry* entry, gf_file_info* info) {
+  const gf_char* entry_path = NULL;
+  const gf_char* file_path = NULL;
+  const gf_char* sep = NULL;
+  gf_size_t len = 0;
+
+  entry_path = gf_entry_get_full_path_string(entry);
+  if (!entry_path || gf_file_info_get_full_path(info, &file_path)) {
+    return GF_FALSE;
+  }
+  sep = strrchr(entry_path, '/');
+  len = sep ? (gf_size_t)(sep - entry_path) + 1 : 0;
+  if (strncmp(file_path, entry_path, len)) {
+    return GF_FALSE;
+  }
+
+  return !strncmp(&file_path[len], "_/", 2) ? GF_TRUE : GF_FALSE;
+}
+
+static gf_status
+build_digest_init(build_digest* digest) {
+  gf_validate(digest);
+
+  digest->provider = gf_hash_get_default();
+  digest->valid = GF_TRUE;
+  _(digest->provider->init(&digest->ctx));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_digest_add_bytes(
+  build_digest* digest, const gf_8u* data, gf_size_t size) {
+  _(digest->provider->update(&digest->ctx, data, size));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add a string to a digest.
+**
+** The terminator is added too, so that the strings in a row are not mixed.
+*/
+
+static gf_status
+build_digest_add_string(build_digest* digest, const gf_char* str) {
+  gf_validate(digest);
+
+  if (!str) {
+    str = "";
+  }
+  _(build_digest_add_bytes(digest, (const gf_8u*)str, strlen(str) + 1));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the path and the contents hash of a file to a digest.
+**
+** A file without the hash makes the digest invalid, so that the unit is
+** always built.
+*/
+
+static gf_status
+build_digest_add_file(build_digest* digest, gf_file_info* info) {
+  const gf_char* path = NULL;
+  gf_16u size = 0;
+  gf_8u hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  gf_validate(digest);
+  gf_validate(info);
+
+  _(gf_file_info_get_full_path(info, &path));
+  _(build_digest_add_string(digest, path));
+  _(gf_file_info_get_hash_size(info, &size));
+  if (!size || size > sizeof(hash)) {
+    digest->valid = GF_FALSE;
+    return GF_SUCCESS;
+  }
+  _(gf_file_info_get_hash(info, sizeof(hash), hash));
+  _(build_digest_add_bytes(digest, hash, size));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the files of an entry to a digest.
+**
+** @param [in, out] digest The digest
+** @param [in]      entry  The entry
+** @param [in]      stat   GF_TRUE: the static files, GF_FALSE: the others
+*/
+
+static gf_status
+build_digest_add_entry_files(
+  build_digest* digest, gf_entry* entry, gf_bool stat) {
+  gf_size_t cnt = 0;
+
+  gf_validate(digest);
+  gf_validate(entry);
+
+  cnt = gf_entry_count_files(entry);
   for (gf_size_t i = 0; i < cnt; i++) {
-    gf_entry* child = NULL;
+    gf_file_info* info = NULL;
 
-    rc = gf_entry_get_child(entry, i, &child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
+    _(gf_entry_get_file(entry, i, &info));
+    if (build_is_static_file(entry, info) == stat) {
+      _(build_digest_add_file(digest, info));
     }
-    rc = build_copy_static_file(child, src, dst);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Finish a digest as a hex string.
+**
+** The string is empty if the digest is invalid.
+*/
+
+static gf_status
+build_digest_final(build_digest* digest, gf_char* buf, gf_size_t size) {
+  gf_8u hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  gf_validate(digest);
+  gf_validate(buf);
+  gf_validate(size >= digest->provider->size * 2 + 1);
+
+  _(digest->provider->final(&digest->ctx, hash));
+  buf[0] = '\0';
+  if (digest->valid) {
+    for (gf_size_t i = 0; i < digest->provider->size; i++) {
+      snprintf(&buf[i * 2], 3, "%02x", hash[i]);
     }
   }
 
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Record a file written by a unit (gf_xslt_output_fn).
+*/
+
 static gf_status
-build_copy_static_file_set(gf_cmd_build* cmd) {
-  gf_status rc = 0;
-  gf_entry* entry = NULL;
-  /* alias */
-  const gf_path* src = GF_CMD_BASE_CAST(cmd)->src_path;
-  const gf_path* dst = GF_CMD_BASE_CAST(cmd)->dst_path;;
+build_add_output(const gf_char* path, gf_ptr data) {
+  _(gf_manifest_unit_add_output(data, path));
 
-  gf_validate(cmd);
+  return GF_SUCCESS;
+}
 
-  rc = gf_site_get_root_entry(cmd->site, &entry);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+/*!
+** @brief Start recording a unit, or tell that its outputs are up to date.
+**
+** @param [in]  ctxt        The build context
+** @param [in]  key         The key of the unit
+** @param [in]  fingerprint The fingerprint of the inputs of the unit
+** @param [out] unit        The unit to be built, or NULL if it is kept
+*/
+
+static gf_status
+build_begin_unit(
+  build_context* ctxt, const gf_char* key, const gf_char* fingerprint,
+  gf_manifest_unit** unit) {
+  gf_validate(ctxt);
+  gf_validate(unit);
+
+  *unit = NULL;
+  if (gf_manifest_keep_unit(ctxt->manifest, key, fingerprint)) {
+    gf_debug("Up to date: %s", key);
+    return GF_SUCCESS;
   }
-  rc = build_copy_static_file(entry, src, dst);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+  _(gf_manifest_add_unit(ctxt->manifest, key, fingerprint, unit));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_get_static_fingerprint(
+  gf_char* buf, gf_size_t size, gf_entry* entry) {
+  build_digest digest;
+
+  _(build_digest_init(&digest));
+  _(build_digest_add_entry_files(&digest, entry, GF_TRUE));
+  _(build_digest_final(&digest, buf, size));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_add_static_outputs(
+  gf_manifest_unit* unit, gf_entry* entry, const gf_path* dst) {
+  gf_status rc = 0;
+  gf_size_t cnt = 0;
+
+  cnt = gf_entry_count_files(entry);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_file_info* info = NULL;
+    const gf_char* file_path = NULL;
+    gf_path* path = NULL;
+
+    _(gf_entry_get_file(entry, i, &info));
+    if (!build_is_static_file(entry, info)) {
+      continue;
+    }
+    _(gf_file_info_get_full_path(info, &file_path));
+    _(gf_path_append_string(&path, dst, file_path));
+    rc = gf_manifest_unit_add_output(unit, gf_path_get_string(path));
+    gf_path_free(path);
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
   }
-  
+
   return GF_SUCCESS;
 }
 
@@ -330,68 +538,120 @@ build_get_style_path(
   gf_validate(root);
 
   // TODO: check the length of the string 'method'.
-  
-  sprintf_s(buf, 1024, "%s.xsl", method);
+
+  snprintf(buf, 1024, "%s.xsl", method);
   rc = gf_path_append_string(&tmp, root, buf);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  
+
   *style_path = tmp;
 
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Get the fingerprint of a process of a section, but site.xml.
+**
+** A process reads site.xml with the parameters, so the whole site.xml is an
+** input besides the stylesheet and the files of the section. It is added by
+** build_finish_process_fingerprint() once site.xml has been digested.
+*/
+
 static gf_status
-build_process_site_file_low(xmlNodePtr node, gf_cmd_build* cmd) {
-  gf_status rc = 0;
-  gf_xslt* xslt = NULL;
-  gf_path* style_path = NULL;
-  
-  const gf_char* method = NULL;
-  const gf_char* output = NULL;
-  
-  gf_validate(node);
-  gf_validate(cmd);
+build_get_process_fingerprint(
+  gf_char* buf, gf_size_t size, build_context* ctxt, gf_entry* entry,
+  const gf_char* method, const gf_char* output, const gf_path* style_path) {
+  const gf_char* style = NULL;
+  build_digest digest;
+
+  _(gf_xslt_cache_get_fingerprint(ctxt->cache, style_path, &style));
+  _(build_digest_init(&digest));
+  _(build_digest_add_string(&digest, method));
+  _(build_digest_add_string(&digest, output));
+  _(build_digest_add_string(&digest, style));
+  _(build_digest_add_string(
+      &digest, gf_path_get_string(ctxt->cmd->conf_path)));
+  _(build_digest_add_string(
+      &digest, gf_path_get_string(ctxt->cmd->site_path)));
+  _(build_digest_add_entry_files(&digest, entry, GF_FALSE));
+  _(build_digest_final(&digest, buf, size));
 
-  method = (gf_char*)xmlGetProp(node, BAD_CAST "method");
-  output = (gf_char*)xmlGetProp(node, BAD_CAST "output");
+  return GF_SUCCESS;
+}
 
-  if (!method) {
-    gf_raise(GF_E_READ, "Invalid meta file.");
+/*!
+** @brief Add the digest of site.xml to the fingerprint of a process.
+**
+** An empty fingerprint is left empty, so that the unit is always built.
+*/
+
+static gf_status
+build_finish_process_fingerprint(
+  gf_char* buf, gf_size_t size, const build_context* ctxt,
+  const gf_char* partial) {
+  build_digest digest;
+
+  buf[0] = '\0';
+  if (gf_strnull(partial)) {
+    return GF_SUCCESS;
   }
+  _(build_digest_init(&digest));
+  _(build_digest_add_string(&digest, partial));
+  _(build_digest_add_bytes(
+      &digest, ctxt->site_hash, digest.provider->size));
+  _(build_digest_final(&digest, buf, size));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Run a process of a section on site.xml.
+**
+** @param [in] ctxt       The build context
+** @param [in] style_path The stylesheet of the process
+** @param [in] output     The file the result is written to (may be NULL)
+** @param [in] unit       The unit of the outputs (may be NULL)
+*/
 
+static gf_status
+build_transform_site(
+  build_context* ctxt, const gf_path* style_path, const gf_char* output,
+  gf_manifest_unit* unit) {
+  gf_status rc = 0;
+  const gf_cmd_base* cmd = NULL;
+  gf_xslt* xslt = NULL;
+
+  gf_validate(ctxt);
+  gf_validate(style_path);
+
+  cmd = ctxt->cmd;
   /* Prepare an XSLT processor */
-  rc = gf_xslt_new(&xslt);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
-  }
-  rc = build_get_style_path(
-    &style_path, method, GF_CMD_BASE_CAST(cmd)->style_path);
+  _(gf_xslt_new(&xslt));
+  rc = gf_xslt_use_template(xslt, ctxt->cache, style_path);
   if (rc != GF_SUCCESS) {
     gf_xslt_free(xslt);
     gf_throw(rc);
   }
-  rc = gf_xslt_read_template(xslt, style_path);
-  gf_path_free(style_path);
-  if (rc != GF_SUCCESS) {
-    gf_xslt_free(xslt);
-    gf_throw(rc);
+  if (unit) {
+    rc = gf_xslt_set_output_fn(xslt, build_add_output, unit);
+    if (rc != GF_SUCCESS) {
+      gf_xslt_free(xslt);
+      gf_throw(rc);
+    }
   }
-  rc = gf_xslt_set_param(
-    xslt, "conf-file", gf_path_get_string(GF_CMD_BASE_CAST(cmd)->conf_path));
+  rc = gf_xslt_set_param(xslt, "conf-file", gf_path_get_string(cmd->conf_path));
   if (rc != GF_SUCCESS) {
     gf_xslt_free(xslt);
     gf_throw(rc);
   }
-  rc = gf_xslt_set_param(
-    xslt, "site-file", gf_path_get_string(GF_CMD_BASE_CAST(cmd)->site_path));
+  rc = gf_xslt_set_param(xslt, "site-file", gf_path_get_string(cmd->site_path));
   if (rc != GF_SUCCESS) {
     gf_xslt_free(xslt);
     gf_throw(rc);
   }
   /* XSLT process */
-  rc = gf_xslt_process(xslt, GF_CMD_BASE_CAST(cmd)->site_path);
+  rc = gf_xslt_process(xslt, cmd->site_path);
   if (rc != GF_SUCCESS) {
     gf_xslt_free(xslt);
     gf_throw(rc);
@@ -406,6 +666,7 @@ build_process_site_file_low(xmlNodePtr node, gf_cmd_build* cmd) {
       gf_throw(rc);
     }
     rc = gf_xslt_write_file(xslt, output_path);
+    gf_path_free(output_path);
     if (rc != GF_SUCCESS) {
       gf_xslt_free(xslt);
       gf_throw(rc);
@@ -413,86 +674,139 @@ build_process_site_file_low(xmlNodePtr node, gf_cmd_build* cmd) {
   }
 
   gf_xslt_free(xslt);
-  
+
   return GF_SUCCESS;
 }
 
 static gf_status
-build_process_site_file(gf_entry* entry, gf_cmd_build* cmd) {
+build_process_site_file_xslt(
+  build_context* ctxt, const gf_char* method, const gf_char* output) {
   gf_status rc = 0;
-  gf_size_t cnt = 0;
+  gf_path* style_path = NULL;
 
-  gf_validate(entry);
-  gf_validate(cmd);
+  gf_validate(ctxt);
 
-  if (gf_entry_is_section(entry)) {
-    gf_path* path = NULL;
-    xmlDocPtr doc = NULL;
-    xmlNodePtr root = NULL;
-    xmlNodePtr node = NULL;
-
-    const gf_path* src = NULL;
-
-    /* alias */
-    src = GF_CMD_BASE_CAST(cmd)->src_path;
-    
-    /* Read meta.gf */
-    path = gf_entry_get_local_path(entry, src);
-    if (!path) {
-      gf_raise(GF_E_PATH, "Failed to build a path.");
-    }
-    doc = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
-    gf_path_free(path);
-    if (!doc) {
-      gf_raise(GF_E_PARSE, "Failed to read site file");
-    }
-    root = xmlDocGetRootElement(doc);
-    if (root) {
-      node = build_xml_get_process_set(root);
-      if (node) {
-        for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-          assert(!xmlStrcmp(cur->name, BAD_CAST "process"));
-          _(build_process_site_file_low(cur, cmd));
-        }
-      }
-    }
+  if (!method) {
+    gf_raise(GF_E_READ, "Invalid meta file.");
   }
-  cnt = gf_entry_count_children(entry);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_entry* child = NULL;
-
-    rc = gf_entry_get_child(entry, i, &child);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
-    rc = build_process_site_file(child, cmd);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
+  _(build_get_style_path(&style_path, method, ctxt->cmd->style_path));
+  rc = build_transform_site(ctxt, style_path, output, NULL);
+  gf_path_free(style_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
   }
-  
+
   return GF_SUCCESS;
 }
 
 static gf_status
-build_get_document_stylesheet(
-  gf_xslt** xslt, const gf_path* style_root, const gf_path* src_path) {
+build_process_site_file_low(build_context* ctxt, xmlNodePtr node) {
+  gf_status rc = 0;
+  xmlChar* method = NULL;
+  xmlChar* output = NULL;
+
+  gf_validate(ctxt);
+  gf_validate(node);
+
+  method = xmlGetProp(node, BAD_CAST "method");
+  output = xmlGetProp(node, BAD_CAST "output");
+  rc = build_process_site_file_xslt(
+    ctxt, (const gf_char*)method, (const gf_char*)output);
+  xmlFree(method);
+  xmlFree(output);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the process set of a section from its meta.gf.
+**
+** @param [out] doc  The document of meta.gf, freed by the caller
+** @param [out] node The process-set element, or NULL if there is none
+*/
+
+static gf_status
+build_read_process_set(
+  xmlDocPtr* doc, xmlNodePtr* node, const build_context* ctxt,
+  gf_entry* entry) {
+  gf_path* path = NULL;
+  xmlDocPtr tmp = NULL;
+  xmlNodePtr root = NULL;
+
+  gf_validate(doc);
+  gf_validate(node);
+  gf_validate(ctxt);
+  gf_validate(entry);
+
+  *node = NULL;
+  /* Read meta.gf */
+  path = gf_entry_get_local_path(entry, ctxt->cmd->src_path);
+  if (!path) {
+    gf_raise(GF_E_PATH, "Failed to build a path.");
+  }
+  tmp = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
+  gf_path_free(path);
+  if (!tmp) {
+    gf_raise(GF_E_PARSE, "Failed to read site file");
+  }
+  root = xmlDocGetRootElement(tmp);
+  if (root) {
+    *node = build_xml_get_process_set(root);
+  }
+  *doc = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_process_section(build_context* ctxt, gf_entry* entry) {
   gf_status rc = 0;
   xmlDocPtr doc = NULL;
+  xmlNodePtr node = NULL;
+
+  gf_validate(ctxt);
+  gf_validate(entry);
+
+  _(build_read_process_set(&doc, &node, ctxt, entry));
+  if (node) {
+    for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
+      assert(!xmlStrcmp(cur->name, BAD_CAST "process"));
+      rc = build_process_site_file_low(ctxt, cur);
+      if (rc != GF_SUCCESS) {
+        xmlFreeDoc(doc);
+        gf_throw(rc);
+      }
+    }
+  }
+  xmlFreeDoc(doc);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the stylesheet of a document by its method.
+**
+** The method is the role of the root element, or its name without a role.
+*/
+
+static gf_status
+build_get_document_stylesheet(
+  gf_xslt** xslt, gf_xslt_cache* cache, const gf_path* style_root,
+  xmlDocPtr doc) {
+  gf_status rc = 0;
   xmlNodePtr root = NULL;
   xmlChar* role = NULL;
   gf_char* method = NULL;
   gf_char style_file[1024] = { 0 };
   gf_path* style_path = NULL;
   gf_xslt* tmp = NULL;
-  
+
   gf_validate(xslt);
-  gf_validate(src_path);
+  gf_validate(doc);
 
-  doc = xmlReadFile(gf_path_get_string(src_path), NULL, GF_XML_PARSE_OPTIONS);
-  if (!doc) {
-    gf_raise(GF_E_PARSE, "Failed to read a document file.");
-  }
   root = xmlDocGetRootElement(doc);
   if (!root) {
     gf_raise(GF_E_PARSE, "Failed to read a document file.");
@@ -504,7 +818,8 @@ build_get_document_stylesheet(
     method = (gf_char*)(root->name);
   }
   assert(method && method[0]);
-  sprintf_s(style_file, 1024, "%s.xsl", method);
+  snprintf(style_file, 1024, "%s.xsl", method);
+  xmlFree(role);
 
   rc = gf_path_append_string(&style_path, style_root, style_file);
   if (rc != GF_SUCCESS) {
@@ -515,13 +830,13 @@ build_get_document_stylesheet(
     gf_path_free(style_path);
     gf_throw(rc);
   }
-  rc = gf_xslt_read_template(tmp, style_path);
+  rc = gf_xslt_use_template(tmp, cache, style_path);
   gf_path_free(style_path);
   if (rc != GF_SUCCESS) {
     gf_xslt_free(tmp);
     gf_throw(rc);
   }
-  
+
   *xslt = tmp;
 
   return GF_SUCCESS;
@@ -529,57 +844,463 @@ build_get_document_stylesheet(
 
 static gf_status
 build_process_document_file_low(
-  const gf_path* dst, const gf_path* src, gf_cmd_build* cmd) {
+  build_context* ctxt, const gf_path* src, gf_manifest_unit* unit) {
   gf_status rc = 0;
   gf_xslt* xslt = NULL;
-  
+  xmlDocPtr doc = NULL;
+
+  gf_validate(ctxt);
   gf_validate(src);
-  gf_validate(dst);
-  gf_validate(cmd);
 
+  /* The document is parsed once for both the method and the transform */
+  _(gf_xslt_read_document(&doc, src));
   rc = build_get_document_stylesheet(
-    &xslt, GF_CMD_BASE_CAST(cmd)->style_path, src);
+    &xslt, ctxt->cache, ctxt->cmd->style_path, doc);
   if (rc != GF_SUCCESS) {
+    xmlFreeDoc(doc);
     gf_throw(rc);
   }
-  rc = gf_xslt_process(xslt, src);
+  if (unit) {
+    rc = gf_xslt_set_output_fn(xslt, build_add_output, unit);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_xslt_process_doc(xslt, doc);
+  }
+  xmlFreeDoc(doc);
   if (rc != GF_SUCCESS) {
     gf_xslt_free(xslt);
     gf_throw(rc);
   }
 
   gf_xslt_free(xslt);
-  
+
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Get the fingerprint of a document.
+**
+** The method is the one recorded in site.xml. The fingerprint is empty for a
+** document without a method, which is always built.
+*/
+
 static gf_status
-build_process_document_file(gf_entry* entry, gf_cmd_build* cmd) {
+build_get_document_fingerprint(
+  gf_char* buf, gf_size_t size, build_context* ctxt, gf_entry* entry) {
   gf_status rc = 0;
-  gf_size_t cnt = 0;
+  const gf_char* method = NULL;
+  gf_path* style_path = NULL;
+  const gf_char* style = NULL;
+  build_digest digest;
 
+  buf[0] = '\0';
+  method = gf_entry_get_method_string(entry);
+  if (gf_strnull(method)) {
+    return GF_SUCCESS;
+  }
+  _(build_get_style_path(&style_path, method, ctxt->cmd->style_path));
+  rc = gf_xslt_cache_get_fingerprint(ctxt->cache, style_path, &style);
+  gf_path_free(style_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  _(build_digest_init(&digest));
+  _(build_digest_add_string(&digest, method));
+  _(build_digest_add_string(&digest, style));
+  _(build_digest_add_entry_files(&digest, entry, GF_FALSE));
+  _(build_digest_final(&digest, buf, size));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The kinds of the jobs of a build
+*/
+
+typedef enum build_node_type {
+  BUILD_NODE_SITE,              ///< Digest site.xml, read by the processes
+  BUILD_NODE_DIRECTORY,         ///< Create the output directory of an entry
+  BUILD_NODE_STATIC,            ///< Copy the static files of an entry
+  BUILD_NODE_PROCESS,           ///< Run a process of a section on site.xml
+  BUILD_NODE_DOCUMENT,          ///< Transform a document
+} build_node_type;
+
+/*!
+** @brief A job of a build
+**
+** A node holds all that its job needs, since the entries of a site may be
+** loaded on demand and are only used in the calling thread.
+*/
+
+typedef struct build_node {
+  build_node_type   type;       ///< The kind of the job
+  gf_char*          label;      ///< The name in the reports (the unit key)
+  gf_path*          src;        ///< The source file, directory or stylesheet
+  gf_path*          dst;        ///< The directory created or copied to
+  gf_char*          output;     ///< The output of a process (may be NULL)
+  gf_char           partial[GF_HASH_BUFSIZE_MAX * 2 + 1]; ///< w/o site.xml
+  gf_manifest_unit* unit;       ///< The unit of the outputs (may be NULL)
+  gf_bool           done;       ///< GF_TRUE once the job is run
+} build_node;
+
+static void
+build_node_free(build_node* node) {
+  if (node) {
+    gf_free(node->label);
+    gf_path_free(node->src);
+    gf_path_free(node->dst);
+    gf_free(node->output);
+    gf_free(node);
+  }
+}
+
+static void
+build_node_free_any(gf_any* any) {
+  if (any) {
+    build_node_free(any->ptr);
+  }
+}
+
+static gf_status
+build_node_new(build_node** node, build_node_type type, const gf_char* label) {
+  gf_status rc = 0;
+  build_node* tmp = NULL;
+
+  gf_validate(node);
+  gf_validate(label);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->type = type;
+  tmp->label = NULL;
+  tmp->src = NULL;
+  tmp->dst = NULL;
+  tmp->output = NULL;
+  tmp->partial[0] = '\0';
+  tmp->unit = NULL;
+  tmp->done = GF_FALSE;
+  rc = gf_strdup(&tmp->label, label);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  *node = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Prepare the node of a document unless its outputs are up to date.
+**
+** @param [out] node  The node, or NULL if the document is up to date
+** @param [in]  ctxt  The build context
+** @param [in]  entry The document entry
+*/
+
+static gf_status
+build_prepare_document(
+  build_node** node, build_context* ctxt, gf_entry* entry) {
+  gf_char key[1024] = { 0 };
+  gf_manifest_unit* unit = NULL;
+  build_node* tmp = NULL;
+
+  gf_validate(node);
+  gf_validate(ctxt);
   gf_validate(entry);
-  gf_validate(cmd);
-  
-  if (gf_entry_is_document(entry)) {
-    gf_path* src = NULL;
-    gf_path* dst = NULL;
 
-    src = gf_entry_get_local_path(entry, GF_CMD_BASE_CAST(cmd)->src_path);
-    if (!src) {
-      gf_raise(GF_E_PATH, "Failed to build a local document path.");
+  *node = NULL;
+  snprintf(key, sizeof(key), "document:%s",
+           gf_entry_get_full_path_string(entry));
+  if (ctxt->manifest) {
+    gf_char fingerprint[GF_HASH_BUFSIZE_MAX * 2 + 1] = { 0 };
+
+    _(build_get_document_fingerprint(
+        fingerprint, sizeof(fingerprint), ctxt, entry));
+    _(build_begin_unit(ctxt, key, fingerprint, &unit));
+    if (!unit) {
+      return GF_SUCCESS;
     }
-    // NOTE: dst_path is a directory path
-    dst = GF_CMD_BASE_CAST(cmd)->dst_path;
-    if (!dst) {
-      gf_path_free(src);
-      gf_raise(GF_E_PATH, "Failed to build a local document path.");
+  }
+  _(build_node_new(&tmp, BUILD_NODE_DOCUMENT, key));
+  tmp->unit = unit;
+  tmp->src = gf_entry_get_local_path(entry, ctxt->cmd->src_path);
+  if (!tmp->src) {
+    build_node_free(tmp);
+    gf_raise(GF_E_PATH, "Failed to build a local document path.");
+  }
+  *node = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_process_document(build_context* ctxt, gf_entry* entry) {
+  gf_status rc = 0;
+  build_node* node = NULL;
+
+  gf_validate(ctxt);
+  gf_validate(entry);
+
+  _(build_prepare_document(&node, ctxt, entry));
+  if (!node) {
+    return GF_SUCCESS;
+  }
+  rc = build_process_document_file_low(ctxt, node->src, node->unit);
+  build_node_free(node);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The jobs of a build and the order between them
+*/
+
+typedef struct build_plan {
+  build_context* ctxt;          ///< The build context
+  gf_job_graph*  graph;         ///< The jobs and their dependencies
+  gf_array*      nodes;         ///< build_node objects by the job index
+  gf_size_t      site;          ///< The job digesting site.xml
+} build_plan;
+
+/*!
+** @brief Add a node to the plan after the jobs it depends on.
+**
+** The node is owned by the plan, even on failure.
+**
+** @param [in, out] plan  The plan
+** @param [in]      node  The node
+** @param [in]      deps  The jobs run before the node
+** @param [in]      count The number of @a deps
+** @param [out]     index The job of the node (may be NULL)
+*/
+
+static gf_status
+build_plan_add_node(
+  build_plan* plan, build_node* node, const gf_size_t* deps, gf_size_t count,
+  gf_size_t* index) {
+  gf_status rc = 0;
+  gf_size_t job = 0;
+
+  gf_validate(plan);
+  gf_validate(node);
+
+  rc = gf_array_add(plan->nodes, (gf_any){ .ptr = node });
+  if (rc != GF_SUCCESS) {
+    build_node_free(node);
+    gf_throw(rc);
+  }
+  _(gf_job_graph_add_job(plan->graph, &job));
+  for (gf_size_t i = 0; i < count; i++) {
+    _(gf_job_graph_add_edge(plan->graph, deps[i], job));
+  }
+  if (index) {
+    *index = job;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Plan the digest of site.xml, which the processes wait for.
+*/
+
+static gf_status
+build_plan_site(build_plan* plan) {
+  gf_status rc = 0;
+  const gf_cmd_base* cmd = NULL;
+  gf_char label[1024] = { 0 };
+  build_node* node = NULL;
+
+  gf_validate(plan);
+
+  cmd = plan->ctxt->cmd;
+  snprintf(label, sizeof(label), "site:%s", gf_path_get_string(cmd->site_path));
+  _(build_node_new(&node, BUILD_NODE_SITE, label));
+  rc = gf_path_clone(&node->src, cmd->site_path);
+  if (rc != GF_SUCCESS) {
+    build_node_free(node);
+    gf_throw(rc);
+  }
+  _(build_plan_add_node(plan, node, NULL, 0, &plan->site));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Plan the copy of the static files of an entry unless up to date.
+*/
+
+static gf_status
+build_plan_static(build_plan* plan, gf_entry* entry, gf_size_t dir) {
+  gf_status rc = 0;
+  build_context* ctxt = NULL;
+  gf_char key[1024] = { 0 };
+  gf_manifest_unit* unit = NULL;
+  build_node* node = NULL;
+
+  gf_validate(plan);
+  gf_validate(entry);
+
+  ctxt = plan->ctxt;
+  snprintf(key, sizeof(key), "static:%s",
+           gf_entry_get_full_path_string(entry));
+  if (ctxt->manifest) {
+    gf_char fingerprint[GF_HASH_BUFSIZE_MAX * 2 + 1] = { 0 };
+
+    _(build_get_static_fingerprint(fingerprint, sizeof(fingerprint), entry));
+    _(build_begin_unit(ctxt, key, fingerprint, &unit));
+    if (!unit) {
+      return GF_SUCCESS;
     }
-    rc = build_process_document_file_low(dst, src, cmd);
-    gf_path_free(src);
-    gf_path_free(dst);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
+    _(build_add_static_outputs(unit, entry, ctxt->cmd->dst_path));
+  }
+  _(build_node_new(&node, BUILD_NODE_STATIC, key));
+  node->unit = unit;
+  rc = build_get_static_path(&node->src, entry, ctxt->cmd->src_path);
+  if (rc == GF_SUCCESS) {
+    rc = build_get_static_path(&node->dst, entry, ctxt->cmd->dst_path);
+  }
+  if (rc != GF_SUCCESS) {
+    build_node_free(node);
+    gf_throw(rc);
+  }
+  _(build_plan_add_node(plan, node, &dir, 1, NULL));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Plan a process of a section.
+**
+** The stylesheet is compiled here for the fingerprint. Whether the outputs
+** are up to date is decided when the job runs, after site.xml is digested.
+*/
+
+static gf_status
+build_plan_process(
+  build_plan* plan, gf_entry* entry, xmlNodePtr cur, gf_size_t dir) {
+  gf_status rc = 0;
+  build_context* ctxt = NULL;
+  xmlChar* method = NULL;
+  xmlChar* output = NULL;
+  gf_char key[1024] = { 0 };
+  build_node* node = NULL;
+  gf_size_t deps[2] = { 0 };
+
+  gf_validate(plan);
+  gf_validate(entry);
+  gf_validate(cur);
+
+  ctxt = plan->ctxt;
+  method = xmlGetProp(cur, BAD_CAST "method");
+  output = xmlGetProp(cur, BAD_CAST "output");
+  if (!method) {
+    xmlFree(output);
+    gf_raise(GF_E_READ, "Invalid meta file.");
+  }
+  snprintf(key, sizeof(key), "process:%s:%s:%s",
+           gf_entry_get_full_path_string(entry), (const gf_char*)method,
+           output ? (const gf_char*)output : "");
+  rc = build_node_new(&node, BUILD_NODE_PROCESS, key);
+  if (rc == GF_SUCCESS && output) {
+    rc = gf_strdup(&node->output, (const gf_char*)output);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = build_get_style_path(
+      &node->src, (const gf_char*)method, ctxt->cmd->style_path);
+  }
+  if (rc == GF_SUCCESS && ctxt->manifest) {
+    rc = build_get_process_fingerprint(
+      node->partial, sizeof(node->partial), ctxt, entry,
+      (const gf_char*)method, (const gf_char*)output, node->src);
+  }
+  xmlFree(method);
+  xmlFree(output);
+  if (rc != GF_SUCCESS) {
+    build_node_free(node);
+    gf_throw(rc);
+  }
+  deps[0] = plan->site;
+  deps[1] = dir;
+  _(build_plan_add_node(plan, node, deps, gf_countof(deps), NULL));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_plan_section(build_plan* plan, gf_entry* entry, gf_size_t dir) {
+  gf_status rc = 0;
+  xmlDocPtr doc = NULL;
+  xmlNodePtr node = NULL;
+
+  gf_validate(plan);
+  gf_validate(entry);
+
+  _(build_read_process_set(&doc, &node, plan->ctxt, entry));
+  if (node) {
+    for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
+      assert(!xmlStrcmp(cur->name, BAD_CAST "process"));
+      rc = build_plan_process(plan, entry, cur, dir);
+      if (rc != GF_SUCCESS) {
+        xmlFreeDoc(doc);
+        gf_throw(rc);
+      }
+    }
+  }
+  xmlFreeDoc(doc);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Plan the jobs of an entry and its children.
+**
+** The jobs are added in the order of the entry tree. The output directory of
+** an entry is created after the one of its parent, and before the files of
+** the entry are copied or written.
+**
+** @param [in, out] plan   The plan
+** @param [in]      entry  The entry
+** @param [in]      parent The job creating the directory of the parent entry
+**                         (NULL for the root entry)
+*/
+
+static gf_status
+build_plan_entry(build_plan* plan, gf_entry* entry, const gf_size_t* parent) {
+  gf_status rc = 0;
+  const gf_char* path = NULL;
+  const gf_char* sep = NULL;
+  gf_char label[1024] = { 0 };
+  build_node* node = NULL;
+  gf_size_t dir = 0;
+  gf_size_t cnt = 0;
+
+  gf_validate(plan);
+  gf_validate(entry);
+
+  path = gf_entry_get_full_path_string(entry);
+  if (!path) {
+    gf_raise(GF_E_STATE, "Failed to build a path.");
+  }
+  sep = strrchr(path, '/');
+  snprintf(label, sizeof(label), "directory:%.*s",
+           sep ? (int)(sep - path) + 1 : 0, path);
+  _(build_node_new(&node, BUILD_NODE_DIRECTORY, label));
+  rc = build_get_directory_path(&node->dst, entry, plan->ctxt->cmd->dst_path);
+  if (rc != GF_SUCCESS) {
+    build_node_free(node);
+    gf_throw(rc);
+  }
+  _(build_plan_add_node(plan, node, parent, parent ? 1 : 0, &dir));
+  _(build_plan_static(plan, entry, dir));
+  if (gf_entry_is_section(entry)) {
+    _(build_plan_section(plan, entry, dir));
+  } else if (gf_entry_is_document(entry)) {
+    _(build_prepare_document(&node, plan->ctxt, entry));
+    if (node) {
+      _(build_plan_add_node(plan, node, &dir, 1, NULL));
     }
   }
   cnt = gf_entry_count_children(entry);
@@ -590,7 +1311,7 @@ build_process_document_file(gf_entry* entry, gf_cmd_build* cmd) {
     if (rc != GF_SUCCESS) {
       gf_throw(rc);
     }
-    rc = build_process_document_file(child, cmd);
+    rc = build_plan_entry(plan, child, &dir);
     if (rc != GF_SUCCESS) {
       gf_throw(rc);
     }
@@ -599,64 +1320,432 @@ build_process_document_file(gf_entry* entry, gf_cmd_build* cmd) {
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Run a process of a section unless its outputs are up to date.
+**
+** The manifest is shared by the threads, so it is locked while the unit is
+** looked up and added.
+*/
+
 static gf_status
-build_convert_document_file_set(gf_cmd_build* cmd) {
+build_run_process(build_context* ctxt, build_node* node) {
   gf_status rc = 0;
+
+  if (ctxt->manifest) {
+    gf_char fingerprint[GF_HASH_BUFSIZE_MAX * 2 + 1] = { 0 };
+
+    _(build_finish_process_fingerprint(
+        fingerprint, sizeof(fingerprint), ctxt, node->partial));
+    gf_mutex_lock(&ctxt->lock);
+    rc = build_begin_unit(ctxt, node->label, fingerprint, &node->unit);
+    gf_mutex_unlock(&ctxt->lock);
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
+    if (!node->unit) {
+      return GF_SUCCESS;
+    }
+  }
+  _(build_transform_site(ctxt, node->src, node->output, node->unit));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Run a job of the build (gf_job_fn).
+*/
+
+static gf_status
+build_run_node(gf_size_t index, gf_ptr data) {
+  build_plan* plan = data;
+  build_context* ctxt = plan->ctxt;
+  gf_any any = { 0 };
+  build_node* node = NULL;
+
+  _(gf_array_get(plan->nodes, index, &any));
+  node = any.ptr;
+  node->done = GF_TRUE;
+  switch (node->type) {
+  case BUILD_NODE_SITE:
+    _(gf_hash_file_with(
+        gf_hash_get_default(), ctxt->site_hash, sizeof(ctxt->site_hash),
+        node->src));
+    break;
+  case BUILD_NODE_DIRECTORY:
+    _(build_make_directory(node->dst));
+    break;
+  case BUILD_NODE_STATIC:
+    _(gf_shell_copy_tree(node->dst, node->src));
+    break;
+  case BUILD_NODE_PROCESS:
+    _(build_run_process(ctxt, node));
+    break;
+  case BUILD_NODE_DOCUMENT:
+    _(build_process_document_file_low(ctxt, node->src, node->unit));
+    break;
+  default:
+    gf_raise(GF_E_STATE, "Unknown build job.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Report the failed jobs in the order of the entry tree.
+**
+** @return The status of the first failed job, GF_SUCCESS if none.
+*/
+
+static gf_status
+build_check_plan(const build_plan* plan, const gf_status* status) {
+  gf_status rc = GF_SUCCESS;
+  gf_size_t skipped = 0;
+
+  for (gf_size_t i = 0; i < gf_array_size(plan->nodes); i++) {
+    gf_any any = { 0 };
+    const build_node* node = NULL;
+
+    (void)gf_array_get(plan->nodes, i, &any);
+    node = any.ptr;
+    if (!node->done) {
+      skipped += 1;
+    } else if (status[i] != GF_SUCCESS) {
+      gf_error("Failed to build '%s'.", node->label);
+      if (rc == GF_SUCCESS) {
+        rc = status[i];
+      }
+    }
+  }
+  if (skipped > 0) {
+    gf_warn("%zu job(s) were not run after the failure.", skipped);
+  }
+
+  return rc;
+}
+
+/*!
+** @brief Report the chain of dependent jobs which bounded the build time.
+**
+** One line sums the path up; the jobs on it are listed at the debug level.
+**
+** @param [in] plan    The plan which has been run
+** @param [in] elapsed The time the jobs took in nanoseconds
+*/
+
+static void
+build_log_critical_path(const build_plan* plan, gf_64u elapsed) {
+  gf_size_t* jobs = NULL;
+  gf_size_t total = 0;
+  gf_size_t cnt = 0;
+  gf_64u nsec = 0;
+
+  total = gf_job_graph_count_jobs(plan->graph);
+  if (gf_malloc((gf_ptr*)&jobs, sizeof(*jobs) * total) != GF_SUCCESS) {
+    return;
+  }
+  if (gf_job_graph_get_critical_path(plan->graph, jobs, &cnt, &nsec) !=
+      GF_SUCCESS) {
+    gf_free(jobs);
+    return;
+  }
+  gf_info("Critical path: %zu of %zu job(s), %.3f of %.3f sec.",
+          cnt, total, (double)nsec / 1e9, (double)elapsed / 1e9);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    const build_node* node = NULL;
+
+    (void)gf_array_get(plan->nodes, jobs[i], &any);
+    node = any.ptr;
+    gf_debug("  %8.3f sec  %s",
+             (double)gf_job_graph_get_job_time(plan->graph, jobs[i]) / 1e9,
+             node->label);
+  }
+  gf_free(jobs);
+}
+
+static void
+build_log_stylesheet_cache(const gf_xslt_cache* cache) {
+  gf_size_t hits = gf_xslt_cache_count_hits(cache);
+  gf_size_t total = hits + gf_xslt_cache_count_misses(cache);
+
+  gf_debug("Compiled %zu stylesheet(s) in %.3f sec; %zu of %zu hit(s).",
+           gf_xslt_cache_count_misses(cache),
+           (double)gf_xslt_cache_get_compile_time(cache) / 1e9, hits, total);
+}
+
+/*!
+** @brief Plan the jobs of the site and run them on a pool of threads.
+**
+** A job starts as soon as the jobs it depends on have succeeded: the output
+** directory of an entry before its copies and transforms, and the digest of
+** site.xml before the processes of the sections. The jobs are planned in the
+** calling thread, and the failures are reported after all the jobs end.
+*/
+
+static gf_status
+build_run_plan(build_context* ctxt, gf_site* site) {
+  gf_status rc = 0;
+  build_plan plan = { .ctxt = ctxt };
   gf_entry* entry = NULL;
-  
+  gf_status* status = NULL;
+  gf_64u start = 0;
+
+  gf_validate(ctxt);
+  gf_validate(site);
+
+  _(gf_site_get_root_entry(site, &entry));
+  if (!entry) {
+    gf_raise(GF_E_STATE, "The root entry was not found.");
+  }
+  _(gf_job_graph_new(&plan.graph));
+  rc = gf_array_new(&plan.nodes);
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_set_free_fn(plan.nodes, build_node_free_any);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = build_plan_site(&plan);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = build_plan_entry(&plan, entry, NULL);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_malloc(
+      (gf_ptr*)&status,
+      sizeof(*status) * gf_job_graph_count_jobs(plan.graph));
+  }
+  if (rc == GF_SUCCESS) {
+    start = gf_datetime_get_monotonic_ns();
+    rc = gf_xslt_run_graph(
+      plan.graph, build_run_node, &plan, ctxt->threads, ctxt->fail_fast,
+      status);
+  }
+  if (rc == GF_SUCCESS) {
+    build_log_critical_path(&plan, gf_datetime_get_monotonic_ns() - start);
+    rc = build_check_plan(&plan, status);
+  }
+  gf_free(status);
+  gf_array_free(plan.nodes);
+  gf_job_graph_free(plan.graph);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_build_prepare(gf_cmd_base* cmd) {
   gf_validate(cmd);
 
-  rc = gf_site_get_root_entry(cmd->site, &entry);
+  if (gf_path_is_empty(cmd->style_path)) {
+    gf_path_free(cmd->style_path);
+    cmd->style_path = NULL;
+    _(gf_path_get_style_path(&cmd->style_path));
+  }
+  /* The stylesheets are looked up in the directory of the parameter */
+  if (!gf_path_is_directory(cmd->style_path)) {
+    gf_path* parent = NULL;
+
+    _(gf_path_get_parent(&parent, cmd->style_path));
+    gf_path_free(cmd->style_path);
+    cmd->style_path = parent;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the manifest of the previous build.
+**
+** @param [out] manifest    The manifest (empty for a full build)
+** @param [out] incremental GF_TRUE if the previous build is reused
+*/
+
+static gf_status
+build_read_manifest(
+  gf_manifest** manifest, gf_bool* incremental, const gf_cmd_base* cmd,
+  const gf_path* path, gf_bool full) {
+  gf_status rc = 0;
+  gf_manifest* tmp = NULL;
+
+  gf_validate(manifest);
+  gf_validate(incremental);
+  gf_validate(cmd);
+  gf_validate(path);
+
+  *incremental = GF_FALSE;
+  _(gf_manifest_new(&tmp));
+  if (!full && gf_path_file_exists(path) &&
+      gf_path_file_exists(cmd->dst_path)) {
+    rc = gf_manifest_read_file(tmp, path);
+    if (rc != GF_SUCCESS) {
+      gf_warn("Failed to read the build manifest; building the whole site.");
+      gf_manifest_free(tmp);
+      tmp = NULL;
+      _(gf_manifest_new(&tmp));
+    } else {
+      *incremental = GF_TRUE;
+    }
+  }
+  *manifest = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+build_site_low(build_context* ctxt, gf_site* site, gf_bool incremental) {
+  gf_status rc = 0;
+
+  gf_validate(ctxt);
+  gf_validate(site);
+
+  /* prepare the output root path */
+  _(build_prepare_output_path(ctxt->cmd, !incremental));
+  /* Each stylesheet is compiled once for the whole build */
+  _(gf_xslt_cache_new(&ctxt->cache));
+  rc = gf_mutex_init(&ctxt->lock);
+  if (rc == GF_SUCCESS) {
+    rc = build_run_plan(ctxt, site);
+    gf_mutex_destroy(&ctxt->lock);
+  }
+  build_log_stylesheet_cache(ctxt->cache);
+  gf_xslt_cache_free(ctxt->cache);
+  ctxt->cache = NULL;
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* Convert site.xml */
-  rc = build_process_site_file(entry, cmd);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the number of the threads running the jobs of a build.
+**
+** @return The `threads' parameter (0: one per core)
+*/
+
+static gf_int
+build_get_thread_count(void) {
+  gf_int threads = 0;
+
+  threads = gf_config_get_int("threads");
+  if (threads < 0) {
+    gf_warn("Invalid 'threads' parameter (%d), using one per core.", threads);
+    threads = 0;
+  }
+
+  return threads;
+}
+
+gf_status
+gf_cmd_build_site(
+  const gf_cmd_base* cmd, gf_site* site, const gf_cmd_build_option* option) {
+  gf_status rc = 0;
+  build_context ctxt = { .cmd = cmd };
+  gf_path* path = NULL;
+  gf_bool full = GF_FALSE;
+  gf_bool incremental = GF_FALSE;
+  gf_size_t removed = 0;
+
+  gf_validate(cmd);
+  gf_validate(site);
+
+  if (option) {
+    full = option->full;
+    ctxt.fail_fast = option->fail_fast;
+  }
+  ctxt.threads = build_get_thread_count();
+
+  _(gf_path_append_string(&path, cmd->conf_path, GF_BUILD_MANIFEST_FILE_NAME));
+  rc = build_read_manifest(&ctxt.manifest, &incremental, cmd, path, full);
+  if (rc == GF_SUCCESS) {
+    rc = build_site_low(&ctxt, site, incremental);
+  }
+  /* The outputs of the units not built any more are removed */
+  if (rc == GF_SUCCESS) {
+    rc = gf_manifest_remove_stale_outputs(ctxt.manifest, &removed);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_manifest_write_file(ctxt.manifest, path);
+  }
+  if (rc == GF_SUCCESS) {
+    gf_info("Built %zu unit(s); %zu up to date, %zu stale file(s) removed.",
+            gf_manifest_count_added_units(ctxt.manifest),
+            gf_manifest_count_kept_units(ctxt.manifest), removed);
+  }
+  gf_manifest_free(ctxt.manifest);
+  gf_path_free(path);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* Convert documents */
-  rc = build_process_document_file(entry, cmd);
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_build_process_entry(
+  const gf_cmd_base* cmd, gf_entry* entry, gf_xslt_cache* cache) {
+  gf_status rc = 0;
+  build_context ctxt = { .cmd = cmd, .cache = cache };
+
+  gf_validate(cmd);
+  gf_validate(entry);
+
+  if (!ctxt.cache) {
+    _(gf_xslt_cache_new(&ctxt.cache));
+  }
+  if (gf_entry_is_section(entry)) {
+    rc = build_process_section(&ctxt, entry);
+  } else if (gf_entry_is_document(entry)) {
+    rc = build_process_document(&ctxt, entry);
+  } else {
+    /* do nothing */
+  }
+  if (!cache) {
+    gf_xslt_cache_free(ctxt.cache);
+  }
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_build_copy_static_file(const gf_cmd_base* cmd, gf_entry* entry) {
+  gf_validate(cmd);
+  gf_validate(entry);
+
+  _(build_copy_static_file_low(entry, cmd->src_path, cmd->dst_path));
+
   return GF_SUCCESS;
 }
 
 static gf_status
 build_process(gf_cmd_build* cmd) {
   gf_status rc = 0;
-  
+  gf_cmd_build_option option = { 0 };
+
   gf_validate(cmd);
 
+  option.full = gf_args_is_specified(GF_CMD_BASE_CAST(cmd)->args, OPT_FULL);
+  option.fail_fast =
+    gf_args_is_specified(GF_CMD_BASE_CAST(cmd)->args, OPT_FAIL_FAST);
   /* read the site file */
   assert(!cmd->site);
-  rc = gf_site_read_file(&cmd->site, GF_CMD_BASE_CAST(cmd)->site_path);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
-  }
-  /* prepare the output root path */
-  rc = build_prepare_output_path(cmd);
+  rc = gf_cmd_update_read_site(GF_CMD_BASE_CAST(cmd), &cmd->site);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* create directories */
-  rc = build_create_directory_set(cmd);
+  rc = gf_cmd_build_prepare(GF_CMD_BASE_CAST(cmd));
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* copy static files */
-  rc = build_copy_static_file_set(cmd);
+  rc = gf_cmd_build_site(GF_CMD_BASE_CAST(cmd), cmd->site, &option);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
-  /* tranlate XML files */
-  rc = build_convert_document_file_set(cmd);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
-  }
-  
+
   return GF_SUCCESS;
 }
 
@@ -664,11 +1753,13 @@ gf_status
 gf_cmd_build_execute(gf_cmd_base* cmd) {
   gf_validate(cmd);
 
+  _(gf_args_parse(cmd->args));
+
   gf_msg("Compiling documents ...");
 
   _(build_process(GF_CMD_BUILD_CAST(cmd)));
-  
+
   gf_msg("Done.");
-  
+
   return GF_SUCCESS;
 }
@@ -16,6 +16,8 @@
 #include <libgf/gf_datatype.h>
 #include <libgf/gf_error.h>
 #include <libgf/gf_cmd_base.h>
+#include <libgf/gf_site.h>
+#include <libgf/gf_xslt.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +27,15 @@ typedef struct gf_cmd_build gf_cmd_build;
 
 #define GF_CMD_BUILD_CAST(cmd) ((gf_cmd_build*)(cmd))
 
+/*!
+** @brief The options of gf_cmd_build_site()
+*/
+
+typedef struct gf_cmd_build_option {
+  gf_bool full;       ///< Build the whole site regardless of the manifest
+  gf_bool fail_fast;  ///< Start no more jobs after a failure
+} gf_cmd_build_option;
+
 /*!
 ** @brief Create a new build command object.
 **
@@ -42,6 +53,64 @@ extern void gf_cmd_build_free(gf_cmd_base* cmd);
 
 extern gf_status gf_cmd_build_execute(gf_cmd_base* cmd);
 
+/*!
+** @brief Set the paths needed to build the site.
+**
+** The style path is read from the `site.style-path' parameter unless it is
+** set already. If it names a file, the directory of the file is used, since
+** the stylesheet of each process is looked up by its name.
+**
+** @param [in, out] cmd Command object
+*/
+
+extern gf_status gf_cmd_build_prepare(gf_cmd_base* cmd);
+
+/*!
+** @brief Build the site with the paths of a command.
+**
+** The outputs whose inputs are unchanged since the last build, as recorded in
+** the build manifest, are kept; the outputs no longer written are removed.
+** The whole site is built if there is no manifest.
+**
+** The directories, static copies, processes and documents are run as jobs
+** by the threads of the `threads' parameter, each as soon as the jobs it
+** depends on have succeeded. A failed job is reported and stops only the
+** jobs depending on it, unless option->fail_fast is set. The critical path
+** of the jobs is reported at the end.
+**
+** @param [in] cmd    Command object prepared by gf_cmd_build_prepare()
+** @param [in] site   The site to be built
+** @param [in] option The build options (NULL: the defaults)
+*/
+
+extern gf_status gf_cmd_build_site(
+  const gf_cmd_base* cmd, gf_site* site, const gf_cmd_build_option* option);
+
+/*!
+** @brief Run the XSLT transforms of an entry.
+**
+** For a section, the processes listed in its meta.gf are run; for a document,
+** the document is transformed. The children are not processed.
+**
+** @param [in]      cmd   Command object prepared by gf_cmd_build_prepare()
+** @param [in]      entry The entry to be processed
+** @param [in, out] cache The compiled stylesheets shared by the entries
+**                        processed together (NULL: compiled for the entry)
+*/
+
+extern gf_status gf_cmd_build_process_entry(
+  const gf_cmd_base* cmd, gf_entry* entry, gf_xslt_cache* cache);
+
+/*!
+** @brief Copy the static files (the `_' directory) of an entry.
+**
+** @param [in] cmd   Command object
+** @param [in] entry The entry whose static files are copied
+*/
+
+extern gf_status gf_cmd_build_copy_static_file(
+  const gf_cmd_base* cmd, gf_entry* entry);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,196 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_cmd_db.c
+** @brief Convert between the site database and the site file.
+*/
+#include <assert.h>
+#include <string.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_path.h>
+#include <libgf/gf_site.h>
+#include <libgf/gf_cmd_base.h>
+#include <libgf/gf_cmd_db.h>
+
+#include "gf_local.h"
+
+struct gf_cmd_db {
+  gf_cmd_base base;
+};
+
+enum {
+  OPT_DB_HELP,
+};
+
+static const gf_cmd_base_info info_ = {
+  .base = {
+    .name        = "db",
+    .description = "Convert between the site database and the site file",
+    .args        = NULL,
+    .create      = gf_cmd_db_new,
+    .free        = gf_cmd_db_free,
+    .execute     = gf_cmd_db_execute,
+  },
+  .options = {
+    {
+      .key         = OPT_DB_HELP,
+      .opt_short   = 'h',
+      .opt_long    = "help",
+      .opt_count   = 0,
+      .usage       = "-h, --help",
+      .description = "Show help.",
+    },
+    /* Terminate */
+    GF_OPTION_NULL,
+  },
+};
+
+static gf_status
+init(gf_cmd_base* cmd) {
+  gf_validate(cmd);
+
+  _(gf_cmd_base_init(cmd));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+prepare(gf_cmd_base* cmd) {
+  gf_validate(cmd);
+
+  _(gf_cmd_base_set_info(cmd, &info_));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_db_new(gf_cmd_base** cmd) {
+  gf_status rc = 0;
+  gf_cmd_base* tmp = NULL;
+
+  gf_validate(cmd);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(gf_cmd_db)));
+
+  rc = init(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    return rc;
+  }
+  rc = prepare(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_cmd_db_free(tmp);
+    return rc;
+  }
+
+  *cmd = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_cmd_db_free(gf_cmd_base* cmd) {
+  if (cmd) {
+    gf_cmd_base_clear(cmd);
+    gf_free(cmd);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void
+db_show_help(const gf_cmd_base* cmd) {
+  gf_msg("usage: gf [options] db [--help] (export | import)");
+  gf_msg("");
+  gf_msg("  export  Write the site database to the site file.");
+  gf_msg("  import  Write the site file to the site database.");
+  gf_msg("");
+  if (cmd && cmd->args) {
+    gf_msg("Options:");
+    gf_msg("");
+    gf_args_print_help(cmd->args);
+  }
+  gf_msg("");
+}
+
+static gf_status
+db_export(const gf_cmd_base* cmd) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+
+  if (!gf_path_file_exists(cmd->db_path)) {
+    gf_raise(GF_E_OPEN, "The site database does not exist. (%s)",
+             gf_path_get_string(cmd->db_path));
+  }
+  _(gf_site_read_db(&site, cmd->db_path));
+  rc = gf_site_write_file(site, cmd->site_path);
+  gf_site_free(site);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  gf_info("The site file '%s' has been written.",
+          gf_path_get_string(cmd->site_path));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+db_import(const gf_cmd_base* cmd) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+
+  if (!gf_path_file_exists(cmd->site_path)) {
+    gf_raise(GF_E_OPEN, "The site file does not exist. (%s)",
+             gf_path_get_string(cmd->site_path));
+  }
+  _(gf_site_read_file(&site, cmd->site_path));
+  rc = gf_site_write_db(site, cmd->db_path);
+  gf_site_free(site);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  gf_info("The site database '%s' has been written.",
+          gf_path_get_string(cmd->db_path));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_db_execute(gf_cmd_base* cmd) {
+  gf_status rc = 0;
+  char* name = NULL;
+
+  gf_validate(cmd);
+
+  _(gf_args_parse(cmd->args));
+  if (gf_args_is_specified(cmd->args, OPT_DB_HELP)) {
+    db_show_help(cmd);
+    return GF_SUCCESS;
+  }
+  if (gf_args_remain(cmd->args) != 1) {
+    db_show_help(cmd);
+    gf_raise(GF_E_OPTION, "Invalid command.");
+  }
+  if (gf_path_is_empty(cmd->conf_path)) {
+    gf_raise(GF_E_COMMAND, "This path is not in a project directory.");
+  }
+  _(gf_args_consume(cmd->args, &name));
+  if (!strcmp(name, "export")) {
+    rc = db_export(cmd);
+  } else if (!strcmp(name, "import")) {
+    rc = db_import(cmd);
+  } else {
+    db_show_help(cmd);
+    gf_error("Unknown sub-command. (%s)", name);
+    rc = GF_E_OPTION;
+  }
+  gf_free(name);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
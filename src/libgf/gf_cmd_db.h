@@ -0,0 +1,52 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_cmd_db.h
+** @brief Convert between the site database and the site file.
+*/
+#ifndef LIBGF_GF_CMD_DB_H
+#define LIBGF_GF_CMD_DB_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_cmd_base.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gf_cmd_db gf_cmd_db;
+
+#define GF_CMD_DB_CAST(cmd) ((gf_cmd_db*)(cmd))
+
+/*!
+** @brief Create a new db command object.
+**
+** @param [out] cmd The pointer to the new db command object
+*/
+
+extern gf_status gf_cmd_db_new(gf_cmd_base** cmd);
+extern void gf_cmd_db_free(gf_cmd_base* cmd);
+
+/*!
+** @brief Execute the db process.
+**
+** `gf db export' writes the site database to the site file (site.xml), and
+** `gf db import' writes the site file to the site database (site.gfdb).
+**
+** @param [in] cmd Command object
+*/
+
+extern gf_status gf_cmd_db_execute(gf_cmd_base* cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_CMD_DB_H */
@@ -4,15 +4,14 @@
  */
 /*!
 ** @file libgf/gf_cmd_list.c
-** @brief Module list.
+** @brief List the entries of the site.
 */
 
 #include <libgf/gf_countof.h>
 #include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
+#include <libgf/gf_array.h>
 #include <libgf/gf_path.h>
-#include <libgf/gf_cmd_config.h>
-#include <libgf/gf_system.h>
 #include <libgf/gf_site.h>
 #include <libgf/gf_cmd_list.h>
 
@@ -23,11 +22,10 @@ struct gf_cmd_list {
   gf_site*    site;
 };
 
-
-/*!
-** @brief
-**
-*/
+enum {
+  OPT_LIST_HELP,
+  OPT_LIST_RECURSIVE,
+};
 
 static const gf_cmd_base_info info_ = {
   .base = {
@@ -39,15 +37,27 @@ static const gf_cmd_base_info info_ = {
     .execute     = gf_cmd_list_execute,
   },
   .options = {
+    {
+      .key         = OPT_LIST_HELP,
+      .opt_short   = 'h',
+      .opt_long    = "help",
+      .opt_count   = 0,
+      .usage       = "-h, --help",
+      .description = "Show help.",
+    },
+    {
+      .key         = OPT_LIST_RECURSIVE,
+      .opt_short   = 'r',
+      .opt_long    = "recursive",
+      .opt_count   = 0,
+      .usage       = "-r, --recursive",
+      .description = "List the descendants of the entries too.",
+    },
     /* Terminate */
     GF_OPTION_NULL,
   },
 };
 
-/*!
-**
-*/
-
 static gf_status
 init(gf_cmd_base* cmd) {
   gf_validate(cmd);
@@ -73,6 +83,8 @@ gf_cmd_list_new(gf_cmd_base** cmd) {
   gf_status rc = 0;
   gf_cmd_base* tmp = NULL;
 
+  gf_validate(cmd);
+
   _(gf_malloc((gf_ptr*)&tmp, sizeof(gf_cmd_list)));
 
   rc = init(tmp);
@@ -87,32 +99,14 @@ gf_cmd_list_new(gf_cmd_base** cmd) {
   }
 
   *cmd = tmp;
-  
+
   return GF_SUCCESS;
 }
 
 void
 gf_cmd_list_free(gf_cmd_base* cmd) {
   if (cmd) {
-    gf_cmd_base_clear(GF_CMD_BASE_CAST(cmd));
-
-    if (cmd->root_path) {
-      gf_path_free(cmd->root_path);
-      cmd->root_path = NULL;
-    }
-    if (cmd->conf_path) {
-      gf_path_free(cmd->conf_path);
-      cmd->conf_path = NULL;
-    }
-    if (cmd->site_path) {
-      gf_path_free(cmd->site_path);
-      cmd->site_path = NULL;
-    }
-    if (cmd->src_path) {
-      gf_path_free(cmd->src_path);
-      cmd->src_path = NULL;
-    }
-
+    gf_cmd_base_clear(cmd);
     if (GF_CMD_LIST_CAST(cmd)->site) {
       gf_site_free(GF_CMD_LIST_CAST(cmd)->site);
       GF_CMD_LIST_CAST(cmd)->site = NULL;
@@ -123,18 +117,186 @@ gf_cmd_list_free(gf_cmd_base* cmd) {
 
 /* -------------------------------------------------------------------------- */
 
+static void
+list_show_help(const gf_cmd_base* cmd) {
+  gf_msg("usage: gf [options] list [--help] [--recursive] [path]");
+  gf_msg("");
+  gf_msg("  path  The directory of the entry relative to the source root.");
+  gf_msg("        The entries under the root entry are listed by default.");
+  gf_msg("");
+  if (cmd && cmd->args) {
+    gf_msg("Options:");
+    gf_msg("");
+    gf_args_print_help(cmd->args);
+  }
+  gf_msg("");
+}
+
+/*!
+** @brief Open the site.
+**
+** The site database is opened lazily, so that only the entries to be listed
+** are read. The site file is read if there is no database.
+*/
+
 static gf_status
-list_process(gf_cmd_list* cmd) {
+list_open_site(gf_cmd_list* cmd) {
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+
+  if (gf_path_file_exists(base->db_path)) {
+    _(gf_site_open(&cmd->site, base->db_path));
+  } else if (gf_path_file_exists(base->site_path)) {
+    _(gf_site_read_file(&cmd->site, base->site_path));
+  } else {
+    gf_raise(GF_E_OPEN, "The site has not been scanned yet. (%s)",
+             gf_path_get_string(base->site_path));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Find the deepest entry whose directory includes the path.
+*/
+
+static gf_status
+list_find_entry(gf_cmd_list* cmd, const gf_char* path, gf_entry** entry) {
+  gf_status rc = 0;
+  gf_string* full_path = NULL;
+  gf_array* lineage = NULL;
+  gf_any any = { 0 };
+
+  /* The directory is given with or without the separators at both ends */
+  _(gf_string_new(&full_path));
+  if (path[0] != GF_PATH_SEPARATOR_CHAR) {
+    rc = gf_string_set(full_path, GF_PATH_SEPARATOR);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_string_append(full_path, path);
+  }
+  if (rc == GF_SUCCESS &&
+      path[gf_strlen(path) - 1] != GF_PATH_SEPARATOR_CHAR) {
+    rc = gf_string_append(full_path, GF_PATH_SEPARATOR);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_new(&lineage);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_site_find_entries(cmd->site, gf_string_get(full_path), lineage);
+  }
+  if (rc == GF_SUCCESS && gf_array_size(lineage) > 0) {
+    rc = gf_array_get(lineage, gf_array_size(lineage) - 1, &any);
+  }
+  gf_array_free(lineage);
+  gf_string_free(full_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  if (!any.ptr) {
+    gf_raise(GF_E_PARAM, "The entry is not found. (%s)", path);
+  }
+  *entry = any.ptr;
+
+  return GF_SUCCESS;
+}
+
+static const gf_char*
+list_get_type_string(gf_entry_type type) {
+  switch (type) {
+  case GF_ENTRY_TYPE_SITE:     return "site";
+  case GF_ENTRY_TYPE_SECTION:  return "section";
+  case GF_ENTRY_TYPE_DOCUMENT: return "document";
+  case GF_ENTRY_TYPE_PROC:     return "proc";
+  case GF_ENTRY_TYPE_FILE:     return "file";
+  default:                     return "unknown";
+  }
+}
+
+static const gf_char*
+list_get_state_string(gf_entry_state state) {
+  switch (state) {
+  case GF_ENTRY_STATE_DRAFT:     return "draft";
+  case GF_ENTRY_STATE_PUBLISHED: return "published";
+  default:                       return "-";
+  }
+}
+
+/*!
+** @brief Print the children of the entry, one entry per line.
+**
+** Only the entries printed are read from the site database.
+*/
+
+static gf_status
+list_print_children(gf_entry* entry, gf_bool recursive) {
+  for (gf_size_t i = 0; i < gf_entry_count_children(entry); i++) {
+    gf_entry* child = NULL;
+    const gf_char* title = NULL;
+
+    _(gf_entry_get_child(entry, i, &child));
+    title = gf_entry_get_title_string(child);
+    gf_msg("%-9s %-8s %s  %s",
+           list_get_state_string(gf_entry_get_state(child)),
+           list_get_type_string(gf_entry_get_type(child)),
+           gf_entry_get_full_path_string(child),
+           gf_strnull(title) ? "" : title);
+    if (recursive) {
+      _(list_print_children(child, recursive));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+list_process(gf_cmd_list* cmd, const gf_char* path) {
+  gf_entry* entry = NULL;
+
   gf_validate(cmd);
-  
+
+  _(list_open_site(cmd));
+  if (gf_strnull(path)) {
+    _(gf_site_get_root_entry(cmd->site, &entry));
+    if (!entry) {
+      return GF_SUCCESS;
+    }
+  } else {
+    _(list_find_entry(cmd, path, &entry));
+  }
+  _(list_print_children(
+      entry, gf_args_is_specified(GF_CMD_BASE_CAST(cmd)->args,
+                                  OPT_LIST_RECURSIVE)));
+
   return GF_SUCCESS;
 }
 
 gf_status
 gf_cmd_list_execute(gf_cmd_base* cmd) {
+  gf_status rc = 0;
+  char* path = NULL;
+
   gf_validate(cmd);
 
-  _(list_process(GF_CMD_LIST_CAST(cmd)));
-  
+  _(gf_args_parse(cmd->args));
+  if (gf_args_is_specified(cmd->args, OPT_LIST_HELP)) {
+    list_show_help(cmd);
+    return GF_SUCCESS;
+  }
+  if (gf_args_remain(cmd->args) > 1) {
+    list_show_help(cmd);
+    gf_raise(GF_E_OPTION, "Invalid command.");
+  }
+  if (gf_path_is_empty(cmd->conf_path)) {
+    gf_raise(GF_E_COMMAND, "This path is not in a project directory.");
+  }
+  if (gf_args_remain(cmd->args) == 1) {
+    _(gf_args_consume(cmd->args, &path));
+  }
+  rc = list_process(GF_CMD_LIST_CAST(cmd), path);
+  gf_free(path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
   return GF_SUCCESS;
 }
@@ -11,6 +11,10 @@
 #include <libgf/gf_countof.h>
 #include <libgf/gf_memory.h>
 #include <libgf/gf_path.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_config.h>
+#include <libgf/gf_hash.h>
+#include <libgf/gf_thread.h>
 #include <libgf/gf_site.h>
 #include <libgf/gf_cmd_base.h>
 #include <libgf/gf_cmd_update.h>
@@ -23,7 +27,8 @@ struct gf_cmd_update {
 };
 
 enum {
-  OPT_BUILD_OPTIONS,
+  OPT_REHASH,
+  OPT_NO_CACHE,
 };
 
 static const gf_cmd_base_info info_ = {
@@ -36,6 +41,22 @@ static const gf_cmd_base_info info_ = {
     .execute     = gf_cmd_update_execute,
   },
   .options = {
+    {
+      .key         = OPT_REHASH,
+      .opt_short   = 'r',
+      .opt_long    = "rehash",
+      .opt_count   = 0,
+      .usage       = "-r, --rehash",
+      .description = "Compute the hash of every file even if it is unchanged.",
+    },
+    {
+      .key         = OPT_NO_CACHE,
+      .opt_short   = '\0',
+      .opt_long    = "no-cache",
+      .opt_count   = 0,
+      .usage       = "--no-cache",
+      .description = "Read every entry file instead of the entry cache.",
+    },
     /* Terminate */
     GF_OPTION_NULL,
   },
@@ -103,45 +124,403 @@ gf_cmd_update_free(gf_cmd_base* cmd) {
   }
 }
 
+gf_bool
+gf_cmd_update_site_exists(const gf_cmd_base* cmd) {
+  if (!cmd) {
+    return GF_FALSE;
+  }
+  return gf_path_file_exists(cmd->db_path) ||
+    gf_path_file_exists(cmd->site_path);
+}
+
+gf_status
+gf_cmd_update_read_site(const gf_cmd_base* cmd, gf_site** site) {
+  gf_validate(cmd);
+  gf_validate(site);
+
+  if (gf_path_file_exists(cmd->db_path)) {
+    if (gf_site_read_db(site, cmd->db_path) == GF_SUCCESS) {
+      return GF_SUCCESS;
+    }
+    gf_warn("Failed to read the site database; the site file is read.");
+  }
+  _(gf_site_read_file(site, cmd->site_path));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_update_write_site(
+  const gf_cmd_base* cmd, gf_site* site, const gf_site* prev) {
+  int ratio = 0;
+
+  gf_validate(cmd);
+  gf_validate(site);
+
+  /* 0 disables the journal */
+  ratio = gf_config_get_int("db.journal-ratio");
+  if (ratio < 0) {
+    gf_warn("Invalid 'db.journal-ratio' parameter (%d), using 0.", ratio);
+    ratio = 0;
+  }
+  _(gf_site_save_db(site, prev, cmd->db_path, (gf_size_t)ratio));
+  _(gf_site_write_file(site, cmd->site_path));
+
+  return GF_SUCCESS;
+}
+
 static gf_status
 update_read_site_file(gf_cmd_update* cmd) {
-  if (gf_path_file_exists(GF_CMD_BASE_CAST(cmd)->site_path)) {
-    _(gf_site_read_file(&cmd->site, GF_CMD_BASE_CAST(cmd)->site_path));
-  } else {
-    _(gf_site_new(&cmd->site));
+  gf_status rc = 0;
+
+  if (gf_cmd_update_site_exists(GF_CMD_BASE_CAST(cmd))) {
+    rc = gf_cmd_update_read_site(GF_CMD_BASE_CAST(cmd), &cmd->site);
+    if (rc == GF_SUCCESS) {
+      return GF_SUCCESS;
+    }
+    /* The site is rebuilt from scratch */
+    gf_warn("Failed to read the site file; all files are rehashed.");
   }
+  _(gf_site_new(&cmd->site));
+
   return GF_SUCCESS;
 }
 
-static gf_status
-update_scan_directory(gf_cmd_update* cmd) {
+static void
+update_log_scan_stats(const gf_file_info_scan_stats* stats) {
+  gf_debug("Walk: %.3f s with %zu thread(s); all hashed: %.3f s.",
+           (double)stats->walk_nsec / 1e9, stats->walkers,
+           (double)stats->total_nsec / 1e9);
+  gf_debug("Hash: %zu file(s) in %.3f s with %zu thread(s), %zu reused.",
+           stats->hashed, (double)stats->hash_nsec / 1e9, stats->hashers,
+           stats->reused);
+  gf_debug("Queue: %llu stall(s) for %.3f s, %llu starvation(s).",
+           (unsigned long long)stats->stalls,
+           (double)stats->stall_nsec / 1e9,
+           (unsigned long long)stats->starved);
+  gf_debug("Tree: %zu byte(s) reserved.", stats->arena_size);
+}
+
+/*!
+** @brief Scan the source directory.
+**
+** The file records of the previous site are passed to the scanner, so that
+** the files whose stat information is unchanged are not read again. The
+** files are fingerprinted with the algorithm of the `hash.algorithm'
+** parameter; the records hashed with the other algorithm are fingerprinted
+** again.
+*/
+
+gf_status
+gf_cmd_update_scan(
+  const gf_cmd_base* cmd, const gf_site* prev, gf_entry_cache* entry_cache,
+  gf_site** site) {
+  gf_status rc = 0;
+  gf_map* cache = NULL;
+  gf_file_info_scan_option option = { 0 };
+  gf_file_info_scan_stats stats = { 0 };
+  int threads = 0;
+  int hash_threads = 0;
+  int queue_depth = 0;
+  char* algorithm = NULL;
+
   gf_validate(cmd);
-  gf_validate(!gf_path_is_empty(GF_CMD_BASE_CAST(cmd)->src_path));
+  gf_validate(!gf_path_is_empty(cmd->src_path));
+  gf_validate(site);
+
+  threads = gf_config_get_int("threads");
+  if (threads < 0) {
+    gf_warn("Invalid 'threads' parameter (%d), using one per core.", threads);
+    threads = 0;
+  }
+  option.threads = gf_thread_resolve_count(threads);
+
+  hash_threads = gf_config_get_int("hash.threads");
+  if (hash_threads < 0) {
+    gf_warn("Invalid 'hash.threads' parameter (%d), using one per core.",
+            hash_threads);
+    hash_threads = 0;
+  }
+  option.hash_threads = gf_thread_resolve_count(hash_threads);
 
-  _(gf_site_scan(&cmd->site, GF_CMD_BASE_CAST(cmd)->src_path));
+  /* 0 means the default depth */
+  queue_depth = gf_config_get_int("hash.queue-size");
+  if (queue_depth < 0) {
+    gf_warn("Invalid 'hash.queue-size' parameter (%d), using default.",
+            queue_depth);
+    queue_depth = 0;
+  }
+  option.queue_depth = (gf_size_t)queue_depth;
+  option.stats = &stats;
+  gf_debug("Scanning with %zu thread(s), hashing with %zu thread(s).",
+           option.threads, option.hash_threads);
+
+  algorithm = gf_config_get_string("hash.algorithm");
+  if (!gf_strnull(algorithm)) {
+    option.hash = gf_hash_find(algorithm);
+    if (!option.hash) {
+      gf_warn("Unknown 'hash.algorithm' parameter (%s), using %s.",
+              algorithm, gf_hash_get_default()->name);
+    }
+  }
+  if (algorithm) {
+    gf_free(algorithm);
+  }
+  if (!option.hash) {
+    option.hash = gf_hash_get_default();
+  }
+  gf_debug("Hashing files with %s.", option.hash->name);
+
+  if (prev) {
+    _(gf_map_new(&cache));
+    rc = gf_site_collect_file_info(prev, cache);
+    if (rc != GF_SUCCESS) {
+      gf_map_free(cache);
+      gf_throw(rc);
+    }
+    gf_debug("%zu file record(s) in the previous site.", gf_map_size(cache));
+    option.cache = cache;
+    option.cache_time = gf_site_get_scan_time(prev);
+  }
+  gf_hash_reset_stats();
+  rc = gf_site_scan_with_option(site, cmd->src_path, &option, entry_cache);
+  gf_map_free(cache);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  gf_hash_log_stats();
+  update_log_scan_stats(&stats);
+  if (entry_cache) {
+    gf_debug("Entry cache: %zu hit(s), %zu miss(es).",
+             gf_entry_cache_count_hits(entry_cache),
+             gf_entry_cache_count_misses(entry_cache));
+  }
   
   return GF_SUCCESS;
 }
 
 static gf_status
-update_write_file(gf_cmd_update* cmd) {
+update_make_entry_cache_path(const gf_cmd_base* cmd, gf_path** path) {
+  _(gf_path_append_string(path, cmd->conf_path, GF_ENTRY_CACHE_FILE_NAME));
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_update_read_entry_cache(
+  const gf_cmd_base* cmd, gf_bool read, gf_entry_cache** cache) {
+  gf_status rc = 0;
+  gf_entry_cache* tmp = NULL;
+  gf_path* path = NULL;
+
+  gf_validate(cmd);
+  gf_validate(cache);
+
+  _(gf_entry_cache_new(&tmp));
+  if (read) {
+    rc = update_make_entry_cache_path(cmd, &path);
+    if (rc != GF_SUCCESS) {
+      gf_entry_cache_free(tmp);
+      gf_throw(rc);
+    }
+    if (gf_path_file_exists(path) &&
+        gf_entry_cache_read_file(tmp, path) != GF_SUCCESS) {
+      /* The cache is rebuilt from scratch */
+      gf_warn("Failed to read the entry cache; all entry files are read.");
+      gf_entry_cache_free(tmp);
+      rc = gf_entry_cache_new(&tmp);
+    }
+    gf_path_free(path);
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
+  }
+  *cache = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_update_write_entry_cache(
+  const gf_cmd_base* cmd, const gf_entry_cache* cache) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+
+  gf_validate(cmd);
+  gf_validate(cache);
+
+  _(update_make_entry_cache_path(cmd, &path));
+  rc = gf_entry_cache_write_file(cache, path);
+  gf_path_free(path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Apply `hash.mmap-size' to the files hashed by the update.
+**
+** The sources are not expected to be written during `gf update', so the
+** large files are mapped into memory.
+*/
+
+static void
+update_set_mmap_threshold(void) {
+  int mmap_size = 0;
+
+  /* Files of this size or larger are memory-mapped (0: default) */
+  mmap_size = gf_config_get_int("hash.mmap-size");
+  if (mmap_size < 0) {
+    gf_warn("Invalid 'hash.mmap-size' parameter (%d), using default.",
+            mmap_size);
+    mmap_size = 0;
+  }
+  if (mmap_size == 0) {
+    mmap_size = GF_HASH_MMAP_THRESHOLD_DEFAULT;
+  }
+  gf_hash_set_mmap_threshold((gf_64u)mmap_size);
+}
+
+/*!
+** @brief Scan the source directory reusing the records of the site file.
+**
+** The records are not reused if `--rehash' is specified. The previous site
+** is kept to compute the changes. The entry cache is ignored and rebuilt if
+** `--no-cache' is specified.
+*/
+
+static gf_status
+update_scan_directory(gf_cmd_update* cmd, gf_site** prev) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_entry_cache* cache = NULL;
+  gf_bool rehash = GF_FALSE;
+  gf_bool no_cache = GF_FALSE;
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+
+  gf_validate(cmd);
+  gf_validate(prev);
+
+  rehash = gf_args_is_specified(base->args, OPT_REHASH);
+  no_cache = gf_args_is_specified(base->args, OPT_NO_CACHE);
+  update_set_mmap_threshold();
+  _(gf_cmd_update_read_entry_cache(base, !no_cache, &cache));
+  rc = gf_cmd_update_scan(base, rehash ? NULL : cmd->site, cache, &site);
+  if (rc == GF_SUCCESS) {
+    rc = gf_cmd_update_write_entry_cache(base, cache);
+  }
+  gf_entry_cache_free(cache);
+  if (rc != GF_SUCCESS) {
+    gf_site_free(site);
+    gf_throw(rc);
+  }
+  *prev = cmd->site;
+  cmd->site = site;
+
+  return GF_SUCCESS;
+}
+
+static void
+update_log_change_count(
+  const gf_site_change_set* changes, gf_site_diff_target target,
+  const char* label) {
+  gf_msg("%s: %zu added, %zu removed, %zu modified, %zu moved.", label,
+         gf_site_change_set_count(changes, target, GF_SITE_DIFF_ADDED),
+         gf_site_change_set_count(changes, target, GF_SITE_DIFF_REMOVED),
+         gf_site_change_set_count(changes, target, GF_SITE_DIFF_MODIFIED),
+         gf_site_change_set_count(changes, target, GF_SITE_DIFF_MOVED));
+}
+
+static void
+update_log_changes(const gf_site_change_set* changes) {
+  static const char* labels[] = {
+    [GF_SITE_DIFF_ADDED]    = "Added",
+    [GF_SITE_DIFF_REMOVED]  = "Removed",
+    [GF_SITE_DIFF_MODIFIED] = "Modified",
+    [GF_SITE_DIFF_MOVED]    = "Moved",
+  };
+
+  for (gf_size_t i = 0; i < gf_site_change_set_size(changes); i++) {
+    const gf_site_diff_item* item = NULL;
+    const char* target = NULL;
+
+    if (gf_site_change_set_get(changes, i, &item) != GF_SUCCESS) {
+      break;
+    }
+    target = item->target == GF_SITE_DIFF_ENTRY ? "entry" : "file";
+    if (item->old_path) {
+      gf_debug("%s %s: %s -> %s",
+               labels[item->type], target, item->old_path, item->path);
+    } else {
+      gf_debug("%s %s: %s", labels[item->type], target, item->path);
+    }
+  }
+  update_log_change_count(changes, GF_SITE_DIFF_ENTRY, "Entries");
+  update_log_change_count(changes, GF_SITE_DIFF_FILE, "Files");
+}
+
+/*!
+** @brief Write the changes since the last update to the `changes file'.
+**
+** The build and deploy steps read it to process only the changed files.
+*/
+
+static gf_status
+update_write_changes(gf_cmd_update* cmd, const gf_site* prev) {
+  gf_status rc = 0;
+  gf_site_change_set* changes = NULL;
+  gf_path* path = NULL;
+
+  gf_validate(cmd);
+  gf_validate(prev);
+
+  _(gf_site_diff(&changes, prev, cmd->site));
+  update_log_changes(changes);
+
+  rc = gf_path_append_string(
+    &path, GF_CMD_BASE_CAST(cmd)->conf_path, GF_CHANGES_FILE_NAME);
+  if (rc == GF_SUCCESS) {
+    rc = gf_site_change_set_write_file(changes, path);
+  }
+  gf_path_free(path);
+  gf_site_change_set_free(changes);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+update_write_file(gf_cmd_update* cmd, const gf_site* prev) {
   gf_validate(cmd);
 
-  _(gf_site_write_file(cmd->site, GF_CMD_BASE_CAST(cmd)->site_path));
+  _(gf_cmd_update_write_site(GF_CMD_BASE_CAST(cmd), cmd->site, prev));
   
   return GF_SUCCESS;
 }
 
 static gf_status
 update_process(gf_cmd_update* cmd) {
+  gf_status rc = 0;
+  gf_site* prev = NULL;
+
   gf_validate(cmd);
 
   /* Read the existing site file */
   _(update_read_site_file(cmd));
   /* Scan directory */
-  _(update_scan_directory(cmd));
-  /* Write site file */
-  _(update_write_file(cmd));
+  _(update_scan_directory(cmd, &prev));
+  /* Write site file and the changes */
+  rc = update_write_file(cmd, prev);
+  if (rc == GF_SUCCESS) {
+    rc = update_write_changes(cmd, prev);
+  }
+  gf_site_free(prev);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
   
   return GF_SUCCESS;
 }
@@ -150,6 +529,8 @@ gf_status
 gf_cmd_update_execute(gf_cmd_base* cmd) {
   gf_validate(cmd);
 
+  _(gf_args_parse(cmd->args));
+
   gf_msg("Update the project directory ...");
 
   _(update_process(GF_CMD_UPDATE_CAST(cmd)));
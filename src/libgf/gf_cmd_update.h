@@ -16,6 +16,7 @@
 #include <libgf/gf_datatype.h>
 #include <libgf/gf_error.h>
 #include <libgf/gf_cmd_base.h>
+#include <libgf/gf_site.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,11 +38,88 @@ extern void gf_cmd_update_free(gf_cmd_base* cmd);
 /*!
 ** @brief Execute the update process.
 **
+** The site file is written, and the changes since the last update are
+** written to `.gf/changes.xml'.
+**
 ** @param [in] cmd Command object
 */
 
 extern gf_status gf_cmd_update_execute(gf_cmd_base* cmd);
 
+/*!
+** @brief Scan the source directory of a command with the configured options.
+**
+** The `threads' and `hash.*' parameters are applied to the scan, except
+** `hash.mmap-size', which is left to the command (see gf_hash_file_with()).
+**
+** @param [in]  cmd         Command object whose src_path is scanned
+** @param [in]  prev        The previous site whose hashes are reused (may be
+**                          NULL)
+** @param [in]  entry_cache The cache of the entry files (may be NULL)
+** @param [out] site        The new site
+*/
+
+extern gf_status gf_cmd_update_scan(
+  const gf_cmd_base* cmd, const gf_site* prev, gf_entry_cache* entry_cache,
+  gf_site** site);
+
+/*!
+** @brief Create the entry cache of a command.
+**
+** The cache file in the configuration directory is read if @a read is
+** GF_TRUE. The cache is empty if the file does not exist or is broken.
+**
+** @param [in]  cmd   Command object
+** @param [in]  read  GF_TRUE to read the cache file
+** @param [out] cache The new cache
+*/
+
+extern gf_status gf_cmd_update_read_entry_cache(
+  const gf_cmd_base* cmd, gf_bool read, gf_entry_cache** cache);
+
+/*!
+** @brief Write the entry cache to the cache file of a command.
+*/
+
+extern gf_status gf_cmd_update_write_entry_cache(
+  const gf_cmd_base* cmd, const gf_entry_cache* cache);
+
+/*!
+** @brief Check whether the site database or the site file of a command exists.
+*/
+
+extern gf_bool gf_cmd_update_site_exists(const gf_cmd_base* cmd);
+
+/*!
+** @brief Read the site of a command.
+**
+** The site database is read if it exists, and the site file is read if the
+** database does not exist or is broken.
+**
+** @param [in]  cmd  Command object
+** @param [out] site The new site
+*/
+
+extern gf_status gf_cmd_update_read_site(
+  const gf_cmd_base* cmd, gf_site** site);
+
+/*!
+** @brief Write the site of a command to the site database and the site file.
+**
+** The changes from @a prev are appended to the journal of the database,
+** which is compacted when it grows over the `db.journal-ratio' parameter
+** (percent of the database). The site file is still written as a whole
+** because the stylesheets read it.
+**
+** @param [in]      cmd  Command object
+** @param [in, out] site The site
+** @param [in]      prev The site read from or last saved to the database, or
+**                       NULL if @a site itself is (see gf_site_save_db())
+*/
+
+extern gf_status gf_cmd_update_write_site(
+  const gf_cmd_base* cmd, gf_site* site, const gf_site* prev);
+
 #ifdef __cplusplus
 }
 #endif
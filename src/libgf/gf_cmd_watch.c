@@ -0,0 +1,634 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_cmd_watch.c
+** @brief Update and build the site continuously.
+*/
+#include <string.h>
+
+#include <libgf/gf_countof.h>
+#include <libgf/gf_memory.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_array.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_path.h>
+#include <libgf/gf_config.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_hash.h>
+#include <libgf/gf_site.h>
+#include <libgf/gf_watch.h>
+#include <libgf/gf_cmd_base.h>
+#include <libgf/gf_cmd_update.h>
+#include <libgf/gf_cmd_build.h>
+#include <libgf/gf_cmd_watch.h>
+
+#include "gf_local.h"
+
+/* The default quiet period which ends a burst of changes (in ms) */
+#define WATCH_DEBOUNCE_DEFAULT 30
+
+/* A burst is cut off after this period even if the changes continue (in ms) */
+#define WATCH_BURST_LIMIT 1000
+
+struct gf_cmd_watch {
+  gf_cmd_base     base;
+  gf_site*        site;         ///< The resident site
+  gf_entry_cache* entry_cache;  ///< The resident entry cache
+  gf_watch*       watch;
+  gf_size_t       src_root;     ///< The index of the source tree in the watch
+  gf_size_t       style_root;   ///< The index of the style tree in the watch
+  gf_map*         changes;      ///< The changed source files and their flags
+  gf_map*         styles;       ///< The changed stylesheets
+  gf_bool         rescan;       ///< The site has to be scanned again
+};
+
+enum {
+  OPT_WATCH_OPTIONS,
+};
+
+static const gf_cmd_base_info info_ = {
+  .base = {
+    .name        = "watch",
+    .description = "Update and build the site whenever a file is changed",
+    .args        = NULL,
+    .create      = gf_cmd_watch_new,
+    .free        = gf_cmd_watch_free,
+    .execute     = gf_cmd_watch_execute,
+  },
+  .options = {
+    /* Terminate */
+    GF_OPTION_NULL,
+  },
+};
+
+/*!
+**
+*/
+
+static gf_status
+init(gf_cmd_base* cmd) {
+  gf_validate(cmd);
+
+  _(gf_cmd_base_init(cmd));
+
+  GF_CMD_WATCH_CAST(cmd)->site        = NULL;
+  GF_CMD_WATCH_CAST(cmd)->entry_cache = NULL;
+  GF_CMD_WATCH_CAST(cmd)->watch       = NULL;
+  GF_CMD_WATCH_CAST(cmd)->src_root    = 0;
+  GF_CMD_WATCH_CAST(cmd)->style_root  = 0;
+  GF_CMD_WATCH_CAST(cmd)->changes     = NULL;
+  GF_CMD_WATCH_CAST(cmd)->styles      = NULL;
+  GF_CMD_WATCH_CAST(cmd)->rescan      = GF_FALSE;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+prepare(gf_cmd_base* cmd) {
+  gf_validate(cmd);
+
+  _(gf_cmd_base_set_info(cmd, &info_));
+  _(gf_map_new(&GF_CMD_WATCH_CAST(cmd)->changes));
+  _(gf_map_new(&GF_CMD_WATCH_CAST(cmd)->styles));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_watch_new(gf_cmd_base** cmd) {
+  gf_status rc = 0;
+  gf_cmd_base* tmp = NULL;
+
+  gf_validate(cmd);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(gf_cmd_watch)));
+
+  rc = init(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    return rc;
+  }
+  rc = prepare(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_cmd_watch_free(tmp);
+    return rc;
+  }
+
+  *cmd = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_cmd_watch_free(gf_cmd_base* cmd) {
+  if (cmd) {
+    gf_cmd_base_clear(GF_CMD_BASE_CAST(cmd));
+
+    if (GF_CMD_WATCH_CAST(cmd)->watch) {
+      gf_watch_free(GF_CMD_WATCH_CAST(cmd)->watch);
+      GF_CMD_WATCH_CAST(cmd)->watch = NULL;
+    }
+    if (GF_CMD_WATCH_CAST(cmd)->site) {
+      gf_site_free(GF_CMD_WATCH_CAST(cmd)->site);
+      GF_CMD_WATCH_CAST(cmd)->site = NULL;
+    }
+    if (GF_CMD_WATCH_CAST(cmd)->entry_cache) {
+      gf_entry_cache_free(GF_CMD_WATCH_CAST(cmd)->entry_cache);
+      GF_CMD_WATCH_CAST(cmd)->entry_cache = NULL;
+    }
+    if (GF_CMD_WATCH_CAST(cmd)->changes) {
+      gf_map_free(GF_CMD_WATCH_CAST(cmd)->changes);
+      GF_CMD_WATCH_CAST(cmd)->changes = NULL;
+    }
+    if (GF_CMD_WATCH_CAST(cmd)->styles) {
+      gf_map_free(GF_CMD_WATCH_CAST(cmd)->styles);
+      GF_CMD_WATCH_CAST(cmd)->styles = NULL;
+    }
+    gf_free(cmd);
+  }
+}
+
+static double
+watch_elapsed_msec(gf_64u start) {
+  return (double)(gf_datetime_get_monotonic_ns() - start) / 1e6;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Scan the source directory and build the whole site.
+**
+** The records of the resident site (or of the site file at the start) are
+** reused, so only the changed files are hashed. The entry files are read
+** through the resident entry cache.
+*/
+
+static gf_status
+watch_build_site(gf_cmd_watch* cmd) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+
+  _(gf_cmd_update_scan(base, cmd->site, cmd->entry_cache, &site));
+  /* The old site is the base of the journal */
+  rc = gf_cmd_update_write_site(base, site, cmd->site);
+  if (cmd->site) {
+    gf_site_free(cmd->site);
+  }
+  cmd->site = site;
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  _(gf_cmd_update_write_entry_cache(base, cmd->entry_cache));
+
+  rc = gf_cmd_build_site(base, cmd->site, NULL);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_read_site_file(gf_cmd_watch* cmd) {
+  _(gf_cmd_update_read_entry_cache(
+      GF_CMD_BASE_CAST(cmd), GF_TRUE, &cmd->entry_cache));
+
+  if (gf_cmd_update_site_exists(GF_CMD_BASE_CAST(cmd))) {
+    if (gf_cmd_update_read_site(GF_CMD_BASE_CAST(cmd), &cmd->site) !=
+        GF_SUCCESS) {
+      /* All files are hashed */
+      gf_warn("Failed to read the site file; all files are rehashed.");
+      cmd->site = NULL;
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Check whether the path is under the output directories
+**
+** They may be placed in the source directory, and the changes made by the
+** build must not trigger another build.
+*/
+
+static gf_bool
+watch_is_output_path(const gf_cmd_watch* cmd, const gf_char* path) {
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+  const gf_path* outputs[] = { base->dst_path, base->build_path };
+  const gf_char* src = gf_path_get_string(base->src_path);
+  gf_size_t src_len = gf_strlen(src);
+
+  for (gf_size_t i = 0; i < gf_countof(outputs); i++) {
+    const gf_char* dst = gf_path_get_string(outputs[i]);
+    gf_size_t len = 0;
+
+    if (gf_strnull(dst) || strncmp(dst, src, src_len)) {
+      continue;
+    }
+    /* The output path relative to the source directory */
+    dst += src_len;
+    len = gf_strlen(dst);
+    if (len > 0 && !strncmp(path, dst, len) &&
+        (path[len] == '\0' || path[len] == GF_PATH_SEPARATOR_CHAR)) {
+      return GF_TRUE;
+    }
+  }
+
+  return GF_FALSE;
+}
+
+static gf_status
+watch_add_change(
+  gf_size_t root, const gf_char* path, gf_32u flags, gf_ptr data) {
+  gf_cmd_watch* cmd = data;
+  gf_map* map = NULL;
+  gf_any any = { 0 };
+
+  if (flags & GF_WATCH_OVERFLOW) {
+    gf_warn("Some changes were lost; the site is scanned again.");
+    cmd->rescan = GF_TRUE;
+    return GF_SUCCESS;
+  }
+  if (root == cmd->style_root) {
+    map = cmd->styles;
+  } else if (watch_is_output_path(cmd, path)) {
+    return GF_SUCCESS;
+  } else if (flags & GF_WATCH_DIRECTORY) {
+    /* The directory may contain entries */
+    cmd->rescan = GF_TRUE;
+    return GF_SUCCESS;
+  } else {
+    map = cmd->changes;
+  }
+  if (gf_map_find(map, path, &any)) {
+    flags |= any.u32;
+  }
+  _(gf_map_set(map, path, (gf_any){ .u32 = flags }));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Wait for a burst of changes.
+**
+** The burst ends when no change is notified for `watch.debounce'
+** milliseconds, so a file saved in several writes is processed once.
+*/
+
+static gf_status
+watch_wait_changes(gf_cmd_watch* cmd, gf_int debounce) {
+  gf_size_t count = 0;
+  gf_64u start = 0;
+
+  _(gf_watch_wait(cmd->watch, -1, watch_add_change, cmd, &count));
+  start = gf_datetime_get_monotonic_ns();
+  while (count > 0 && watch_elapsed_msec(start) < WATCH_BURST_LIMIT) {
+    _(gf_watch_wait(cmd->watch, debounce, watch_add_change, cmd, &count));
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct watch_context {
+  gf_cmd_watch* cmd;
+  gf_array*     documents;    ///< The entries to be transformed
+  gf_array*     sections;     ///< The sections to be transformed
+  gf_array*     statics;      ///< The entries whose static files are copied
+  gf_bool       site_changed; ///< The site file has to be written
+} watch_context;
+
+static gf_status
+watch_add_entry(gf_array* entries, gf_entry* entry) {
+  for (gf_size_t i = 0; i < gf_array_size(entries); i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entries, i, &any));
+    if (any.ptr == entry) {
+      return GF_SUCCESS;
+    }
+  }
+  _(gf_array_add(entries, (gf_any){ .ptr = entry }));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the sections including the file, whose index pages list it
+*/
+
+static gf_status
+watch_add_sections(watch_context* ctxt, const gf_char* path) {
+  gf_status rc = 0;
+  gf_array* lineage = NULL;
+
+  _(gf_array_new(&lineage));
+  rc = gf_site_find_entries(ctxt->cmd->site, path, lineage);
+  for (gf_size_t i = 0; rc == GF_SUCCESS && i < gf_array_size(lineage); i++) {
+    gf_any any = { 0 };
+
+    rc = gf_array_get(lineage, i, &any);
+    if (rc == GF_SUCCESS && gf_entry_is_section(any.ptr)) {
+      rc = watch_add_entry(ctxt->sections, any.ptr);
+    }
+  }
+  gf_array_free(lineage);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_apply_change(const gf_char* key, gf_any value, gf_ptr data) {
+  watch_context* ctxt = data;
+  gf_cmd_watch* cmd = ctxt->cmd;
+  gf_entry* entry = NULL;
+  gf_site_change change = GF_SITE_CHANGE_NONE;
+
+  (void)value;
+
+  _(gf_site_update_file(
+      cmd->site, GF_CMD_BASE_CAST(cmd)->src_path, key, &entry, &change));
+  switch (change) {
+  case GF_SITE_CHANGE_STRUCTURE:
+    cmd->rescan = GF_TRUE;
+    break;
+  case GF_SITE_CHANGE_ENTRY:
+    gf_debug("Entry changed: %s", key);
+    ctxt->site_changed = GF_TRUE;
+    if (gf_site_get_file_role(entry, key) == GF_SITE_FILE_DOCUMENT) {
+      _(watch_add_entry(ctxt->documents, entry));
+    }
+    _(watch_add_sections(ctxt, key));
+    break;
+  case GF_SITE_CHANGE_FILE:
+    gf_debug("File changed: %s", key);
+    ctxt->site_changed = GF_TRUE;
+    if (gf_site_get_file_role(entry, key) == GF_SITE_FILE_STATIC) {
+      _(watch_add_entry(ctxt->statics, entry));
+    }
+    break;
+  default:
+    break;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the entries processed by the changed stylesheets.
+**
+** A stylesheet named after a method (`<method>.xsl') affects the entries of
+** the method. Any other file, such as an included stylesheet, may affect all
+** the entries.
+*/
+
+static gf_status
+watch_collect_style_entries(watch_context* ctxt, gf_entry* entry) {
+  const gf_char* method = NULL;
+  gf_bool all = GF_FALSE;
+
+  method = gf_entry_get_method_string(entry);
+  all = gf_map_find(ctxt->cmd->styles, "", NULL);
+  if (!gf_strnull(method) && !all) {
+    gf_char name[1024] = { 0 };
+
+    snprintf(name, sizeof(name), GF_PATH_SEPARATOR "%s.xsl", method);
+    all = gf_map_find(ctxt->cmd->styles, name, NULL);
+  }
+  if (all && gf_entry_is_document(entry)) {
+    _(watch_add_entry(ctxt->documents, entry));
+  } else if (all && gf_entry_is_section(entry)) {
+    _(watch_add_entry(ctxt->sections, entry));
+  }
+  for (gf_size_t i = 0; i < gf_entry_count_children(entry); i++) {
+    gf_entry* child = NULL;
+
+    _(gf_entry_get_child(entry, i, &child));
+    _(watch_collect_style_entries(ctxt, child));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_classify_style(const gf_char* key, gf_any value, gf_ptr data) {
+  gf_bool* known = data;
+
+  (void)value;
+
+  if (!gf_site_get_style_method(key, NULL, 0)) {
+    *known = GF_FALSE;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_apply_styles(watch_context* ctxt) {
+  gf_cmd_watch* cmd = ctxt->cmd;
+  gf_entry* root = NULL;
+  gf_bool known = GF_TRUE;
+
+  if (gf_map_size(cmd->styles) == 0) {
+    return GF_SUCCESS;
+  }
+  _(gf_map_foreach(cmd->styles, watch_classify_style, &known));
+  if (!known) {
+    /* "" stands for all the stylesheets */
+    _(gf_map_set(cmd->styles, "", (gf_any){ .u32 = 0 }));
+  }
+  _(gf_site_get_root_entry(cmd->site, &root));
+  if (root) {
+    _(watch_collect_style_entries(ctxt, root));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_process_entries(gf_cmd_watch* cmd, gf_array* entries, gf_bool statics) {
+  gf_status rc = 0;
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+  gf_xslt_cache* cache = NULL;
+
+  /* The stylesheets are watched, so they are compiled again for each burst */
+  if (!statics) {
+    _(gf_xslt_cache_new(&cache));
+  }
+  for (gf_size_t i = 0; i < gf_array_size(entries); i++) {
+    gf_any any = { 0 };
+
+    rc = gf_array_get(entries, i, &any);
+    if (rc != GF_SUCCESS) {
+      break;
+    }
+    if (statics) {
+      rc = gf_cmd_build_copy_static_file(base, any.ptr);
+    } else {
+      rc = gf_cmd_build_process_entry(base, any.ptr, cache);
+    }
+    if (rc != GF_SUCCESS) {
+      /* Keep watching; the entry is processed again when it is fixed */
+      gf_warn("Failed to build %s.", gf_entry_get_full_path_string(any.ptr));
+      rc = GF_SUCCESS;
+    }
+  }
+  gf_xslt_cache_free(cache);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Apply a burst of changes to the site and the output.
+**
+** The documents are transformed first, since they do not depend on the site
+** file. Then the site file is written, and the sections are transformed with
+** it.
+*/
+
+static gf_status
+watch_apply_changes(gf_cmd_watch* cmd, watch_context* ctxt) {
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+
+  if (!cmd->rescan) {
+    _(gf_map_foreach(cmd->changes, watch_apply_change, ctxt));
+  }
+  if (cmd->rescan) {
+    gf_msg("Scanning the source directory again ...");
+    _(watch_build_site(cmd));
+    return GF_SUCCESS;
+  }
+  _(watch_apply_styles(ctxt));
+
+  _(watch_process_entries(cmd, ctxt->statics, GF_TRUE));
+  _(watch_process_entries(cmd, ctxt->documents, GF_FALSE));
+  if (ctxt->site_changed) {
+    _(gf_cmd_update_write_site(base, cmd->site, NULL));
+  }
+  _(watch_process_entries(cmd, ctxt->sections, GF_FALSE));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_process_changes(gf_cmd_watch* cmd) {
+  gf_status rc = 0;
+  watch_context ctxt = { 0 };
+  gf_64u start = 0;
+
+  start = gf_datetime_get_monotonic_ns();
+
+  ctxt.cmd = cmd;
+  rc = gf_array_new(&ctxt.documents);
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_new(&ctxt.sections);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_new(&ctxt.statics);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = watch_apply_changes(cmd, &ctxt);
+  }
+  if (rc == GF_SUCCESS) {
+    gf_msg("%zu file(s) changed; built %zu document(s) and %zu section(s) "
+           "in %.1f ms.",
+           gf_map_size(cmd->changes) + gf_map_size(cmd->styles),
+           gf_array_size(ctxt.documents), gf_array_size(ctxt.sections),
+           watch_elapsed_msec(start));
+  }
+  gf_array_free(ctxt.documents);
+  gf_array_free(ctxt.sections);
+  gf_array_free(ctxt.statics);
+
+  (void)gf_map_clear(cmd->changes);
+  (void)gf_map_clear(cmd->styles);
+  cmd->rescan = GF_FALSE;
+
+  gf_throw(rc);
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static gf_status
+watch_start(gf_cmd_watch* cmd) {
+  const gf_cmd_base* base = GF_CMD_BASE_CAST(cmd);
+
+  _(gf_watch_new(&cmd->watch));
+  _(gf_watch_add_tree(cmd->watch, base->src_path, &cmd->src_root));
+  _(gf_watch_add_tree(cmd->watch, base->style_path, &cmd->style_root));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_process(gf_cmd_watch* cmd) {
+  gf_status rc = 0;
+  gf_int debounce = 0;
+  gf_64u start = 0;
+
+  gf_validate(cmd);
+
+  debounce = gf_config_get_int("watch.debounce");
+  if (debounce <= 0) {
+    if (debounce < 0) {
+      gf_warn("Invalid 'watch.debounce' parameter (%d), using default.",
+              debounce);
+    }
+    debounce = WATCH_DEBOUNCE_DEFAULT;
+  }
+
+  /*
+   * The trees are watched before the first build, so that the changes made
+   * during the build are queued and picked up by the first debounce cycle.
+   */
+  _(gf_cmd_build_prepare(GF_CMD_BASE_CAST(cmd)));
+  /* The watched files may be truncated while they are hashed */
+  gf_hash_set_mmap_threshold(GF_HASH_MMAP_THRESHOLD_NEVER);
+  _(watch_start(cmd));
+
+  /* Build the site once, which is kept in memory */
+  start = gf_datetime_get_monotonic_ns();
+  _(watch_read_site_file(cmd));
+  _(watch_build_site(cmd));
+  gf_msg("Built the site in %.1f ms.", watch_elapsed_msec(start));
+
+  gf_msg("Watching %s ...",
+         gf_path_get_string(GF_CMD_BASE_CAST(cmd)->src_path));
+  for (;;) {
+    _(watch_wait_changes(cmd, debounce));
+    rc = watch_process_changes(cmd);
+    if (rc != GF_SUCCESS) {
+      gf_warn("Failed to apply the changes; waiting for the next change.");
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_cmd_watch_execute(gf_cmd_base* cmd) {
+  gf_validate(cmd);
+
+  _(gf_args_parse(cmd->args));
+
+  gf_msg("Watching the project directory ...");
+
+  _(watch_process(GF_CMD_WATCH_CAST(cmd)));
+
+  return GF_SUCCESS;
+}
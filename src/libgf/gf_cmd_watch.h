@@ -0,0 +1,52 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_cmd_watch.h
+** @brief Update and build the site continuously.
+*/
+#ifndef LIBGF_GF_CMD_WATCH_H
+#define LIBGF_GF_CMD_WATCH_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_cmd_base.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gf_cmd_watch gf_cmd_watch;
+
+#define GF_CMD_WATCH_CAST(cmd) ((gf_cmd_watch*)(cmd))
+
+/*!
+** @brief Create a new watch command object.
+**
+** @param [out] cmd The pointer to the new watch command object
+*/
+
+extern gf_status gf_cmd_watch_new(gf_cmd_base** cmd);
+extern void gf_cmd_watch_free(gf_cmd_base* cmd);
+
+/*!
+** @brief Execute the watch process.
+**
+** The site is updated and built once, and then the changes of the source
+** files and the stylesheets are applied until the process is interrupted.
+**
+** @param [in] cmd Command object
+*/
+
+extern gf_status gf_cmd_watch_execute(gf_cmd_base* cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_CMD_WATCH_H */
@@ -41,21 +41,27 @@ config_doc_set_default_params(xmlNodePtr root) {
     xmlChar* key;
     xmlChar* value;
   } params[] = {
-    { X_("threads"),         X_("0")                          },
-    { X_("site.title"),      X_("My Awesome Website")         },
-    { X_("site.author"),     X_("John Due")                   },
-    { X_("site.email"),      X_("john@example.com")           },
-    { X_("site.pub-path"),   X_("pub")                        },
-    { X_("site.src-path"),   X_("src")                        },
-    { X_("site.style-path"), X_("..\\etc\\docbook\\book.xsl") },
-    { X_("site.data"),       X_("data")                       },
-    { X_("http.host"),       X_("localhost")                  },
-    { X_("http.port"),       X_("8080")                       },
-    { X_("http.root"),       X_("/")                          },
-    { X_("http.url"),        X_("example.com")                },
-    { X_("remote.scp.host"), X_("example.com")                },
-    { X_("remote.scp.port"), X_("22")                         },
-    { X_("remote.scp.root"), X_("/")                          },
+    { X_("threads"),          X_("0")                          },
+    { X_("db.journal-ratio"), X_("50")                         },
+    { X_("hash.algorithm"),   X_("fp128")                      },
+    { X_("hash.mmap-size"),   X_("4194304")                    },
+    { X_("hash.threads"),     X_("0")                          },
+    { X_("hash.queue-size"),  X_("1024")                       },
+    { X_("site.title"),       X_("My Awesome Website")         },
+    { X_("site.author"),      X_("John Due")                   },
+    { X_("site.email"),       X_("john@example.com")           },
+    { X_("site.pub-path"),    X_("pub")                        },
+    { X_("site.src-path"),    X_("src")                        },
+    { X_("site.style-path"),  X_("..\\etc\\docbook\\book.xsl") },
+    { X_("site.data"),        X_("data")                       },
+    { X_("watch.debounce"),   X_("30")                         },
+    { X_("http.host"),        X_("localhost")                  },
+    { X_("http.port"),        X_("8080")                       },
+    { X_("http.root"),        X_("/")                          },
+    { X_("http.url"),         X_("example.com")                },
+    { X_("remote.scp.host"),  X_("example.com")                },
+    { X_("remote.scp.port"),  X_("22")                         },
+    { X_("remote.scp.root"),  X_("/")                          },
   };
   
   gf_validate(root);
@@ -6,7 +6,11 @@
 ** @file libgf/gf_datetime.c
 ** @brief Datetime management
 */
+#if defined(_WIN32)
+#include <windows.h>
+#endif
 #include <ctype.h>
+#include <errno.h>
 #include <time.h>
 
 #include <libgf/gf_memory.h>
@@ -27,6 +31,58 @@ gf_datetime_get_current_time(gf_datetime* datetime) {
   return GF_SUCCESS;
 }
 
+gf_64u
+gf_datetime_get_monotonic_ns(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER count = { 0 };
+  static LARGE_INTEGER freq = { 0 };
+
+  if (freq.QuadPart == 0) {
+    QueryPerformanceFrequency(&freq);
+  }
+  QueryPerformanceCounter(&count);
+
+  return (gf_64u)(count.QuadPart / freq.QuadPart) * 1000000000ULL +
+         (gf_64u)(count.QuadPart % freq.QuadPart) * 1000000000ULL /
+         (gf_64u)freq.QuadPart;
+#else
+  struct timespec ts = { 0 };
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (gf_64u)ts.tv_sec * 1000000000ULL + (gf_64u)ts.tv_nsec;
+#endif
+}
+
+void
+gf_datetime_get_local_time(gf_datetime_local* local) {
+#if defined(_WIN32)
+  SYSTEMTIME tm = { 0 };
+
+  GetLocalTime(&tm);
+  local->year = tm.wYear;
+  local->month = tm.wMonth;
+  local->day = tm.wDay;
+  local->hour = tm.wHour;
+  local->minute = tm.wMinute;
+  local->second = tm.wSecond;
+  local->msec = tm.wMilliseconds;
+#else
+  struct timespec ts = { 0 };
+  struct tm tm = { 0 };
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  localtime_r(&ts.tv_sec, &tm);
+  local->year = tm.tm_year + 1900;
+  local->month = tm.tm_mon + 1;
+  local->day = tm.tm_mday;
+  local->hour = tm.tm_hour;
+  local->minute = tm.tm_min;
+  local->second = tm.tm_sec;
+  local->msec = (gf_int)(ts.tv_nsec / 1000000);
+#endif
+}
+
 static gf_int
 datetime_parse_digit(const gf_char** ptr, gf_int digit) {
   gf_int n = 0;
@@ -133,14 +189,19 @@ gf_datetime_parse_iso8061_string(const gf_char* str, gf_datetime* datetime) {
 gf_status
 gf_datetime_make_string(
   gf_string* str, const gf_char* fmt, gf_datetime datetime) {
-  errno_t err = 0;
+  int err = 0;
   struct tm tm = { 0 };
   gf_char buf[256] = { 0 };
+  time_t t = (time_t)datetime;
 
   gf_validate(str);
   gf_validate(!gf_strnull(fmt));
   
-  err = localtime_s(&tm, (time_t*)&datetime);
+#if defined(_WIN32)
+  err = localtime_s(&tm, &t);
+#else
+  err = localtime_r(&t, &tm) ? 0 : errno;
+#endif
   if (err != 0) {
     gf_raise(GF_E_DATA, "Failed to make a datetime string.");
   }
@@ -24,6 +24,35 @@ typedef gf_64u gf_datetime;
 
 extern gf_status gf_datetime_get_current_time(gf_datetime* datetime);
 
+/*!
+** @brief Get the time of a monotonic clock in nanoseconds.
+**
+** The origin is unspecified; use the difference of two values to measure an
+** elapsed time.
+*/
+
+extern gf_64u gf_datetime_get_monotonic_ns(void);
+
+/*!
+** @brief The current local time broken down to the milliseconds
+*/
+
+typedef struct gf_datetime_local {
+  gf_int year;                  ///< The year (e.g. 2021)
+  gf_int month;                 ///< The month (1-12)
+  gf_int day;                   ///< The day of the month (1-31)
+  gf_int hour;                  ///< The hour (0-23)
+  gf_int minute;                ///< The minute (0-59)
+  gf_int second;                ///< The second (0-59)
+  gf_int msec;                  ///< The millisecond (0-999)
+} gf_datetime_local;
+
+/*!
+** @brief Get the current local time, as written to the logs.
+*/
+
+extern void gf_datetime_get_local_time(gf_datetime_local* local);
+
 /*!
 ** @brief Parse a datetime string as a extended ISO 8061 format.
 **
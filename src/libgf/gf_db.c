@@ -0,0 +1,1028 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_db.c
+** @brief The binary site database (site.gfdb).
+*/
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_shell.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_db.h>
+
+#include "gf_local.h"
+
+/* The records are read in place, so their layout must not depend on the ABI */
+_Static_assert(sizeof(gf_db_header) == 112, "gf_db_header");
+_Static_assert(sizeof(gf_db_entry) == 80, "gf_db_entry");
+_Static_assert(sizeof(gf_db_file) == 72 + GF_HASH_BUFSIZE_MAX, "gf_db_file");
+_Static_assert(sizeof(gf_db_category) == 24, "gf_db_category");
+_Static_assert(sizeof(gf_db_journal_header) == 16, "gf_db_journal_header");
+_Static_assert(sizeof(gf_db_journal_record) == 24, "gf_db_journal_record");
+
+/*!
+** @brief The alignment of the sections
+*/
+
+#define DB_ALIGNMENT 8
+
+static const gf_size_t db_record_size_[GF_DB_SECTION_COUNT] = {
+  [GF_DB_SECTION_STRINGS]    = 1,
+  [GF_DB_SECTION_ENTRIES]    = sizeof(gf_db_entry),
+  [GF_DB_SECTION_FILES]      = sizeof(gf_db_file),
+  [GF_DB_SECTION_CATEGORIES] = sizeof(gf_db_category),
+  [GF_DB_SECTION_REFS]       = sizeof(gf_32u),
+};
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A database opened for reading
+*/
+
+struct gf_db {
+  const gf_8u*        data;     ///< The image of the file
+  gf_size_t           size;     ///< The size of the image
+  const gf_db_header* header;   ///< The header at the top of the image
+};
+
+static gf_status
+db_map_file(gf_db* db, const gf_path* path) {
+  const gf_char* name = gf_path_get_string(path);
+#if defined(_WIN32)
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE map = NULL;
+  LARGE_INTEGER size = { 0 };
+
+  file = CreateFileA(
+    name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+      (gf_64u)size.QuadPart > (gf_64u)SIZE_MAX) {
+    CloseHandle(file);
+    gf_raise(GF_E_DATA, "Invalid database file. (%s)", name);
+  }
+  map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!map) {
+    gf_raise(GF_E_READ, "Failed to map file. (%s)", name);
+  }
+  db->data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+  /* The view keeps the mapping */
+  CloseHandle(map);
+  if (!db->data) {
+    gf_raise(GF_E_READ, "Failed to map file. (%s)", name);
+  }
+  db->size = (gf_size_t)size.QuadPart;
+#else
+  int fd = -1;
+  struct stat st = { 0 };
+  void* addr = NULL;
+
+  fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  if (fstat(fd, &st) != 0 || st.st_size == 0 ||
+      (gf_64u)st.st_size > (gf_64u)SIZE_MAX) {
+    (void)close(fd);
+    gf_raise(GF_E_DATA, "Invalid database file. (%s)", name);
+  }
+  addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  (void)close(fd);
+  if (addr == MAP_FAILED) {
+    gf_raise(GF_E_READ, "Failed to map file. (%s)", name);
+  }
+  db->data = addr;
+  db->size = (gf_size_t)st.st_size;
+#endif
+
+  return GF_SUCCESS;
+}
+
+static void
+db_unmap_file(gf_db* db) {
+  if (db->data) {
+#if defined(_WIN32)
+    UnmapViewOfFile(db->data);
+#else
+    (void)munmap((void*)db->data, db->size);
+#endif
+  }
+  db->data = NULL;
+  db->size = 0;
+}
+
+static gf_status
+db_validate_header(const gf_db* db) {
+  const gf_db_header* header = NULL;
+
+  if (db->size < sizeof(*header)) {
+    gf_raise(GF_E_DATA, "Invalid database file.");
+  }
+  header = (const gf_db_header*)db->data;
+  if (memcmp(header->magic, GF_DB_MAGIC, sizeof(header->magic))) {
+    gf_raise(GF_E_DATA, "Invalid database file.");
+  }
+  if (header->byte_order != GF_DB_BYTE_ORDER) {
+    gf_raise(GF_E_DATA, "The database was written in another byte order.");
+  }
+  if (header->version != GF_DB_VERSION) {
+    gf_raise(GF_E_DATA, "Unsupported database version (%u).",
+             (unsigned)header->version);
+  }
+  if (header->file_size != (gf_64u)db->size) {
+    gf_raise(GF_E_DATA, "The database file is truncated.");
+  }
+  for (gf_size_t i = 0; i < GF_DB_SECTION_COUNT; i++) {
+    const gf_db_section* section = &header->sections[i];
+
+    if (section->offset % DB_ALIGNMENT != 0 ||
+        section->offset > (gf_64u)db->size ||
+        section->count > GF_DB_NONE ||
+        section->count * db_record_size_[i] >
+        (gf_64u)db->size - section->offset) {
+      gf_raise(GF_E_DATA, "Invalid database file.");
+    }
+  }
+  /* The last string must be terminated */
+  if (header->sections[GF_DB_SECTION_STRINGS].count == 0 ||
+      db->data[header->sections[GF_DB_SECTION_STRINGS].offset +
+               header->sections[GF_DB_SECTION_STRINGS].count - 1] != '\0') {
+    gf_raise(GF_E_DATA, "Invalid database file.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_open(gf_db** db, const gf_path* path) {
+  gf_status rc = 0;
+  gf_db* tmp = NULL;
+
+  gf_validate(db);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->data = NULL;
+  tmp->size = 0;
+  tmp->header = NULL;
+
+  rc = db_map_file(tmp, path);
+  if (rc == GF_SUCCESS) {
+    rc = db_validate_header(tmp);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_db_close(tmp);
+    gf_throw(rc);
+  }
+  tmp->header = (const gf_db_header*)tmp->data;
+  *db = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_db_close(gf_db* db) {
+  if (db) {
+    db_unmap_file(db);
+    gf_free(db);
+  }
+}
+
+static const gf_8u*
+db_get_record(const gf_db* db, gf_db_section_type type, gf_32u index) {
+  const gf_db_section* section = NULL;
+
+  if (!db) {
+    return NULL;
+  }
+  section = &db->header->sections[type];
+  if ((gf_64u)index >= section->count) {
+    return NULL;
+  }
+
+  return db->data + section->offset + (gf_size_t)index * db_record_size_[type];
+}
+
+gf_32u
+gf_db_get_generation(const gf_db* db) {
+  return db ? db->header->generation : 0;
+}
+
+gf_64u
+gf_db_get_scan_time(const gf_db* db) {
+  return db ? db->header->scan_time : 0;
+}
+
+gf_64u
+gf_db_get_size(const gf_db* db) {
+  return db ? (gf_64u)db->size : 0;
+}
+
+gf_size_t
+gf_db_count_entries(const gf_db* db) {
+  return db ? (gf_size_t)db->header->sections[GF_DB_SECTION_ENTRIES].count : 0;
+}
+
+gf_size_t
+gf_db_count_files(const gf_db* db) {
+  return db ? (gf_size_t)db->header->sections[GF_DB_SECTION_FILES].count : 0;
+}
+
+gf_size_t
+gf_db_count_categories(const gf_db* db) {
+  return db ?
+    (gf_size_t)db->header->sections[GF_DB_SECTION_CATEGORIES].count : 0;
+}
+
+const gf_db_entry*
+gf_db_get_entry(const gf_db* db, gf_32u index) {
+  return (const gf_db_entry*)db_get_record(db, GF_DB_SECTION_ENTRIES, index);
+}
+
+const gf_db_file*
+gf_db_get_file(const gf_db* db, gf_32u index) {
+  return (const gf_db_file*)db_get_record(db, GF_DB_SECTION_FILES, index);
+}
+
+const gf_db_category*
+gf_db_get_category(const gf_db* db, gf_32u index) {
+  return (const gf_db_category*)
+    db_get_record(db, GF_DB_SECTION_CATEGORIES, index);
+}
+
+const gf_char*
+gf_db_get_string(const gf_db* db, gf_32u offset) {
+  /* The strings section is terminated, so a valid offset is a C string */
+  return (const gf_char*)db_get_record(db, GF_DB_SECTION_STRINGS, offset);
+}
+
+gf_32u
+gf_db_get_ref(const gf_db* db, const gf_db_list* list, gf_32u index) {
+  const gf_8u* ref = NULL;
+  gf_32u value = GF_DB_NONE;
+
+  if (!list || index >= list->count ||
+      list->first > GF_DB_NONE - list->count) {
+    return GF_DB_NONE;
+  }
+  ref = db_get_record(db, GF_DB_SECTION_REFS, list->first + index);
+  if (ref) {
+    memcpy(&value, ref, sizeof(value));
+  }
+
+  return value;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A growing byte buffer of a section
+*/
+
+typedef struct db_buffer {
+  gf_8u*    data;
+  gf_size_t size;
+  gf_size_t capacity;
+} db_buffer;
+
+static gf_status
+db_buffer_append(db_buffer* buf, gf_const_ptr data, gf_size_t size) {
+  if (buf->size + size > buf->capacity) {
+    gf_size_t capacity = buf->capacity ? buf->capacity : 4096;
+
+    while (capacity < buf->size + size) {
+      capacity *= 2;
+    }
+    _(gf_realloc((gf_ptr*)&buf->data, capacity));
+    buf->capacity = capacity;
+  }
+  _(gf_memcpy(buf->data + buf->size, data, size));
+  buf->size += size;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief A database under construction
+*/
+
+struct gf_db_builder {
+  db_buffer sections[GF_DB_SECTION_COUNT]; ///< The images of the sections
+  gf_map*   strings;                       ///< String -> the offset
+  gf_64u    scan_time;                     ///< gf_db_header::scan_time
+};
+
+gf_status
+gf_db_builder_new(gf_db_builder** builder) {
+  gf_status rc = 0;
+  gf_db_builder* tmp = NULL;
+  gf_32u offset = 0;
+
+  gf_validate(builder);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  for (gf_size_t i = 0; i < GF_DB_SECTION_COUNT; i++) {
+    tmp->sections[i] = (db_buffer){ NULL, 0, 0 };
+  }
+  tmp->strings = NULL;
+  tmp->scan_time = 0;
+  rc = gf_map_new(&tmp->strings);
+  if (rc == GF_SUCCESS) {
+    /* The offset 0 is the empty string */
+    rc = gf_db_builder_add_string(tmp, "", &offset);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_db_builder_free(tmp);
+    gf_throw(rc);
+  }
+  *builder = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_db_builder_free(gf_db_builder* builder) {
+  if (builder) {
+    for (gf_size_t i = 0; i < GF_DB_SECTION_COUNT; i++) {
+      if (builder->sections[i].data) {
+        gf_free(builder->sections[i].data);
+      }
+    }
+    if (builder->strings) {
+      gf_map_free(builder->strings);
+    }
+    gf_free(builder);
+  }
+}
+
+gf_status
+gf_db_builder_add_string(
+  gf_db_builder* builder, const gf_char* str, gf_32u* offset) {
+  db_buffer* buf = NULL;
+  gf_any any = { 0 };
+  gf_size_t len = 0;
+
+  gf_validate(builder);
+  gf_validate(offset);
+
+  if (!str) {
+    str = "";
+  }
+  if (gf_map_find(builder->strings, str, &any)) {
+    *offset = any.u32;
+    return GF_SUCCESS;
+  }
+  buf = &builder->sections[GF_DB_SECTION_STRINGS];
+  len = strlen(str) + 1;
+  if (buf->size + len > (gf_size_t)GF_DB_NONE) {
+    gf_raise(GF_E_DATA, "Too many strings for the database.");
+  }
+  *offset = (gf_32u)buf->size;
+  _(db_buffer_append(buf, str, len));
+  _(gf_map_set(builder->strings, str, (gf_any){ .u32 = *offset }));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+db_builder_add_record(
+  gf_db_builder* builder, gf_db_section_type type, gf_const_ptr record,
+  gf_32u* index) {
+  db_buffer* buf = &builder->sections[type];
+  gf_size_t count = buf->size / db_record_size_[type];
+
+  if (count >= (gf_size_t)GF_DB_NONE) {
+    gf_raise(GF_E_DATA, "Too many records for the database.");
+  }
+  _(db_buffer_append(buf, record, db_record_size_[type]));
+  if (index) {
+    *index = (gf_32u)count;
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_builder_add_entry(
+  gf_db_builder* builder, const gf_db_entry* record, gf_32u* index) {
+  gf_validate(builder);
+  gf_validate(record);
+
+  _(db_builder_add_record(builder, GF_DB_SECTION_ENTRIES, record, index));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_builder_add_file(
+  gf_db_builder* builder, const gf_db_file* record, gf_32u* index) {
+  gf_validate(builder);
+  gf_validate(record);
+
+  _(db_builder_add_record(builder, GF_DB_SECTION_FILES, record, index));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_builder_add_category(
+  gf_db_builder* builder, const gf_db_category* record, gf_32u* index) {
+  gf_validate(builder);
+  gf_validate(record);
+
+  _(db_builder_add_record(builder, GF_DB_SECTION_CATEGORIES, record, index));
+
+  return GF_SUCCESS;
+}
+
+gf_db_entry*
+gf_db_builder_get_entry(gf_db_builder* builder, gf_32u index) {
+  db_buffer* buf = NULL;
+
+  if (!builder) {
+    return NULL;
+  }
+  buf = &builder->sections[GF_DB_SECTION_ENTRIES];
+  if ((gf_size_t)index >= buf->size / sizeof(gf_db_entry)) {
+    return NULL;
+  }
+
+  return (gf_db_entry*)(buf->data + (gf_size_t)index * sizeof(gf_db_entry));
+}
+
+gf_status
+gf_db_builder_add_refs(
+  gf_db_builder* builder, const gf_32u* values, gf_size_t count,
+  gf_db_list* list) {
+  db_buffer* buf = NULL;
+  gf_size_t first = 0;
+
+  gf_validate(builder);
+  gf_validate(values || count == 0);
+  gf_validate(list);
+
+  buf = &builder->sections[GF_DB_SECTION_REFS];
+  first = buf->size / sizeof(gf_32u);
+  if (first + count >= (gf_size_t)GF_DB_NONE) {
+    gf_raise(GF_E_DATA, "Too many records for the database.");
+  }
+  if (count > 0) {
+    _(db_buffer_append(buf, values, count * sizeof(gf_32u)));
+  }
+  list->first = (gf_32u)first;
+  list->count = (gf_32u)count;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_db_builder_set_scan_time(gf_db_builder* builder, gf_64u scan_time) {
+  if (builder) {
+    builder->scan_time = scan_time;
+  }
+}
+
+static gf_size_t
+db_align(gf_size_t offset) {
+  return (offset + DB_ALIGNMENT - 1) / DB_ALIGNMENT * DB_ALIGNMENT;
+}
+
+static gf_status
+db_write_sections(const gf_db_builder* builder, gf_32u generation, FILE* fp) {
+  static const gf_8u padding[DB_ALIGNMENT] = { 0 };
+  gf_db_header header = { 0 };
+  gf_size_t offset = 0;
+
+  memcpy(header.magic, GF_DB_MAGIC, sizeof(header.magic));
+  header.version = GF_DB_VERSION;
+  header.byte_order = GF_DB_BYTE_ORDER;
+  header.generation = generation;
+  header.scan_time = builder->scan_time;
+  offset = db_align(sizeof(header));
+  for (gf_size_t i = 0; i < GF_DB_SECTION_COUNT; i++) {
+    const db_buffer* buf = &builder->sections[i];
+
+    header.sections[i].offset = (gf_64u)offset;
+    header.sections[i].count = (gf_64u)(buf->size / db_record_size_[i]);
+    offset = db_align(offset + buf->size);
+  }
+  header.file_size = (gf_64u)offset;
+
+  if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+    gf_raise(GF_E_WRITE, "Failed to write the database.");
+  }
+  offset = sizeof(header);
+  for (gf_size_t i = 0; i < GF_DB_SECTION_COUNT; i++) {
+    const db_buffer* buf = &builder->sections[i];
+    gf_size_t pad = (gf_size_t)header.sections[i].offset - offset;
+
+    if (pad > 0 && fwrite(padding, 1, pad, fp) != pad) {
+      gf_raise(GF_E_WRITE, "Failed to write the database.");
+    }
+    if (buf->size > 0 && fwrite(buf->data, 1, buf->size, fp) != buf->size) {
+      gf_raise(GF_E_WRITE, "Failed to write the database.");
+    }
+    offset = (gf_size_t)header.sections[i].offset + buf->size;
+  }
+  if (offset < (gf_size_t)header.file_size) {
+    gf_size_t pad = (gf_size_t)header.file_size - offset;
+
+    if (fwrite(padding, 1, pad, fp) != pad) {
+      gf_raise(GF_E_WRITE, "Failed to write the database.");
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+db_make_path(gf_path** dst, const gf_path* path, const gf_char* suffix) {
+  gf_status rc = 0;
+  gf_string* name = NULL;
+
+  _(gf_string_new(&name));
+  rc = gf_string_set(name, gf_path_get_string(path));
+  if (rc == GF_SUCCESS) {
+    rc = gf_string_append(name, suffix);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_new(dst, gf_string_get(name));
+  }
+  gf_string_free(name);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Flush a file to the disk.
+*/
+
+static gf_status
+db_sync_file(FILE* fp) {
+  if (fflush(fp) != 0) {
+    gf_raise(GF_E_WRITE, "Failed to flush file.");
+  }
+#if defined(_WIN32)
+  if (_commit(_fileno(fp)) != 0) {
+#else
+  if (fsync(fileno(fp)) != 0) {
+#endif
+    gf_raise(GF_E_WRITE, "Failed to flush file.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Choose the generation of a new database file.
+**
+** It is the next of the existing file, or made from the clock if there is
+** no valid file. 0 is not used.
+*/
+
+static gf_32u
+db_next_generation(const gf_path* path) {
+  gf_db_header header = { 0 };
+  gf_32u generation = 0;
+  FILE* fp = NULL;
+
+  fp = fopen(gf_path_get_string(path), "rb");
+  if (fp) {
+    if (fread(&header, sizeof(header), 1, fp) == 1 &&
+        !memcmp(header.magic, GF_DB_MAGIC, sizeof(header.magic)) &&
+        header.byte_order == GF_DB_BYTE_ORDER) {
+      generation = header.generation + 1;
+    }
+    fclose(fp);
+  }
+  if (generation == 0) {
+    gf_64u ns = gf_datetime_get_monotonic_ns();
+
+    generation = (gf_32u)(ns ^ (ns >> 32));
+  }
+
+  return generation ? generation : 1;
+}
+
+gf_status
+gf_db_builder_write_file(const gf_db_builder* builder, const gf_path* path) {
+  gf_status rc = 0;
+  gf_path* tmp_path = NULL;
+  FILE* fp = NULL;
+
+  gf_validate(builder);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(db_make_path(&tmp_path, path, ".tmp"));
+  fp = fopen(gf_path_get_string(tmp_path), "wb");
+  if (!fp) {
+    gf_error("Failed to open file. (%s)", gf_path_get_string(tmp_path));
+    gf_path_free(tmp_path);
+    gf_raise(GF_E_OPEN, "Failed to write the database.");
+  }
+  rc = db_write_sections(builder, db_next_generation(path), fp);
+  if (rc == GF_SUCCESS) {
+    /* The rename must not be visible before the content */
+    rc = db_sync_file(fp);
+  }
+  if (fclose(fp) != 0 && rc == GF_SUCCESS) {
+    gf_error("Failed to close file. (%s)", gf_path_get_string(tmp_path));
+    rc = GF_E_WRITE;
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_shell_replace(path, tmp_path);
+  }
+  if (rc != GF_SUCCESS) {
+    (void)remove(gf_path_get_string(tmp_path));
+  }
+  gf_path_free(tmp_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A batch of records to be appended to a journal
+*/
+
+struct gf_db_journal {
+  db_buffer records;            ///< The images of the records
+  gf_size_t count;              ///< The number of the records
+};
+
+/*!
+** @brief Compute the checksum of a record.
+**
+** The checksum covers the type, the size and the payload, with the checksum
+** field itself zeroed.
+*/
+
+static gf_status
+db_journal_checksum(
+  const gf_db_journal_record* record, const gf_8u* data, gf_8u* checksum) {
+  const gf_hash_provider* provider = NULL;
+  gf_db_journal_record tmp = *record;
+  gf_hash_context ctx = { 0 };
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  provider = gf_hash_find(GF_HASH_NAME_FP128);
+  if (!provider || provider->size < sizeof(tmp.checksum)) {
+    gf_raise(GF_E_INTERNAL, "The journal checksum is not available.");
+  }
+  memset(tmp.checksum, 0, sizeof(tmp.checksum));
+  _(provider->init(&ctx));
+  _(provider->update(&ctx, (const gf_8u*)&tmp, sizeof(tmp)));
+  if (record->size > 0) {
+    _(provider->update(&ctx, data, record->size));
+  }
+  _(provider->final(&ctx, digest));
+  memcpy(checksum, digest, sizeof(tmp.checksum));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+db_journal_append(
+  db_buffer* buf, gf_32u type, gf_const_ptr data, gf_size_t size) {
+  gf_db_journal_record record = { 0 };
+
+  if (size > (gf_size_t)UINT32_MAX) {
+    gf_raise(GF_E_DATA, "Too large journal record.");
+  }
+  record.type = type;
+  record.size = (gf_32u)size;
+  _(db_journal_checksum(&record, data, record.checksum));
+  _(db_buffer_append(buf, &record, sizeof(record)));
+  if (size > 0) {
+    _(db_buffer_append(buf, data, size));
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_journal_new(gf_db_journal** journal) {
+  gf_db_journal* tmp = NULL;
+
+  gf_validate(journal);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->records = (db_buffer){ NULL, 0, 0 };
+  tmp->count = 0;
+  *journal = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_db_journal_free(gf_db_journal* journal) {
+  if (journal) {
+    if (journal->records.data) {
+      gf_free(journal->records.data);
+    }
+    gf_free(journal);
+  }
+}
+
+gf_status
+gf_db_journal_add(
+  gf_db_journal* journal, gf_32u type, gf_const_ptr data, gf_size_t size) {
+  gf_validate(journal);
+  gf_validate(type != GF_DB_JOURNAL_COMMIT);
+  gf_validate(data || size == 0);
+
+  _(db_journal_append(&journal->records, type, data, size));
+  journal->count++;
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_db_journal_count(const gf_db_journal* journal) {
+  return journal ? journal->count : 0;
+}
+
+gf_64u
+gf_db_journal_size(const gf_db_journal* journal) {
+  if (!journal) {
+    return 0;
+  }
+  return (gf_64u)(journal->records.size + sizeof(gf_db_journal_record));
+}
+
+gf_status
+gf_db_make_journal_path(gf_path** journal, const gf_path* path) {
+  gf_validate(journal);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(db_make_path(journal, path, GF_DB_JOURNAL_SUFFIX));
+
+  return GF_SUCCESS;
+}
+
+static gf_bool
+db_journal_is_valid_header(
+  const gf_db_journal_header* header, gf_32u generation) {
+  return !memcmp(header->magic, GF_DB_JOURNAL_MAGIC, sizeof(header->magic)) &&
+    header->version == GF_DB_JOURNAL_VERSION &&
+    header->byte_order == GF_DB_BYTE_ORDER &&
+    header->generation == generation;
+}
+
+static gf_status
+db_journal_create(FILE* fp, gf_32u generation, gf_64u* size) {
+  gf_db_journal_header header = { 0 };
+
+  memcpy(header.magic, GF_DB_JOURNAL_MAGIC, sizeof(header.magic));
+  header.version = GF_DB_JOURNAL_VERSION;
+  header.byte_order = GF_DB_BYTE_ORDER;
+  header.generation = generation;
+  if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+    gf_raise(GF_E_WRITE, "Failed to write the journal.");
+  }
+  *size = sizeof(header);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Position a journal file at the end of its valid part.
+*/
+
+static gf_status
+db_journal_seek(FILE* fp, gf_32u generation, gf_64u size) {
+  gf_db_journal_header header = { 0 };
+  int rc = 0;
+
+  if (size < sizeof(header) ||
+      fread(&header, sizeof(header), 1, fp) != 1 ||
+      !db_journal_is_valid_header(&header, generation) ||
+      fseek(fp, 0, SEEK_END) != 0) {
+    gf_raise(GF_E_STATE, "The journal is not the expected one.");
+  }
+#if defined(_WIN32)
+  if ((gf_64u)_ftelli64(fp) < size) {
+    gf_raise(GF_E_STATE, "The journal is not the expected one.");
+  }
+  rc = _chsize_s(_fileno(fp), (__int64)size);
+#else
+  if ((gf_64u)ftello(fp) < size) {
+    gf_raise(GF_E_STATE, "The journal is not the expected one.");
+  }
+  rc = ftruncate(fileno(fp), (off_t)size);
+#endif
+  if (rc != 0 || fseek(fp, 0, SEEK_END) != 0) {
+    gf_raise(GF_E_WRITE, "Failed to truncate the journal.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_journal_write_file(
+  const gf_db_journal* journal, const gf_path* path, gf_32u generation,
+  gf_64u* size) {
+  gf_status rc = 0;
+  db_buffer commit = { NULL, 0, 0 };
+  const gf_char* name = NULL;
+  gf_64u offset = 0;
+  FILE* fp = NULL;
+
+  gf_validate(journal);
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(size);
+
+  name = gf_path_get_string(path);
+  fp = fopen(name, *size == 0 ? "wb" : "r+b");
+  if (!fp) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  if (*size == 0) {
+    rc = db_journal_create(fp, generation, &offset);
+  } else {
+    rc = db_journal_seek(fp, generation, *size);
+    offset = *size;
+  }
+  if (rc == GF_SUCCESS) {
+    rc = db_journal_append(&commit, GF_DB_JOURNAL_COMMIT, NULL, 0);
+  }
+  if (rc == GF_SUCCESS && journal->records.size > 0 &&
+      fwrite(journal->records.data, 1, journal->records.size, fp) !=
+      journal->records.size) {
+    rc = GF_E_WRITE;
+  }
+  if (rc == GF_SUCCESS &&
+      fwrite(commit.data, 1, commit.size, fp) != commit.size) {
+    rc = GF_E_WRITE;
+  }
+  if (rc == GF_SUCCESS) {
+    rc = db_sync_file(fp);
+  }
+  if (fclose(fp) != 0 && rc == GF_SUCCESS) {
+    rc = GF_E_WRITE;
+  }
+  if (commit.data) {
+    gf_free(commit.data);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_error("Failed to write the journal. (%s)", name);
+    gf_throw(rc);
+  }
+  *size = offset + journal->records.size + sizeof(gf_db_journal_record);
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+db_read_file(db_buffer* buf, const gf_path* path) {
+  const gf_char* name = gf_path_get_string(path);
+  gf_8u chunk[4096];
+  gf_size_t len = 0;
+  FILE* fp = NULL;
+
+  fp = fopen(name, "rb");
+  if (!fp) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  do {
+    len = fread(chunk, 1, sizeof(chunk), fp);
+    if (len > 0 && db_buffer_append(buf, chunk, len) != GF_SUCCESS) {
+      fclose(fp);
+      gf_raise(GF_E_READ, "Failed to read file. (%s)", name);
+    }
+  } while (len == sizeof(chunk));
+  if (ferror(fp)) {
+    fclose(fp);
+    gf_raise(GF_E_READ, "Failed to read file. (%s)", name);
+  }
+  fclose(fp);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the record at an offset of a journal.
+**
+** @return GF_TRUE if a whole record with the matching checksum is there.
+*/
+
+static gf_bool
+db_journal_get_record(
+  const db_buffer* buf, gf_size_t offset, gf_db_journal_record* record) {
+  gf_8u checksum[sizeof(record->checksum)];
+
+  if (buf->size - offset < sizeof(*record)) {
+    return GF_FALSE;
+  }
+  memcpy(record, buf->data + offset, sizeof(*record));
+  if (record->size > buf->size - offset - sizeof(*record)) {
+    return GF_FALSE;
+  }
+  if (db_journal_checksum(
+        record, buf->data + offset + sizeof(*record), checksum) !=
+      GF_SUCCESS) {
+    return GF_FALSE;
+  }
+
+  return !memcmp(checksum, record->checksum, sizeof(checksum));
+}
+
+static gf_status
+db_journal_read_records(
+  const db_buffer* buf, gf_32u generation, gf_db_journal_fn fn, gf_ptr user,
+  gf_64u* size) {
+  gf_db_journal_header header = { 0 };
+  gf_db_journal_record record = { 0 };
+  gf_size_t batch = 0;
+  gf_size_t offset = 0;
+
+  if (buf->size < sizeof(header)) {
+    return GF_SUCCESS;
+  }
+  memcpy(&header, buf->data, sizeof(header));
+  if (!db_journal_is_valid_header(&header, generation)) {
+    gf_debug("The journal of another database is ignored.");
+    return GF_SUCCESS;
+  }
+  batch = offset = sizeof(header);
+  *size = (gf_64u)offset;
+  while (db_journal_get_record(buf, offset, &record)) {
+    offset += sizeof(record) + record.size;
+    if (record.type != GF_DB_JOURNAL_COMMIT) {
+      continue;
+    }
+    /* The batch is complete */
+    while (batch < offset - sizeof(record)) {
+      memcpy(&record, buf->data + batch, sizeof(record));
+      batch += sizeof(record);
+      _(fn(record.type, buf->data + batch, record.size, user));
+      batch += record.size;
+    }
+    batch = offset;
+    *size = (gf_64u)offset;
+  }
+  if (offset < buf->size) {
+    gf_warn("The journal is broken after %llu byte(s).",
+            (unsigned long long)*size);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_db_journal_read_file(
+  const gf_path* path, gf_32u generation, gf_db_journal_fn fn, gf_ptr user,
+  gf_64u* size) {
+  gf_status rc = 0;
+  db_buffer buf = { NULL, 0, 0 };
+
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(fn);
+  gf_validate(size);
+
+  *size = 0;
+  if (!gf_path_file_exists(path)) {
+    return GF_SUCCESS;
+  }
+  rc = db_read_file(&buf, path);
+  if (rc == GF_SUCCESS) {
+    rc = db_journal_read_records(&buf, generation, fn, user, size);
+  }
+  if (buf.data) {
+    gf_free(buf.data);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
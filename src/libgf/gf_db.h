@@ -0,0 +1,402 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_db.h
+** @brief The binary site database (site.gfdb).
+**
+** The database is the compact form of site.xml. It is mapped into memory and
+** its records are read in place, so nothing is deserialized until it is used.
+**
+** The file consists of the header and the following sections. The records
+** refer to each other by indices and to the strings by offsets, instead of
+** pointers.
+**
+**   - strings    : NUL-terminated strings (offset 0 is the empty string)
+**   - entries    : gf_db_entry records in the preorder of the entry tree
+**   - files      : gf_db_file records
+**   - categories : gf_db_category records
+**   - refs       : gf_32u values listed by gf_db_list
+**
+** The integers are stored in the byte order of the writer, which is checked
+** by gf_db_open().
+**
+** The changes made after the database was written are appended to its
+** journal (site.gfdb.journal) instead of writing the whole file again. See
+** gf_db_journal.
+*/
+#ifndef LIBGF_GF_DB_H
+#define LIBGF_GF_DB_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_path.h>
+#include <libgf/gf_hash.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GF_DB_MAGIC      "GFDB"       ///< The first 4 bytes of the file
+#define GF_DB_VERSION    2            ///< Incremented on a format change
+#define GF_DB_BYTE_ORDER 0x01020304   ///< Written in the writer's byte order
+#define GF_DB_NONE       0xFFFFFFFFu  ///< The null index
+
+/*!
+** @brief The sections of the database
+*/
+
+enum gf_db_section_type {
+  GF_DB_SECTION_STRINGS    = 0,
+  GF_DB_SECTION_ENTRIES    = 1,
+  GF_DB_SECTION_FILES      = 2,
+  GF_DB_SECTION_CATEGORIES = 3,
+  GF_DB_SECTION_REFS       = 4,
+  GF_DB_SECTION_COUNT      = 5,
+};
+
+typedef enum gf_db_section_type gf_db_section_type;
+
+typedef struct gf_db_section {
+  gf_64u offset;                ///< The offset from the top of the file
+  gf_64u count;                 ///< The number of the records (bytes: strings)
+} gf_db_section;
+
+typedef struct gf_db_header {
+  gf_8u         magic[4];       ///< GF_DB_MAGIC
+  gf_32u        version;        ///< GF_DB_VERSION
+  gf_32u        byte_order;     ///< GF_DB_BYTE_ORDER
+  gf_32u        generation;     ///< Changed every time the file is written
+  gf_64u        file_size;      ///< The size of the whole file
+  gf_64u        scan_time;      ///< The time the files were scanned
+  gf_db_section sections[GF_DB_SECTION_COUNT];
+} gf_db_header;
+
+/*!
+** @brief A range of the refs section
+*/
+
+typedef struct gf_db_list {
+  gf_32u first;                 ///< The index of the first value
+  gf_32u count;                 ///< The number of the values
+} gf_db_list;
+
+typedef struct gf_db_entry {
+  gf_32u     type;              ///< gf_entry_type
+  gf_32u     state;             ///< gf_entry_state
+  gf_64u     date;              ///< gf_datetime
+  gf_32u     title;             ///< String
+  gf_32u     author;            ///< String
+  gf_32u     method;            ///< String
+  gf_32u     output_path;       ///< String
+  gf_32u     parent;            ///< Entry index (GF_DB_NONE: top level)
+  gf_32u     file_info;         ///< File index (GF_DB_NONE: none)
+  gf_db_list file_set;          ///< File indices
+  gf_db_list description;       ///< Strings of the paragraphs
+  gf_db_list subject_set;       ///< Category indices
+  gf_db_list keyword_set;       ///< Category indices
+  gf_db_list children;          ///< Entry indices
+} gf_db_entry;
+
+typedef struct gf_db_file {
+  gf_32u file_name;             ///< String
+  gf_32u full_path;             ///< String
+  gf_32u hash_algorithm;        ///< String
+  gf_16u hash_size;             ///< The size of the hash in bytes
+  gf_16u mode;
+  gf_16s link_count;
+  gf_16s uid;
+  gf_16s gid;
+  gf_16u reserved;
+  gf_32u device;
+  gf_32u rdevice;
+  gf_64u inode;
+  gf_64u file_size;
+  gf_64u access_time;
+  gf_64u modify_time;
+  gf_64u create_time;
+  gf_8u  hash[GF_HASH_BUFSIZE_MAX];
+} gf_db_file;
+
+typedef struct gf_db_category {
+  gf_32u     kind;              ///< gf_category_kind
+  gf_32u     id;                ///< String
+  gf_32u     name;              ///< String
+  gf_32u     reserved;
+  gf_db_list entries;           ///< Entry indices in the order of the tree
+} gf_db_category;
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A database opened for reading
+*/
+
+typedef struct gf_db gf_db;
+
+/*!
+** @brief Open a database file.
+**
+** The file is mapped into memory, and the header and the bounds of the
+** sections are validated. The indices in the records are checked when they
+** are looked up.
+**
+** @param [out] db   The new database object
+** @param [in]  path The path of the database file
+**
+** @return GF_SUCCESS on success, GF_E_DATA if the file is not a database of
+**         this version, GF_E_* otherwise.
+*/
+
+extern gf_status gf_db_open(gf_db** db, const gf_path* path);
+
+extern void gf_db_close(gf_db* db);
+
+/*!
+** @brief Get the generation of the database, which binds the journal to it.
+*/
+
+extern gf_32u gf_db_get_generation(const gf_db* db);
+
+/*!
+** @brief Get the time the files of the database were scanned (0: unknown).
+*/
+
+extern gf_64u gf_db_get_scan_time(const gf_db* db);
+
+/*!
+** @brief Get the size of the database file in bytes.
+*/
+
+extern gf_64u gf_db_get_size(const gf_db* db);
+
+extern gf_size_t gf_db_count_entries(const gf_db* db);
+extern gf_size_t gf_db_count_files(const gf_db* db);
+extern gf_size_t gf_db_count_categories(const gf_db* db);
+
+/*!
+** @brief Get a record or a string.
+**
+** The records are the images in the mapped file. NULL is returned if the
+** index or the offset is out of range.
+*/
+
+extern const gf_db_entry* gf_db_get_entry(const gf_db* db, gf_32u index);
+extern const gf_db_file* gf_db_get_file(const gf_db* db, gf_32u index);
+extern const gf_db_category* gf_db_get_category(const gf_db* db, gf_32u index);
+extern const gf_char* gf_db_get_string(const gf_db* db, gf_32u offset);
+
+/*!
+** @brief Get a value of a list.
+**
+** @return The value, GF_DB_NONE if @a index is out of the list.
+*/
+
+extern gf_32u gf_db_get_ref(
+  const gf_db* db, const gf_db_list* list, gf_32u index);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A database under construction
+*/
+
+typedef struct gf_db_builder gf_db_builder;
+
+extern gf_status gf_db_builder_new(gf_db_builder** builder);
+extern void gf_db_builder_free(gf_db_builder* builder);
+
+/*!
+** @brief Add a string to the string table.
+**
+** The same strings are stored once.
+**
+** @param [in, out] builder The builder
+** @param [in]      str     The string (NULL is the empty string)
+** @param [out]     offset  The offset of the string
+*/
+
+extern gf_status gf_db_builder_add_string(
+  gf_db_builder* builder, const gf_char* str, gf_32u* offset);
+
+/*!
+** @brief Add a record.
+**
+** @param [in, out] builder The builder
+** @param [in]      record  The record to be copied
+** @param [out]     index   The index of the record (may be NULL)
+*/
+
+extern gf_status gf_db_builder_add_entry(
+  gf_db_builder* builder, const gf_db_entry* record, gf_32u* index);
+extern gf_status gf_db_builder_add_file(
+  gf_db_builder* builder, const gf_db_file* record, gf_32u* index);
+extern gf_status gf_db_builder_add_category(
+  gf_db_builder* builder, const gf_db_category* record, gf_32u* index);
+
+/*!
+** @brief Get an entry record added to the builder to fill it later.
+**
+** The pointer is valid until the next entry is added.
+*/
+
+extern gf_db_entry* gf_db_builder_get_entry(
+  gf_db_builder* builder, gf_32u index);
+
+/*!
+** @brief Add values to the refs section.
+**
+** @param [in, out] builder The builder
+** @param [in]      values  The values
+** @param [in]      count   The number of the values
+** @param [out]     list    The range of the added values
+*/
+
+extern gf_status gf_db_builder_add_refs(
+  gf_db_builder* builder, const gf_32u* values, gf_size_t count,
+  gf_db_list* list);
+
+/*!
+** @brief Set the time the files of the database were scanned.
+*/
+
+extern void gf_db_builder_set_scan_time(
+  gf_db_builder* builder, gf_64u scan_time);
+
+/*!
+** @brief Write the database file.
+**
+** The file is written to a temporary file next to @a path, flushed to the
+** disk, and then renamed to @a path, so the old file is kept on failure. The
+** new file gets a generation different from the old one, so the journal of
+** the old file is no longer applied to it.
+*/
+
+extern gf_status gf_db_builder_write_file(
+  const gf_db_builder* builder, const gf_path* path);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The journal of a database
+**
+** The journal is the header followed by the records, each of which is a
+** gf_db_journal_record and its payload. The records are appended in batches
+** closed by a GF_DB_JOURNAL_COMMIT record, and only the closed batches whose
+** checksums match are read. So a batch interrupted while it is appended is
+** discarded as a whole, and the journal is valid up to the previous batch.
+**
+** The journal belongs to the database of the generation in its header; the
+** journal of another generation is regarded as empty. The payloads are
+** defined by the user of the journal (see gf_site_save_db()).
+*/
+
+#define GF_DB_JOURNAL_MAGIC    "GFJL"  ///< The first 4 bytes of the journal
+#define GF_DB_JOURNAL_VERSION  2       ///< Incremented on a format change
+#define GF_DB_JOURNAL_COMMIT   0       ///< The type of the record of a commit
+#define GF_DB_JOURNAL_SUFFIX   ".journal"
+
+typedef struct gf_db_journal_header {
+  gf_8u  magic[4];              ///< GF_DB_JOURNAL_MAGIC
+  gf_32u version;               ///< GF_DB_JOURNAL_VERSION
+  gf_32u byte_order;            ///< GF_DB_BYTE_ORDER
+  gf_32u generation;            ///< The generation of the database
+} gf_db_journal_header;
+
+typedef struct gf_db_journal_record {
+  gf_32u type;                  ///< GF_DB_JOURNAL_COMMIT or defined by the user
+  gf_32u size;                  ///< The size of the payload following it
+  gf_8u  checksum[16];          ///< fp128 of the record and the payload
+} gf_db_journal_record;
+
+/*!
+** @brief A batch of records to be appended to a journal
+*/
+
+typedef struct gf_db_journal gf_db_journal;
+
+extern gf_status gf_db_journal_new(gf_db_journal** journal);
+extern void gf_db_journal_free(gf_db_journal* journal);
+
+/*!
+** @brief Add a record to the batch.
+**
+** @param [in, out] journal The batch
+** @param [in]      type    The type of the record (not GF_DB_JOURNAL_COMMIT)
+** @param [in]      data    The payload
+** @param [in]      size    The size of the payload
+*/
+
+extern gf_status gf_db_journal_add(
+  gf_db_journal* journal, gf_32u type, gf_const_ptr data, gf_size_t size);
+
+extern gf_size_t gf_db_journal_count(const gf_db_journal* journal);
+
+/*!
+** @brief Get the number of the bytes the batch adds to the journal.
+*/
+
+extern gf_64u gf_db_journal_size(const gf_db_journal* journal);
+
+/*!
+** @brief Make the path of the journal of a database.
+*/
+
+extern gf_status gf_db_make_journal_path(
+  gf_path** journal, const gf_path* path);
+
+/*!
+** @brief Append the batch to a journal file.
+**
+** The bytes after the valid part of the journal, which are left by an
+** interrupted append, are discarded first. The file is flushed to the disk
+** before this returns.
+**
+** @param [in]      journal    The batch
+** @param [in]      path       The path of the journal file
+** @param [in]      generation The generation of the database
+** @param [in, out] size       The size of the valid part of the journal (0 to
+**                             start a new journal), and then the new size
+**
+** @return GF_SUCCESS on success, GF_E_STATE if the journal file is not the
+**         one of @a generation and @a size, GF_E_* otherwise.
+*/
+
+extern gf_status gf_db_journal_write_file(
+  const gf_db_journal* journal, const gf_path* path, gf_32u generation,
+  gf_64u* size);
+
+/*!
+** @brief Callback for gf_db_journal_read_file()
+*/
+
+typedef gf_status (*gf_db_journal_fn)(
+  gf_32u type, const gf_8u* data, gf_size_t size, gf_ptr user);
+
+/*!
+** @brief Read the records of a journal file.
+**
+** @a fn is called for each record of the closed batches in order. A missing
+** journal is empty.
+**
+** @param [in]  path       The path of the journal file
+** @param [in]  generation The generation of the database
+** @param [in]  fn         The function called for each record
+** @param [in]  user       The user data passed to @a fn
+** @param [out] size       The size of the valid part of the journal
+*/
+
+extern gf_status gf_db_journal_read_file(
+  const gf_path* path, gf_32u generation, gf_db_journal_fn fn, gf_ptr user,
+  gf_64u* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_DB_H */
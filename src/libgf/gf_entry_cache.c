@@ -0,0 +1,346 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_entry_cache.c
+** @brief Cache of the information read from the entry files.
+*/
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_entry_cache.h>
+
+#include "gf_local.h"
+#include "gf_site_local.h"
+
+/*!
+** @brief The cache of the entry information keyed by the content
+**
+** The information of an entry file is reused while its fingerprint is
+** unchanged, so the file is not read again.
+*/
+
+struct gf_entry_cache {
+  gf_map*        items;       ///< "algorithm:hash" -> entry_cache_item
+  site_taxonomy* taxonomy;    ///< The categories referred by the records
+  gf_mutex       lock;        ///< Guards the members while reading entries
+  gf_size_t      hits;        ///< Entries filled from the cache
+  gf_size_t      misses;      ///< Entries read from the entry files
+};
+
+/*!
+** @brief A record of the cache
+*/
+
+typedef struct entry_cache_item {
+  gf_entry* entry;            ///< The information of the entry file
+  gf_bool   used;             ///< Looked up or stored since it was read
+} entry_cache_item;
+
+static void
+entry_cache_item_free(gf_any* any) {
+  if (any && any->ptr) {
+    entry_cache_item* item = any->ptr;
+
+    gf_entry_free(item->entry);
+    gf_free(item);
+  }
+}
+
+static gf_status
+entry_cache_item_new(
+  entry_cache_item** item, site_taxonomy* taxonomy, gf_bool used) {
+  gf_status rc = 0;
+  entry_cache_item* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->used = used;
+  rc = entry_new(&tmp->entry, taxonomy);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  *item = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add a record to the cache unless the key is already cached.
+*/
+
+static gf_status
+entry_cache_add(
+  gf_entry_cache* cache, const gf_char* key, entry_cache_item* item) {
+  gf_status rc = GF_SUCCESS;
+  gf_bool added = GF_FALSE;
+
+  gf_mutex_lock(&cache->lock);
+  if (!gf_map_find(cache->items, key, NULL)) {
+    rc = gf_map_set(cache->items, key, (gf_any){ .ptr = item });
+    added = rc == GF_SUCCESS ? GF_TRUE : GF_FALSE;
+  }
+  gf_mutex_unlock(&cache->lock);
+  if (!added) {
+    entry_cache_item_free(&(gf_any){ .ptr = item });
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_entry_cache_new(gf_entry_cache** cache) {
+  gf_status rc = 0;
+  gf_entry_cache* tmp = NULL;
+
+  gf_validate(cache);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->items = NULL;
+  tmp->taxonomy = NULL;
+  tmp->hits = 0;
+  tmp->misses = 0;
+  rc = gf_mutex_init(&tmp->lock);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  rc = gf_map_new(&tmp->items);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set_free_fn(tmp->items, entry_cache_item_free);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_taxonomy_new(&tmp->taxonomy);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_entry_cache_free(tmp);
+    gf_throw(rc);
+  }
+  *cache = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_entry_cache_free(gf_entry_cache* cache) {
+  if (cache) {
+    if (cache->items) {
+      gf_map_free(cache->items);
+    }
+    site_taxonomy_free(cache->taxonomy);
+    gf_mutex_destroy(&cache->lock);
+    gf_free(cache);
+  }
+}
+
+gf_size_t
+gf_entry_cache_count_hits(const gf_entry_cache* cache) {
+  return cache ? cache->hits : 0;
+}
+
+gf_size_t
+gf_entry_cache_count_misses(const gf_entry_cache* cache) {
+  return cache ? cache->misses : 0;
+}
+
+/*!
+** @brief Find the information of the entry file in the cache.
+**
+** The record is not modified once it is added, so it can be read without
+** the lock.
+**
+** @param [in]  cache The cache
+** @param [in]  key   The content key of the entry file
+** @param [in]  entry The entry to be filled
+** @param [out] found The cached information
+*/
+
+gf_bool
+entry_cache_lookup(
+  gf_entry_cache* cache, const gf_char* key, const gf_entry* entry,
+  const gf_entry** found) {
+  gf_any any = { 0 };
+  entry_cache_item* item = NULL;
+
+  gf_mutex_lock(&cache->lock);
+  if (gf_map_find(cache->items, key, &any)) {
+    item = any.ptr;
+    /* A meta file and a document of the same content */
+    if (item->entry->type != entry->type) {
+      item = NULL;
+    }
+  }
+  if (item) {
+    item->used = GF_TRUE;
+    cache->hits += 1;
+  } else {
+    cache->misses += 1;
+  }
+  gf_mutex_unlock(&cache->lock);
+  if (!item) {
+    return GF_FALSE;
+  }
+  *found = item->entry;
+
+  return GF_TRUE;
+}
+
+gf_status
+entry_cache_store(
+  gf_entry_cache* cache, const gf_char* key, const gf_entry* entry) {
+  gf_status rc = 0;
+  entry_cache_item* item = NULL;
+
+  _(entry_cache_item_new(&item, cache->taxonomy, GF_TRUE));
+  rc = entry_copy_info(item->entry, entry);
+  if (rc != GF_SUCCESS) {
+    entry_cache_item_free(&(gf_any){ .ptr = item });
+    gf_throw(rc);
+  }
+  _(entry_cache_add(cache, key, item));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_cache_read_entry(site_xml_loader* loader, gf_entry* entry) {
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(entry);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    gf_bool found = GF_FALSE;
+
+    _(site_read_xml_entry_info(loader, entry, name, &found));
+    if (!found) {
+      const gf_char* text = NULL;
+
+      /* Unknown element - ignore */
+      _(site_xml_read_text(loader, &text));
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_cache_read_item(site_xml_loader* loader, gf_entry_cache* cache) {
+  gf_status rc = 0;
+  entry_cache_item* item = NULL;
+  xmlChar* key = NULL;
+
+  if (site_xml_get_name(loader) != SITE_XML_ITEM) {
+    gf_raise(GF_E_DATA, "Invalid cache file.");
+  }
+  key = xmlTextReaderGetAttribute(loader->reader, BAD_CAST"key");
+  if (!key) {
+    gf_raise(GF_E_DATA, "Invalid cache file.");
+  }
+  rc = entry_cache_item_new(&item, cache->taxonomy, GF_FALSE);
+  if (rc == GF_SUCCESS) {
+    rc = entry_cache_read_entry(loader, item->entry);
+    if (rc != GF_SUCCESS) {
+      entry_cache_item_free(&(gf_any){ .ptr = item });
+    }
+  }
+  if (rc == GF_SUCCESS) {
+    rc = entry_cache_add(cache, (const gf_char*)key, item);
+  }
+  xmlFree(key);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_cache_read_content(site_xml_loader* loader, gf_entry_cache* cache) {
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  _(entry_move_to_element(loader->reader, 0));
+  if (site_xml_get_name(loader) != SITE_XML_ENTRY_CACHE) {
+    gf_raise(GF_E_DATA, "Invalid cache file.");
+  }
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    _(entry_cache_read_item(loader, cache));
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_entry_cache_read_file(gf_entry_cache* cache, const gf_path* path) {
+  gf_status rc = 0;
+  site_xml_loader loader;
+
+  gf_validate(cache);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(site_open_xml_loader(&loader, path, GF_XML_PARSE_OPTIONS));
+  rc = entry_cache_read_content(&loader, cache);
+  site_close_xml_loader(&loader);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_cache_write_item(const gf_char* key, gf_any value, gf_ptr data) {
+  xmlTextWriterPtr writer = data;
+  const entry_cache_item* item = value.ptr;
+  const gf_entry* entry = item->entry;
+
+  /* The records of the removed entry files are dropped */
+  if (!item->used) {
+    return GF_SUCCESS;
+  }
+  _(site_write_xml_start(writer, "item"));
+  _(site_write_xml_attribute(writer, "key", key));
+  _(site_write_xml_entry_info(writer, entry));
+  _(site_write_xml_element(writer, "method", gf_string_get(entry->method)));
+  _(site_write_xml_category_set(
+      writer, "subject-set", "subject", entry, GF_CATEGORY_SUBJECT));
+  _(site_write_xml_category_set(
+      writer, "keyword-set", "keyword", entry, GF_CATEGORY_KEYWORD));
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_entry_cache_write_file(const gf_entry_cache* cache, const gf_path* path) {
+  gf_status rc = 0;
+  site_xml_stream stream;
+
+  gf_validate(cache);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(site_open_xml_stream(&stream, path));
+  rc = site_write_xml_start(stream.writer, "entry-cache");
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_foreach(cache->items, entry_cache_write_item, stream.writer);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_write_xml_end(stream.writer);
+  }
+  _(site_close_xml_stream(&stream, path, rc));
+
+  return GF_SUCCESS;
+}
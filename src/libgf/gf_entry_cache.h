@@ -0,0 +1,76 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_entry_cache.h
+** @brief Cache of the information read from the entry files.
+*/
+#ifndef LIBGF_GF_ENTRY_CACHE_H
+#define LIBGF_GF_ENTRY_CACHE_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_path.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The cache of the information read from the entry files.
+**
+** The records are keyed by the fingerprint of the entry file, so an entry
+** file is not read again until its content changes.
+*/
+
+typedef struct gf_entry_cache gf_entry_cache;
+
+extern gf_status gf_entry_cache_new(gf_entry_cache** cache);
+extern void gf_entry_cache_free(gf_entry_cache* cache);
+
+/*!
+** @brief Add the records of a cache file.
+**
+** @param [in, out] cache The cache
+** @param [in]      path  The cache file written by gf_entry_cache_write_file()
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_entry_cache_read_file(
+  gf_entry_cache* cache, const gf_path* path);
+
+/*!
+** @brief Write the cache to a file.
+**
+** Only the records looked up or added since the cache was read are written,
+** so the records of the removed entry files are dropped.
+**
+** @param [in] cache The cache
+** @param [in] path  The file path to be written
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_entry_cache_write_file(
+  const gf_entry_cache* cache, const gf_path* path);
+
+/*!
+** @brief Count the entries filled from the cache and read from the files.
+*/
+
+extern gf_size_t gf_entry_cache_count_hits(const gf_entry_cache* cache);
+extern gf_size_t gf_entry_cache_count_misses(const gf_entry_cache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_ENTRY_CACHE_H */
@@ -7,11 +7,11 @@
 ** @brief Error handling module.
 */
 #include <stdio.h>
-#include <windows.h>
 
 #define GF_USE_SAFE_ERROR_ 1
 
 #include <libgf/gf_error.h>
+#include <libgf/gf_datetime.h>
 
 #define ERROR_MESSAGE_LENGTH 1024
 
@@ -23,12 +23,12 @@ gf_safe_error(
   static char buf[ERROR_MESSAGE_LENGTH + 1] = { 0 };
 
   const char* str = NULL;
-  SYSTEMTIME tm = { 0 };
+  gf_datetime_local tm = { 0 };
   va_list arg = { 0 };
 
   if (fmt && *fmt) {
     va_start(arg, fmt);
-    vsprintf_s(buf, ERROR_MESSAGE_LENGTH, fmt, arg);
+    vsnprintf(buf, ERROR_MESSAGE_LENGTH, fmt, arg);
     va_end(arg);
     str = buf;
   } else {
@@ -36,20 +36,20 @@ gf_safe_error(
   }
 
   /* Current time */
-  GetLocalTime(&tm);
+  gf_datetime_get_local_time(&tm);
   
 #if defined(GF_DEBUG_)
   fprintf(stderr, "%s:%d: [%04d/%02d/%02d %02d:%02d:%02d.%03d] error: %s\n",
           file, line,
-          tm.wYear, tm.wMonth, tm.wDay, tm.wHour,
-          tm.wMinute, tm.wSecond, tm.wMilliseconds,
+          tm.year, tm.month, tm.day, tm.hour,
+          tm.minute, tm.second, tm.msec,
           str);
 #else
   (void)file;
   (void)line;
   fprintf(stderr, "[%04d/%02d/%02d %02d:%02d:%02d.%03d] error: %s\n",
-          tm.wYear, tm.wMonth, tm.wDay, tm.wHour,
-          tm.wMinute, tm.wSecond, tm.wMilliseconds,
+          tm.year, tm.month, tm.day, tm.hour,
+          tm.minute, tm.second, tm.msec,
           str);
 #endif
   fprintf(stderr, "Return Code: 0x%04X\n", code);
@@ -10,289 +10,1498 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
 
 #include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
 #include <libgf/gf_hash.h>
 #include <libgf/gf_array.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_thread.h>
 #include <libgf/gf_file_info.h>
 
 #include "gf_local.h"
 
+/*
+** Memory layout
+**
+** A scanned tree is owned by an arena. The nodes, the hash buffers and the
+** path strings are carved out of large blocks, so that a tree of a million
+** files takes a few thousand allocations and is freed with one call. The
+** children of a directory are allocated as one contiguous range of nodes,
+** sorted by the file name. The file name of a node is the last component of
+** its full path, so each path is stored once.
+**
+** A node created by gf_file_info_new() is a standalone node, which owns its
+** strings and has room for the largest hash. gf_file_info_free() frees a
+** standalone node or a whole tree (given its root); it does nothing for the
+** other nodes of a tree, so they can be shared by the containers referring
+** to the tree.
+*/
+
+typedef struct file_info_arena file_info_arena;
+
 struct gf_file_info {
-  gf_path*  file_name;                    ///< file name
-  gf_path*  full_path;                    ///< full path name
-  gf_8u     hash[GF_HASH_BUFSIZE_SHA512]; ///< SHA-512 hash
+  const gf_char* file_name;               ///< file name
+  const gf_char* full_path;               ///< full path name
+  gf_8u*    hash;                         ///< content fingerprint
+  const gf_hash_provider* hash_algorithm; ///< the algorithm of the hash
+  file_info_arena* arena;                 ///< the owner (NULL if standalone)
+  gf_file_info* children;                 ///< the first of the children
+  gf_size_t child_count;                  ///< the number of the children
   gf_any    user_data;                    ///< user defined data
   gf_32u    user_flag;                    ///< user defined flag
   gf_16u    hash_size;                    ///< hash buffer size (in byte)
-  gf_16u    inode;                        ///< stat64::st_ino
+  gf_16u    hash_capacity;                ///< allocated size of hash
   gf_16u    mode;                         ///< stat64::st_mode
   gf_16s    link_count;                   ///< stat64::st_nlink
   gf_16s    uid;                          ///< stat64::st_uid
   gf_16s    gid;                          ///< stat64::st_gid
   gf_32u    device;                       ///< stat64::st_dev 
   gf_32u    rdevice;                      ///< stat64::st_rdev
+  gf_64u    inode;                        ///< stat64::st_ino
   gf_64u    file_size;                    ///< stat64::st_size
   gf_64u    access_time;                  ///< stat64::st_atime
   gf_64u    modify_time;                  ///< stat64::st_mtime
   gf_64u    create_time;                  ///< stat64::st_ctime
-  gf_array* children;
 };
 
+/* -------------------------------------------------------------------------- */
+
+#define FILE_INFO_ARENA_BLOCK_SIZE (256 * 1024)
+
+typedef struct file_info_block file_info_block;
+
+struct file_info_block {
+  file_info_block* next;
+  gf_size_t        size;          ///< The capacity of data
+  gf_size_t        used;
+  max_align_t      data[];
+};
+
+struct file_info_arena {
+  gf_mutex         lock;          ///< Guards the list of the blocks
+  file_info_block* blocks;
+  gf_file_info*    root;          ///< The node which frees the arena
+  gf_size_t        reserved;      ///< The bytes of the blocks
+};
+
+/*!
+** @brief The allocation cursor of a thread
+**
+** Each walker carves its nodes out of its own block, and takes the lock of
+** the arena only to link a new block.
+*/
+
+typedef struct file_info_pool {
+  file_info_arena* arena;
+  file_info_block* block;         ///< The block being carved (may be NULL)
+} file_info_pool;
+
+static gf_status
+file_info_arena_new(file_info_arena** arena) {
+  gf_status rc = 0;
+  file_info_arena* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->blocks = NULL;
+  tmp->root = NULL;
+  tmp->reserved = 0;
+  rc = gf_mutex_init(&tmp->lock);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  *arena = tmp;
+
+  return GF_SUCCESS;
+}
+
+static void
+file_info_arena_free(file_info_arena* arena) {
+  if (arena) {
+    file_info_block* block = arena->blocks;
+
+    while (block) {
+      file_info_block* next = block->next;
+      gf_free(block);
+      block = next;
+    }
+    gf_mutex_destroy(&arena->lock);
+    gf_free(arena);
+  }
+}
+
+static gf_status
+file_info_arena_add_block(
+  file_info_arena* arena, gf_size_t size, file_info_block** block) {
+  file_info_block* tmp = NULL;
+
+  if (size < FILE_INFO_ARENA_BLOCK_SIZE) {
+    size = FILE_INFO_ARENA_BLOCK_SIZE;
+  }
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp) + size));
+  tmp->size = size;
+  tmp->used = 0;
+
+  gf_mutex_lock(&arena->lock);
+  tmp->next = arena->blocks;
+  arena->blocks = tmp;
+  arena->reserved += sizeof(*tmp) + size;
+  gf_mutex_unlock(&arena->lock);
+
+  *block = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+file_info_pool_alloc(
+  file_info_pool* pool, gf_size_t size, gf_size_t align, gf_ptr* ptr) {
+  file_info_block* block = pool->block;
+  gf_size_t offset = 0;
+
+  if (block) {
+    offset = (block->used + align - 1) & ~(align - 1);
+  }
+  if (!block || offset + size > block->size) {
+    _(file_info_arena_add_block(pool->arena, size, &block));
+    pool->block = block;
+    offset = 0;
+  }
+  *ptr = (gf_8u*)block->data + offset;
+  block->used = offset + size;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Allocate from the arena outside of a scan
+**
+** A node of a finished tree gets a private block, which is freed with the
+** tree. This is used when a record is rewritten, which is rare.
+*/
+
+static gf_status
+file_info_arena_alloc(file_info_arena* arena, gf_size_t size, gf_ptr* ptr) {
+  file_info_pool pool = { .arena = arena, .block = NULL };
+
+  _(file_info_pool_alloc(&pool, size, sizeof(max_align_t), ptr));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+file_info_pool_strdup(
+  file_info_pool* pool, const gf_char* str, gf_size_t len, gf_char** dst) {
+  gf_char* tmp = NULL;
+
+  _(file_info_pool_alloc(pool, len + 1, 1, (gf_ptr*)&tmp));
+  memcpy(tmp, str, len);
+  tmp[len] = '\0';
+  *dst = tmp;
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static const gf_char file_info_empty_[] = "";
+
+static gf_status
+file_info_init(gf_file_info* info) {
+  gf_validate(info);
+
+  info->file_name = file_info_empty_;
+  info->full_path = file_info_empty_;
+  info->arena = NULL;
+  info->children = NULL;
+  info->child_count = 0;
+  info->inode = 0;
+  info->mode = 0;
+  info->link_count= 0;
+  info->uid = 0;
+  info->gid = 0;
+  info->device = 0;
+  info->rdevice = 0;
+  info->file_size = 0;
+  info->access_time = 0;
+  info->modify_time = 0;
+  info->create_time = 0;
+
+  info->user_data.data = 0;
+  info->user_flag = 0;
+  
+  info->hash = NULL;
+  info->hash_algorithm = NULL;
+  info->hash_size = 0;
+  info->hash_capacity = 0;
+  
+  return GF_SUCCESS;
+}
+
+static void
+file_info_free_string(const gf_char* str) {
+  if (str && str != file_info_empty_) {
+    gf_free((gf_ptr)str);
+  }
+}
+
+/*!
+** @brief Replace a string of a node
+**
+** A standalone node owns a heap copy of the string; a node of a tree gets a
+** copy in the arena, and the old one is left until the tree is freed.
+*/
+
+static gf_status
+file_info_assign_string(
+  gf_file_info* info, const gf_char** dst, const gf_char* src) {
+  gf_char* tmp = NULL;
+  gf_size_t len = gf_strlen(src);
+
+  if (!strcmp(*dst, src)) {
+    return GF_SUCCESS;
+  }
+  if (info->arena) {
+    _(file_info_arena_alloc(info->arena, len + 1, (gf_ptr*)&tmp));
+    memcpy(tmp, src, len + 1);
+  } else {
+    _(gf_strdup(&tmp, src));
+    file_info_free_string(*dst);
+  }
+  *dst = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Make sure the hash buffer can hold a hash of the size
+*/
+
+static gf_status
+file_info_reserve_hash(gf_file_info* info, gf_size_t size) {
+  gf_8u* tmp = NULL;
+
+  gf_validate(size <= GF_HASH_BUFSIZE_MAX);
+
+  if (size <= info->hash_capacity) {
+    return GF_SUCCESS;
+  }
+  /* A standalone node always has the room for the largest hash */
+  gf_validate(info->arena);
+
+  _(file_info_arena_alloc(info->arena, size, (gf_ptr*)&tmp));
+  memset(tmp, 0, size);
+  if (info->hash) {
+    memcpy(tmp, info->hash, info->hash_capacity);
+  }
+  info->hash = tmp;
+  info->hash_capacity = (gf_16u)size;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+file_info_set_path(gf_file_info* info, const gf_path* disp_path) {
+  gf_status rc = 0;
+  gf_path* file_name = NULL;
+
+  gf_validate(info);
+
+  /*
+  ** set full path name
+  */
+  _(file_info_assign_string(
+      info, &info->full_path, gf_path_get_string(disp_path)));
+  /*
+  ** set file name
+  */
+  _(gf_path_clone(&file_name, disp_path));
+  rc = gf_path_file_name(file_name);
+  if (rc == GF_SUCCESS) {
+    rc = file_info_assign_string(
+      info, &info->file_name, gf_path_get_string(file_name));
+  }
+  gf_path_free(file_name);
+  gf_throw(rc);
+  
+  return GF_SUCCESS;
+}
+
+static void
+file_info_copy_stat(gf_file_info* info, const struct stat64* st) {
+  info->inode       = st->st_ino;
+  info->mode        = st->st_mode;
+  info->link_count  = st->st_nlink;
+  info->uid         = st->st_uid;
+  info->gid         = st->st_gid;
+  info->device      = st->st_dev;
+  info->rdevice     = st->st_rdev;
+  info->file_size   = st->st_size;
+  info->access_time = st->st_atime;
+  info->modify_time = st->st_mtime;
+  info->create_time = st->st_ctime;
+}
+
+static gf_status
+file_info_set_stat(gf_file_info* info, const gf_path* path) {
+  int ret = 0;
+  struct stat64 st = { 0 };
+
+  gf_validate(info);
+  gf_validate(path);
+
+  ret = stat64(gf_path_get_string(path), &st);
+  if (ret != 0) {
+    gf_raise(GF_E_API, "Could not get a file information.");
+  }
+  file_info_copy_stat(info, &st);
+
+  return GF_SUCCESS;
+}
+
+#if !defined(_WIN32)
+/*!
+** @brief Get the stat information of an entry of the opened directory
+**
+** The entry is looked up relative to the directory descriptor, so that the
+** kernel does not resolve the whole path again for every entry.
+*/
+
+static gf_status
+file_info_set_stat_at(gf_file_info* info, int dirfd, const gf_char* name) {
+  int ret = 0;
+  struct stat64 st = { 0 };
+
+  gf_validate(info);
+  gf_validate(!gf_strnull(name));
+
+  ret = fstatat64(dirfd, name, &st, 0);
+  if (ret != 0) {
+    gf_raise(GF_E_API, "Could not get a file information. (%s)", name);
+  }
+  file_info_copy_stat(info, &st);
+
+  return GF_SUCCESS;
+}
+#endif
+
+static gf_status
+file_info_set_hash(gf_file_info* info, const gf_path* path) {
+  gf_validate(info);
+  gf_validate(info->hash_algorithm);
+  gf_validate(path);
+
+  _(gf_hash_file_with(
+      info->hash_algorithm, info->hash, info->hash_capacity, path));
+  
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Reuse the hash of the previous record if the file seems unchanged.
+**
+** The file is regarded as unchanged when the inode number, the size, the
+** modification time and the change (creation) time are equal to those of the
+** previous record. The hash is reused only if it was computed by the same
+** algorithm, so the records of the other algorithms (or of the old site.xml
+** without the algorithm name) are fingerprinted again.
+**
+** The times have one-second resolution, so a file modified in the same second
+** as the previous scan read it may keep all of them. Such a "racily clean"
+** record, whose modification time is not older than the scan which recorded
+** it (@a cache_time), is fingerprinted again.
+*/
+
+static gf_bool
+file_info_reuse_hash(
+  gf_file_info* info, const gf_map* cache, gf_64u cache_time) {
+  gf_any any = { 0 };
+  const gf_file_info* prev = NULL;
+  static const gf_8u zero[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  if (!cache) {
+    return GF_FALSE;
+  }
+  if (!gf_map_find(cache, info->full_path, &any)) {
+    return GF_FALSE;
+  }
+  prev = any.ptr;
+  if (!prev || !gf_file_info_is_file(prev) ||
+      prev->hash_algorithm != info->hash_algorithm ||
+      prev->hash_size != info->hash_size ||
+      prev->inode != info->inode ||
+      prev->file_size != info->file_size ||
+      prev->modify_time != info->modify_time ||
+      prev->create_time != info->create_time) {
+    return GF_FALSE;
+  }
+  if (prev->modify_time >= cache_time) {
+    return GF_FALSE;
+  }
+  /* A zero hash means the record has no valid hash */
+  if (!memcmp(prev->hash, zero, prev->hash_size)) {
+    return GF_FALSE;
+  }
+  memcpy(info->hash, prev->hash, prev->hash_size);
+
+  return GF_TRUE;
+}
+
+/*!
+** @brief Create a new standalone node
+**
+** The node has the room for the largest hash right after itself.
+*/
+
+static gf_status
+file_info_alloc(gf_file_info** info) {
+  gf_status rc = 0;
+  gf_file_info* tmp = NULL;
+
+  gf_validate(info);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp) + GF_HASH_BUFSIZE_MAX));
+  rc = file_info_init(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  tmp->hash = (gf_8u*)(tmp + 1);
+  tmp->hash_capacity = GF_HASH_BUFSIZE_MAX;
+  memset(tmp->hash, 0, GF_HASH_BUFSIZE_MAX);
+
+  *info = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Set the algorithm and the size of the hash
+**
+** The hash of a regular file is left empty, so that file_info_set_hash() can
+** fill it later.
+*/
+
+static gf_status
+file_info_prepare_hash(gf_file_info* info, const gf_hash_provider* hash) {
+  if (gf_file_info_is_file(info)) {
+    info->hash_algorithm = hash ? hash : gf_hash_get_default();
+    info->hash_size = (gf_16u)info->hash_algorithm->size;
+    _(file_info_reserve_hash(info, info->hash_size));
+  } else if (info->hash) {
+    // TODO: memset must be wrapped by gf_memset
+    memset(info->hash, 0, info->hash_size);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Create a new node with the stat information only
+*/
+
+static gf_status
+file_info_new_stat(
+  gf_file_info** info, const gf_path* disp_path, const gf_path* path,
+  const gf_hash_provider* hash) {
+  gf_status rc = 0;
+  gf_file_info* tmp = NULL;
+  
+  gf_validate(info);
+  
+  _(file_info_alloc(&tmp));
+  /* If a path is specified, we collect file information */
+  if (!gf_path_is_empty(disp_path) && !gf_path_is_empty(path)) {
+    rc = file_info_set_path(tmp, disp_path);
+    if (rc == GF_SUCCESS) {
+      rc = file_info_set_stat(tmp, path);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = file_info_prepare_hash(tmp, hash);
+    }
+    if (rc != GF_SUCCESS) {
+      gf_file_info_free(tmp);
+      gf_throw(rc);
+    }
+  }
+
+  *info = tmp;
+  
+  return GF_SUCCESS;
+}
+
+static gf_status
+file_info_new(
+  gf_file_info** info, const gf_path* disp_path, const gf_path* path,
+  const gf_map* cache, gf_64u cache_time, const gf_hash_provider* hash) {
+  gf_status rc = 0;
+  gf_file_info* tmp = NULL;
+
+  gf_validate(info);
+
+  _(file_info_new_stat(&tmp, disp_path, path, hash));
+  if (gf_file_info_is_file(tmp) &&
+      !file_info_reuse_hash(tmp, cache, cache_time)) {
+    rc = file_info_set_hash(tmp, path);
+    if (rc != GF_SUCCESS) {
+      gf_file_info_free(tmp);
+      gf_throw(rc);
+    }
+  }
+  *info = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_file_info_new(
+  gf_file_info** info, const gf_path* disp_path, const gf_path* path) {
+  return file_info_new(info, disp_path, path, NULL, 0, NULL);
+}
+
+gf_status
+gf_file_info_refresh(
+  gf_file_info* info, const gf_path* path, gf_bool* changed) {
+  gf_8u hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_16u hash_size = 0;
+  const gf_hash_provider* algorithm = NULL;
+
+  gf_validate(info);
+  gf_validate(path);
+  gf_validate(changed);
+
+  /* The previous fingerprint is compared with the new one */
+  if (info->hash) {
+    memcpy(hash, info->hash, info->hash_capacity);
+  }
+  hash_size = info->hash_size;
+  algorithm = info->hash_algorithm;
+
+  _(file_info_set_stat(info, path));
+  _(file_info_prepare_hash(info, algorithm));
+  if (gf_file_info_is_file(info)) {
+    _(file_info_set_hash(info, path));
+  }
+  *changed = (algorithm != info->hash_algorithm ||
+              hash_size != info->hash_size ||
+              (hash_size > 0 && memcmp(hash, info->hash, hash_size))) ?
+    GF_TRUE : GF_FALSE;
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*
+** Directory scanner
+**
+** The directory tree is scanned by a set of workers. Each worker owns a deque
+** of directories to be read. A worker pushes the sub-directories it finds to
+** the bottom of its own deque and takes its next task from there (depth
+** first). An idle worker steals from the top of the other deques, so it gets
+** the directory nearest to the root, which tends to be the largest subtree.
+**
+** The children of each directory are sorted by the file name after reading,
+** so that the result does not depend on the number of workers or on the
+** order of the entries returned by readdir().
+**
+** On POSIX systems, the entries are looked up relative to the descriptor of
+** the opened directory (fstatat), and the real path of an entry is built only
+** when it is needed: for a sub-directory to be queued, or for a file whose
+** hash has to be computed. The file name and the display path of a node are
+** taken from the directory entry and the parent node, without parsing paths.
+**
+** A walker reads all the names of a directory into its own buffer first, and
+** then allocates the children as one range of nodes from its pool.
+**
+** Reading the contents is decoupled from the walk. The walkers create the
+** nodes with the stat information only, and queue the regular files whose
+** hash cannot be reused into a bounded queue. A separate pool of hash
+** workers drains the queue and fills the hashes, so that a large file does
+** not hold up the walk. When the queue is full, the walker waits (a stall);
+** the scan finishes when the walkers are done and the queue is drained.
+*/
+
+#define FILE_INFO_SCAN_QUEUE_DEPTH 1024
+
+typedef struct file_info_scan_task {
+  gf_file_info* info;             ///< The directory node to be filled
+  gf_path*      path;             ///< The real path of the directory
+} file_info_scan_task;
+
+typedef struct file_info_hash_job {
+  gf_file_info* info;             ///< The file node to be hashed
+  gf_path*      path;             ///< The real path of the file
+} file_info_hash_job;
+
+typedef struct file_info_scan_deque {
+  gf_mutex             lock;
+  file_info_scan_task* tasks;
+  gf_size_t            head;      ///< The next task to be stolen
+  gf_size_t            tail;      ///< The end of the tasks (owner side)
+  gf_size_t            size;      ///< The capacity of tasks
+} file_info_scan_deque;
+
+typedef struct file_info_scanner file_info_scanner;
+
+typedef struct file_info_scan_worker {
+  file_info_scanner* scanner;
+  gf_size_t          index;
+  file_info_pool     pool;        ///< Allocates the nodes found
+  gf_char*           names;       ///< The names of the directory being read
+  gf_size_t          names_size;  ///< The capacity of names
+  const gf_char**    sorted;      ///< The names sorted
+  gf_size_t          sorted_size; ///< The capacity of sorted
+  gf_size_t          reused;      ///< Files whose hash was reused
+  gf_64u             stalls;      ///< Times the hash queue was full
+  gf_64u             stall_nsec;  ///< Time spent waiting for the queue
+} file_info_scan_worker;
+
+typedef struct file_info_hash_worker {
+  file_info_scanner* scanner;
+  gf_size_t          hashed;      ///< Files hashed
+  gf_64u             starved;     ///< Times the hash queue was empty
+  gf_64u             busy_nsec;   ///< Time spent on hashing
+} file_info_hash_worker;
+
+struct file_info_scanner {
+  file_info_arena*       arena;   ///< The owner of the nodes
+  const gf_map*          cache;   ///< Previous records (may be NULL)
+  gf_64u                 cache_time; ///< The time 'cache' was scanned
+  const gf_hash_provider* hash;   ///< The hash algorithm
+  file_info_scan_deque*  deques;
+  file_info_scan_worker* workers;
+  gf_size_t              count;   ///< The number of workers
+  gf_mutex               lock;    ///< Guards the members below
+  gf_cond                cond;
+  gf_size_t              pending; ///< Tasks queued or being processed
+  gf_size_t              queued;  ///< Tasks queued
+  gf_status              status;  ///< The first error occurred
+  /* The hash stage */
+  file_info_hash_worker* hashers;
+  gf_size_t              hasher_count;
+  gf_mutex               hash_lock; ///< Guards the hash queue
+  gf_cond                hash_ready; ///< A job is queued or the queue closed
+  gf_cond                hash_room; ///< A job is taken from the queue
+  file_info_hash_job*    jobs;    ///< Ring buffer of the hash jobs
+  gf_size_t              depth;   ///< The capacity of jobs
+  gf_size_t              head;    ///< The next job to be taken
+  gf_size_t              used;    ///< The number of jobs queued
+  gf_bool                closed;  ///< No more jobs will be queued
+};
+
+#define FILE_INFO_SCAN_DEQUE_CHUNK_SIZE 64
+
+static void
+file_info_scan_task_free(file_info_scan_task* task) {
+  if (task) {
+    gf_path_free(task->path);
+    task->info = NULL;
+    task->path = NULL;
+  }
+}
+
+static gf_status
+file_info_scan_deque_push(
+  file_info_scan_deque* deque, const file_info_scan_task* task) {
+  gf_status rc = 0;
+
+  gf_mutex_lock(&deque->lock);
+  if (deque->tail >= deque->size && deque->head > 0) {
+    /* Reuse the slots already stolen */
+    gf_size_t used = deque->tail - deque->head;
+    for (gf_size_t i = 0; i < used; i++) {
+      deque->tasks[i] = deque->tasks[deque->head + i];
+    }
+    deque->head = 0;
+    deque->tail = used;
+  }
+  if (deque->tail >= deque->size) {
+    gf_size_t size = deque->size + FILE_INFO_SCAN_DEQUE_CHUNK_SIZE;
+    rc = gf_realloc((gf_ptr*)&deque->tasks, sizeof(*deque->tasks) * size);
+    if (rc != GF_SUCCESS) {
+      gf_mutex_unlock(&deque->lock);
+      gf_throw(rc);
+    }
+    deque->size = size;
+  }
+  deque->tasks[deque->tail] = *task;
+  deque->tail += 1;
+  gf_mutex_unlock(&deque->lock);
+
+  return GF_SUCCESS;
+}
+
+static gf_bool
+file_info_scan_deque_pop(file_info_scan_deque* deque, file_info_scan_task* task) {
+  gf_bool ret = GF_FALSE;
+
+  gf_mutex_lock(&deque->lock);
+  if (deque->head < deque->tail) {
+    deque->tail -= 1;
+    *task = deque->tasks[deque->tail];
+    ret = GF_TRUE;
+  }
+  if (deque->head == deque->tail) {
+    deque->head = 0;
+    deque->tail = 0;
+  }
+  gf_mutex_unlock(&deque->lock);
+
+  return ret;
+}
+
+static gf_bool
+file_info_scan_deque_steal(
+  file_info_scan_deque* deque, file_info_scan_task* task) {
+  gf_bool ret = GF_FALSE;
+
+  gf_mutex_lock(&deque->lock);
+  if (deque->head < deque->tail) {
+    *task = deque->tasks[deque->head];
+    deque->head += 1;
+    ret = GF_TRUE;
+  }
+  if (deque->head == deque->tail) {
+    deque->head = 0;
+    deque->tail = 0;
+  }
+  gf_mutex_unlock(&deque->lock);
+
+  return ret;
+}
+
+static void
+file_info_scan_deque_clear(file_info_scan_deque* deque) {
+  for (gf_size_t i = deque->head; i < deque->tail; i++) {
+    file_info_scan_task_free(&deque->tasks[i]);
+  }
+  gf_free(deque->tasks);
+  deque->tasks = NULL;
+  deque->head = 0;
+  deque->tail = 0;
+  deque->size = 0;
+}
+
+static void
+file_info_scanner_set_error(file_info_scanner* scanner, gf_status rc) {
+  gf_mutex_lock(&scanner->lock);
+  if (scanner->status == GF_SUCCESS) {
+    scanner->status = rc;
+  }
+  gf_cond_broadcast(&scanner->cond);
+  gf_mutex_unlock(&scanner->lock);
+}
+
+static gf_status
+file_info_scanner_push(file_info_scan_worker* worker, file_info_scan_task* task) {
+  gf_status rc = 0;
+  file_info_scanner* scanner = worker->scanner;
+
+  /*
+  ** The counters are updated before the task becomes visible, so that a
+  ** thief never takes a task which has not been counted yet.
+  */
+  gf_mutex_lock(&scanner->lock);
+  scanner->pending += 1;
+  scanner->queued += 1;
+  gf_cond_signal(&scanner->cond);
+  gf_mutex_unlock(&scanner->lock);
+
+  rc = file_info_scan_deque_push(&scanner->deques[worker->index], task);
+  if (rc != GF_SUCCESS) {
+    gf_mutex_lock(&scanner->lock);
+    scanner->pending -= 1;
+    scanner->queued -= 1;
+    gf_mutex_unlock(&scanner->lock);
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_bool
+file_info_scanner_take(file_info_scan_worker* worker, file_info_scan_task* task) {
+  file_info_scanner* scanner = worker->scanner;
+  gf_bool found = GF_FALSE;
+
+  found = file_info_scan_deque_pop(&scanner->deques[worker->index], task);
+  for (gf_size_t i = 1; !found && i < scanner->count; i++) {
+    gf_size_t victim = (worker->index + i) % scanner->count;
+    found = file_info_scan_deque_steal(&scanner->deques[victim], task);
+  }
+  if (found) {
+    gf_mutex_lock(&scanner->lock);
+    scanner->queued -= 1;
+    gf_mutex_unlock(&scanner->lock);
+  }
+
+  return found;
+}
+
+static void
+file_info_scanner_done(file_info_scanner* scanner) {
+  gf_mutex_lock(&scanner->lock);
+  scanner->pending -= 1;
+  if (scanner->pending == 0) {
+    gf_cond_broadcast(&scanner->cond);
+  }
+  gf_mutex_unlock(&scanner->lock);
+}
+
+static gf_status
+file_info_scanner_get_status(file_info_scanner* scanner) {
+  gf_status rc = 0;
+
+  gf_mutex_lock(&scanner->lock);
+  rc = scanner->status;
+  gf_mutex_unlock(&scanner->lock);
+
+  return rc;
+}
+
+/*!
+** @brief Queue a file to be hashed by the hash workers
+**
+** The job (and the ownership of its path) is passed to the hash stage. If the
+** queue is full, the walker waits until a hash worker takes a job.
+*/
+
+static void
+file_info_scanner_push_hash(
+  file_info_scan_worker* worker, const file_info_hash_job* job) {
+  file_info_scanner* scanner = worker->scanner;
+  gf_64u start = 0;
+
+  gf_mutex_lock(&scanner->hash_lock);
+  if (scanner->used == scanner->depth) {
+    worker->stalls += 1;
+    start = gf_datetime_get_monotonic_ns();
+    while (scanner->used == scanner->depth) {
+      gf_cond_wait(&scanner->hash_room, &scanner->hash_lock);
+    }
+    worker->stall_nsec += gf_datetime_get_monotonic_ns() - start;
+  }
+  scanner->jobs[(scanner->head + scanner->used) % scanner->depth] = *job;
+  scanner->used += 1;
+  gf_cond_signal(&scanner->hash_ready);
+  gf_mutex_unlock(&scanner->hash_lock);
+}
+
+static gf_bool
+file_info_scanner_take_hash(
+  file_info_hash_worker* worker, file_info_hash_job* job) {
+  file_info_scanner* scanner = worker->scanner;
+  gf_bool found = GF_FALSE;
+
+  gf_mutex_lock(&scanner->hash_lock);
+  if (scanner->used == 0 && !scanner->closed) {
+    worker->starved += 1;
+    while (scanner->used == 0 && !scanner->closed) {
+      gf_cond_wait(&scanner->hash_ready, &scanner->hash_lock);
+    }
+  }
+  if (scanner->used > 0) {
+    *job = scanner->jobs[scanner->head];
+    scanner->head = (scanner->head + 1) % scanner->depth;
+    scanner->used -= 1;
+    gf_cond_signal(&scanner->hash_room);
+    found = GF_TRUE;
+  }
+  gf_mutex_unlock(&scanner->hash_lock);
+
+  return found;
+}
+
+static void
+file_info_scanner_close_hash(file_info_scanner* scanner) {
+  gf_mutex_lock(&scanner->hash_lock);
+  scanner->closed = GF_TRUE;
+  gf_cond_broadcast(&scanner->hash_ready);
+  gf_mutex_unlock(&scanner->hash_lock);
+}
+
+static void
+file_info_hash_worker_run(gf_ptr data) {
+  gf_status rc = 0;
+  file_info_hash_worker* worker = data;
+  file_info_scanner* scanner = worker->scanner;
+  file_info_hash_job job = { 0 };
+  gf_64u start = 0;
+
+  /* Keep draining after an error, so that no walker waits forever */
+  while (file_info_scanner_take_hash(worker, &job)) {
+    if (file_info_scanner_get_status(scanner) == GF_SUCCESS) {
+      start = gf_datetime_get_monotonic_ns();
+      rc = file_info_set_hash(job.info, job.path);
+      worker->busy_nsec += gf_datetime_get_monotonic_ns() - start;
+      worker->hashed += 1;
+      if (rc != GF_SUCCESS) {
+        file_info_scanner_set_error(scanner, rc);
+      }
+    }
+    gf_path_free(job.path);
+  }
+}
+
+static int
+file_info_compare_name(const void* lhs, const void* rhs) {
+  return strcmp(*(const gf_char* const*)lhs, *(const gf_char* const*)rhs);
+}
+
+/*!
+** @brief Read the names of the entries into the buffer of the worker
+**
+** The names are sorted, so that the children are allocated in order.
+*/
+
 static gf_status
-file_info_init(gf_file_info* info) {
-  gf_validate(info);
+file_info_scan_read_names(
+  file_info_scan_worker* worker, DIR* dp, gf_size_t* count) {
+  struct dirent* ep = NULL;
+  gf_size_t used = 0;
+  gf_size_t cnt = 0;
 
-  info->file_name = NULL;
-  info->full_path = NULL;
-  info->inode = 0;
-  info->mode = 0;
-  info->link_count= 0;
-  info->uid = 0;
-  info->gid = 0;
-  info->device = 0;
-  info->rdevice = 0;
-  info->file_size = 0;
-  info->access_time = 0;
-  info->modify_time = 0;
-  info->create_time = 0;
-  info->children = NULL;
+  while ((ep = readdir(dp)) != NULL) {
+    gf_size_t len = 0;
+
+    if (!strcmp(ep->d_name, ".") || !strcmp(ep->d_name, "..")) {
+      continue;
+    }
+    len = gf_strlen(ep->d_name) + 1;
+    if (used + len > worker->names_size) {
+      gf_size_t size = (used + len) * 2;
+      _(gf_realloc((gf_ptr*)&worker->names, size));
+      worker->names_size = size;
+    }
+    memcpy(worker->names + used, ep->d_name, len);
+    used += len;
+    cnt += 1;
+  }
+  if (cnt > worker->sorted_size) {
+    _(gf_realloc((gf_ptr*)&worker->sorted, sizeof(*worker->sorted) * cnt));
+    worker->sorted_size = cnt;
+  }
+  /* The buffer may have moved while reading, so it is indexed afterwards */
+  used = 0;
+  for (gf_size_t i = 0; i < cnt; i++) {
+    worker->sorted[i] = worker->names + used;
+    used += gf_strlen(worker->names + used) + 1;
+  }
+  qsort(worker->sorted, cnt, sizeof(*worker->sorted), file_info_compare_name);
+  *count = cnt;
 
-  info->user_data.data = 0;
-  info->user_flag = 0;
-  
-  info->hash_size = GF_HASH_BUFSIZE_SHA512;
-  _(gf_bzero(info->hash, info->hash_size));
-  
   return GF_SUCCESS;
 }
 
-static gf_status
-file_info_set_path(gf_file_info* info, const gf_path* disp_path) {
-  gf_status rc = 0;
-  gf_path* file_name = NULL;
-  
-  gf_validate(info);
+/*!
+** @brief Fill the node of an entry of the directory being scanned
+**
+** The display path is that of the parent followed by the name, and the file
+** name is the tail of it.
+**
+** @param [in] dirfd The descriptor of the opened directory (POSIX only)
+*/
 
-  /*
-  ** set full path name
-  */
-  rc = gf_path_copy(info->full_path, disp_path);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+static gf_status
+file_info_scan_fill_child(
+  file_info_scan_worker* worker, gf_file_info* child,
+  const file_info_scan_task* task, int dirfd, const gf_char* name) {
+  const gf_char* parent = task->info->full_path;
+  gf_size_t parent_len = gf_strlen(parent);
+  gf_size_t name_len = gf_strlen(name);
+  gf_char* full_path = NULL;
+
+  (void)file_info_init(child);
+  child->arena = worker->pool.arena;
+
+  /* The root is "/", whose children are "/name" */
+  if (parent_len > 0 && parent[parent_len - 1] == GF_PATH_SEPARATOR_CHAR) {
+    parent_len -= 1;
   }
-  /*
-  ** set file name
-  */
-  rc = gf_path_clone(&file_name, disp_path);
-  if (rc != GF_SUCCESS) {
+  _(file_info_pool_alloc(
+      &worker->pool, parent_len + name_len + 2, 1, (gf_ptr*)&full_path));
+  memcpy(full_path, parent, parent_len);
+  full_path[parent_len] = GF_PATH_SEPARATOR_CHAR;
+  memcpy(full_path + parent_len + 1, name, name_len + 1);
+  child->full_path = full_path;
+  child->file_name = full_path + parent_len + 1;
+
+#if defined(_WIN32)
+  {
+    gf_status rc = 0;
+    gf_path* path = NULL;
+
+    (void)dirfd;
+
+    _(gf_path_append_string(&path, task->path, name));
+    rc = file_info_set_stat(child, path);
+    gf_path_free(path);
     gf_throw(rc);
   }
+#else
+  _(file_info_set_stat_at(child, dirfd, name));
+#endif
+  if (gf_file_info_is_file(child)) {
+    const gf_hash_provider* hash = worker->scanner->hash;
+
+    child->hash_algorithm = hash ? hash : gf_hash_get_default();
+    child->hash_size = (gf_16u)child->hash_algorithm->size;
+    child->hash_capacity = child->hash_size;
+    _(file_info_pool_alloc(
+        &worker->pool, child->hash_size, 1, (gf_ptr*)&child->hash));
+    memset(child->hash, 0, child->hash_size);
+  }
 
-  rc = gf_path_file_name(file_name);
-  if (rc != GF_SUCCESS) {
-    gf_path_free(file_name);
-    gf_throw(rc);
+  return GF_SUCCESS;
+}
+
+static gf_status
+file_info_scan_entry(
+  file_info_scan_worker* worker, file_info_scan_task* task,
+  gf_file_info* child, const gf_char* name) {
+  gf_status rc = 0;
+  file_info_scanner* scanner = worker->scanner;
+  file_info_scan_task sub = { 0 };
+
+  if (gf_file_info_is_directory(child)) {
+    /* The child is owned by the tree; the task is filled later */
+    _(gf_path_append_string(&sub.path, task->path, name));
+    sub.info = child;
+    rc = file_info_scanner_push(worker, &sub);
+  } else if (gf_file_info_is_file(child)) {
+    if (file_info_reuse_hash(
+          child, scanner->cache, scanner->cache_time)) {
+      worker->reused += 1;
+      return GF_SUCCESS;
+    }
+    /* The real path is needed only to read the contents */
+    _(gf_path_append_string(&sub.path, task->path, name));
+    if (scanner->hasher_count == 0) {
+      /* No hash worker; hash it here */
+      rc = file_info_set_hash(child, sub.path);
+    } else {
+      file_info_hash_job job = { .info = child, .path = sub.path };
+      sub.path = NULL;
+      file_info_scanner_push_hash(worker, &job);
+    }
   }
-  rc = gf_path_copy(info->file_name, file_name);
-  gf_path_free(file_name);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+  if (!sub.info || rc != GF_SUCCESS) {
+    file_info_scan_task_free(&sub);
   }
-  
+  gf_throw(rc);
+
   return GF_SUCCESS;
 }
 
 static gf_status
-file_info_set_stat(gf_file_info* info, const gf_path* path) {
-  int ret = 0;
-  struct stat64 st = { 0 };
+file_info_scan_children(
+  file_info_scan_worker* worker, file_info_scan_task* task, int fd,
+  gf_size_t count) {
+  gf_file_info* children = NULL;
 
-  gf_validate(info);
-  gf_validate(path);
+  if (count == 0) {
+    return GF_SUCCESS;
+  }
+  _(file_info_pool_alloc(
+      &worker->pool, sizeof(*children) * count, _Alignof(gf_file_info),
+      (gf_ptr*)&children));
+  /* The range is complete before any of the children is queued */
+  for (gf_size_t i = 0; i < count; i++) {
+    _(file_info_scan_fill_child(
+        worker, &children[i], task, fd, worker->sorted[i]));
+  }
+  task->info->children = children;
+  task->info->child_count = count;
 
-  ret = stat64(gf_path_get_string(path), &st);
-  if (ret != 0) {
-    gf_raise(GF_E_API, "Could not get a file information.");
+  for (gf_size_t i = 0; i < count; i++) {
+    _(file_info_scan_entry(worker, task, &children[i], worker->sorted[i]));
   }
-  info->inode       = st.st_ino;
-  info->mode        = st.st_mode;
-  info->link_count  = st.st_nlink;
-  info->uid         = st.st_uid;
-  info->gid         = st.st_gid;
-  info->device      = st.st_dev;
-  info->rdevice     = st.st_rdev;
-  info->file_size   = st.st_size;
-  info->access_time = st.st_atime;
-  info->modify_time = st.st_mtime;
-  info->create_time = st.st_ctime;
 
   return GF_SUCCESS;
 }
 
 static gf_status
-file_info_set_hash(gf_file_info* info, const gf_path* path) {
-  gf_validate(info);
-  gf_validate(path);
+file_info_scan_directory(
+  file_info_scan_worker* worker, file_info_scan_task* task) {
+  gf_status rc = 0;
+  DIR* dp = NULL;
+  int fd = -1;
+  gf_size_t count = 0;
+
+  dp = opendir(gf_path_get_string(task->path));
+  if (!dp) {
+    gf_raise(GF_E_API, "Couldn't open the directory.");
+  }
+#if !defined(_WIN32)
+  fd = dirfd(dp);
+#endif
+  rc = file_info_scan_read_names(worker, dp, &count);
+  if (rc == GF_SUCCESS) {
+    rc = file_info_scan_children(worker, task, fd, count);
+  }
+  (void)closedir(dp);
+  gf_throw(rc);
 
-  _(gf_hash_file(info->hash, GF_HASH_BUFSIZE_SHA512, path));
-  
   return GF_SUCCESS;
 }
 
 static void
-file_info_free(gf_any* any) {
-  if (any) {
-    if (any->ptr) {
-      gf_file_info_free((gf_file_info*)any->ptr);
+file_info_scan_worker_run(gf_ptr data) {
+  gf_status rc = 0;
+  file_info_scan_worker* worker = data;
+  file_info_scanner* scanner = worker->scanner;
+  file_info_scan_task task = { 0 };
+  gf_bool finished = GF_FALSE;
+
+  while (!finished) {
+    if (file_info_scanner_take(worker, &task)) {
+      gf_mutex_lock(&scanner->lock);
+      rc = scanner->status;
+      gf_mutex_unlock(&scanner->lock);
+      if (rc == GF_SUCCESS) {
+        rc = file_info_scan_directory(worker, &task);
+        if (rc != GF_SUCCESS) {
+          file_info_scanner_set_error(scanner, rc);
+        }
+      }
+      file_info_scan_task_free(&task);
+      file_info_scanner_done(scanner);
+      continue;
+    }
+    /* Nothing to take; wait for new tasks or the end of the scan */
+    gf_mutex_lock(&scanner->lock);
+    while (scanner->queued == 0 && scanner->pending > 0 &&
+           scanner->status == GF_SUCCESS) {
+      gf_cond_wait(&scanner->cond, &scanner->lock);
     }
+    finished = scanner->pending == 0 || scanner->status != GF_SUCCESS;
+    gf_mutex_unlock(&scanner->lock);
   }
 }
 
 static gf_status
-file_info_prepare_path(gf_file_info* info) {
-  gf_validate(info);
+file_info_scanner_init(file_info_scanner* scanner) {
+  gf_validate(scanner);
+
+  scanner->arena = NULL;
+  scanner->cache = NULL;
+  scanner->cache_time = 0;
+  scanner->hash = NULL;
+  scanner->deques = NULL;
+  scanner->workers = NULL;
+  scanner->count = 0;
+  scanner->pending = 0;
+  scanner->queued = 0;
+  scanner->status = GF_SUCCESS;
+  scanner->hashers = NULL;
+  scanner->hasher_count = 0;
+  scanner->jobs = NULL;
+  scanner->depth = 0;
+  scanner->head = 0;
+  scanner->used = 0;
+  scanner->closed = GF_FALSE;
 
-  _(gf_path_new(&info->file_name, ""));
-  _(gf_path_new(&info->full_path, ""));
-  
   return GF_SUCCESS;
 }
 
 static gf_status
-file_info_prepare_children(gf_file_info* info) {
-  gf_array* children = 0;
-  
-  gf_validate(info);
+file_info_scanner_prepare(
+  file_info_scanner* scanner, gf_size_t count, gf_size_t hashers,
+  gf_size_t depth) {
+  gf_size_t size = 0;
+
+  gf_validate(scanner);
+  gf_validate(count > 0);
+  gf_validate(hashers > 0);
+  gf_validate(depth > 0);
+
+  _(gf_mutex_init(&scanner->lock));
+  _(gf_cond_init(&scanner->cond));
+  _(gf_mutex_init(&scanner->hash_lock));
+  _(gf_cond_init(&scanner->hash_ready));
+  _(gf_cond_init(&scanner->hash_room));
+
+  _(gf_malloc((gf_ptr*)&scanner->jobs, sizeof(*scanner->jobs) * depth));
+  scanner->depth = depth;
+  size = sizeof(*scanner->hashers) * hashers;
+  _(gf_malloc((gf_ptr*)&scanner->hashers, size));
+  _(gf_bzero(scanner->hashers, size));
+  for (gf_size_t i = 0; i < hashers; i++) {
+    scanner->hashers[i].scanner = scanner;
+  }
+  scanner->hasher_count = hashers;
+
+  size = sizeof(*scanner->deques) * count;
+  _(gf_malloc((gf_ptr*)&scanner->deques, size));
+  _(gf_bzero(scanner->deques, size));
+  size = sizeof(*scanner->workers) * count;
+  _(gf_malloc((gf_ptr*)&scanner->workers, size));
+  _(gf_bzero(scanner->workers, size));
+
+  for (gf_size_t i = 0; i < count; i++) {
+    _(gf_mutex_init(&scanner->deques[i].lock));
+    scanner->workers[i].scanner = scanner;
+    scanner->workers[i].index = i;
+    scanner->workers[i].pool.arena = scanner->arena;
+    scanner->count += 1;
+  }
 
-  _(gf_array_new(&children));
-  info->children = children;
-  _(gf_array_set_free_fn(info->children, file_info_free));
-  
   return GF_SUCCESS;
 }
 
-gf_status
-gf_file_info_new(
-  gf_file_info** info, const gf_path* disp_path, const gf_path* path) {
-  gf_status rc = 0;
-  gf_file_info* tmp = NULL;
-  
-  gf_validate(info);
-  
-  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
-  rc = file_info_init(tmp);
-  if (rc != GF_SUCCESS) {
-    gf_free(tmp);
-    gf_throw(rc);
-  }
-  rc = file_info_prepare_path(tmp);
-  if (rc != GF_SUCCESS) {
-    gf_file_info_free(tmp);
-    gf_throw(rc);
+static void
+file_info_scanner_release(file_info_scanner* scanner) {
+  for (gf_size_t i = 0; i < scanner->count; i++) {
+    file_info_scan_deque_clear(&scanner->deques[i]);
+    gf_mutex_destroy(&scanner->deques[i].lock);
+    gf_free(scanner->workers[i].names);
+    gf_free(scanner->workers[i].sorted);
   }
-  rc = file_info_prepare_children(tmp);
-  if (rc != GF_SUCCESS) {
-    gf_file_info_free(tmp);
-    gf_throw(rc);
+  for (gf_size_t i = 0; i < scanner->used; i++) {
+    gf_path_free(scanner->jobs[(scanner->head + i) % scanner->depth].path);
   }
-  /* If a path is specified, we collect file information */
-  if (!gf_path_is_empty(disp_path) && !gf_path_is_empty(path)) {
-    rc = file_info_set_path(tmp, disp_path);
+  gf_free(scanner->deques);
+  gf_free(scanner->workers);
+  gf_free(scanner->jobs);
+  gf_free(scanner->hashers);
+  gf_cond_destroy(&scanner->hash_room);
+  gf_cond_destroy(&scanner->hash_ready);
+  gf_mutex_destroy(&scanner->hash_lock);
+  gf_cond_destroy(&scanner->cond);
+  gf_mutex_destroy(&scanner->lock);
+  (void)file_info_scanner_init(scanner);
+}
+
+static gf_size_t
+file_info_scanner_start_hashers(file_info_scanner* scanner, gf_thread* threads) {
+  gf_size_t started = 0;
+
+  for (gf_size_t i = 0; i < scanner->hasher_count; i++) {
+    gf_status rc = gf_thread_create(
+      &threads[i], file_info_hash_worker_run, &scanner->hashers[i]);
     if (rc != GF_SUCCESS) {
-      gf_file_info_free(tmp);
-      gf_throw(rc);
+      break;
     }
-    rc = file_info_set_stat(tmp, path);
+    started += 1;
+  }
+  if (started < scanner->hasher_count) {
+    gf_warn("Hashing with %zu worker(s).", started);
+  }
+  /* Without any hash worker, the walkers hash the files by themselves */
+  scanner->hasher_count = started;
+
+  return started;
+}
+
+static void
+file_info_scanner_collect_stats(
+  const file_info_scanner* scanner, gf_file_info_scan_stats* stats) {
+  for (gf_size_t i = 0; i < scanner->count; i++) {
+    stats->reused     += scanner->workers[i].reused;
+    stats->stalls     += scanner->workers[i].stalls;
+    stats->stall_nsec += scanner->workers[i].stall_nsec;
+  }
+  for (gf_size_t i = 0; i < scanner->hasher_count; i++) {
+    stats->hashed    += scanner->hashers[i].hashed;
+    stats->starved   += scanner->hashers[i].starved;
+    stats->hash_nsec += scanner->hashers[i].busy_nsec;
+  }
+  stats->walkers = scanner->count;
+  stats->hashers = scanner->hasher_count;
+}
+
+static gf_status
+file_info_scanner_run(
+  file_info_scanner* scanner, gf_file_info_scan_stats* stats) {
+  gf_status rc = 0;
+  gf_thread* threads = NULL;
+  gf_thread* hashers = NULL;
+  gf_size_t started = 0;
+  gf_size_t hashing = 0;
+  gf_64u start = gf_datetime_get_monotonic_ns();
+
+  _(gf_malloc((gf_ptr*)&hashers, sizeof(*hashers) * scanner->hasher_count));
+  hashing = file_info_scanner_start_hashers(scanner, hashers);
+
+  if (scanner->count > 1) {
+    rc = gf_malloc((gf_ptr*)&threads, sizeof(*threads) * scanner->count);
     if (rc != GF_SUCCESS) {
-      gf_file_info_free(tmp);
+      file_info_scanner_close_hash(scanner);
+      for (gf_size_t i = 0; i < hashing; i++) {
+        (void)gf_thread_join(hashers[i]);
+      }
+      gf_free(hashers);
       gf_throw(rc);
     }
-    if (gf_file_info_is_file(tmp)) {
-      rc = file_info_set_hash(tmp, path);
+    /* The calling thread works as the worker #0 */
+    for (gf_size_t i = 1; i < scanner->count; i++) {
+      rc = gf_thread_create(
+        &threads[i], file_info_scan_worker_run, &scanner->workers[i]);
       if (rc != GF_SUCCESS) {
-        gf_file_info_free(tmp);
-        gf_throw(rc);
+        break;
       }
-    } else {
-      // TODO: memset must be wrapped by gf_memset
-      memset(tmp->hash, 0, tmp->hash_size);
+      started += 1;
+    }
+    if (rc != GF_SUCCESS) {
+      gf_warn("Scanning with %zu worker(s).", started + 1);
     }
   }
+  file_info_scan_worker_run(&scanner->workers[0]);
+
+  for (gf_size_t i = 1; i <= started; i++) {
+    (void)gf_thread_join(threads[i]);
+  }
+  gf_free(threads);
+  stats->walk_nsec = gf_datetime_get_monotonic_ns() - start;
+
+  /* Let the hash workers drain the queue and finish */
+  file_info_scanner_close_hash(scanner);
+  for (gf_size_t i = 0; i < hashing; i++) {
+    (void)gf_thread_join(hashers[i]);
+  }
+  gf_free(hashers);
+  stats->total_nsec = gf_datetime_get_monotonic_ns() - start;
+  file_info_scanner_collect_stats(scanner, stats);
+
+  gf_throw(scanner->status);
 
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Create the root node of a tree in the arena
+**
+** The root frees the arena. The rest of the block is passed to the walker #0
+** through @a pool.
+*/
+
+static gf_status
+file_info_new_root(
+  gf_file_info** info, file_info_pool* pool, const gf_path* disp_path,
+  const gf_path* path, const gf_file_info_scan_option* option) {
+  gf_file_info* tmp = NULL;
+  gf_char* full_path = NULL;
+  const gf_char* str = gf_path_get_string(disp_path);
+
+  _(file_info_pool_alloc(
+      pool, sizeof(*tmp), _Alignof(gf_file_info), (gf_ptr*)&tmp));
+  (void)file_info_init(tmp);
+  tmp->arena = pool->arena;
+  pool->arena->root = tmp;
+
+  /* The name of the root is the root itself ("/") */
+  _(file_info_pool_strdup(pool, str, gf_strlen(str), &full_path));
+  tmp->full_path = full_path;
+  tmp->file_name = full_path;
+
+  _(file_info_set_stat(tmp, path));
+  _(file_info_prepare_hash(tmp, option->hash));
+  if (gf_file_info_is_file(tmp) &&
+      !file_info_reuse_hash(tmp, option->cache, option->cache_time)) {
+    _(file_info_set_hash(tmp, path));
+  }
   *info = tmp;
-  
+
   return GF_SUCCESS;
 }
 
 static gf_status
 file_info_scan(
-  gf_file_info** info, const gf_path* relpath, const gf_path* path) {
+  gf_file_info** info, const gf_path* relpath, const gf_path* path,
+  const gf_file_info_scan_option* option) {
   gf_status rc = 0;
-
-  rc = gf_file_info_new(info, relpath, path);
+  gf_file_info* tmp = NULL;
+  file_info_scanner scanner;
+  file_info_scan_task task = { 0 };
+  file_info_pool pool = { 0 };
+  gf_file_info_scan_stats stats = { 0 };
+  gf_size_t depth = 0;
+
+  _(file_info_arena_new(&pool.arena));
+  rc = file_info_new_root(&tmp, &pool, relpath, path, option);
   if (rc != GF_SUCCESS) {
+    /* The root may not have been created */
+    file_info_arena_free(pool.arena);
     gf_throw(rc);
   }
-  if (gf_file_info_is_directory(*info)) {
-    DIR* dp = NULL;
-    struct dirent* ep = NULL;
-
-    dp = opendir(gf_path_get_string(path));
-    if (!dp) {
-      gf_raise(GF_E_API, "Couldn't open the directory.");
-    }
-    while ((ep = readdir(dp)) != NULL) {
-      gf_file_info* child = NULL;
-      gf_path* child_path = NULL;
-      gf_path* child_relpath = NULL;
+  if (!gf_file_info_is_directory(tmp)) {
+    *info = tmp;
+    return GF_SUCCESS;
+  }
 
-      if (!strcmp(ep->d_name, ".") || !strcmp(ep->d_name, "..")) {
-        continue;
-      }
-      rc = gf_path_append_string(&child_path, path, ep->d_name);
-      if (rc != GF_SUCCESS) {
-        (void)closedir(dp);
-        gf_throw(rc);
-      }
-      rc = gf_path_append_string(&child_relpath, relpath, ep->d_name);
-      if (rc != GF_SUCCESS) {
-        (void)closedir(dp);
-        gf_path_free(child_path);
-        gf_throw(rc);
-      }
-      rc = file_info_scan(&child, child_relpath, child_path);
-      gf_path_free(child_path);
-      gf_path_free(child_relpath);
-      if (rc != GF_SUCCESS) {
-        (void)closedir(dp);
-        gf_throw(rc);
-      }
-      rc = gf_file_info_add_child(*info, child);
-      if (rc != GF_SUCCESS) {
-        (void)closedir(dp);
-        gf_throw(rc);
-      }
-    }
-    (void)closedir(dp);
+  depth = option->queue_depth > 0 ?
+    option->queue_depth : FILE_INFO_SCAN_QUEUE_DEPTH;
+
+  (void)file_info_scanner_init(&scanner);
+  scanner.arena = pool.arena;
+  scanner.cache = option->cache;
+  scanner.cache_time = option->cache_time;
+  scanner.hash = option->hash;
+  rc = file_info_scanner_prepare(
+    &scanner,
+    gf_thread_resolve_count((gf_int)option->threads),
+    gf_thread_resolve_count((gf_int)option->hash_threads),
+    depth);
+  if (rc == GF_SUCCESS) {
+    scanner.workers[0].pool = pool;
+    task.info = tmp;
+    rc = gf_path_clone(&task.path, path);
   }
-  
+  if (rc == GF_SUCCESS) {
+    rc = file_info_scanner_push(&scanner.workers[0], &task);
+  } else {
+    file_info_scan_task_free(&task);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = file_info_scanner_run(&scanner, &stats);
+  }
+  file_info_scanner_release(&scanner);
+  stats.arena_size = pool.arena->reserved;
+  if (option->stats) {
+    *option->stats = stats;
+  }
+  if (rc != GF_SUCCESS) {
+    gf_file_info_free(tmp);
+    gf_throw(rc);
+  }
+  *info = tmp;
+
   return GF_SUCCESS;
 }
 
 gf_status
 gf_file_info_scan(gf_file_info** info, const gf_path* path) {
+  gf_file_info_scan_option option = { 0 };
+
+  option.threads = 1;
+  option.hash_threads = 1;
+
+  return gf_file_info_scan_with_option(info, path, &option);
+}
+
+gf_status
+gf_file_info_scan_with_option(
+  gf_file_info** info, const gf_path* path,
+  const gf_file_info_scan_option* option) {
   gf_status rc = 0;
   gf_path* root = NULL;
-  
+
   gf_validate(info);
   gf_validate(path);
+  gf_validate(option);
 
   _(gf_path_new(&root, GF_PATH_SEPARATOR));
 
   /* Do scan */
-  rc = file_info_scan(info, root, path);
+  rc = file_info_scan(info, root, path, option);
   gf_path_free(root);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
@@ -304,15 +1513,15 @@ gf_file_info_scan(gf_file_info** info, const gf_path* path) {
 void
 gf_file_info_free(gf_file_info* info) {
   if (info) {
-    if (info->file_name) {
-      gf_path_free(info->file_name);
-    }
-    if (info->full_path) {
-      gf_path_free(info->full_path);
-    }
-    if (info->children) {
-      gf_array_free(info->children);
+    if (info->arena) {
+      /* The other nodes of a tree are freed with the root */
+      if (info->arena->root == info) {
+        file_info_arena_free(info->arena);
+      }
+      return;
     }
+    file_info_free_string(info->file_name);
+    file_info_free_string(info->full_path);
     (void)file_info_init(info);
     gf_free(info);
   }
@@ -330,11 +1539,15 @@ gf_file_info_copy(gf_file_info* dst, const gf_file_info* src) {
   gf_validate(dst);
   gf_validate(src);
 
-  _(gf_path_copy(dst->file_name, src->file_name));
-  _(gf_path_copy(dst->full_path, src->full_path));
+  if (dst == src) {
+    return GF_SUCCESS;
+  }
+  _(file_info_assign_string(dst, &dst->file_name, src->file_name));
+  _(file_info_assign_string(dst, &dst->full_path, src->full_path));
+  _(file_info_reserve_hash(dst, src->hash_size));
 
   /* NOTE: We don't touch the member 'dst->children' */
-  dst->inode          = dst->inode;
+  dst->inode          = src->inode;
   dst->mode           = src->mode;
   dst->link_count     = src->link_count;
   dst->uid            = src->uid;
@@ -348,8 +1561,11 @@ gf_file_info_copy(gf_file_info* dst, const gf_file_info* src) {
   dst->user_data.data = src->user_data.data;
   dst->user_flag      = src->user_flag;
   dst->hash_size      = src->hash_size;
+  dst->hash_algorithm = src->hash_algorithm;
 
-  _(gf_memcpy(dst->hash, src->hash, src->hash_size));
+  if (src->hash_size > 0) {
+    _(gf_memcpy(dst->hash, src->hash, src->hash_size));
+  }
 
   return GF_SUCCESS;
 }
@@ -385,35 +1601,49 @@ gf_file_info_is_directory(const gf_file_info* info) {
 
 gf_size_t
 gf_file_info_count_children(const gf_file_info* info) {
-  return info && info->children ? gf_array_size(info->children) : 0;
+  return info ? info->child_count : 0;
 }
 
 gf_status
-gf_file_info_add_child(gf_file_info* info, gf_file_info* child) {
-  gf_any any = { 0 };
-  
+gf_file_info_get_child(
+  const gf_file_info* info, gf_size_t index, gf_file_info** child) {
   gf_validate(info);
+  gf_validate(index < info->child_count);
   gf_validate(child);
 
-  any.ptr = child;
-  _(gf_array_add(info->children, any));
-  
+  *child = &info->children[index];
+
   return GF_SUCCESS;
 }
 
-gf_status
-gf_file_info_get_child(
-  const gf_file_info* info, gf_size_t index, gf_file_info** child) {
-  gf_any any = { 0 };
-  
-  gf_validate(info);
-  gf_validate(info->children);
-  gf_validate(child);
+gf_bool
+gf_file_info_find_child(
+  const gf_file_info* info, const gf_char* file_name, gf_file_info** child) {
+  gf_size_t lo = 0;
+  gf_size_t hi = 0;
 
-  _(gf_array_get(info->children, index, &any));
-  *child = any.ptr;
+  if (!info || gf_strnull(file_name)) {
+    return GF_FALSE;
+  }
+  /* The children are sorted by the scanner */
+  hi = info->child_count;
+  while (lo < hi) {
+    gf_size_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(info->children[mid].file_name, file_name);
+
+    if (cmp == 0) {
+      if (child) {
+        *child = &info->children[mid];
+      }
+      return GF_TRUE;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
 
-  return GF_SUCCESS;
+  return GF_FALSE;
 }
 
 gf_status
@@ -422,7 +1652,7 @@ gf_file_info_get_file_name(
   gf_validate(info);
   gf_validate(file_name);
 
-  *file_name = gf_path_get_string(info->file_name);
+  *file_name = info->file_name;
 
   return GF_SUCCESS;
 }
@@ -435,7 +1665,7 @@ gf_file_info_does_file_name_equal(
   if (!info || gf_strnull(file_name)) {
     return GF_FALSE;
   }
-  if (!strcmp(gf_path_get_string(info->file_name), file_name)) {
+  if (!strcmp(info->file_name, file_name)) {
     ret = GF_TRUE;
   } else {
     ret = GF_FALSE;
@@ -451,7 +1681,7 @@ gf_file_info_get_full_path(
   gf_validate(info);
   gf_validate(full_path);
 
-  *full_path = gf_path_get_string(info->full_path);
+  *full_path = info->full_path;
 
   return GF_SUCCESS;
 }
@@ -462,7 +1692,9 @@ gf_file_info_get_hash(const gf_file_info* info, gf_size_t size, gf_8u* hash) {
   gf_validate(size >= info->hash_size);
   gf_validate(hash);
 
-  _(gf_memcpy(hash, info->hash, info->hash_size));
+  if (info->hash_size > 0) {
+    _(gf_memcpy(hash, info->hash, info->hash_size));
+  }
 
   return GF_SUCCESS;
 }
@@ -501,6 +1733,17 @@ gf_file_info_get_user_flag(const gf_file_info* info, gf_32u* user_flag) {
   return GF_SUCCESS;
 }
 
+gf_status
+gf_file_info_get_hash_algorithm(
+  const gf_file_info* info, const gf_char** hash_algorithm) {
+  gf_validate(info);
+  gf_validate(hash_algorithm);
+
+  *hash_algorithm = info->hash_algorithm ? info->hash_algorithm->name : NULL;
+
+  return GF_SUCCESS;
+}
+
 gf_status
 gf_file_info_get_hash_size(const gf_file_info* info, gf_16u* hash_size) {
   gf_validate(info);
@@ -512,7 +1755,7 @@ gf_file_info_get_hash_size(const gf_file_info* info, gf_16u* hash_size) {
 }
 
 gf_status
-gf_file_info_get_inode(const gf_file_info* info, gf_16u* inode) {
+gf_file_info_get_inode(const gf_file_info* info, gf_64u* inode) {
   gf_validate(info);
   gf_validate(inode);
 
@@ -627,7 +1870,7 @@ gf_status
 gf_file_info_set_file_name(gf_file_info* info, const gf_char* file_name) {
   gf_validate(info);
   gf_validate(file_name);
-  _(gf_path_set_string(info->file_name, file_name));
+  _(file_info_assign_string(info, &info->file_name, file_name));
   return GF_SUCCESS;
 }
 
@@ -635,15 +1878,16 @@ gf_status
 gf_file_info_set_full_path(gf_file_info* info, const gf_char* full_path) {
   gf_validate(info);
   gf_validate(full_path);
-  _(gf_path_set_string(info->full_path, full_path));
+  _(file_info_assign_string(info, &info->full_path, full_path));
   return GF_SUCCESS;
 }
 
 gf_status
 gf_file_info_set_hash(gf_file_info* info, gf_size_t size, gf_8u* hash) {
   gf_validate(info);
-  gf_validate(size > 0);
+  gf_validate(size > 0 && size <= GF_HASH_BUFSIZE_MAX);
   gf_validate(hash);
+  _(file_info_reserve_hash(info, size));
   _(gf_memcpy(info->hash, hash, size));
   return GF_SUCCESS;
 }
@@ -651,9 +1895,10 @@ gf_file_info_set_hash(gf_file_info* info, gf_size_t size, gf_8u* hash) {
 gf_status
 gf_file_info_set_hash_string(gf_file_info* info, gf_size_t size, gf_8u* str) {
   gf_validate(info);
-  gf_validate(size > 0);
+  gf_validate(size > 0 && size <= GF_HASH_BUFSIZE_MAX);
   gf_validate(str);
 
+  _(file_info_reserve_hash(info, size));
   _(gf_hash_parse_string(info->hash, (gf_char*)str, size));
   
   return GF_SUCCESS;
@@ -673,15 +1918,26 @@ gf_file_info_set_user_flag(gf_file_info* info, gf_32u user_flag) {
   return GF_SUCCESS;
 }
 
+gf_status
+gf_file_info_set_hash_algorithm(
+  gf_file_info* info, const gf_char* hash_algorithm) {
+  gf_validate(info);
+  /* An unknown name is kept as NULL, so the hash is never reused */
+  info->hash_algorithm = gf_hash_find(hash_algorithm);
+  return GF_SUCCESS;
+}
+
 gf_status
 gf_file_info_set_hash_size(gf_file_info* info, gf_16u hash_size) {
   gf_validate(info);
+  gf_validate(hash_size <= GF_HASH_BUFSIZE_MAX);
+  _(file_info_reserve_hash(info, hash_size));
   info->hash_size = hash_size;
   return GF_SUCCESS;
 }
 
 gf_status
-gf_file_info_set_inode(gf_file_info* info, gf_16u inode) {
+gf_file_info_set_inode(gf_file_info* info, gf_64u inode) {
   gf_validate(info);
   info->inode = inode;
   return GF_SUCCESS;
@@ -745,9 +2001,9 @@ gf_file_info_set_access_time(gf_file_info* info, gf_64u access_time) {
 
 gf_status
 gf_file_info_set_modify_time(gf_file_info* info, gf_64u modify_time) {
-  return GF_SUCCESS;
-  info->modify_time = modify_time;
   gf_validate(info);
+  info->modify_time = modify_time;
+  return GF_SUCCESS;
 }
 
 gf_status
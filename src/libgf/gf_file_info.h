@@ -17,6 +17,8 @@
 #include <libgf/gf_error.h>
 
 #include <libgf/gf_path.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_hash.h>
 
 #ifdef __cplusplus
 extern {
@@ -24,6 +26,41 @@ extern {
 
 typedef struct gf_file_info gf_file_info;
 
+/*!
+** @brief Statistics of gf_file_info_scan_with_option()
+**
+** The times are in nanoseconds. If the walkers stall often, hashing is the
+** bottleneck; if the hash workers are starved, the walk is.
+*/
+
+typedef struct gf_file_info_scan_stats {
+  gf_size_t walkers;            ///< The number of walkers
+  gf_size_t hashers;            ///< The number of hash workers
+  gf_size_t hashed;             ///< Files hashed
+  gf_size_t reused;             ///< Files whose hash was reused
+  gf_64u    walk_nsec;          ///< Elapsed time until the walk finished
+  gf_64u    total_nsec;         ///< Elapsed time until all hashes were done
+  gf_64u    hash_nsec;          ///< Time spent on hashing (summed)
+  gf_64u    stalls;             ///< Times a walker found the queue full
+  gf_64u    stall_nsec;         ///< Time the walkers waited for the queue
+  gf_64u    starved;            ///< Times a hash worker found the queue empty
+  gf_size_t arena_size;         ///< Bytes reserved for the tree
+} gf_file_info_scan_stats;
+
+/*!
+** @brief Options for gf_file_info_scan_with_option()
+*/
+
+typedef struct gf_file_info_scan_option {
+  gf_size_t     threads;        ///< The number of walkers (0: one per core)
+  gf_size_t     hash_threads;   ///< The number of hash workers (0: per core)
+  gf_size_t     queue_depth;    ///< The capacity of hash queue (0: default)
+  const gf_map* cache;          ///< Previous records keyed by full path
+  gf_64u        cache_time;     ///< The time the records were scanned
+  const gf_hash_provider* hash; ///< The hash algorithm (NULL: default)
+  gf_file_info_scan_stats* stats; ///< Receives the statistics (may be NULL)
+} gf_file_info_scan_option;
+
 /*!
 ** @brief Create a new gf_file_info object.
 **
@@ -40,11 +77,72 @@ typedef struct gf_file_info gf_file_info;
 extern gf_status gf_file_info_new(
   gf_file_info** info, const gf_path* disp_path, const gf_path* path);
 
+/*!
+** @brief Read the information of a file again.
+**
+** The stat information is updated and the file is hashed again with the
+** algorithm of the record, regardless of the modify time, because a file may
+** be rewritten several times within its resolution.
+**
+** @param [in, out] info    The record to be updated
+** @param [in]      path    The real path of the file
+** @param [out]     changed GF_TRUE if the fingerprint has changed
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+extern gf_status gf_file_info_refresh(
+  gf_file_info* info, const gf_path* path, gf_bool* changed);
+
+/*!
+** @brief Scan a whole directory tree.
+**
+** The children of each directory are sorted by the file name.
+**
+** The nodes of the tree and their strings are allocated in an arena owned by
+** the root. The children of a directory are stored contiguously, and the file
+** name of a node points into its full path. The whole tree is freed by passing
+** the root to gf_file_info_free(); the other nodes must not be freed alone.
+**
+** @param [out] info The root of the tree
+** @param [in]  path The path of the directory to be scanned
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
 extern gf_status gf_file_info_scan(gf_file_info** info, const gf_path* path);
 
+/*!
+** @brief Scan a whole directory tree with the specified options.
+**
+** The directories are read by option->threads walkers in parallel, and the
+** files are hashed by option->hash_threads workers fed through a queue of
+** option->queue_depth jobs. This function returns after all the hashes are
+** filled. The result is the same as gf_file_info_scan() regardless of the
+** number of workers.
+**
+** If option->cache is specified, it maps the full path (the path for display)
+** to the gf_file_info record of the previous scan. The hash of a regular file
+** whose inode, size, modify time and change time are unchanged is copied from
+** the record instead of reading the file, provided that the record was hashed
+** with option->hash. option->cache_time is the time (in seconds, as the stat
+** times) when the previous scan started; a record modified at or after it is
+** not trusted, since a later change in the same second keeps its stat.
+**
+** @param [out] info   The root of the tree
+** @param [in]  path   The path of the directory to be scanned
+** @param [in]  option The scan options
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+extern gf_status gf_file_info_scan_with_option(
+  gf_file_info** info, const gf_path* path,
+  const gf_file_info_scan_option* option);
+
 /*!
 ** @brief Discards the gf_file_info object.
 **
+** If @a info is the root of a scanned tree, the whole tree is freed. This
+** function does nothing for the other nodes of the tree.
+**
 ** @param [in, out] info 
 */
 extern void gf_file_info_free(gf_file_info* info);
@@ -60,12 +158,24 @@ extern gf_bool gf_file_info_is_directory(const gf_file_info* info);
 
 extern gf_size_t gf_file_info_count_children(const gf_file_info* info);
 
-extern gf_status gf_file_info_add_child(
-  gf_file_info* info, gf_file_info* child);
-
 extern gf_status gf_file_info_get_child(
   const gf_file_info* info, gf_size_t index, gf_file_info** child);
 
+/*!
+** @brief Find a child by the file name.
+**
+** The children of a scanned directory are sorted by the file name, so the
+** child is looked up by a binary search.
+**
+** @param [in]  info      The directory
+** @param [in]  file_name The file name of the child
+** @param [out] child     The child found (may be NULL)
+**
+** @return GF_TRUE if the child is found, GF_FALSE otherwise.
+*/
+extern gf_bool gf_file_info_find_child(
+  const gf_file_info* info, const gf_char* file_name, gf_file_info** child);
+
 /* -------------------------------------------------------------------------- */
 
 extern gf_status gf_file_info_get_file_name(
@@ -89,11 +199,20 @@ extern gf_status gf_file_info_get_user_data(
 extern gf_status gf_file_info_get_user_flag(
   const gf_file_info* info, gf_32u* user_flag);
 
+/*!
+** @brief Get the name of the algorithm the hash was computed with.
+**
+** The name is NULL if the algorithm is unknown (e.g., the record was read
+** from an old site.xml).
+*/
+extern gf_status gf_file_info_get_hash_algorithm(
+  const gf_file_info* info, const gf_char** hash_algorithm);
+
 extern gf_status gf_file_info_get_hash_size(
   const gf_file_info* info, gf_16u* hash_size);
 
 extern gf_status gf_file_info_get_inode(
-  const gf_file_info* info, gf_16u* inode);
+  const gf_file_info* info, gf_64u* inode);
 
 extern gf_status gf_file_info_get_mode(
   const gf_file_info* info, gf_16u* mode);
@@ -145,10 +264,13 @@ extern gf_status gf_file_info_set_user_data(
 extern gf_status gf_file_info_set_user_flag(
   gf_file_info* info, gf_32u user_flag);
 
+extern gf_status gf_file_info_set_hash_algorithm(
+  gf_file_info* info, const gf_char* hash_algorithm);
+
 extern gf_status gf_file_info_set_hash_size(
   gf_file_info* info, gf_16u hash_size);
 
-extern gf_status gf_file_info_set_inode(gf_file_info* info, gf_16u inode);
+extern gf_status gf_file_info_set_inode(gf_file_info* info, gf_64u inode);
 
 extern gf_status gf_file_info_set_mode(gf_file_info* info, gf_16u mode);
 
@@ -9,8 +9,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <windows.h>
-
 #include <libxml/parser.h>
 #include <libxslt/xslt.h>
 #include <libxslt/extensions.h>
@@ -30,6 +28,8 @@
 #include <libgf/gf_cmd_build.h>
 #include <libgf/gf_cmd_clean.h>
 #include <libgf/gf_cmd_list.h>
+#include <libgf/gf_cmd_watch.h>
+#include <libgf/gf_cmd_db.h>
 
 #include <libgf/gf_global.h>
 
@@ -45,6 +45,8 @@ static const gf_cmd_index command_index_[] = {
   { "build",   gf_cmd_build_new,  },
   { "clean",   gf_cmd_clean_new,  },
   { "list",    gf_cmd_list_new,   },
+  { "watch",   gf_cmd_watch_new,  },
+  { "db",      gf_cmd_db_new,     },
 };
 
 static gf_status
@@ -6,54 +6,665 @@
 ** @file libgf/gf_hash.c
 ** @brief Hash functions
 */
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-#include <openssl/sha.h>
+#include <openssl/evp.h>
 
 #include <libgf/gf_memory.h>
+#include <libgf/gf_countof.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_thread.h>
 #include <libgf/gf_hash.h>
 
 #include "gf_local.h"
 
-#define GF_HASH_BUFSIZE_FILE 4096
+/* -------------------------------------------------------------------------- */
+/*
+** SHA-512 (OpenSSL EVP)
+*/
+
+static gf_status
+hash_sha512_init(gf_hash_context* ctx) {
+  EVP_MD_CTX* md = NULL;
 
-#define OPENSSL_RAISE(ret)                                \
-  if (ret == 0) {                                         \
-    gf_raise(GF_E_API, "Failed to calcurate file hash."); \
+  md = EVP_MD_CTX_new();
+  if (!md) {
+    gf_raise(GF_E_ALLOC, "Failed to create a digest context.");
+  }
+  if (!EVP_DigestInit_ex(md, EVP_sha512(), NULL)) {
+    EVP_MD_CTX_free(md);
+    gf_raise(GF_E_API, "Failed to calcurate file hash.");
   }
+  ctx->ptr = md;
 
-gf_status
-gf_hash_file(gf_8u* hash, gf_size_t size, const gf_path* path) {
+  return GF_SUCCESS;
+}
+
+static gf_status
+hash_sha512_update(gf_hash_context* ctx, const gf_8u* data, gf_size_t size) {
+  if (!EVP_DigestUpdate((EVP_MD_CTX*)ctx->ptr, data, size)) {
+    gf_raise(GF_E_API, "Failed to calcurate file hash.");
+  }
+  return GF_SUCCESS;
+}
+
+static gf_status
+hash_sha512_final(gf_hash_context* ctx, gf_8u* digest) {
   int ret = 0;
-  SHA512_CTX ctxt = { 0 };
-  FILE* fp = NULL;
-  gf_8u buffer[GF_HASH_BUFSIZE_FILE] = { 0 };
-  size_t read_bytes = 0;
 
-  static const size_t s_bufsize = GF_HASH_BUFSIZE_FILE;
-  
+  ret = EVP_DigestFinal_ex((EVP_MD_CTX*)ctx->ptr, digest, NULL);
+  EVP_MD_CTX_free((EVP_MD_CTX*)ctx->ptr);
+  ctx->ptr = NULL;
+  if (!ret) {
+    gf_raise(GF_E_API, "Failed to calcurate file hash.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+** FP128: 128-bit non-cryptographic fingerprint
+**
+** The input is consumed in 64-byte stripes by eight independent 64-bit lanes
+** (the xxHash64 round), so the lanes can be computed in parallel by the CPU
+** and the compiler can vectorize the loop. At the end, the lanes are merged
+** into two 64-bit halves together with the tail bytes and the total length.
+** The words are read in little-endian order, so the digest does not depend
+** on the platform.
+*/
+
+#define FP128_LANES  8
+#define FP128_STRIPE (FP128_LANES * 8)
+
+static const gf_64u FP128_P1 = 0x9E3779B185EBCA87ULL;
+static const gf_64u FP128_P2 = 0xC2B2AE3D27D4EB4FULL;
+static const gf_64u FP128_P3 = 0x165667B19E3779F9ULL;
+static const gf_64u FP128_P4 = 0x85EBCA77C2B2AE63ULL;
+static const gf_64u FP128_P5 = 0x27D4EB2F165667C5ULL;
+
+typedef struct hash_fp128_state {
+  gf_64u    acc[FP128_LANES];   ///< Lane accumulators
+  gf_8u     buf[FP128_STRIPE];  ///< Pending bytes of an incomplete stripe
+  gf_size_t used;               ///< The size of pending bytes
+  gf_64u    total;              ///< The total size of the input
+} hash_fp128_state;
+
+_Static_assert(sizeof(hash_fp128_state) <= sizeof(gf_hash_context),
+               "gf_hash_context is too small");
+
+static inline gf_64u
+fp128_rotl(gf_64u x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline gf_64u
+fp128_read64(const gf_8u* p) {
+  gf_64u v = 0;
+
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+
+  return v;
+}
+
+static inline gf_64u
+fp128_round(gf_64u acc, gf_64u input) {
+  acc += input * FP128_P2;
+  acc  = fp128_rotl(acc, 31);
+  acc *= FP128_P1;
+  return acc;
+}
+
+static inline gf_64u
+fp128_merge(gf_64u h, gf_64u acc) {
+  h ^= fp128_round(0, acc);
+  h  = h * FP128_P1 + FP128_P4;
+  return h;
+}
+
+static inline gf_64u
+fp128_avalanche(gf_64u h) {
+  h ^= h >> 33;
+  h *= FP128_P2;
+  h ^= h >> 29;
+  h *= FP128_P3;
+  h ^= h >> 32;
+  return h;
+}
+
+static void
+fp128_consume(gf_64u* acc, const gf_8u* p, gf_size_t stripes) {
+  for (gf_size_t s = 0; s < stripes; s++, p += FP128_STRIPE) {
+    for (int i = 0; i < FP128_LANES; i++) {
+      acc[i] = fp128_round(acc[i], fp128_read64(p + i * 8));
+    }
+  }
+}
+
+static gf_status
+hash_fp128_init(gf_hash_context* ctx) {
+  hash_fp128_state* st = (hash_fp128_state*)ctx->buf;
+
+  for (int i = 0; i < FP128_LANES; i++) {
+    st->acc[i] = FP128_P5 + FP128_P2 * (gf_64u)(i + 1);
+  }
+  st->used = 0;
+  st->total = 0;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+hash_fp128_update(gf_hash_context* ctx, const gf_8u* data, gf_size_t size) {
+  hash_fp128_state* st = (hash_fp128_state*)ctx->buf;
+  gf_size_t n = 0;
+
+  st->total += size;
+  /* Fill the pending stripe first */
+  if (st->used > 0) {
+    n = FP128_STRIPE - st->used;
+    if (n > size) {
+      n = size;
+    }
+    memcpy(st->buf + st->used, data, n);
+    st->used += n;
+    data += n;
+    size -= n;
+    if (st->used < FP128_STRIPE) {
+      return GF_SUCCESS;
+    }
+    fp128_consume(st->acc, st->buf, 1);
+    st->used = 0;
+  }
+  /* Consume the whole stripes directly from the input */
+  n = size / FP128_STRIPE;
+  fp128_consume(st->acc, data, n);
+  data += n * FP128_STRIPE;
+  size -= n * FP128_STRIPE;
+  /* Keep the rest */
+  if (size > 0) {
+    memcpy(st->buf, data, size);
+    st->used = size;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+hash_fp128_final(gf_hash_context* ctx, gf_8u* digest) {
+  hash_fp128_state* st = (hash_fp128_state*)ctx->buf;
+  const gf_8u* p = st->buf;
+  gf_size_t rest = st->used;
+  gf_64u h[2] = { 0 };
+
+  h[0] = fp128_rotl(st->acc[0], 1) + fp128_rotl(st->acc[1], 7) +
+         fp128_rotl(st->acc[2], 12) + fp128_rotl(st->acc[3], 18);
+  h[1] = fp128_rotl(st->acc[4], 1) + fp128_rotl(st->acc[5], 7) +
+         fp128_rotl(st->acc[6], 12) + fp128_rotl(st->acc[7], 18);
+  for (int i = 0; i < FP128_LANES / 2; i++) {
+    h[0] = fp128_merge(h[0], st->acc[i]);
+    h[1] = fp128_merge(h[1], st->acc[i + FP128_LANES / 2]);
+  }
+  h[0] += st->total;
+  h[1] += st->total * FP128_P5;
+
+  /* Tail words go to the halves alternately */
+  for (int k = 0; rest >= 8; k ^= 1, p += 8, rest -= 8) {
+    h[k] ^= fp128_round(0, fp128_read64(p));
+    h[k]  = fp128_rotl(h[k], 27) * FP128_P1 + FP128_P4;
+  }
+  if (rest > 0) {
+    gf_64u v = 0;
+    for (gf_size_t i = 0; i < rest; i++) {
+      v |= (gf_64u)p[i] << (i * 8);
+    }
+    h[1] ^= (v ^ rest) * FP128_P5;
+    h[1]  = fp128_rotl(h[1], 11) * FP128_P1;
+  }
+
+  h[0] += h[1];
+  h[1] += h[0];
+  h[0] = fp128_avalanche(h[0]);
+  h[1] = fp128_avalanche(h[1]);
+  h[0] += h[1];
+  h[1] += h[0];
+
+  for (int i = 0; i < 8; i++) {
+    digest[i]     = (gf_8u)(h[0] >> (i * 8));
+    digest[i + 8] = (gf_8u)(h[1] >> (i * 8));
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static const gf_hash_provider hash_providers_[] = {
+  {
+    .name   = GF_HASH_NAME_FP128,
+    .size   = GF_HASH_BUFSIZE_FP128,
+    .init   = hash_fp128_init,
+    .update = hash_fp128_update,
+    .final  = hash_fp128_final,
+  },
+  {
+    .name   = GF_HASH_NAME_SHA512,
+    .size   = GF_HASH_BUFSIZE_SHA512,
+    .init   = hash_sha512_init,
+    .update = hash_sha512_update,
+    .final  = hash_sha512_final,
+  },
+};
+
+const gf_hash_provider*
+gf_hash_get_default(void) {
+  return &hash_providers_[0];
+}
+
+const gf_hash_provider*
+gf_hash_find(const gf_char* name) {
+  if (!name) {
+    return NULL;
+  }
+  for (gf_size_t i = 0; i < gf_countof(hash_providers_); i++) {
+    if (!strcmp(hash_providers_[i].name, name)) {
+      return &hash_providers_[i];
+    }
+  }
+  return NULL;
+}
+
+gf_size_t
+gf_hash_count_providers(void) {
+  return gf_countof(hash_providers_);
+}
+
+const gf_hash_provider*
+gf_hash_get_provider(gf_size_t index) {
+  if (index >= gf_countof(hash_providers_)) {
+    return NULL;
+  }
+  return &hash_providers_[index];
+}
+
+gf_status
+gf_hash_buffer(
+  const gf_hash_provider* provider, gf_8u* hash, gf_size_t size,
+  const gf_8u* data, gf_size_t len) {
+  gf_status rc = 0;
+  gf_hash_context ctx;
+
+  gf_validate(provider);
   gf_validate(hash);
-  gf_validate(size >= GF_HASH_BUFSIZE_SHA512);
+  gf_validate(size >= provider->size);
+  gf_validate(data || len == 0);
+
+  _(provider->init(&ctx));
+  rc = provider->update(&ctx, data, len);
+  if (rc != GF_SUCCESS) {
+    (void)provider->final(&ctx, hash);
+    gf_throw(rc);
+  }
+  _(provider->final(&ctx, hash));
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+** File I/O
+**
+** A file at least as large as the threshold is mapped into memory and hashed
+** in place; a smaller one is read into a buffer owned by the calling thread,
+** so that the buffer is reused across files without locking. Both paths tell
+** the system that the file is read sequentially, so that it reads ahead.
+*/
+
+static gf_64u hash_mmap_threshold_ = GF_HASH_MMAP_THRESHOLD_DEFAULT;
+
+static atomic_uint_fast64_t hash_stats_[GF_HASH_IO_COUNT][3];
+
+enum {
+  HASH_STATS_FILES,
+  HASH_STATS_BYTES,
+  HASH_STATS_NSEC,
+};
+
+static gf_thread_once hash_buffer_once_ = GF_THREAD_ONCE_INIT;
+static gf_thread_key  hash_buffer_key_;
+static gf_status      hash_buffer_key_status_ = GF_SUCCESS;
+
+typedef struct hash_file {
+#if defined(_WIN32)
+  HANDLE handle;
+#else
+  int    fd;
+#endif
+  gf_64u size;
+} hash_file;
+
+static void
+hash_buffer_free(gf_ptr buffer) {
+  gf_free(buffer);
+}
+
+static void
+hash_buffer_key_init(void) {
+  hash_buffer_key_status_ =
+    gf_thread_key_create(&hash_buffer_key_, hash_buffer_free);
+}
+
+/*!
+** @brief Get the read buffer of the calling thread
+**
+** The buffer of GF_HASH_BUFSIZE_READ bytes is allocated on the first call in
+** each thread and released when the thread exits.
+*/
+
+static gf_status
+hash_get_buffer(gf_8u** buffer) {
+  gf_status rc = 0;
+  gf_ptr tmp = NULL;
+
+  gf_thread_call_once(&hash_buffer_once_, hash_buffer_key_init);
+  _(hash_buffer_key_status_);
+
+  tmp = gf_thread_key_get(hash_buffer_key_);
+  if (!tmp) {
+    _(gf_malloc(&tmp, GF_HASH_BUFSIZE_READ));
+    rc = gf_thread_key_set(hash_buffer_key_, tmp);
+    if (rc != GF_SUCCESS) {
+      gf_free(tmp);
+      gf_throw(rc);
+    }
+  }
+  *buffer = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+hash_file_open(hash_file* file, const gf_path* path) {
+  const gf_char* name = gf_path_get_string(path);
+#if defined(_WIN32)
+  LARGE_INTEGER size = { 0 };
+
+  file->handle = CreateFileA(
+    name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file->handle == INVALID_HANDLE_VALUE) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  if (!GetFileSizeEx(file->handle, &size)) {
+    CloseHandle(file->handle);
+    gf_raise(GF_E_READ, "Failed to get the file size. (%s)", name);
+  }
+  file->size = (gf_64u)size.QuadPart;
+#else
+  struct stat st = { 0 };
+
+  file->fd = open(name, O_RDONLY);
+  if (file->fd < 0) {
+    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", name);
+  }
+  if (fstat(file->fd, &st) != 0) {
+    (void)close(file->fd);
+    gf_raise(GF_E_READ, "Failed to get the file size. (%s)", name);
+  }
+  file->size = (gf_64u)st.st_size;
+# if defined(POSIX_FADV_SEQUENTIAL)
+  (void)posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+# endif
+#endif
+
+  return GF_SUCCESS;
+}
+
+static void
+hash_file_close(hash_file* file) {
+#if defined(_WIN32)
+  CloseHandle(file->handle);
+#else
+  (void)close(file->fd);
+#endif
+}
+
+/*!
+** @brief Hash the file through a memory mapping
+**
+** @a mapped is cleared if the file cannot be mapped, and then the context is
+** left untouched, so that the caller falls back to hash_file_read() with it.
+** A failure of the provider is returned with @a mapped set, since the context
+** has been fed in part.
+*/
+
+static gf_status
+hash_file_map(
+  const gf_hash_provider* provider, gf_hash_context* ctx,
+  const hash_file* file, gf_bool* mapped) {
+  gf_status rc = 0;
+  const gf_8u* data = NULL;
+#if defined(_WIN32)
+  HANDLE map = NULL;
+
+  *mapped = GF_FALSE;
+
+  if (file->size > (gf_64u)SIZE_MAX) {
+    return GF_SUCCESS;
+  }
+  map = CreateFileMappingA(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!map) {
+    return GF_SUCCESS;
+  }
+  data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(map);
+    return GF_SUCCESS;
+  }
+  *mapped = GF_TRUE;
+  rc = provider->update(ctx, data, (gf_size_t)file->size);
+  UnmapViewOfFile(data);
+  CloseHandle(map);
+#else
+  void* addr = NULL;
+
+  *mapped = GF_FALSE;
+  if (file->size > (gf_64u)SIZE_MAX) {
+    return GF_SUCCESS;
+  }
+  addr = mmap(NULL, (size_t)file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+  if (addr == MAP_FAILED) {
+    return GF_SUCCESS;
+  }
+# if defined(MADV_SEQUENTIAL)
+  (void)madvise(addr, (size_t)file->size, MADV_SEQUENTIAL);
+# endif
+  data = addr;
+  *mapped = GF_TRUE;
+  rc = provider->update(ctx, data, (gf_size_t)file->size);
+  (void)munmap(addr, (size_t)file->size);
+#endif
+
+  return rc;
+}
+
+/*!
+** @brief Hash the file by positional reads into the thread's buffer
+*/
+
+static gf_status
+hash_file_read(
+  const gf_hash_provider* provider, gf_hash_context* ctx,
+  const hash_file* file) {
+  gf_8u* buffer = NULL;
+  gf_64u offset = 0;
+
+  _(hash_get_buffer(&buffer));
+
+  for (;;) {
+#if defined(_WIN32)
+    DWORD len = 0;
+    OVERLAPPED ov = { 0 };
+
+    ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    if (!ReadFile(file->handle, buffer, GF_HASH_BUFSIZE_READ, &len, &ov)) {
+      if (GetLastError() == ERROR_HANDLE_EOF) {
+        break;
+      }
+      gf_raise(GF_E_READ, "Failed to read file.");
+    }
+#else
+    ssize_t len = pread(file->fd, buffer, GF_HASH_BUFSIZE_READ, (off_t)offset);
+
+    if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      gf_raise(GF_E_READ, "Failed to read file.");
+    }
+#endif
+    if (len == 0) {
+      break;
+    }
+    _(provider->update(ctx, buffer, (gf_size_t)len));
+    offset += (gf_64u)len;
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_hash_file_with(
+  const gf_hash_provider* provider, gf_8u* hash, gf_size_t size,
+  const gf_path* path) {
+  gf_status rc = 0;
+  gf_hash_context ctx;
+  hash_file file;
+  gf_hash_io io = GF_HASH_IO_READ;
+  gf_64u start = 0;
+  gf_64u nsec = 0;
+  gf_bool mapped = GF_FALSE;
+
+  gf_validate(provider);
+  gf_validate(hash);
+  gf_validate(size >= provider->size);
   gf_validate(!gf_path_is_empty(path));
-  
-  ret = SHA512_Init(&ctxt);
-  OPENSSL_RAISE(ret);
-  
-  fp = fopen(gf_path_get_string(path), "rb");
-  if (!fp) {
-    gf_raise(GF_E_OPEN, "Failed to open file. (%s)", gf_path_get_string(path));
+
+  start = gf_datetime_get_monotonic_ns();
+
+  _(hash_file_open(&file, path));
+  rc = provider->init(&ctx);
+  if (rc != GF_SUCCESS) {
+    hash_file_close(&file);
+    gf_throw(rc);
+  }
+  if (file.size > 0 && file.size >= hash_mmap_threshold_) {
+    rc = hash_file_map(provider, &ctx, &file, &mapped);
+    if (mapped) {
+      io = GF_HASH_IO_MAP;
+    } else {
+      gf_trace("Mapping failed; reading the file. (%s)",
+               gf_path_get_string(path));
+      rc = hash_file_read(provider, &ctx, &file);
+    }
+  } else {
+    rc = hash_file_read(provider, &ctx, &file);
   }
-  while ((read_bytes = fread(buffer, sizeof(buffer[0]), s_bufsize, fp)) > 0) {
-    ret = SHA512_Update(&ctxt, buffer, read_bytes);
-    OPENSSL_RAISE(ret);
+  hash_file_close(&file);
+  if (rc != GF_SUCCESS) {
+    gf_error("Failed to hash file. (%s)", gf_path_get_string(path));
+    (void)provider->final(&ctx, hash);
+    gf_throw(rc);
   }
+  _(provider->final(&ctx, hash));
 
-  ret = SHA512_Final(hash, &ctxt);
-  OPENSSL_RAISE(ret);
+  nsec = gf_datetime_get_monotonic_ns() - start;
+  atomic_fetch_add_explicit(
+    &hash_stats_[io][HASH_STATS_FILES], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(
+    &hash_stats_[io][HASH_STATS_BYTES], file.size, memory_order_relaxed);
+  atomic_fetch_add_explicit(
+    &hash_stats_[io][HASH_STATS_NSEC], nsec, memory_order_relaxed);
 
   return GF_SUCCESS;
 }
 
+void
+gf_hash_set_mmap_threshold(gf_64u threshold) {
+  hash_mmap_threshold_ = threshold;
+}
+
+gf_64u
+gf_hash_get_mmap_threshold(void) {
+  return hash_mmap_threshold_;
+}
+
+gf_status
+gf_hash_get_stats(gf_hash_io io, gf_hash_stats* stats) {
+  gf_validate(io < GF_HASH_IO_COUNT);
+  gf_validate(stats);
+
+  stats->files = atomic_load(&hash_stats_[io][HASH_STATS_FILES]);
+  stats->bytes = atomic_load(&hash_stats_[io][HASH_STATS_BYTES]);
+  stats->nsec  = atomic_load(&hash_stats_[io][HASH_STATS_NSEC]);
+
+  return GF_SUCCESS;
+}
+
+void
+gf_hash_reset_stats(void) {
+  for (gf_size_t i = 0; i < GF_HASH_IO_COUNT; i++) {
+    atomic_store(&hash_stats_[i][HASH_STATS_FILES], 0);
+    atomic_store(&hash_stats_[i][HASH_STATS_BYTES], 0);
+    atomic_store(&hash_stats_[i][HASH_STATS_NSEC], 0);
+  }
+}
+
+void
+gf_hash_log_stats(void) {
+  static const gf_char* labels[GF_HASH_IO_COUNT] = { "read", "mmap" };
+
+  for (gf_size_t i = 0; i < GF_HASH_IO_COUNT; i++) {
+    gf_hash_stats st = { 0 };
+    double mib = 0;
+    double sec = 0;
+
+    (void)gf_hash_get_stats((gf_hash_io)i, &st);
+    if (st.files == 0) {
+      continue;
+    }
+    mib = (double)st.bytes / (1024.0 * 1024.0);
+    sec = (double)st.nsec / 1e9;
+    gf_debug("Hashed %llu file(s) by %s: %.1f MiB, %.1f MiB/s per thread.",
+             (unsigned long long)st.files, labels[i], mib,
+             sec > 0 ? mib / sec : 0.0);
+  }
+}
+
+gf_status
+gf_hash_file(gf_8u* hash, gf_size_t size, const gf_path* path) {
+  return gf_hash_file_with(
+    gf_hash_find(GF_HASH_NAME_SHA512), hash, size, path);
+}
+
 gf_status
 gf_hash_parse_string(gf_8u* buffer, const gf_char* str, gf_size_t size) {
   gf_char chr[3] = { 0 };
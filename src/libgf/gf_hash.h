@@ -21,6 +21,159 @@ extern "C" {
 #endif
 
 #define GF_HASH_BUFSIZE_SHA512 64
+#define GF_HASH_BUFSIZE_FP128  16
+#define GF_HASH_BUFSIZE_MAX    GF_HASH_BUFSIZE_SHA512
+
+#define GF_HASH_NAME_SHA512 "sha512"
+#define GF_HASH_NAME_FP128  "fp128"
+
+/* The size of the per-thread read buffer */
+#define GF_HASH_BUFSIZE_READ (1024 * 1024)
+
+/* Files of this size or larger are mapped into memory by default */
+#define GF_HASH_MMAP_THRESHOLD_DEFAULT (4 * 1024 * 1024)
+
+/* The threshold with which no file is mapped */
+#define GF_HASH_MMAP_THRESHOLD_NEVER UINT64_MAX
+
+/*!
+** @brief The I/O strategies of gf_hash_file_with()
+*/
+
+typedef enum gf_hash_io {
+  GF_HASH_IO_READ,              ///< Positional reads into a per-thread buffer
+  GF_HASH_IO_MAP,               ///< Memory mapping
+  GF_HASH_IO_COUNT,
+} gf_hash_io;
+
+/*!
+** @brief Statistics of the files hashed by an I/O strategy
+*/
+
+typedef struct gf_hash_stats {
+  gf_64u files;                 ///< The number of files
+  gf_64u bytes;                 ///< The total size of the files
+  gf_64u nsec;                  ///< The time spent (summed over threads)
+} gf_hash_stats;
+
+/*!
+** @brief The working area of a hash provider
+**
+** The buffer is large enough for any provider, so the context can be placed
+** on the stack.
+*/
+
+typedef union gf_hash_context {
+  gf_8u  buf[256];
+  gf_64u align_;
+  gf_ptr ptr;
+} gf_hash_context;
+
+/*!
+** @brief Hash provider
+**
+** A hash provider computes a digest of gf_hash_provider::size bytes
+** incrementally with the three callbacks.
+*/
+
+typedef struct gf_hash_provider gf_hash_provider;
+
+struct gf_hash_provider {
+  const gf_char* name;            ///< The algorithm name stored in site.xml
+  gf_size_t      size;            ///< The digest size (in byte)
+  gf_status (*init)(gf_hash_context* ctx);
+  gf_status (*update)(gf_hash_context* ctx, const gf_8u* data, gf_size_t size);
+  gf_status (*final)(gf_hash_context* ctx, gf_8u* digest);
+};
+
+/*!
+** @brief Get the default provider
+**
+** The default is the non-cryptographic 128-bit fingerprint "fp128", which is
+** intended for change detection.
+*/
+
+extern const gf_hash_provider* gf_hash_get_default(void);
+
+/*!
+** @brief Find a provider by the name
+**
+** @param [in] name The algorithm name ("fp128", "sha512")
+**
+** @return The provider, or NULL if the name is unknown.
+*/
+
+extern const gf_hash_provider* gf_hash_find(const gf_char* name);
+
+extern gf_size_t gf_hash_count_providers(void);
+
+extern const gf_hash_provider* gf_hash_get_provider(gf_size_t index);
+
+/*!
+** @brief Compute the digest of a memory block
+**
+** @param [in]  provider The hash provider
+** @param [out] hash     The buffer of the digest
+** @param [in]  size     The size of @a hash (>= provider->size)
+** @param [in]  data     The data to be hashed
+** @param [in]  len      The size of @a data
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_hash_buffer(
+  const gf_hash_provider* provider, gf_8u* hash, gf_size_t size,
+  const gf_8u* data, gf_size_t len);
+
+/*!
+** @brief Compute the digest of a file with the specified provider
+**
+** A file at least as large as gf_hash_get_mmap_threshold() is mapped into
+** memory; a smaller one is read into a 1 MiB buffer owned by the calling
+** thread. This function is thread safe.
+**
+** A mapped file must not be truncated while it is hashed: reading the pages
+** past the new end raises SIGBUS (an in-page error on Windows), which stops
+** the process. The files which may be written meanwhile, as those watched by
+** `gf watch', must be hashed with GF_HASH_MMAP_THRESHOLD_NEVER.
+**
+** @param [in]  provider The hash provider
+** @param [out] hash     The buffer of the digest
+** @param [in]  size     The size of @a hash (>= provider->size)
+** @param [in]  path     The file to be hashed
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_hash_file_with(
+  const gf_hash_provider* provider, gf_8u* hash, gf_size_t size,
+  const gf_path* path);
+
+/*!
+** @brief Set the file size from which gf_hash_file_with() maps the file
+**
+** This must not be called while files are being hashed.
+*/
+
+extern void gf_hash_set_mmap_threshold(gf_64u threshold);
+extern gf_64u gf_hash_get_mmap_threshold(void);
+
+/*!
+** @brief Get the statistics of the files hashed by the I/O strategy
+*/
+
+extern gf_status gf_hash_get_stats(gf_hash_io io, gf_hash_stats* stats);
+extern void gf_hash_reset_stats(void);
+
+/*!
+** @brief Write the throughput of each I/O strategy to the debug log
+*/
+
+extern void gf_hash_log_stats(void);
+
+/*!
+** @brief Compute the SHA-512 digest of a file
+*/
 
 extern gf_status gf_hash_file(gf_8u* buffer, gf_size_t size, const gf_path* path);
 extern gf_status gf_hash_parse_string(
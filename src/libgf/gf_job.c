@@ -0,0 +1,390 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_job.c
+** @brief Jobs run on a pool of threads in the order of a graph.
+*/
+#include <libgf/gf_memory.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_log.h>
+#include <libgf/gf_job.h>
+
+#include "gf_local.h"
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A job of a graph and the jobs depending on it
+*/
+
+typedef struct job_graph_node {
+  gf_size_t* next;              ///< The jobs run after this job
+  gf_size_t  next_count;        ///< The number of the jobs in 'next'
+  gf_size_t  next_size;         ///< The buffer size of 'next'
+  gf_size_t  deps;              ///< The number of the jobs run before
+  gf_64u     start;             ///< The time the job started (nsec)
+  gf_64u     end;               ///< The time the job ended (nsec)
+} job_graph_node;
+
+struct gf_job_graph {
+  job_graph_node* jobs;         ///< The jobs
+  gf_size_t       count;        ///< The number of the jobs
+  gf_size_t       size;         ///< The buffer size of 'jobs'
+};
+
+gf_status
+gf_job_graph_new(gf_job_graph** graph) {
+  gf_job_graph* tmp = NULL;
+
+  gf_validate(graph);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->jobs = NULL;
+  tmp->count = 0;
+  tmp->size = 0;
+  *graph = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_job_graph_free(gf_job_graph* graph) {
+  if (graph) {
+    for (gf_size_t i = 0; i < graph->count; i++) {
+      gf_free(graph->jobs[i].next);
+    }
+    gf_free(graph->jobs);
+    gf_free(graph);
+  }
+}
+
+gf_status
+gf_job_graph_add_job(gf_job_graph* graph, gf_size_t* index) {
+  job_graph_node* job = NULL;
+
+  gf_validate(graph);
+
+  if (graph->count == graph->size) {
+    gf_size_t size = graph->size ? graph->size * 2 : 64;
+
+    _(gf_realloc((gf_ptr*)&graph->jobs, sizeof(*graph->jobs) * size));
+    graph->size = size;
+  }
+  job = &graph->jobs[graph->count];
+  job->next = NULL;
+  job->next_count = 0;
+  job->next_size = 0;
+  job->deps = 0;
+  job->start = 0;
+  job->end = 0;
+  if (index) {
+    *index = graph->count;
+  }
+  graph->count += 1;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_job_graph_add_edge(
+  gf_job_graph* graph, gf_size_t before, gf_size_t after) {
+  job_graph_node* job = NULL;
+
+  gf_validate(graph);
+  gf_validate(before < after);
+  gf_validate(after < graph->count);
+
+  job = &graph->jobs[before];
+  if (job->next_count == job->next_size) {
+    gf_size_t size = job->next_size ? job->next_size * 2 : 4;
+
+    _(gf_realloc((gf_ptr*)&job->next, sizeof(*job->next) * size));
+    job->next_size = size;
+  }
+  job->next[job->next_count++] = after;
+  graph->jobs[after].deps += 1;
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_job_graph_count_jobs(const gf_job_graph* graph) {
+  return graph ? graph->count : 0;
+}
+
+gf_64u
+gf_job_graph_get_job_time(const gf_job_graph* graph, gf_size_t index) {
+  if (!graph || index >= graph->count) {
+    return 0;
+  }
+  return graph->jobs[index].end - graph->jobs[index].start;
+}
+
+gf_status
+gf_job_graph_get_critical_path(
+  const gf_job_graph* graph, gf_size_t* jobs, gf_size_t* count,
+  gf_64u* nsec) {
+  gf_status rc = 0;
+  gf_64u* total = NULL;
+  gf_size_t* prev = NULL;
+  gf_size_t last = 0;
+  gf_size_t cnt = 0;
+
+  gf_validate(graph);
+  gf_validate(jobs || graph->count == 0);
+  gf_validate(count);
+
+  *count = 0;
+  if (nsec) {
+    *nsec = 0;
+  }
+  if (graph->count == 0) {
+    return GF_SUCCESS;
+  }
+  _(gf_malloc((gf_ptr*)&total, sizeof(*total) * graph->count));
+  rc = gf_malloc((gf_ptr*)&prev, sizeof(*prev) * graph->count);
+  if (rc != GF_SUCCESS) {
+    gf_free(total);
+    gf_throw(rc);
+  }
+  for (gf_size_t i = 0; i < graph->count; i++) {
+    total[i] = gf_job_graph_get_job_time(graph, i);
+    prev[i] = i;
+  }
+  /* The edges run forward, so the index order is a topological order */
+  for (gf_size_t i = 0; i < graph->count; i++) {
+    const job_graph_node* job = &graph->jobs[i];
+
+    for (gf_size_t j = 0; j < job->next_count; j++) {
+      gf_size_t n = job->next[j];
+      gf_64u t = total[i] + gf_job_graph_get_job_time(graph, n);
+
+      if (t > total[n]) {
+        total[n] = t;
+        prev[n] = i;
+      }
+    }
+    if (total[i] > total[last]) {
+      last = i;
+    }
+  }
+  if (nsec) {
+    *nsec = total[last];
+  }
+  for (gf_size_t i = last; ; i = prev[i]) {
+    jobs[cnt++] = i;
+    if (prev[i] == i) {
+      break;
+    }
+  }
+  for (gf_size_t i = 0; i < cnt / 2; i++) {
+    gf_size_t t = jobs[i];
+
+    jobs[i] = jobs[cnt - 1 - i];
+    jobs[cnt - 1 - i] = t;
+  }
+  *count = cnt;
+  gf_free(prev);
+  gf_free(total);
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The jobs shared by the threads of gf_job_graph_run()
+*/
+
+typedef struct job_runner {
+  gf_job_graph*  graph;         ///< The jobs and their order
+  gf_job_fn      fn;            ///< The callback which runs a job
+  gf_ptr         data;          ///< The user data of the callback
+  gf_status*     status;        ///< The results of the jobs
+  gf_size_t*     waiting;       ///< The unfinished jobs before (guarded)
+  gf_size_t*     ready;         ///< The queue of the jobs to run (guarded)
+  gf_size_t      head;          ///< The next job in 'ready' (guarded)
+  gf_size_t      tail;          ///< The end of 'ready' (guarded)
+  gf_size_t      running;       ///< The number of running jobs (guarded)
+  gf_bool        fail_fast;     ///< Start no job after a failure
+  gf_bool        failed;        ///< A job has failed (guarded)
+  gf_mutex       lock;          ///< Guards the members above
+  gf_cond        cond;          ///< Signaled when a job ends
+} job_runner;
+
+/*!
+** @brief Take a job whose dependencies have all succeeded.
+**
+** Waits while no job is ready but some are running, since they may make
+** others ready.
+**
+** @return GF_FALSE if no job is left to be run.
+*/
+
+static gf_bool
+job_take(job_runner* runner, gf_size_t* index) {
+  gf_bool ret = GF_FALSE;
+
+  gf_mutex_lock(&runner->lock);
+  while (runner->head == runner->tail && runner->running > 0 &&
+         !(runner->fail_fast && runner->failed)) {
+    gf_cond_wait(&runner->cond, &runner->lock);
+  }
+  if (runner->head < runner->tail &&
+      !(runner->fail_fast && runner->failed)) {
+    *index = runner->ready[runner->head++];
+    runner->running += 1;
+    ret = GF_TRUE;
+  }
+  gf_mutex_unlock(&runner->lock);
+
+  return ret;
+}
+
+/*!
+** @brief Finish a job and make ready the jobs waiting for it.
+**
+** The jobs depending on a failed job are never made ready.
+*/
+
+static void
+job_finish(job_runner* runner, gf_size_t index) {
+  const job_graph_node* job = &runner->graph->jobs[index];
+
+  gf_mutex_lock(&runner->lock);
+  runner->running -= 1;
+  if (runner->status[index] == GF_SUCCESS) {
+    for (gf_size_t i = 0; i < job->next_count; i++) {
+      gf_size_t n = job->next[i];
+
+      runner->waiting[n] -= 1;
+      if (runner->waiting[n] == 0) {
+        runner->ready[runner->tail++] = n;
+      }
+    }
+  } else {
+    runner->failed = GF_TRUE;
+  }
+  gf_cond_broadcast(&runner->cond);
+  gf_mutex_unlock(&runner->lock);
+}
+
+static void
+job_run_worker(gf_ptr data) {
+  job_runner* runner = data;
+  job_graph_node* job = NULL;
+  gf_size_t index = 0;
+
+  while (job_take(runner, &index)) {
+    job = &runner->graph->jobs[index];
+    job->start = gf_datetime_get_monotonic_ns();
+    runner->status[index] = runner->fn(index, runner->data);
+    job->end = gf_datetime_get_monotonic_ns();
+    job_finish(runner, index);
+  }
+}
+
+static void
+job_runner_finalize(job_runner* runner) {
+  gf_free(runner->ready);
+  gf_free(runner->waiting);
+  runner->ready = NULL;
+  runner->waiting = NULL;
+}
+
+static gf_status
+job_runner_prepare(job_runner* runner) {
+  gf_status rc = 0;
+  gf_size_t count = runner->graph->count;
+
+  rc = gf_malloc((gf_ptr*)&runner->waiting, sizeof(gf_size_t) * count);
+  if (rc == GF_SUCCESS) {
+    rc = gf_malloc((gf_ptr*)&runner->ready, sizeof(gf_size_t) * count);
+  }
+  if (rc != GF_SUCCESS) {
+    job_runner_finalize(runner);
+    gf_throw(rc);
+  }
+  /* The jobs without dependencies are ready in the order of the index */
+  for (gf_size_t i = 0; i < count; i++) {
+    runner->status[i] = GF_E_STATE;
+    runner->graph->jobs[i].start = 0;
+    runner->graph->jobs[i].end = 0;
+    runner->waiting[i] = runner->graph->jobs[i].deps;
+    if (runner->waiting[i] == 0) {
+      runner->ready[runner->tail++] = i;
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_job_graph_run(
+  gf_job_graph* graph, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status) {
+  gf_status rc = 0;
+  job_runner runner = { 0 };
+  gf_thread* workers = NULL;
+  gf_size_t workers_count = 0;
+  gf_size_t started = 0;
+  gf_size_t count = 0;
+
+  gf_validate(graph);
+  gf_validate(fn);
+  gf_validate(status || graph->count == 0);
+
+  count = graph->count;
+  if (count == 0) {
+    return GF_SUCCESS;
+  }
+  runner.graph = graph;
+  runner.fn = fn;
+  runner.data = data;
+  runner.status = status;
+  runner.fail_fast = fail_fast;
+  _(job_runner_prepare(&runner));
+  rc = gf_mutex_init(&runner.lock);
+  if (rc != GF_SUCCESS) {
+    job_runner_finalize(&runner);
+    gf_throw(rc);
+  }
+  rc = gf_cond_init(&runner.cond);
+  if (rc != GF_SUCCESS) {
+    gf_mutex_destroy(&runner.lock);
+    job_runner_finalize(&runner);
+    gf_throw(rc);
+  }
+
+  workers_count = gf_thread_resolve_count(threads);
+  if (workers_count > count) {
+    workers_count = count;
+  }
+  if (workers_count > 1) {
+    rc = gf_malloc((gf_ptr*)&workers, sizeof(*workers) * workers_count);
+    /* The calling thread works as the worker #0 */
+    for (gf_size_t i = 1; rc == GF_SUCCESS && i < workers_count; i++) {
+      rc = gf_thread_create(&workers[i], job_run_worker, &runner);
+      if (rc == GF_SUCCESS) {
+        started += 1;
+      }
+    }
+    if (rc != GF_SUCCESS) {
+      gf_warn("Running the jobs with %zu thread(s).", started + 1);
+    }
+  }
+  job_run_worker(&runner);
+  for (gf_size_t i = 1; i <= started; i++) {
+    (void)gf_thread_join(workers[i]);
+  }
+  gf_free(workers);
+  gf_cond_destroy(&runner.cond);
+  gf_mutex_destroy(&runner.lock);
+
+  gf_debug("Ran %zu of %zu job(s) with %zu thread(s).",
+           runner.head, count, started + 1);
+  job_runner_finalize(&runner);
+
+  return GF_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_job.h
+** @brief Jobs run on a pool of threads in the order of a graph.
+*/
+#ifndef LIBGF_GF_JOB_H
+#define LIBGF_GF_JOB_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The callback which runs a job.
+**
+** @param [in] index The index of the job
+** @param [in] data  The user data
+*/
+
+typedef gf_status (*gf_job_fn)(gf_size_t index, gf_ptr data);
+
+/*!
+** @brief A set of jobs and the order between them
+**
+** The jobs are numbered in the order they are added, and an edge always goes
+** from a job to a later one, so the graph has no cycle by construction.
+*/
+
+typedef struct gf_job_graph gf_job_graph;
+
+extern gf_status gf_job_graph_new(gf_job_graph** graph);
+extern void gf_job_graph_free(gf_job_graph* graph);
+
+/*!
+** @brief Add a job to the graph.
+**
+** @param [in, out] graph The graph
+** @param [out]     index The index of the new job (may be NULL)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_job_graph_add_job(gf_job_graph* graph, gf_size_t* index);
+
+/*!
+** @brief Make a job wait for another one.
+**
+** @param [in, out] graph  The graph
+** @param [in]      before The job run first
+** @param [in]      after  The job run after @a before has succeeded; it must
+**                         be added later than @a before
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_job_graph_add_edge(
+  gf_job_graph* graph, gf_size_t before, gf_size_t after);
+
+extern gf_size_t gf_job_graph_count_jobs(const gf_job_graph* graph);
+
+/*!
+** @brief Run the jobs of a graph on a pool of threads.
+**
+** A job is started once all the jobs before it have succeeded; the jobs
+** ready at the same time are taken in the order they became ready, and the
+** jobs without dependencies in the order of the index. A job waiting for a
+** failed one is never started. A failed job does not stop the others unless
+** @a fail_fast is set; then no job is started after the failure, while the
+** running ones are finished.
+**
+** The calling thread runs jobs as well. The callback is called on any of the
+** threads, so it must keep the state of a job on its own (see
+** gf_xslt_run_graph() for the messages of libxml2 and the logs).
+**
+** @param [in, out] graph     The graph, which keeps the times of the jobs
+** @param [in]      fn        The callback which runs a job
+** @param [in]      data      The user data passed to the callback
+** @param [in]      threads   The number of threads (0: one per core)
+** @param [in]      fail_fast GF_TRUE to start no job after a failure
+** @param [out]     status    The results of the jobs (one for each job); the
+**                            jobs not started are left GF_E_STATE
+**
+** @return GF_SUCCESS if the jobs were run (whatever their results),
+**         GF_E_* otherwise.
+*/
+
+extern gf_status gf_job_graph_run(
+  gf_job_graph* graph, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status);
+
+/*!
+** @brief Get the time a job of the last run took in nanoseconds.
+**
+** @return The time, or 0 if the job was not run.
+*/
+
+extern gf_64u gf_job_graph_get_job_time(
+  const gf_job_graph* graph, gf_size_t index);
+
+/*!
+** @brief Get the critical path of the last run.
+**
+** The critical path is the chain of dependent jobs which took the longest
+** time in total; no number of threads can make the run shorter than it.
+**
+** @param [in]  graph The graph
+** @param [out] jobs  The jobs on the path in the order they were run; the
+**                    buffer must have room for all the jobs of the graph
+** @param [out] count The number of the jobs on the path
+** @param [out] nsec  The total time of the path in nanoseconds (may be NULL)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_job_graph_get_critical_path(
+  const gf_job_graph* graph, gf_size_t* jobs, gf_size_t* count,
+  gf_64u* nsec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_JOB_H */
@@ -35,6 +35,22 @@
 #define GF_SITE_FILE_NAME "site.xml"
 #endif  /* GF_SITE_FILE_NAME */
 
+#ifndef GF_SITE_DB_FILE_NAME
+#define GF_SITE_DB_FILE_NAME "site.gfdb"
+#endif  /* GF_SITE_DB_FILE_NAME */
+
+#ifndef GF_CHANGES_FILE_NAME
+#define GF_CHANGES_FILE_NAME "changes.xml"
+#endif  /* GF_CHANGES_FILE_NAME */
+
+#ifndef GF_ENTRY_CACHE_FILE_NAME
+#define GF_ENTRY_CACHE_FILE_NAME "entry-cache.xml"
+#endif  /* GF_ENTRY_CACHE_FILE_NAME */
+
+#ifndef GF_BUILD_MANIFEST_FILE_NAME
+#define GF_BUILD_MANIFEST_FILE_NAME "build-manifest.xml"
+#endif  /* GF_BUILD_MANIFEST_FILE_NAME */
+
 /*!
 ** @brief The parser options for LibXML2
 */
@@ -48,4 +64,15 @@
   XML_PARSE_XINCLUDE
 #endif
 
+/*!
+** @brief The parser options to read the information of an entry file
+**
+** Only the leading information is read, so XInclude is not processed.
+*/
+
+#ifndef GF_XML_READ_INFO_OPTIONS
+#define GF_XML_READ_INFO_OPTIONS \
+  ((GF_XML_PARSE_OPTIONS) & ~XML_PARSE_XINCLUDE)
+#endif
+
 #endif  /* LIBGF_GF_LOCAL_H */
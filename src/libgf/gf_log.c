@@ -9,14 +9,19 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#if !defined(_WIN32)
+#include <strings.h>
 
-#include <windows.h>
+#define stricmp strcasecmp
+#endif
 
 #define GF_USE_SAFE_ERROR_ 1
 
 #include <libgf/gf_countof.h>
 #include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_thread.h>
 #include <libgf/gf_log.h>
 
 #include "gf_local.h"
@@ -58,6 +63,11 @@ static gf_log logger_ = {
 
 #define LOG_WRITE_STREAM_SIZE 16
 
+/* The buffer which keeps the log of each thread (see gf_log_capture()) */
+static gf_thread_once log_capture_once_ = GF_THREAD_ONCE_INIT;
+static gf_thread_key  log_capture_key_;
+static gf_status      log_capture_key_status_ = GF_SUCCESS;
+
 static gf_status
 log_prepare(void) {
   gf_write_stream** stream = NULL;
@@ -183,67 +193,128 @@ log_get_log_level_info(gf_log_level level, const log_level_info** info) {
 }
 
 static gf_status
-log_write(
+log_build_message(char** msg, const char* fmt, va_list args) {
+  char* tmp = NULL;
+  int len = 0;
+  va_list count;
+
+  gf_validate(msg);
+  gf_validate(fmt);
+
+  /* Count characters of the message */
+  va_copy(count, args);
+  len = vsnprintf(NULL, 0, fmt, count) + 1;
+  va_end(count);
+  if (len <= 0) {
+    gf_raise(GF_E_PARAM, "Invalid log message format.");
+  }
+  /* Write message */
+  _(gf_malloc((gf_ptr*)&tmp, len));
+  vsnprintf(tmp, len, fmt, args);
+
+  *msg = tmp;
+  
+  return GF_SUCCESS;
+}
+
+static gf_status
+log_format(char** text, const char* fmt, ...) {
+  gf_status rc = 0;
+  va_list args;
+
+  va_start(args, fmt);
+  rc = log_build_message(text, fmt, args);
+  va_end(args);
+
+  return rc;
+}
+
+/*!
+** @brief Format a line of the log, which ends with a newline.
+**
+** The lines written at once and the lines captured for a thread (see
+** gf_log_capture()) share this format.
+*/
+
+static gf_status
+log_format_line(
+  char** text,
   const log_level_info* info, const char* file, int line, const char* msg) {
 
-  SYSTEMTIME tm = { 0 };
+  gf_datetime_local tm = { 0 };
 
+  gf_validate(text);
   gf_validate(info);
   gf_validate(file);
   gf_validate(msg);
 
   /* Current time */
-  GetLocalTime(&tm);
-  
-  for (gf_size_t i = 0; i < logger_.used; i++) {
+  gf_datetime_get_local_time(&tm);
+
 #if defined(GF_DETAIL_LOG_)
 # if defined(GF_DEBUG_)
-    /* detailed debug log */
-    gf_stream_write(
-      logger_.stream[i], "%s:%d: [%04d/%02d/%02d %02d:%02d:%02d.%03d] %s%s\n",
+  /* detailed debug log */
+  _(log_format(
+      text, "%s:%d: [%04d/%02d/%02d %02d:%02d:%02d.%03d] %s%s\n",
       file, line,
-      tm.wYear, tm.wMonth, tm.wDay, tm.wHour,
-      tm.wMinute, tm.wSecond, tm.wMilliseconds,
-      info->prefix, msg);
+      tm.year, tm.month, tm.day, tm.hour,
+      tm.minute, tm.second, tm.msec,
+      info->prefix, msg));
 # else
-    /* detailed log */
-    (void)file;
-    (void)line;
-    gf_stream_write(
-      logger_.stream[i], "[%04d/%02d/%02d %02d:%02d:%02d.%03d] %s%s\n",
-      tm.wYear, tm.wMonth, tm.wDay, tm.wHour,
-      tm.wMinute, tm.wSecond, tm.wMilliseconds,
-      info->prefix, msg);
+  /* detailed log */
+  (void)file;
+  (void)line;
+  _(log_format(
+      text, "[%04d/%02d/%02d %02d:%02d:%02d.%03d] %s%s\n",
+      tm.year, tm.month, tm.day, tm.hour,
+      tm.minute, tm.second, tm.msec,
+      info->prefix, msg));
 # endif
 #else
-    /* normal log */
-    (void)file;
-    (void)line;
-    (void)tm;
+  /* normal log */
+  (void)file;
+  (void)line;
+  (void)tm;
 
-    gf_stream_write(logger_.stream[i], "%s%s\n", info->prefix, msg);
+  _(log_format(text, "%s%s\n", info->prefix, msg));
 #endif
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+log_write(const char* text) {
+  gf_validate(text);
+
+  for (gf_size_t i = 0; i < logger_.used; i++) {
+    gf_stream_write(logger_.stream[i], "%s", text);
   }
   
   return GF_SUCCESS;
 }
 
-static gf_status
-log_build_message(char** msg, const char* fmt, va_list args) {
-  char* tmp = NULL;
-  int len = 0;
+static void
+log_capture_key_init(void) {
+  log_capture_key_status_ = gf_thread_key_create(&log_capture_key_, NULL);
+}
 
-  gf_validate(msg);
-  gf_validate(fmt);
+static gf_string*
+log_get_capture(void) {
+  gf_thread_call_once(&log_capture_once_, log_capture_key_init);
+  if (log_capture_key_status_ != GF_SUCCESS) {
+    return NULL;
+  }
+  return gf_thread_key_get(log_capture_key_);
+}
 
-  /* Count characters of the message */
-  len = _vscprintf(fmt, args) + 1;
-  /* Write message */
-  _(gf_malloc((gf_ptr*)&tmp, len));
-  vsprintf_s(tmp, len, fmt, args);
+static gf_status
+log_capture(gf_string* buffer, const char* text) {
+  gf_validate(buffer);
+  gf_validate(text);
+
+  /* Written as is by gf_log_flush() */
+  _(gf_string_append(buffer, text));
 
-  *msg = tmp;
-  
   return GF_SUCCESS;
 }
 
@@ -253,7 +324,9 @@ gf_log_write(
 
   gf_status rc = 0;
   char* msg = NULL;
+  char* text = NULL;
   const log_level_info* info = NULL;
+  gf_string* buffer = NULL;
   va_list args;
 
   gf_validate(!gf_strnull(file));
@@ -272,12 +345,22 @@ gf_log_write(
   if (rc != GF_SUCCESS) {
     return rc;
   }
-  /* Print out */
-  rc = log_write(info, file, line, msg);
+  rc = log_format_line(&text, info, file, line, msg);
   gf_free(msg);
   if (rc != GF_SUCCESS) {
     return rc;
   }
+  /* Print out, or keep it for the thread */
+  buffer = log_get_capture();
+  if (buffer) {
+    rc = log_capture(buffer, text);
+  } else {
+    rc = log_write(text);
+  }
+  gf_free(text);
+  if (rc != GF_SUCCESS) {
+    return rc;
+  }
   
   return GF_SUCCESS;
 }
@@ -305,3 +388,28 @@ gf_msg(const char* fmt, ...) {
 
   return GF_SUCCESS;
 }
+
+gf_status
+gf_log_capture(gf_string* buffer) {
+  gf_thread_call_once(&log_capture_once_, log_capture_key_init);
+  _(log_capture_key_status_);
+
+  _(gf_thread_key_set(log_capture_key_, buffer));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_log_flush(gf_string* buffer) {
+  gf_validate(buffer);
+
+  if (gf_string_is_empty(buffer)) {
+    return GF_SUCCESS;
+  }
+  for (gf_size_t i = 0; i < logger_.used; i++) {
+    gf_stream_write(logger_.stream[i], "%s", gf_string_get(buffer));
+  }
+  _(gf_string_set(buffer, ""));
+
+  return GF_SUCCESS;
+}
@@ -23,6 +23,7 @@ extern "C" {
 #endif
 
 typedef struct gf_log gf_log;
+typedef struct gf_string gf_string;
 
 /*!
 ** @brief The contants for logging level.
@@ -121,6 +122,30 @@ extern gf_status gf_log_write(
 
 extern gf_status gf_msg(const char* fmt, ...);
 
+/*!
+** @brief Keep the log of the calling thread in a buffer.
+**
+** While a buffer is set, the log written by the calling thread is appended to
+** the buffer instead of the streams. The jobs run in parallel keep their log
+** this way, and write it out with gf_log_flush() in a fixed order.
+**
+** @param [in] buffer The buffer (NULL: write to the streams again)
+**
+** @return Returns GF_SUCCESS on success, GF_E_* otherwise
+*/
+
+extern gf_status gf_log_capture(gf_string* buffer);
+
+/*!
+** @brief Write the log kept in a buffer to the streams and clear the buffer.
+**
+** @param [in, out] buffer The buffer set by gf_log_capture()
+**
+** @return Returns GF_SUCCESS on success, GF_E_* otherwise
+*/
+
+extern gf_status gf_log_flush(gf_string* buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,581 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_manifest.c
+** @brief The build manifest (build-manifest.xml).
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_array.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_shell.h>
+#include <libgf/gf_manifest.h>
+
+#include "gf_local.h"
+
+/*!
+** @brief A unit of a build
+*/
+
+struct gf_manifest_unit {
+  gf_char*  fingerprint;        ///< The fingerprint of the inputs
+  gf_array* outputs;            ///< The files written (gf_char*)
+  gf_array* stale;              ///< The files recorded by the previous build
+  gf_bool   kept;               ///< Kept since the manifest was read
+  gf_bool   added;              ///< Built since the manifest was read
+};
+
+struct gf_manifest {
+  gf_map* units;                ///< Key -> gf_manifest_unit
+};
+
+static void
+manifest_string_free(gf_any* any) {
+  if (any && any->ptr) {
+    gf_free(any->ptr);
+    any->ptr = NULL;
+  }
+}
+
+static void
+manifest_unit_free(gf_any* any) {
+  if (any && any->ptr) {
+    gf_manifest_unit* unit = any->ptr;
+
+    gf_free(unit->fingerprint);
+    gf_array_free(unit->outputs);
+    gf_array_free(unit->stale);
+    gf_free(unit);
+    any->ptr = NULL;
+  }
+}
+
+static gf_status
+manifest_new_string_array(gf_array** ary) {
+  gf_status rc = 0;
+  gf_array* tmp = NULL;
+
+  _(gf_array_new(&tmp));
+  rc = gf_array_set_free_fn(tmp, manifest_string_free);
+  if (rc != GF_SUCCESS) {
+    gf_array_free(tmp);
+    gf_throw(rc);
+  }
+  *ary = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_add_string(gf_array* ary, const gf_char* str) {
+  gf_status rc = 0;
+  gf_char* tmp = NULL;
+
+  _(gf_strdup(&tmp, str));
+  rc = gf_array_add(ary, (gf_any){ .ptr = tmp });
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_unit_new(gf_manifest_unit** unit, const gf_char* fingerprint) {
+  gf_status rc = 0;
+  gf_manifest_unit* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->fingerprint = NULL;
+  tmp->outputs = NULL;
+  tmp->stale = NULL;
+  tmp->kept = GF_FALSE;
+  tmp->added = GF_FALSE;
+  rc = gf_strdup(&tmp->fingerprint, fingerprint);
+  if (rc == GF_SUCCESS) {
+    rc = manifest_new_string_array(&tmp->outputs);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = manifest_new_string_array(&tmp->stale);
+  }
+  if (rc != GF_SUCCESS) {
+    manifest_unit_free(&(gf_any){ .ptr = tmp });
+    gf_throw(rc);
+  }
+  *unit = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_manifest_unit*
+manifest_find_unit(const gf_manifest* manifest, const gf_char* key) {
+  gf_any any = { 0 };
+
+  if (!gf_map_find(manifest->units, key, &any)) {
+    return NULL;
+  }
+
+  return any.ptr;
+}
+
+gf_status
+gf_manifest_new(gf_manifest** manifest) {
+  gf_status rc = 0;
+  gf_manifest* tmp = NULL;
+
+  gf_validate(manifest);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->units = NULL;
+  rc = gf_map_new(&tmp->units);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set_free_fn(tmp->units, manifest_unit_free);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_manifest_free(tmp);
+    gf_throw(rc);
+  }
+  *manifest = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_manifest_free(gf_manifest* manifest) {
+  if (manifest) {
+    if (manifest->units) {
+      gf_map_free(manifest->units);
+    }
+    gf_free(manifest);
+  }
+}
+
+gf_bool
+gf_manifest_keep_unit(
+  gf_manifest* manifest, const gf_char* key, const gf_char* fingerprint) {
+  gf_manifest_unit* unit = NULL;
+
+  if (!manifest || gf_strnull(key) || gf_strnull(fingerprint)) {
+    return GF_FALSE;
+  }
+  unit = manifest_find_unit(manifest, key);
+  if (!unit || unit->added || strcmp(unit->fingerprint, fingerprint)) {
+    return GF_FALSE;
+  }
+  for (gf_size_t i = 0; i < gf_array_size(unit->outputs); i++) {
+    gf_any any = { 0 };
+    gf_path* path = NULL;
+    gf_bool exists = GF_FALSE;
+
+    if (gf_array_get(unit->outputs, i, &any) != GF_SUCCESS ||
+        gf_path_new(&path, any.ptr) != GF_SUCCESS) {
+      return GF_FALSE;
+    }
+    exists = gf_path_file_exists(path);
+    gf_path_free(path);
+    if (!exists) {
+      return GF_FALSE;
+    }
+  }
+  unit->kept = GF_TRUE;
+
+  return GF_TRUE;
+}
+
+gf_status
+gf_manifest_add_unit(
+  gf_manifest* manifest, const gf_char* key, const gf_char* fingerprint,
+  gf_manifest_unit** unit) {
+  gf_status rc = 0;
+  gf_manifest_unit* tmp = NULL;
+
+  gf_validate(manifest);
+  gf_validate(!gf_strnull(key));
+  gf_validate(fingerprint);
+  gf_validate(unit);
+
+  tmp = manifest_find_unit(manifest, key);
+  if (!tmp) {
+    _(manifest_unit_new(&tmp, fingerprint));
+    rc = gf_map_set(manifest->units, key, (gf_any){ .ptr = tmp });
+    if (rc != GF_SUCCESS) {
+      manifest_unit_free(&(gf_any){ .ptr = tmp });
+      gf_throw(rc);
+    }
+  } else if (!tmp->added) {
+    /* The files of the previous build are removed unless written again */
+    for (gf_size_t i = 0; i < gf_array_size(tmp->outputs); i++) {
+      gf_any any = { 0 };
+
+      _(gf_array_get(tmp->outputs, i, &any));
+      _(manifest_add_string(tmp->stale, any.ptr));
+    }
+    _(gf_array_clear(tmp->outputs));
+    _(gf_strassign(&tmp->fingerprint, fingerprint));
+  } else {
+    /* Added twice in a build; the outputs are joined */
+  }
+  tmp->kept = GF_FALSE;
+  tmp->added = GF_TRUE;
+  *unit = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_manifest_unit_add_output(gf_manifest_unit* unit, const gf_char* path) {
+  gf_validate(unit);
+  gf_validate(!gf_strnull(path));
+
+  _(manifest_add_string(unit->outputs, path));
+
+  return GF_SUCCESS;
+}
+
+static gf_bool
+manifest_unit_is_live(const gf_manifest_unit* unit) {
+  return unit->kept || unit->added;
+}
+
+static gf_status
+manifest_add_live_output(const gf_char* key, gf_any value, gf_ptr data) {
+  const gf_manifest_unit* unit = value.ptr;
+  gf_map* live = data;
+
+  (void)key;
+
+  if (!manifest_unit_is_live(unit)) {
+    return GF_SUCCESS;
+  }
+  for (gf_size_t i = 0; i < gf_array_size(unit->outputs); i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(unit->outputs, i, &any));
+    _(gf_map_set(live, any.ptr, (gf_any){ .u64 = 0 }));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The state while the stale files are removed
+*/
+
+typedef struct manifest_cleaner {
+  gf_map*   live;               ///< The files written by the live units
+  gf_size_t count;              ///< The number of the files removed
+} manifest_cleaner;
+
+static gf_status
+manifest_remove_files(manifest_cleaner* cleaner, const gf_array* files) {
+  for (gf_size_t i = 0; i < gf_array_size(files); i++) {
+    gf_any any = { 0 };
+    gf_path* path = NULL;
+
+    _(gf_array_get(files, i, &any));
+    if (gf_map_find(cleaner->live, any.ptr, NULL)) {
+      continue;
+    }
+    /* Removed once even if several units wrote it */
+    _(gf_map_set(cleaner->live, any.ptr, (gf_any){ .u64 = 0 }));
+    _(gf_path_new(&path, any.ptr));
+    if (gf_path_file_exists(path)) {
+      if (gf_shell_remove_file(path) == GF_SUCCESS) {
+        gf_debug("Removed the stale output. (%s)", (const gf_char*)any.ptr);
+        cleaner->count++;
+      } else {
+        gf_warn("Failed to remove the stale output. (%s)",
+                (const gf_char*)any.ptr);
+      }
+    }
+    gf_path_free(path);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_remove_unit_outputs(const gf_char* key, gf_any value, gf_ptr data) {
+  const gf_manifest_unit* unit = value.ptr;
+  manifest_cleaner* cleaner = data;
+
+  (void)key;
+
+  if (!manifest_unit_is_live(unit)) {
+    _(manifest_remove_files(cleaner, unit->outputs));
+  }
+  _(manifest_remove_files(cleaner, unit->stale));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_manifest_remove_stale_outputs(
+  const gf_manifest* manifest, gf_size_t* count) {
+  gf_status rc = 0;
+  manifest_cleaner cleaner = { 0 };
+
+  gf_validate(manifest);
+
+  _(gf_map_new(&cleaner.live));
+  rc = gf_map_foreach(manifest->units, manifest_add_live_output, cleaner.live);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_foreach(
+      manifest->units, manifest_remove_unit_outputs, &cleaner);
+  }
+  gf_map_free(cleaner.live);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  if (count) {
+    *count = cleaner.count;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_count_unit(const gf_char* key, gf_any value, gf_ptr data) {
+  const gf_manifest_unit* unit = value.ptr;
+  gf_size_t* count = data;
+
+  (void)key;
+
+  if (unit->kept) {
+    count[0]++;
+  }
+  if (unit->added) {
+    count[1]++;
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_manifest_count_kept_units(const gf_manifest* manifest) {
+  gf_size_t count[2] = { 0 };
+
+  if (manifest) {
+    (void)gf_map_foreach(manifest->units, manifest_count_unit, count);
+  }
+
+  return count[0];
+}
+
+gf_size_t
+gf_manifest_count_added_units(const gf_manifest* manifest) {
+  gf_size_t count[2] = { 0 };
+
+  if (manifest) {
+    (void)gf_map_foreach(manifest->units, manifest_count_unit, count);
+  }
+
+  return count[1];
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Read the units of the manifest file.
+**
+** <build-manifest>
+**   <unit key="..." fingerprint="...">
+**     <output>...</output>
+**   </unit>
+** </build-manifest>
+*/
+
+static gf_status
+manifest_read_unit(
+  gf_manifest* manifest, xmlTextReaderPtr reader, gf_manifest_unit** unit) {
+  gf_status rc = 0;
+  xmlChar* key = NULL;
+  xmlChar* fingerprint = NULL;
+  gf_manifest_unit* tmp = NULL;
+
+  key = xmlTextReaderGetAttribute(reader, BAD_CAST"key");
+  fingerprint = xmlTextReaderGetAttribute(reader, BAD_CAST"fingerprint");
+  if (!key || !key[0] || !fingerprint) {
+    rc = GF_E_DATA;
+  }
+  if (rc == GF_SUCCESS) {
+    rc = manifest_unit_new(&tmp, (const gf_char*)fingerprint);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set(manifest->units, (const gf_char*)key,
+                    (gf_any){ .ptr = tmp });
+    if (rc != GF_SUCCESS) {
+      manifest_unit_free(&(gf_any){ .ptr = tmp });
+    }
+  }
+  xmlFree(key);
+  xmlFree(fingerprint);
+  if (rc != GF_SUCCESS) {
+    gf_raise(rc, "Invalid build manifest.");
+  }
+  *unit = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_read_content(gf_manifest* manifest, xmlTextReaderPtr reader) {
+  gf_status rc = 0;
+  gf_manifest_unit* unit = NULL;
+  int ret = 0;
+
+  while ((ret = xmlTextReaderRead(reader)) == 1) {
+    const xmlChar* name = NULL;
+
+    if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+      continue;
+    }
+    name = xmlTextReaderConstLocalName(reader);
+    if (xmlTextReaderDepth(reader) == 0) {
+      if (xmlStrcmp(name, BAD_CAST"build-manifest")) {
+        gf_raise(GF_E_DATA, "Invalid build manifest.");
+      }
+    } else if (!xmlStrcmp(name, BAD_CAST"unit")) {
+      _(manifest_read_unit(manifest, reader, &unit));
+    } else if (!xmlStrcmp(name, BAD_CAST"output") && unit) {
+      xmlChar* text = xmlTextReaderReadString(reader);
+
+      rc = GF_SUCCESS;
+      if (text && text[0]) {
+        rc = gf_manifest_unit_add_output(unit, (const gf_char*)text);
+      }
+      xmlFree(text);
+      if (rc != GF_SUCCESS) {
+        gf_throw(rc);
+      }
+    } else {
+      /* Unknown element - ignore */
+    }
+  }
+  if (ret < 0) {
+    gf_raise(GF_E_DATA, "Invalid build manifest.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_manifest_read_file(gf_manifest* manifest, const gf_path* path) {
+  gf_status rc = 0;
+  xmlTextReaderPtr reader = NULL;
+
+  gf_validate(manifest);
+  gf_validate(!gf_path_is_empty(path));
+
+  reader = xmlReaderForFile(
+    gf_path_get_string(path), NULL, GF_XML_READ_INFO_OPTIONS);
+  if (!reader) {
+    gf_raise(GF_E_READ, "Failed to read the build manifest.");
+  }
+  rc = manifest_read_content(manifest, reader);
+  xmlFreeTextReader(reader);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_write_unit(const gf_char* key, gf_any value, gf_ptr data) {
+  const gf_manifest_unit* unit = value.ptr;
+  xmlTextWriterPtr writer = data;
+
+  /* The units of the removed sources are dropped */
+  if (!manifest_unit_is_live(unit)) {
+    return GF_SUCCESS;
+  }
+  if (xmlTextWriterStartElement(writer, BAD_CAST"unit") < 0 ||
+      xmlTextWriterWriteAttribute(writer, BAD_CAST"key", BAD_CAST key) < 0 ||
+      xmlTextWriterWriteAttribute(
+        writer, BAD_CAST"fingerprint", BAD_CAST unit->fingerprint) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write the build manifest.");
+  }
+  for (gf_size_t i = 0; i < gf_array_size(unit->outputs); i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(unit->outputs, i, &any));
+    if (xmlTextWriterWriteElement(
+          writer, BAD_CAST"output", BAD_CAST any.ptr) < 0) {
+      gf_raise(GF_E_WRITE, "Failed to write the build manifest.");
+    }
+  }
+  if (xmlTextWriterEndElement(writer) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write the build manifest.");
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+manifest_write_content(
+  const gf_manifest* manifest, xmlTextWriterPtr writer) {
+  if (xmlTextWriterSetIndent(writer, 1) < 0 ||
+      xmlTextWriterSetIndentString(writer, BAD_CAST"  ") < 0 ||
+      xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) < 0 ||
+      xmlTextWriterStartElement(writer, BAD_CAST"build-manifest") < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write the build manifest.");
+  }
+  _(gf_map_foreach(manifest->units, manifest_write_unit, writer));
+  if (xmlTextWriterEndDocument(writer) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write the build manifest.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_manifest_write_file(const gf_manifest* manifest, const gf_path* path) {
+  gf_status rc = 0;
+  gf_path* tmp_path = NULL;
+  gf_char* tmp_name = NULL;
+  gf_size_t len = 0;
+  xmlTextWriterPtr writer = NULL;
+
+  static const gf_char SUFFIX[] = ".tmp";
+
+  gf_validate(manifest);
+  gf_validate(!gf_path_is_empty(path));
+
+  /* The manifest is replaced at once, so a broken one is never read */
+  len = strlen(gf_path_get_string(path)) + sizeof(SUFFIX);
+  _(gf_malloc((gf_ptr*)&tmp_name, len));
+  snprintf(tmp_name, len, "%s%s", gf_path_get_string(path), SUFFIX);
+  rc = gf_path_new(&tmp_path, tmp_name);
+  gf_free(tmp_name);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  writer = xmlNewTextWriterFilename(gf_path_get_string(tmp_path), 0);
+  if (!writer) {
+    gf_path_free(tmp_path);
+    gf_raise(GF_E_OPEN, "Failed to open the build manifest.");
+  }
+  rc = manifest_write_content(manifest, writer);
+  xmlFreeTextWriter(writer);
+  if (rc == GF_SUCCESS) {
+    rc = gf_shell_replace(path, tmp_path);
+  } else {
+    (void)remove(gf_path_get_string(tmp_path));
+  }
+  gf_path_free(tmp_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_manifest.h
+** @brief The build manifest (build-manifest.xml).
+**
+** The manifest records the units of a build - a document, a process of a
+** section or the static files of an entry - with the fingerprint of their
+** inputs and the files they wrote. The next build skips the units whose
+** fingerprints are unchanged, and removes the files no unit writes any more.
+*/
+#ifndef LIBGF_GF_MANIFEST_H
+#define LIBGF_GF_MANIFEST_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_path.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gf_manifest gf_manifest;
+typedef struct gf_manifest_unit gf_manifest_unit;
+
+/*!
+** @brief Create a new empty manifest.
+**
+** @param [out] manifest The new manifest
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_manifest_new(gf_manifest** manifest);
+extern void gf_manifest_free(gf_manifest* manifest);
+
+/*!
+** @brief Add the units recorded in a manifest file.
+**
+** @param [in, out] manifest The manifest
+** @param [in]      path     The file written by gf_manifest_write_file()
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_manifest_read_file(
+  gf_manifest* manifest, const gf_path* path);
+
+/*!
+** @brief Write the manifest to a file.
+**
+** Only the units kept or added since the manifest was read are written, so
+** the units of the removed sources are dropped.
+**
+** @param [in] manifest The manifest
+** @param [in] path     The file path to be written
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_manifest_write_file(
+  const gf_manifest* manifest, const gf_path* path);
+
+/*!
+** @brief Keep a unit if its outputs are up to date.
+**
+** The outputs are up to date if the unit was recorded with the same
+** fingerprint and all of its files exist.
+**
+** @param [in, out] manifest    The manifest
+** @param [in]      key         The key of the unit
+** @param [in]      fingerprint The fingerprint of the inputs of the unit
+**
+** @return GF_TRUE if the unit is kept, GF_FALSE if it has to be built.
+*/
+
+extern gf_bool gf_manifest_keep_unit(
+  gf_manifest* manifest, const gf_char* key, const gf_char* fingerprint);
+
+/*!
+** @brief Start recording a unit which is built.
+**
+** The files recorded for the unit before are forgotten; those which are not
+** recorded again are removed by gf_manifest_remove_stale_outputs().
+**
+** @param [in, out] manifest    The manifest
+** @param [in]      key         The key of the unit
+** @param [in]      fingerprint The fingerprint of the inputs of the unit
+** @param [out]     unit        The unit, valid while the manifest lives
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_manifest_add_unit(
+  gf_manifest* manifest, const gf_char* key, const gf_char* fingerprint,
+  gf_manifest_unit** unit);
+
+/*!
+** @brief Record a file written by a unit.
+*/
+
+extern gf_status gf_manifest_unit_add_output(
+  gf_manifest_unit* unit, const gf_char* path);
+
+/*!
+** @brief Remove the files which no unit kept or added writes.
+**
+** @param [in]  manifest The manifest
+** @param [out] count    The number of the files removed (may be NULL)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_manifest_remove_stale_outputs(
+  const gf_manifest* manifest, gf_size_t* count);
+
+/*!
+** @brief Count the units kept and added since the manifest was read.
+*/
+
+extern gf_size_t gf_manifest_count_kept_units(const gf_manifest* manifest);
+extern gf_size_t gf_manifest_count_added_units(const gf_manifest* manifest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_MANIFEST_H */
@@ -0,0 +1,302 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_map.c
+** @brief String keyed hash map module.
+*/
+#include <assert.h>
+#include <string.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_map.h>
+
+#include "gf_local.h"
+
+/* The number of buckets must be a power of two */
+#define MAP_INITIAL_BUCKETS 64
+
+typedef struct map_node map_node;
+
+struct map_node {
+  map_node* next;
+  gf_32u    hash;
+  gf_char*  key;
+  gf_any    value;
+};
+
+struct gf_map {
+  map_node**     buckets;
+  gf_size_t      bucket_count;
+  gf_size_t      used;
+  gf_map_free_fn free;
+};
+
+/*!
+** @brief FNV-1a hash of the key string
+*/
+
+static gf_32u
+map_hash(const gf_char* key) {
+  gf_32u h = 2166136261u;
+
+  for (const gf_8u* p = (const gf_8u*)key; *p; p++) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+
+  return h;
+}
+
+static gf_status
+map_init(gf_map* map) {
+  gf_validate(map);
+
+  map->buckets = NULL;
+  map->bucket_count = 0;
+  map->used = 0;
+  map->free = NULL;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+map_alloc_buckets(map_node*** buckets, gf_size_t count) {
+  map_node** tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp) * count));
+  for (gf_size_t i = 0; i < count; i++) {
+    tmp[i] = NULL;
+  }
+  *buckets = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+map_prepare(gf_map* map) {
+  gf_validate(map);
+
+  _(map_alloc_buckets(&map->buckets, MAP_INITIAL_BUCKETS));
+  map->bucket_count = MAP_INITIAL_BUCKETS;
+
+  return GF_SUCCESS;
+}
+
+static void
+map_free_node(gf_map* map, map_node* node) {
+  assert(node);
+
+  if (map->free) {
+    map->free(&node->value);
+  }
+  gf_free(node->key);
+  gf_free(node);
+}
+
+static map_node*
+map_find_node(const gf_map* map, const gf_char* key, gf_32u hash) {
+  map_node* node = map->buckets[hash & (map->bucket_count - 1)];
+
+  for (; node; node = node->next) {
+    if (node->hash == hash && !strcmp(node->key, key)) {
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+/*!
+** @brief Double the number of buckets when the load factor exceeds 3/4
+*/
+
+static gf_status
+map_grow(gf_map* map) {
+  map_node** buckets = NULL;
+  gf_size_t count = 0;
+
+  if (map->used * 4 < map->bucket_count * 3) {
+    return GF_SUCCESS;
+  }
+  count = map->bucket_count * 2;
+  _(map_alloc_buckets(&buckets, count));
+  for (gf_size_t i = 0; i < map->bucket_count; i++) {
+    map_node* node = map->buckets[i];
+    while (node) {
+      map_node* next = node->next;
+      gf_size_t index = node->hash & (count - 1);
+      node->next = buckets[index];
+      buckets[index] = node;
+      node = next;
+    }
+  }
+  gf_free(map->buckets);
+  map->buckets = buckets;
+  map->bucket_count = count;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_map_new(gf_map** map) {
+  gf_status rc = 0;
+  gf_map* tmp = NULL;
+
+  gf_validate(map);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  rc = map_init(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  rc = map_prepare(tmp);
+  if (rc != GF_SUCCESS) {
+    gf_map_free(tmp);
+    gf_throw(rc);
+  }
+  *map = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_map_free(gf_map* map) {
+  if (map) {
+    if (map->buckets) {
+      (void)gf_map_clear(map);
+      gf_free(map->buckets);
+    }
+    (void)map_init(map);
+    gf_free(map);
+  }
+}
+
+gf_status
+gf_map_clear(gf_map* map) {
+  gf_validate(map);
+
+  for (gf_size_t i = 0; i < map->bucket_count; i++) {
+    map_node* node = map->buckets[i];
+    while (node) {
+      map_node* next = node->next;
+      map_free_node(map, node);
+      node = next;
+    }
+    map->buckets[i] = NULL;
+  }
+  map->used = 0;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_map_set_free_fn(gf_map* map, gf_map_free_fn fn) {
+  gf_validate(map);
+  map->free = fn;
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_map_set(gf_map* map, const gf_char* key, gf_any value) {
+  gf_status rc = 0;
+  gf_32u hash = 0;
+  gf_size_t index = 0;
+  map_node* node = NULL;
+
+  gf_validate(map);
+  gf_validate(key);
+
+  hash = map_hash(key);
+  node = map_find_node(map, key, hash);
+  if (node) {
+    if (map->free) {
+      map->free(&node->value);
+    }
+    node->value = value;
+    return GF_SUCCESS;
+  }
+
+  _(map_grow(map));
+
+  _(gf_malloc((gf_ptr*)&node, sizeof(*node)));
+  rc = gf_strdup(&node->key, key);
+  if (rc != GF_SUCCESS) {
+    gf_free(node);
+    gf_throw(rc);
+  }
+  node->hash = hash;
+  node->value = value;
+  index = hash & (map->bucket_count - 1);
+  node->next = map->buckets[index];
+  map->buckets[index] = node;
+  map->used += 1;
+
+  return GF_SUCCESS;
+}
+
+gf_bool
+gf_map_find(const gf_map* map, const gf_char* key, gf_any* value) {
+  map_node* node = NULL;
+
+  if (!map || !key) {
+    return GF_FALSE;
+  }
+  node = map_find_node(map, key, map_hash(key));
+  if (!node) {
+    return GF_FALSE;
+  }
+  if (value) {
+    *value = node->value;
+  }
+
+  return GF_TRUE;
+}
+
+gf_status
+gf_map_remove(gf_map* map, const gf_char* key) {
+  gf_32u hash = 0;
+  map_node** link = NULL;
+
+  gf_validate(map);
+  gf_validate(key);
+
+  hash = map_hash(key);
+  link = &map->buckets[hash & (map->bucket_count - 1)];
+  for (; *link; link = &(*link)->next) {
+    map_node* node = *link;
+    if (node->hash == hash && !strcmp(node->key, key)) {
+      *link = node->next;
+      map_free_node(map, node);
+      map->used -= 1;
+      break;
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_map_foreach(const gf_map* map, gf_map_visit_fn fn, gf_ptr data) {
+  gf_validate(map);
+  gf_validate(fn);
+
+  for (gf_size_t i = 0; i < map->bucket_count; i++) {
+    for (map_node* node = map->buckets[i]; node; node = node->next) {
+      _(fn(node->key, node->value, data));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_map_size(const gf_map* map) {
+  if (!map) {
+    return 0;
+  }
+  return map->used;
+}
@@ -0,0 +1,147 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_map.h
+** @brief String keyed hash map module.
+*/
+#ifndef LIBGF_GF_MAP_H
+#define LIBGF_GF_MAP_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+** @brief Hash map type
+**
+** This is a opaque datatype. To instantiate, use gf_map_new(). The keys are
+** copied into the map; the values are stored as they are.
+*/
+
+typedef struct gf_map gf_map;
+
+typedef void (*gf_map_free_fn)(gf_any* any);
+
+/*!
+** @brief Callback for gf_map_foreach()
+**
+** Returning other than GF_SUCCESS stops the iteration, and the status is
+** returned from gf_map_foreach().
+*/
+
+typedef gf_status (*gf_map_visit_fn)(
+  const gf_char* key, gf_any value, gf_ptr data);
+
+/*!
+** @brief Create a new map object
+**
+** @param [out] map The map object to be created
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_map_new(gf_map** map);
+
+/*!
+** @brief Destroy the specified map object
+**
+** @param [in] map The map object to be destroyed
+*/
+
+extern void gf_map_free(gf_map* map);
+
+/*!
+** @brief Remove all the elements of the map
+**
+** If the callback gf_map_free_fn has been set, it is called for each value.
+**
+** @param [in] map The map object to be cleared
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_map_clear(gf_map* map);
+
+/*
+** @brief Set the deallocation callback function
+**
+** @param [in, out] map The map object
+** @param [in]      fn  The user defined callback to be set
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_map_set_free_fn(gf_map* map, gf_map_free_fn fn);
+
+/*!
+** @brief Associate the value with the key
+**
+** If the key already exists, the old value is released by the free callback
+** and replaced.
+**
+** @param [in, out] map   The map object
+** @param [in]      key   The key string
+** @param [in]      value The value to be stored
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_map_set(gf_map* map, const gf_char* key, gf_any value);
+
+/*!
+** @brief Look up the value associated with the key
+**
+** @param [in]  map   The map object
+** @param [in]  key   The key string
+** @param [out] value The value found (may be NULL)
+**
+** @return GF_TRUE if the key is found, GF_FALSE otherwise.
+*/
+
+extern gf_bool gf_map_find(
+  const gf_map* map, const gf_char* key, gf_any* value);
+
+/*!
+** @brief Remove the key and its value
+**
+** @param [in, out] map The map object
+** @param [in]      key The key string
+**
+** @return GF_SUCCESS on success (including the key is not found), GF_E_*
+**         otherwise.
+*/
+
+extern gf_status gf_map_remove(gf_map* map, const gf_char* key);
+
+/*!
+** @brief Call the function for each element of the map
+**
+** The order of the iteration is unspecified. The map must not be modified
+** while iterating.
+**
+** @param [in] map  The map object
+** @param [in] fn   The callback
+** @param [in] data The user data passed to @a fn
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_map_foreach(
+  const gf_map* map, gf_map_visit_fn fn, gf_ptr data);
+
+extern gf_size_t gf_map_size(const gf_map* map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_MAP_H */
@@ -11,11 +11,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
 
 #include <libgen.h>
 
+#if defined(_WIN32)
 #include <shlwapi.h>
+#endif
 
 #include <libgf/gf_swap.h>
 #include <libgf/gf_memory.h>
@@ -134,6 +143,70 @@ gf_path_clone(gf_path** dst, const gf_path* src) {
   return GF_SUCCESS;
 }
 
+#if !defined(_WIN32)
+/*!
+** @brief Make the full path of a path string as _fullpath() on Windows.
+**
+** The components "." and ".." are removed lexically, so that the path does
+** not need to exist, and the symbolic links are not resolved.
+*/
+
+static char*
+path_make_full_path(const char* str) {
+  gf_status rc = 0;
+  gf_path* cwd = NULL;
+  const char* base = "";
+  char* src = NULL;
+  char* buf = NULL;
+  gf_size_t len = 0;
+  gf_size_t pos = 0;
+
+  if (str[0] != '/') {
+    if (gf_path_get_current_path(&cwd) != GF_SUCCESS) {
+      return NULL;
+    }
+    base = gf_path_get_string(cwd);
+  }
+  len = strlen(base) + 1 + strlen(str) + 1;
+  rc = gf_malloc((gf_ptr*)&src, len);
+  if (rc == GF_SUCCESS) {
+    rc = gf_malloc((gf_ptr*)&buf, len + 1);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_free(src);
+    gf_path_free(cwd);
+    return NULL;
+  }
+  snprintf(src, len, "%s/%s", base, str);
+  gf_path_free(cwd);
+
+  for (const char* p = src; *p; ) {
+    gf_size_t n = strcspn(p, "/");
+
+    if (n == 2 && p[0] == '.' && p[1] == '.') {
+      /* Back to the previous separator, but not beyond the root */
+      while (pos > 0 && buf[--pos] != '/') {
+      }
+    } else if (n > 0 && !(n == 1 && p[0] == '.')) {
+      buf[pos++] = '/';
+      memcpy(&buf[pos], p, n);
+      pos += n;
+    }
+    p += n;
+    if (*p == '/') {
+      p++;
+    }
+  }
+  if (pos == 0) {
+    buf[pos++] = '/';
+  }
+  buf[pos] = '\0';
+  gf_free(src);
+
+  return buf;
+}
+#endif
+
 gf_status
 gf_path_absolute_path(gf_path* path) {
   gf_status rc = 0;
@@ -141,15 +214,17 @@ gf_path_absolute_path(gf_path* path) {
 
   gf_validate(path);
 
-  // NOTE: _fullpath is a windows specific API. On UN*X, you should use
-  // realpath(3) instead.
+#if defined(_WIN32)
   buf = _fullpath(NULL, path->buf, 0);
+#else
+  buf = path_make_full_path(path->buf);
+#endif
   if (!buf) {
     gf_raise(GF_E_API, "Failed to get full path name '%s'", path->buf);
   }
   rc = gf_strassign(&path->buf, buf);
+  gf_free(buf);
   if (rc != GF_SUCCESS) {
-    gf_free(buf);
     gf_throw(rc);
   }
   path->len = gf_strlen(path->buf);
@@ -232,7 +307,11 @@ gf_path_is_root(const gf_path* path) {
   if (gf_path_is_empty(path)) {
     return GF_FALSE;
   }
+#if defined(_WIN32)
   return PathIsRoot(path->buf) ? GF_TRUE : GF_FALSE;
+#else
+  return !strcmp(path->buf, "/") ? GF_TRUE : GF_FALSE;
+#endif
 }
 
 gf_bool
@@ -240,6 +319,7 @@ gf_path_is_empty(const gf_path* path) {
   return !path || gf_strnull(path->buf);
 }
 
+#if defined(_WIN32)
 gf_bool
 gf_path_file_exists(const gf_path* path) {
   return path && PathFileExists(path->buf) ? GF_TRUE : GF_FALSE;
@@ -249,6 +329,22 @@ gf_bool
 gf_path_is_directory(const gf_path* path) {
   return path && PathIsDirectory(path->buf) ? GF_TRUE : GF_FALSE;
 }
+#else
+gf_bool
+gf_path_file_exists(const gf_path* path) {
+  struct stat st;
+
+  return path && path->buf && !stat(path->buf, &st) ? GF_TRUE : GF_FALSE;
+}
+
+gf_bool
+gf_path_is_directory(const gf_path* path) {
+  struct stat st;
+
+  return path && path->buf && !stat(path->buf, &st) && S_ISDIR(st.st_mode) ?
+    GF_TRUE : GF_FALSE;
+}
+#endif
 
 gf_bool
 gf_path_has_separator(const gf_path* path) {
@@ -306,7 +402,7 @@ gf_path_append(gf_path* path, const gf_path* src) {
   */
   ptr = buf;
   if (path->len > 0) {
-    memcpy_s(ptr, path->len, path->buf, path->len);
+    memcpy(ptr, path->buf, path->len);
     ptr += path->len;
     // TODO: make a function to check this condition below
     if (path->len > 1 || path->buf[0] != '/') {
@@ -314,7 +410,7 @@ gf_path_append(gf_path* path, const gf_path* src) {
       ptr++;
     }
   }
-  memcpy_s(ptr, src->len, src->buf, src->len);
+  memcpy(ptr, src->buf, src->len);
 
   buf[len] = '\0';
   // Assignment
@@ -429,7 +525,7 @@ gf_path_evacuate(const gf_path* path) {
   }
 
   len = path->len + gf_string_size(str_date) + extra;
-  rc = gf_malloc((gf_ptr *)buf, len);
+  rc = gf_malloc((gf_ptr *)&buf, len);
   if (rc != GF_SUCCESS) {
     gf_path_free(new_path);
     gf_string_free(str_date);
@@ -438,21 +534,24 @@ gf_path_evacuate(const gf_path* path) {
   for (gf_size_t i = 0; ; i++) {
     int ret = 0;
     
-    ret = sprintf_s(buf, len, "%s.%s-%04d",
-                    path->buf, gf_string_get(str_date), i);
-    if (ret == 0) {
+    ret = snprintf(buf, len, "%s.%s-%04zu",
+                   path->buf, gf_string_get(str_date), i);
+    if (ret <= 0 || (gf_size_t)ret >= len) {
+      gf_free(buf);
       gf_path_free(new_path);
       gf_string_free(str_date);
       gf_raise(GF_E_API, "Failed to evacuate the existing directory.");
     }
     rc = gf_path_set_string(new_path, buf);
     if (rc != GF_SUCCESS) {
+      gf_free(buf);
       gf_path_free(new_path);
       gf_string_free(str_date);
       gf_throw(rc);
     }
     if (!gf_path_file_exists(new_path)) {
       rc = gf_shell_move(new_path, path);
+      gf_free(buf);
       gf_path_free(new_path);
       gf_string_free(str_date);
       if (rc != GF_SUCCESS) {
@@ -473,7 +572,11 @@ gf_status
 gf_path_change_directory(const gf_path* path) {
   gf_validate(!gf_path_is_empty(path));
 
+#if defined(_WIN32)
   if (!SetCurrentDirectory(path->buf)) {
+#else
+  if (chdir(path->buf)) {
+#endif
     gf_raise(GF_E_INTERNAL,
              "Failed to change the directory. (%s)", path->buf);
   }
@@ -488,7 +591,11 @@ gf_path_create_directory(const gf_path* path) {
   gf_validate(path);
 
   str = gf_path_get_string(path);
+#if defined(_WIN32)
   if (!CreateDirectory(str, NULL)) {
+#else
+  if (mkdir(str, 0777)) {
+#endif
     gf_raise(GF_E_PATH, "Failed to create directory. (%s)", path->buf);
   }
   
@@ -498,8 +605,13 @@ gf_path_create_directory(const gf_path* path) {
 gf_status
 gf_path_get_module_file_path(gf_path** path) {
   gf_status rc = 0;
+#if defined(_WIN32)
   DWORD path_size = MAX_PATH / 2 + 1;
   DWORD ret_size = 0;
+#else
+  gf_size_t path_size = 128;
+  ssize_t ret_size = 0;
+#endif
   gf_path* new_path = NULL;
   char* tmp = NULL;
   
@@ -513,12 +625,20 @@ gf_path_get_module_file_path(gf_path** path) {
       gf_free(tmp);
       return rc;
     }
+#if defined(_WIN32)
     ret_size = GetModuleFileNameA(NULL, tmp, path_size);
-    if (ret_size == 0) {
+#else
+    ret_size = readlink("/proc/self/exe", tmp, path_size);
+#endif
+    if (ret_size <= 0) {
       gf_free(tmp);
       gf_raise(GF_E_PATH, "Failed to get the module file path.");
     }
-  } while (ret_size >= path_size);
+  } while ((gf_size_t)ret_size >= path_size);
+#if !defined(_WIN32)
+  /* readlink(2) does not terminate the string */
+  tmp[ret_size] = '\0';
+#endif
 
   rc = gf_path_new(&new_path, tmp);
   gf_free(tmp);
@@ -573,7 +693,11 @@ gf_path_get_style_path(gf_path** path) {
     gf_raise(GF_E_PARAM, "The style path is empty");
   }
 
+#if defined(_WIN32)
   if (PathIsRelative(str)) {
+#else
+  if (str[0] != '/') {
+#endif
     rc = gf_path_get_module_directory_path(&module_path);
     if (rc != GF_SUCCESS) {
       gf_throw(rc);
@@ -600,18 +724,41 @@ gf_path_get_style_path(gf_path** path) {
 gf_status
 gf_path_get_current_path(gf_path** path) {
   gf_status rc = 0;
+#if defined(_WIN32)
   DWORD len = 0;
+#else
+  gf_size_t len = 64;
+#endif
   char* buf = NULL;
   gf_path* tmp = NULL;
 
   gf_validate(path);
 
+#if defined(_WIN32)
   /* Determine the required buffer size */
   len = GetCurrentDirectory(0, NULL);
 
   _(gf_malloc((gf_ptr*)&buf, len));
 
   GetCurrentDirectory(len, buf);
+#else
+  /* Grow the buffer until the path fits in */
+  for (;;) {
+    rc = gf_realloc((gf_ptr*)&buf, len);
+    if (rc != GF_SUCCESS) {
+      gf_free(buf);
+      gf_throw(rc);
+    }
+    if (getcwd(buf, len)) {
+      break;
+    }
+    if (errno != ERANGE) {
+      gf_free(buf);
+      gf_raise(GF_E_PATH, "Failed to get the current directory.");
+    }
+    len *= 2;
+  }
+#endif
   rc = gf_path_new(&tmp, buf);
   gf_free(buf);
   if (rc != GF_SUCCESS) {
@@ -723,9 +870,60 @@ gf_uri_free(gf_uri* uri) {
   }
 }
 
+#if !defined(_WIN32)
+/*!
+** @brief Copy a part of a path string as _splitpath_s() on Windows.
+**
+** @return 0 on success, ERANGE if the buffer is too small.
+*/
+
+static int
+uri_copy_part(char* dst, gf_size_t size, const char* src, gf_size_t n) {
+  if (n >= size) {
+    return ERANGE;
+  }
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+
+  return 0;
+}
+
+/*!
+** @brief Split a path string as _splitpath_s() on Windows.
+**
+** The drive is always empty. The directory keeps the last separator, and
+** the extension keeps the leading period.
+*/
+
+static int
+uri_split_path(gf_uri* uri, const char* path, gf_size_t len) {
+  const char* name = strrchr(path, '/');
+  const char* ext = NULL;
+  int ret = 0;
+
+  name = name ? name + 1 : path;
+  ext = strrchr(name, '.');
+  if (!ext) {
+    ext = name + strlen(name);
+  }
+  ret = uri_copy_part(uri->drive, len, path, 0);
+  if (ret == 0) {
+    ret = uri_copy_part(uri->dir, len, path, (gf_size_t)(name - path));
+  }
+  if (ret == 0) {
+    ret = uri_copy_part(uri->fname, len, name, (gf_size_t)(ext - name));
+  }
+  if (ret == 0) {
+    ret = uri_copy_part(uri->ext, len, ext, strlen(ext));
+  }
+
+  return ret;
+}
+#endif
+
 gf_status
 gf_uri_split(gf_uri** uri, const char* path, gf_size_t len) {
-  errno_t ret = 0;
+  int ret = 0;
   gf_uri* tmp = NULL;
 
   gf_validate(!gf_strnull(path));
@@ -733,8 +931,12 @@ gf_uri_split(gf_uri** uri, const char* path, gf_size_t len) {
 
   _(gf_uri_new(&tmp, len));
 
+#if defined(_WIN32)
   ret = _splitpath_s(
     path, tmp->drive, len, tmp->dir, len, tmp->fname, len, tmp->ext, len);
+#else
+  ret = uri_split_path(tmp, path, len);
+#endif
   if (ret != 0) {
     gf_uri_free(tmp);
     gf_raise(GF_E_PATH, "Failed to split the path.");
@@ -751,14 +953,19 @@ gf_uri_build_directory_path(gf_path** path, gf_uri* uri) {
   gf_size_t size = uri->size * 2;
   gf_path* tmp = NULL;
   char* str = NULL;
-  errno_t ret = 0;
+  int ret = 0;
   
   gf_validate(path);
   gf_validate(uri);
 
   _(gf_malloc((gf_ptr *)&str, size));
 
+#if defined(_WIN32)
   ret = _makepath_s(str, size, uri->drive, uri->dir, NULL, NULL);
+#else
+  ret = snprintf(str, size, "%s%s", uri->drive, uri->dir);
+  ret = ret < 0 || (gf_size_t)ret >= size ? ERANGE : 0;
+#endif
   if (ret != 0) {
     gf_free(str);
     gf_raise(GF_E_PATH, "Failed to make directory path.");
@@ -96,8 +96,8 @@ extern gf_status gf_path_file_name(gf_path* path);
 /*!
 ** @brief Get parent directory path
 **
-** @note This function depends on _splitpath_s() and _makepath() that limit the
-** string length in MAX_PATH.
+** @note On Windows, this function depends on _splitpath_s() and _makepath()
+** that limit the string length in MAX_PATH.
 */
 
 extern gf_status gf_path_get_parent(gf_path** parent, const gf_path* path);
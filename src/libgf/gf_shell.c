@@ -8,15 +8,27 @@
 */
 
 #include <assert.h>
+#include <string.h>
 
+#if defined(_WIN32)
 #include <windows.h>
-
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
 #include <libgf/gf_shell.h>
 #include <libgf/gf_local.h>
 
 /* -------------------------------------------------------------------------- */
 
+#if defined(_WIN32)
 /*
 ** The common interface for file attributes
 */
@@ -53,11 +65,25 @@ shell_has_attributes(const gf_path* path, DWORD flags) {
 
   return shell_has_specified_attributes(attr, flags);
 }
+#else
+/*
+** The common interface for file attributes (POSIX)
+*/
+
+static gf_bool
+shell_stat(const gf_path* path, struct stat* st) {
+  if (gf_path_is_empty(path)) {
+    return GF_FALSE;
+  }
+  return stat(gf_path_get_string(path), st) == 0 ? GF_TRUE : GF_FALSE;
+}
+#endif
 
 /* -------------------------------------------------------------------------- */
 
 gf_bool
 gf_shell_file_exists(const gf_path* path) {
+#if defined(_WIN32)
   DWORD attr = 0;
   
   if (gf_path_is_empty(path)) {
@@ -66,15 +92,27 @@ gf_shell_file_exists(const gf_path* path) {
   attr = shell_get_file_attributes(path);
   
   return attr != INVALID_FILE_ATTRIBUTES ? GF_TRUE : GF_FALSE;
+#else
+  struct stat st;
+
+  return shell_stat(path, &st);
+#endif
 }
 
 gf_bool
 gf_shell_is_directory(const gf_path* path) {
+#if defined(_WIN32)
   return shell_has_attributes(path, FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat st;
+
+  return (shell_stat(path, &st) && S_ISDIR(st.st_mode)) ? GF_TRUE : GF_FALSE;
+#endif
 }
 
 gf_bool
 gf_shell_is_normal_file(const gf_path* path) {
+#if defined(_WIN32)
   DWORD attr = 0;
   const DWORD flags = FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE;
 
@@ -89,6 +127,17 @@ gf_shell_is_normal_file(const gf_path* path) {
 
   /* not reaches here. */
   return GF_TRUE;
+#else
+  struct stat st;
+
+  if (!shell_stat(path, &st)) {
+    return GF_FALSE;
+  } else if (S_ISDIR(st.st_mode) || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode)) {
+    return GF_FALSE;
+  } else {
+    return GF_TRUE;
+  }
+#endif
 }
 
 int
@@ -136,8 +185,45 @@ gf_shell_compare_files(gf_path* f1, gf_path* f2) {
   return ret;
 }
 
+#if !defined(_WIN32)
+static gf_status
+shell_copy_contents(int out, int in) {
+  static const gf_size_t SIZE = 64 * 1024;
+
+  gf_status rc = GF_SUCCESS;
+  char* buf = NULL;
+
+  _(gf_malloc((gf_ptr*)&buf, SIZE));
+  while (rc == GF_SUCCESS) {
+    ssize_t len = read(in, buf, SIZE);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      rc = len < 0 ? GF_E_READ : GF_SUCCESS;
+      break;
+    }
+    for (ssize_t done = 0; done < len; ) {
+      ssize_t ret = write(out, buf + done, (size_t)(len - done));
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret < 0) {
+        rc = GF_E_WRITE;
+        break;
+      }
+      done += ret;
+    }
+  }
+  gf_free(buf);
+
+  return rc;
+}
+#endif
+
 gf_status
 gf_shell_copy_file(const gf_path* dst, const gf_path* src) {
+#if defined(_WIN32)
   BOOL ret = FALSE;
   const char* s = NULL;
   const char* d = NULL;
@@ -156,17 +242,59 @@ gf_shell_copy_file(const gf_path* dst, const gf_path* src) {
   }
   
   return GF_SUCCESS;
+#else
+  gf_status rc = 0;
+  const char* s = NULL;
+  const char* d = NULL;
+  struct stat st;
+  int in = -1;
+  int out = -1;
+
+  gf_validate(!gf_path_is_empty(dst));
+  gf_validate(!gf_path_is_empty(src));
+
+  s = gf_path_get_string(src);
+  d = gf_path_get_string(dst);
+
+  in = open(s, O_RDONLY | O_CLOEXEC);
+  if (in < 0) {
+    gf_raise(GF_E_SHELL, "Failed to copy file (src:%s)(dst:%s)", s, d);
+  }
+  if (fstat(in, &st) != 0) {
+    close(in);
+    gf_raise(GF_E_SHELL, "Failed to copy file (src:%s)(dst:%s)", s, d);
+  }
+  out = open(d, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+  if (out < 0) {
+    close(in);
+    gf_raise(GF_E_SHELL, "Failed to copy file (src:%s)(dst:%s)", s, d);
+  }
+  rc = shell_copy_contents(out, in);
+  close(in);
+  if (close(out) != 0 && rc == GF_SUCCESS) {
+    rc = GF_E_WRITE;
+  }
+  if (rc != GF_SUCCESS) {
+    gf_raise(GF_E_SHELL, "Failed to copy file (src:%s)(dst:%s)", s, d);
+  }
+
+  return GF_SUCCESS;
+#endif
 }
 
 gf_status
 gf_shell_make_directory(const gf_path* path) {
-  BOOL ret = FALSE;
+  gf_bool ret = GF_FALSE;
   const char* s = NULL;
 
   gf_validate(!gf_path_is_empty(path));
 
   s = gf_path_get_string(path);
-  ret = CreateDirectory(s, NULL);
+#if defined(_WIN32)
+  ret = CreateDirectory(s, NULL) ? GF_TRUE : GF_FALSE;
+#else
+  ret = mkdir(s, 0777) == 0 ? GF_TRUE : GF_FALSE;
+#endif
   if (!ret) {
     gf_raise(GF_E_SHELL, "Failed to create directory. (%s)", s);
   }
@@ -176,6 +304,7 @@ gf_shell_make_directory(const gf_path* path) {
 
 gf_status
 gf_shell_touch(const gf_path* path) {
+#if defined(_WIN32)
   HANDLE hFile = INVALID_HANDLE_VALUE;
   const char* s = gf_path_get_string(path);
   
@@ -196,17 +325,35 @@ gf_shell_touch(const gf_path* path) {
   CloseHandle(hFile);
   
   return GF_SUCCESS;
+#else
+  int fd = -1;
+
+  gf_validate(!gf_path_is_empty(path));
+
+  fd = open(gf_path_get_string(path), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    gf_raise(GF_E_OPEN, "Failed to touch the file (%s)",
+             gf_path_get_string(path));
+  }
+  close(fd);
+
+  return GF_SUCCESS;
+#endif
 }
 
 gf_status
 gf_shell_remove_file(const gf_path* path) {
-  BOOL ret = FALSE;
+  gf_bool ret = GF_FALSE;
   const char* s = NULL;
   
   gf_validate(!gf_path_is_empty(path));
 
   s = gf_path_get_string(path);
-  ret = DeleteFile(s);
+#if defined(_WIN32)
+  ret = DeleteFile(s) ? GF_TRUE : GF_FALSE;
+#else
+  ret = unlink(s) == 0 ? GF_TRUE : GF_FALSE;
+#endif
   if (!ret) {
     gf_raise(GF_E_SHELL, "Faild to remove file. (%s)", s);
   }
@@ -216,13 +363,17 @@ gf_shell_remove_file(const gf_path* path) {
 
 gf_status
 gf_shell_remove_directory(const gf_path* path) {
-  BOOL ret = FALSE;
+  gf_bool ret = GF_FALSE;
   const char* s = NULL;
   
   gf_validate(!gf_path_is_empty(path));
 
   s = gf_path_get_string(path);
-  ret = RemoveDirectory(s);
+#if defined(_WIN32)
+  ret = RemoveDirectory(s) ? GF_TRUE : GF_FALSE;
+#else
+  ret = rmdir(s) == 0 ? GF_TRUE : GF_FALSE;
+#endif
   if (!ret) {
     gf_raise(GF_E_SHELL, "Failed to remove direcotry. (%s)", s);
   }
@@ -232,17 +383,23 @@ gf_shell_remove_directory(const gf_path* path) {
 
 gf_status
 gf_shell_rename(const gf_path* dst, const gf_path* src) {
-  BOOL ret = FALSE;
+  gf_bool ret = GF_FALSE;
   const char* s = NULL;
   const char* d = NULL;
+#if defined(_WIN32)
   static const DWORD flags = 0;
+#endif
   
   gf_validate(!gf_path_is_empty(dst));
   gf_validate(!gf_path_is_empty(src));
 
   s = gf_path_get_string(src);
   d = gf_path_get_string(dst);
-  ret = MoveFileEx(s, d, flags);
+#if defined(_WIN32)
+  ret = MoveFileEx(s, d, flags) ? GF_TRUE : GF_FALSE;
+#else
+  ret = rename(s, d) == 0 ? GF_TRUE : GF_FALSE;
+#endif
   if (!ret) {
     gf_raise(GF_E_SHELL, "Failed to move file. (src:%s)(dst:%s)", s, d);
   }
@@ -255,6 +412,34 @@ gf_shell_move(const gf_path* dst, const gf_path* src) {
   return gf_shell_rename(dst, src);
 }
 
+gf_status
+gf_shell_replace(const gf_path* dst, const gf_path* src) {
+  gf_bool ret = GF_FALSE;
+  const char* s = NULL;
+  const char* d = NULL;
+#if defined(_WIN32)
+  static const DWORD flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+#endif
+
+  gf_validate(!gf_path_is_empty(dst));
+  gf_validate(!gf_path_is_empty(src));
+
+  s = gf_path_get_string(src);
+  d = gf_path_get_string(dst);
+#if defined(_WIN32)
+  ret = MoveFileEx(s, d, flags) ? GF_TRUE : GF_FALSE;
+#else
+  /* rename(2) replaces the destination atomically */
+  ret = rename(s, d) == 0 ? GF_TRUE : GF_FALSE;
+#endif
+  if (!ret) {
+    gf_raise(GF_E_SHELL, "Failed to replace file. (src:%s)(dst:%s)", s, d);
+  }
+
+  return GF_SUCCESS;
+}
+
+#if defined(_WIN32)
 gf_status
 gf_shell_traverse_tree(
   const gf_path* path, const gf_path* trace_path, gf_shell_traverse_order order,
@@ -361,11 +546,155 @@ gf_shell_traverse_tree(
   return GF_SUCCESS;
 }
 
+static gf_bool
+shell_is_directory_entry(gf_ptr find_data) {
+  const WIN32_FIND_DATA* fd = (WIN32_FIND_DATA*)find_data;
+
+  return shell_has_specified_attributes(
+    fd->dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+}
+#else
+static gf_status
+shell_set_entry_type(
+  gf_shell_entry* entry, const struct dirent* ep) {
+  struct stat st;
+
+#if defined(DT_DIR)
+  /* Most file systems fill the type, which saves a stat call per entry */
+  if (ep->d_type != DT_UNKNOWN) {
+    entry->is_directory = ep->d_type == DT_DIR ? GF_TRUE : GF_FALSE;
+    return GF_SUCCESS;
+  }
+#else
+  (void)ep;
+#endif
+  if (fstatat(entry->dirfd, entry->name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    gf_raise(GF_E_SHELL, "Failed to get file status. (%s)", entry->name);
+  }
+  entry->is_directory = S_ISDIR(st.st_mode) ? GF_TRUE : GF_FALSE;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+shell_append_paths(
+  gf_path** child, gf_path** trace, const gf_path* path,
+  const gf_path* trace_path, const char* name) {
+  _(gf_path_append_string(child, path, name));
+  if (!gf_path_is_empty(trace_path)) {
+    _(gf_path_append_string(trace, trace_path, name));
+  } else {
+    _(gf_path_new(trace, name));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Traverse the opened directory
+**
+** The sub-directories are opened relative to the descriptor of the parent,
+** and the entries are classified by the type in the directory entry, so that
+** neither the path is resolved from the root nor stat is called for each
+** entry. Symbolic links are not followed.
+**
+** The paths for the callback are built only if @a path is specified;
+** otherwise the callback gets NULL paths and refers to the entry through
+** gf_shell_entry. The descriptor @a fd is closed by this function.
+*/
+
+static gf_status
+shell_traverse_at(
+  int fd, const char* name, const gf_path* path, const gf_path* trace_path,
+  gf_shell_traverse_order order, gf_shell_fn fn, gf_ptr data) {
+  gf_status rc = GF_SUCCESS;
+  DIR* dp = NULL;
+  struct dirent* ep = NULL;
+
+  dp = fdopendir(fd);
+  if (!dp) {
+    close(fd);
+    gf_raise(GF_E_SHELL, "Failed to find file. (%s)", name);
+  }
+  while (rc == GF_SUCCESS && (ep = readdir(dp)) != NULL) {
+    gf_shell_entry entry = { 0 };
+    gf_path* child = NULL;
+    gf_path* trace = NULL;
+
+    if (!strcmp(ep->d_name, ".") || !strcmp(ep->d_name, "..")) {
+      continue;
+    }
+    entry.dirfd = dirfd(dp);
+    entry.name = ep->d_name;
+    rc = shell_set_entry_type(&entry, ep);
+    if (rc == GF_SUCCESS && path) {
+      rc = shell_append_paths(&child, &trace, path, trace_path, entry.name);
+    }
+    /* Preorder processing */
+    if (rc == GF_SUCCESS && fn && order == GF_SHELL_TRAVERSE_PREORDER) {
+      rc = fn(child, trace, &entry, data);
+    }
+    /* Dig into the sub-directory */
+    if (rc == GF_SUCCESS && entry.is_directory) {
+      int sub = openat(entry.dirfd, entry.name,
+                       O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (sub < 0) {
+        gf_error("Failed to find file. (%s)", entry.name);
+        rc = GF_E_SHELL;
+      } else {
+        rc = shell_traverse_at(sub, entry.name, child, trace, order, fn, data);
+      }
+    }
+    /* Postorder processing */
+    if (rc == GF_SUCCESS && fn && order == GF_SHELL_TRAVERSE_POSTORDER) {
+      rc = fn(child, trace, &entry, data);
+    }
+    gf_path_free(trace);
+    gf_path_free(child);
+  }
+  (void)closedir(dp);
+  gf_throw(rc);
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+shell_open_directory(int* fd, const gf_path* path) {
+  const char* s = gf_path_get_string(path);
+
+  *fd = open(s, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (*fd < 0) {
+    gf_raise(GF_E_SHELL, "Failed to find file. (%s)", s);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_shell_traverse_tree(
+  const gf_path* path, const gf_path* trace_path, gf_shell_traverse_order order,
+  gf_shell_fn fn, gf_ptr data) {
+  int fd = -1;
+
+  gf_validate(!gf_path_is_empty(path));
+
+  _(shell_open_directory(&fd, path));
+  _(shell_traverse_at(
+      fd, gf_path_get_string(path), path, trace_path, order, fn, data));
+
+  return GF_SUCCESS;
+}
+
+static gf_bool
+shell_is_directory_entry(gf_ptr find_data) {
+  return ((const gf_shell_entry*)find_data)->is_directory;
+}
+#endif
+
 static gf_status
 shell_copy_callback(
   const gf_path* path, const gf_path* trace, gf_ptr find_data, gf_ptr data) {
   gf_status rc = 0;
-  const WIN32_FIND_DATA* fd = (WIN32_FIND_DATA*)find_data;
   gf_path* dst = NULL;
 
   gf_validate(!gf_path_is_empty(path));
@@ -373,13 +702,10 @@ shell_copy_callback(
   gf_validate(data);
   gf_validate(find_data);
 
-  /* alias */
-  DWORD attr = fd->dwFileAttributes;
-
   _(gf_path_append_string(&dst, (gf_path*)data, gf_path_get_string(trace)));
   assert(!gf_path_is_empty(dst));
 
-  if (shell_has_specified_attributes(attr, FILE_ATTRIBUTE_DIRECTORY)) {
+  if (shell_is_directory_entry(find_data)) {
     if (!gf_shell_file_exists(dst)) {
       rc = gf_shell_make_directory(dst);
       gf_path_free(dst);
@@ -434,22 +760,30 @@ gf_shell_copy_tree(const gf_path* dst, const gf_path* src) {
 static gf_status
 shell_remove_callback(
   const gf_path* path, const gf_path* trace, gf_ptr find_data, gf_ptr data) {
-  const WIN32_FIND_DATA* fd = (WIN32_FIND_DATA*)find_data;
-  DWORD attr = 0;
-
+#if defined(_WIN32)
   (void)data;
   (void)trace;
   
   gf_validate(!gf_path_is_empty(path));
 
-  /* alias */
-  attr = fd->dwFileAttributes;
-
-  if (shell_has_specified_attributes(attr, FILE_ATTRIBUTE_DIRECTORY)) {
+  if (shell_is_directory_entry(find_data)) {
     _(gf_shell_remove_directory(path));
   } else {
     _(gf_shell_remove_file(path));
   }
+#else
+  /* No path is built; the entry is removed relative to its directory */
+  const gf_shell_entry* entry = find_data;
+  const int flags = entry->is_directory ? AT_REMOVEDIR : 0;
+
+  (void)data;
+  (void)trace;
+  (void)path;
+
+  if (unlinkat(entry->dirfd, entry->name, flags) != 0) {
+    gf_raise(GF_E_SHELL, "Failed to remove file. (%s)", entry->name);
+  }
+#endif
   
   return GF_SUCCESS;
 }
@@ -461,8 +795,17 @@ gf_shell_remove_tree(const gf_path* path) {
   gf_validate(!gf_path_is_empty(path));
 
   if (gf_shell_is_directory(path)) {
+#if defined(_WIN32)
     rc = gf_shell_traverse_tree(
       path, NULL, GF_SHELL_TRAVERSE_POSTORDER, shell_remove_callback, NULL);
+#else
+    int fd = -1;
+
+    _(shell_open_directory(&fd, path));
+    rc = shell_traverse_at(
+      fd, gf_path_get_string(path), NULL, NULL,
+      GF_SHELL_TRAVERSE_POSTORDER, shell_remove_callback, NULL);
+#endif
     if (rc != GF_SUCCESS) {
       gf_throw(rc);
     }
@@ -482,12 +825,16 @@ gf_shell_remove_tree(const gf_path* path) {
 
 gf_status
 gf_shell_change_directory(const gf_path* path) {
-  BOOL ret = FALSE;
+  gf_bool ret = GF_FALSE;
   const char* s = NULL;
   
   gf_validate(!gf_path_is_empty(path));
   s = gf_path_get_string(path);
-  ret = SetCurrentDirectory(s);
+#if defined(_WIN32)
+  ret = SetCurrentDirectory(s) ? GF_TRUE : GF_FALSE;
+#else
+  ret = chdir(s) == 0 ? GF_TRUE : GF_FALSE;
+#endif
   if (!ret) {
     gf_raise(GF_E_SHELL, "Failed to change directory. (%s)", s);
   }
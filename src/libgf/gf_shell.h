@@ -141,6 +141,21 @@ extern gf_status gf_shell_rename(const gf_path* dst, const gf_path* src);
 
 extern gf_status gf_shell_move(const gf_path* dst, const gf_path* src);
 
+/*!
+** @brief Replace a file with another file.
+**
+** Unlike gf_shell_rename(), the destination file is overwritten if it
+** exists. The file is replaced atomically where the platform supports it, so
+** a reader sees either the old or the new file.
+**
+** @param dst [in] The path to the file to be replaced
+** @param src [in] The path to the new file, which is moved to @a dst
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise
+*/
+
+extern gf_status gf_shell_replace(const gf_path* dst, const gf_path* src);
+
 /*!
 t** @brief Function pointer type for shell operations
 **
@@ -153,6 +168,21 @@ t** @brief Function pointer type for shell operations
 typedef gf_status (*gf_shell_fn)(
   const gf_path* path, const gf_path* trace, gf_ptr find_data, gf_ptr data);
 
+#if !defined(_WIN32)
+/*!
+** @brief The directory entry passed to gf_shell_fn as find_data
+**
+** On Windows, find_data points to WIN32_FIND_DATA. On the other systems, it
+** points to this structure, which is valid only during the callback.
+*/
+
+typedef struct gf_shell_entry {
+  int            dirfd;         ///< The directory which contains the entry
+  const gf_char* name;          ///< The file name of the entry
+  gf_bool        is_directory;  ///< GF_TRUE if the entry is a directory
+} gf_shell_entry;
+#endif
+
 /*!
 ** @brief The order of evaluation in traversing directory tree.
 */
@@ -9,30 +9,36 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
 
+#include <libgf/gf_countof.h>
 #include <libgf/gf_memory.h>
 #include <libgf/gf_array.h>
+#include <libgf/gf_map.h>
 #include <libgf/gf_path.h>
 #include <libgf/gf_hash.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_shell.h>
 #include <libgf/gf_file_info.h>
+#include <libgf/gf_db.h>
 #include <libgf/gf_site.h>
 
 #include "gf_local.h"
-
-/* -------------------------------------------------------------------------- */
+#include "gf_site_local.h"
 
 /*!
-** @brief A subject of entries
-**
+** @brief The size of the buffer for the key made by site_make_content_key()
 */
 
-struct gf_category {
-  gf_string* id;    ///< String usable for a URL or an identifier etc.
-  gf_string* name;  ///< Printable name
-};
+#define SITE_CONTENT_KEY_SIZE (GF_HASH_BUFSIZE_MAX * 2 + 64)
+
+/* -------------------------------------------------------------------------- */
 
 static gf_status
 category_init(gf_category* cat) {
@@ -40,6 +46,7 @@ category_init(gf_category* cat) {
 
   cat->id = NULL;
   cat->name = NULL;
+  cat->entries = NULL;
 
   return GF_SUCCESS;
 }
@@ -50,6 +57,7 @@ category_prepare(gf_category* cat) {
 
   _(gf_string_new(&cat->id));
   _(gf_string_new(&cat->name));
+  _(gf_array_new(&cat->entries));
   
   return GF_SUCCESS;
 }
@@ -86,6 +94,9 @@ gf_category_free(gf_category* cat) {
     if (cat->name) {
       gf_string_free(cat->name);
     }
+    if (cat->entries) {
+      gf_array_free(cat->entries);
+    }
     (void)category_init(cat);
     gf_free(cat);
   }
@@ -118,36 +129,186 @@ gf_category_set_name(gf_category* cat, const gf_string* name) {
   return GF_SUCCESS;
 }
 
+const gf_char*
+gf_category_get_id_string(const gf_category* cat) {
+  return cat ? gf_string_get(cat->id) : NULL;
+}
+
+const gf_char*
+gf_category_get_name_string(const gf_category* cat) {
+  return cat ? gf_string_get(cat->name) : NULL;
+}
+
+gf_size_t
+gf_category_count_entries(const gf_category* cat) {
+  return cat && cat->entries ? gf_array_size(cat->entries) : 0;
+}
+
+gf_status
+gf_category_get_entry(
+  const gf_category* cat, gf_size_t index, gf_entry** entry) {
+  gf_any any = { 0 };
+
+  gf_validate(cat);
+  gf_validate(entry);
+
+  _(gf_array_get(cat->entries, index, &any));
+  *entry = (gf_entry*)(any.ptr);
+
+  return GF_SUCCESS;
+}
+
 /* -------------------------------------------------------------------------- */
 
+void
+site_taxonomy_free(site_taxonomy* taxonomy) {
+  if (taxonomy) {
+    for (gf_size_t i = 0; i < 2; i++) {
+      if (taxonomy->categories[i]) {
+        gf_array_free(taxonomy->categories[i]);
+      }
+      if (taxonomy->index[i]) {
+        gf_map_free(taxonomy->index[i]);
+      }
+    }
+    gf_mutex_destroy(&taxonomy->lock);
+    gf_free(taxonomy);
+  }
+}
+
+gf_status
+site_taxonomy_new(site_taxonomy** taxonomy) {
+  gf_status rc = 0;
+  site_taxonomy* tmp = NULL;
+
+  gf_validate(taxonomy);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  for (gf_size_t i = 0; i < 2; i++) {
+    tmp->categories[i] = NULL;
+    tmp->index[i] = NULL;
+  }
+  rc = gf_mutex_init(&tmp->lock);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  for (gf_size_t i = 0; rc == GF_SUCCESS && i < 2; i++) {
+    rc = gf_array_new(&tmp->categories[i]);
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_set_free_fn(tmp->categories[i], category_free);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = gf_map_new(&tmp->index[i]);
+    }
+  }
+  if (rc != GF_SUCCESS) {
+    site_taxonomy_free(tmp);
+    gf_throw(rc);
+  }
+  *taxonomy = tmp;
+
+  return GF_SUCCESS;
+}
+
 /*!
-** @brief Site entry object.
+** @brief Remove all the categories.
 **
-** An entry is a resource of the website, which is determined to be processed by
-** the Grayfish convertion processor. Not the all source files in the website
-** are regarded as entry objects. Only the following files are processed as
-** site entries.
+** The entries referring to the categories must be removed beforehand.
+*/
+
+static gf_status
+site_taxonomy_clear(site_taxonomy* taxonomy) {
+  gf_validate(taxonomy);
+
+  for (gf_size_t i = 0; i < 2; i++) {
+    _(gf_map_clear(taxonomy->index[i]));
+    _(gf_array_clear(taxonomy->categories[i]));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Find or add the category of the ID, and get its index.
 **
-**   - First, the directory including meta.gf file is treated as a section entry
-**   - Second, the index.dbk is regarded as a main document entry.
-*/
-
-struct gf_entry {
-  gf_entry_type  type;        ///< Type of a entry
-  gf_entry_state state;       ///< State of a entry
-  gf_string*     title;       ///< Entry title retrieved from an entry file
-  gf_string*     author;      ///< Name of an author read from an entry file
-  gf_datetime    date;        ///< Published date read from an entry file
-  gf_array*      description; ///< A description composed with paragraph strings
-  gf_file_info*  file_info;   ///< The info file. (meta.gf, index.dbk ...)
-  gf_string*     method;      ///< The process type linked to the XSLT file name
-  gf_site*       site;        ///< The site object which includes this object
-  gf_path*       output_path; ///< The output path 
-  gf_array*      subject_set; ///< Array of gf_category objects
-  gf_array*      keyword_set; ///< Array of gf_category objects
-  gf_array*      file_set;    ///< Array of gf_file_info objects
-  gf_array*      children;    ///< Entry children
-};
+** The name of the category is the one added first.
+*/
+
+static gf_status
+site_taxonomy_add(
+  site_taxonomy* taxonomy, gf_category_kind kind, const gf_char* id,
+  const gf_char* name, gf_32u* index) {
+  gf_status rc = GF_SUCCESS;
+  gf_any any = { 0 };
+  gf_category* cat = NULL;
+
+  gf_validate(taxonomy);
+  gf_validate(kind == GF_CATEGORY_SUBJECT || kind == GF_CATEGORY_KEYWORD);
+  gf_validate(!gf_strnull(id));
+  gf_validate(!gf_strnull(name));
+  gf_validate(index);
+
+  gf_mutex_lock(&taxonomy->lock);
+  if (gf_map_find(taxonomy->index[kind], id, &any)) {
+    *index = any.u32;
+  } else {
+    *index = (gf_32u)gf_array_size(taxonomy->categories[kind]);
+    rc = gf_category_new(&cat);
+    if (rc == GF_SUCCESS) {
+      rc = gf_string_set(cat->id, id);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = gf_string_set(cat->name, name);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_add(taxonomy->categories[kind], (gf_any){ .ptr = cat });
+    }
+    if (rc != GF_SUCCESS) {
+      gf_category_free(cat);
+    } else {
+      /* On failure, the category is left unused in the table */
+      rc = gf_map_set(taxonomy->index[kind], id, (gf_any){ .u32 = *index });
+    }
+  }
+  gf_mutex_unlock(&taxonomy->lock);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the category of the index.
+**
+** A category is not modified once it is added, so the returned object can be
+** read without the lock.
+*/
+
+static gf_status
+site_taxonomy_get(
+  site_taxonomy* taxonomy, gf_category_kind kind, gf_32u index,
+  gf_category** cat) {
+  gf_status rc = 0;
+  gf_any any = { 0 };
+
+  gf_validate(taxonomy);
+  gf_validate(kind == GF_CATEGORY_SUBJECT || kind == GF_CATEGORY_KEYWORD);
+  gf_validate(cat);
+
+  gf_mutex_lock(&taxonomy->lock);
+  rc = gf_array_get(taxonomy->categories[kind], index, &any);
+  gf_mutex_unlock(&taxonomy->lock);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  *cat = any.ptr;
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
 
 static void entry_free(gf_any* any);
 
@@ -165,10 +326,16 @@ entry_init(gf_entry* entry) {
   entry->method      = NULL;
   entry->site        = NULL;
   entry->output_path = NULL;
+  entry->taxonomy    = NULL;
   entry->subject_set = NULL;
   entry->keyword_set = NULL;
   entry->file_set    = NULL;
   entry->children    = NULL;
+  entry->db          = NULL;
+  entry->db_index    = 0;
+  entry->pending     = 0;
+  entry->overlay     = NULL;
+  entry->seq         = 0;
   
   return GF_SUCCESS;
 }
@@ -184,10 +351,9 @@ entry_prepare(gf_entry* entry) {
   _(gf_string_new(&entry->method));
   _(gf_path_new(&entry->output_path, ""));
   _(gf_array_new(&entry->subject_set));
-  _(gf_array_set_free_fn(entry->subject_set, category_free));
   _(gf_array_new(&entry->keyword_set));
-  _(gf_array_set_free_fn(entry->keyword_set, category_free));
-  _(gf_array_new(&entry->file_set)); // this array doesn't free element objects
+  _(gf_array_new(&entry->file_set));
+  _(gf_array_set_free_fn(entry->file_set, gf_file_info_free_any));
   _(gf_array_new(&entry->children));
   _(gf_array_set_free_fn(entry->children, entry_free));
 
@@ -230,6 +396,9 @@ gf_entry_free(gf_entry* entry) {
     if (entry->author) {
       gf_string_free(entry->author);
     }
+    if (entry->description) {
+      gf_array_free(entry->description);
+    }
     if (entry->method) {
       gf_string_free(entry->method);
     }
@@ -367,6 +536,14 @@ gf_entry_get_local_path(const gf_entry* entry, const gf_path* root) {
 }
 
 
+const gf_char*
+gf_entry_get_method_string(const gf_entry* entry) {
+  if (!entry || !entry->method) {
+    return NULL;
+  }
+  return gf_string_get(entry->method);
+}
+
 gf_bool
 gf_entry_is_section(const gf_entry* entry) {
   return entry && entry->type == GF_ENTRY_TYPE_SECTION ? GF_TRUE : GF_FALSE;
@@ -377,9 +554,64 @@ gf_entry_is_document(const gf_entry* entry) {
   return entry && entry->type == GF_ENTRY_TYPE_DOCUMENT ? GF_TRUE : GF_FALSE;
 }
 
+gf_entry_type
+gf_entry_get_type(const gf_entry* entry) {
+  return entry ? entry->type : GF_ENTRY_TYPE_UNKNOWN;
+}
+
+gf_entry_state
+gf_entry_get_state(const gf_entry* entry) {
+  return entry ? entry->state : GF_ENTRY_STATE_UNKNOWN;
+}
+
+const gf_char*
+gf_entry_get_title_string(const gf_entry* entry) {
+  if (!entry || !entry->title) {
+    return NULL;
+  }
+  return gf_string_get(entry->title);
+}
+
+/*!
+** @brief Count the items of a list of an entry.
+**
+** A pending list is counted in the database without being read.
+*/
+
+static gf_size_t
+entry_count_items(const gf_entry* entry, gf_32u part, const gf_array* list) {
+  const gf_db_entry* rec = NULL;
+
+  if (!entry) {
+    return 0;
+  }
+  if (!(entry->pending & part)) {
+    return list ? gf_array_size(list) : 0;
+  }
+  if (part == ENTRY_PENDING_CHILDREN && entry->overlay) {
+    return site_journal_overlay_count_children(entry);
+  }
+  rec = gf_db_get_entry(entry->db, entry->db_index);
+  if (!rec) {
+    return 0;
+  }
+  switch (part) {
+  case ENTRY_PENDING_CHILDREN:
+    return rec->children.count;
+  case ENTRY_PENDING_FILE_SET:
+    return rec->file_set.count;
+  case ENTRY_PENDING_DESCRIPTION:
+    return rec->description.count;
+  default:
+    assert(0);
+    return 0;
+  }
+}
+
 gf_size_t
 gf_entry_count_children(const gf_entry* entry) {
-  return entry && entry->children ? gf_array_size(entry->children) : 0;
+  return entry_count_items(
+    entry, ENTRY_PENDING_CHILDREN, entry ? entry->children : NULL);
 }
 
 gf_status
@@ -389,40 +621,156 @@ gf_entry_get_child(gf_entry* entry, gf_size_t index, gf_entry** child) {
   gf_validate(entry);
   gf_validate(child);
 
+  _(entry_load(entry, ENTRY_PENDING_CHILDREN));
   _(gf_array_get(entry->children, index, &any));
   *child = (gf_entry*)(any.ptr);
   
   return GF_SUCCESS;
 }
 
+gf_size_t
+gf_entry_count_files(const gf_entry* entry) {
+  return entry_count_items(
+    entry, ENTRY_PENDING_FILE_SET, entry ? entry->file_set : NULL);
+}
+
+gf_status
+gf_entry_get_file(gf_entry* entry, gf_size_t index, gf_file_info** info) {
+  gf_any any = { 0 };
+
+  gf_validate(entry);
+  gf_validate(info);
+
+  _(entry_load(entry, ENTRY_PENDING_FILE_SET));
+  _(gf_array_get(entry->file_set, index, &any));
+  *info = (gf_file_info*)(any.ptr);
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_entry_count_paragraphs(const gf_entry* entry) {
+  return entry_count_items(
+    entry, ENTRY_PENDING_DESCRIPTION, entry ? entry->description : NULL);
+}
+
+gf_status
+gf_entry_get_paragraph_string(
+  gf_entry* entry, gf_size_t index, const gf_char** str) {
+  gf_any any = { 0 };
+
+  gf_validate(entry);
+  gf_validate(str);
+
+  _(entry_load(entry, ENTRY_PENDING_DESCRIPTION));
+  _(gf_array_get(entry->description, index, &any));
+  *str = gf_string_get((gf_string*)any.ptr);
+
+  return GF_SUCCESS;
+}
+
 /* -------------------------------------------------------------------------- */
 
+/*!
+** @brief Open a reader of the entry file.
+**
+** The entry file is read by the streaming reader, so that only the leading
+** information is read from long documents. If @a reader already has a reader,
+** it is reused for the file.
+*/
+
 static gf_status
-entry_read_xml_file(xmlDocPtr* doc, const gf_path* root, gf_entry* entry) {
+entry_open_reader(
+  xmlTextReaderPtr* reader, const gf_path* root, gf_entry* entry) {
   gf_path* path = NULL;
-  xmlDocPtr tmp = NULL;
-  
+  xmlTextReaderPtr tmp = NULL;
+  int ret = 0;
+
 #ifdef GF_DEBUG_
-  static const int option = 0;
+  /* The errors are reported, but the blank nodes are dropped as usual */
+  static const int option = XML_PARSE_NOBLANKS;
 #else
-  static const int option = GF_XML_PARSE_OPTIONS;
+  static const int option = GF_XML_READ_INFO_OPTIONS;
 #endif
-  
-  gf_validate(doc);
+
+  gf_validate(reader);
   gf_validate(entry);
 
   path = gf_entry_get_local_path(entry, root);
   if (!path) {
     gf_raise(GF_E_PATH, "Failed to create local path");
   }
-  tmp = xmlReadFile(gf_path_get_string(path), NULL, option);
+  if (*reader) {
+    ret = xmlReaderNewFile(*reader, gf_path_get_string(path), NULL, option);
+    gf_path_free(path);
+    if (ret != 0) {
+      gf_raise(GF_E_API, "Failed to read an XML file.");
+    }
+    return GF_SUCCESS;
+  }
+  tmp = xmlReaderForFile(gf_path_get_string(path), NULL, option);
   gf_path_free(path);
   if (!tmp) {
     gf_raise(GF_E_API, "Failed to read an XML file.");
   }
 
-  *doc = tmp;
-  
+  *reader = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Move the reader to the next element of the depth.
+**
+** The nodes other than elements are skipped.
+**
+** @param [in, out] reader The reader
+** @param [in]      depth  The depth of the element (0: the root element)
+*/
+
+gf_status
+entry_move_to_element(xmlTextReaderPtr reader, int depth) {
+  int ret = 0;
+
+  gf_validate(reader);
+
+  while ((ret = xmlTextReaderRead(reader)) == 1) {
+    int type = xmlTextReaderNodeType(reader);
+
+    if (xmlTextReaderDepth(reader) < depth) {
+      /* The parent is closed */
+      break;
+    }
+    if (type == XML_READER_TYPE_ELEMENT &&
+        xmlTextReaderDepth(reader) == depth) {
+      return GF_SUCCESS;
+    }
+  }
+  if (ret < 0) {
+    gf_raise(GF_E_API, "Failed to read an XML file.");
+  }
+  gf_raise(GF_E_DATA, "Invalid XML document.");
+}
+
+/*!
+** @brief Read the element under the reader into a node tree.
+**
+** The node is owned by the reader and valid until the reader moves.
+*/
+
+static gf_status
+entry_expand_element(xmlTextReaderPtr reader, xmlNodePtr* node) {
+  xmlNodePtr tmp = NULL;
+
+  gf_validate(reader);
+  gf_validate(node);
+
+  tmp = xmlTextReaderExpand(reader);
+  if (!tmp) {
+    gf_raise(GF_E_API, "Failed to read an XML file.");
+  }
+  *node = tmp;
+
   return GF_SUCCESS;
 }
 
@@ -507,276 +855,381 @@ entry_set_description(gf_entry* entry, xmlNodePtr node) {
   return GF_SUCCESS;
 }
 
-static gf_status
-entry_set_subject_set(gf_entry* entry, xmlNodePtr node) {
-  gf_status rc = 0;
-  xmlNodePtr subject_node = NULL;
-  
-  gf_validate(entry);
-  gf_validate(node);
-
-  // NOTE: We process the first child of the subject_set node.
-  subject_node = node->children;
-  if (subject_node->type != XML_ELEMENT_NODE) {
-    gf_raise(GF_E_DATA, "Invalid XML data.");
-  }
-  if (!!xmlStrcmp(subject_node->name, BAD_CAST"subject")) {
-    gf_raise(GF_E_DATA, "Invalid XML data.");
-  }
-  for (xmlNodePtr cur = subject_node->children; cur; cur = cur->next) {
-    if (cur->type == XML_ELEMENT_NODE) {
-      if (!xmlStrcmp(cur->name, BAD_CAST"subjectterm")) {
-        gf_string* s = NULL;
-        gf_category* cat = NULL;
-        xmlChar* id = NULL;
-
-        id = xmlGetProp(cur, BAD_CAST"id");
-        if (!id) {
-          gf_raise(GF_E_DATA, "Invalid XML data.");
-        }
-        if (!xmlNodeIsText(cur->children)) {
-          gf_raise(GF_E_DATA, "Invalid XML data.");
-        }
-        _(gf_category_new(&cat));
-
-        rc = gf_string_new(&s);
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_string_set(s, (const char*)id);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_category_set_id(cat, s);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_string_set(s, (const char*)cur->children->content);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_category_set_name(cat, s);
-        gf_string_free(s);
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_array_add(entry->subject_set, (gf_any){ .ptr = cat });
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-      }
-    }
-  }
-  
-  return GF_SUCCESS;
-}
+/*!
+** @brief Create an entry whose categories are stored in the taxonomy.
+*/
 
-static gf_status
-entry_set_keyword_set(gf_entry* entry, xmlNodePtr node) {
-  gf_status rc = 0;
-  
+gf_status
+entry_new(gf_entry** entry, site_taxonomy* taxonomy) {
   gf_validate(entry);
-  gf_validate(node);
+  gf_validate(taxonomy);
+
+  _(gf_entry_new(entry));
+  (*entry)->taxonomy = taxonomy;
 
-  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-    if (cur->type == XML_ELEMENT_NODE) {
-      if (!xmlStrcmp(cur->name, BAD_CAST"keyword")) {
-        gf_string* s = NULL;
-        gf_category* cat = NULL;
-        xmlChar* id = NULL;
-
-        id = xmlGetProp(cur, BAD_CAST"id");
-        if (!id) {
-          gf_raise(GF_E_DATA, "Invalid XML data.");
-        }
-        if (!xmlNodeIsText(cur->children)) {
-          gf_raise(GF_E_DATA, "Invalid XML data.");
-        }
-        _(gf_category_new(&cat));
-
-        rc = gf_string_new(&s);
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_string_set(s, (const char*)id);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_category_set_id(cat, s);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_string_set(s, (const char*)cur->children->content);
-        if (rc != GF_SUCCESS) {
-          gf_string_free(s);
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_category_set_name(cat, s);
-        gf_string_free(s);
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-        rc = gf_array_add(entry->keyword_set, (gf_any){ .ptr = cat });
-        if (rc != GF_SUCCESS) {
-          gf_category_free(cat);
-          gf_throw(rc);
-        }
-      }
-    }
-  }
-  
   return GF_SUCCESS;
 }
 
-static gf_status
-entry_set_document_info(gf_entry* entry, const gf_path* root_path) {
-  gf_status rc = 0;
-  xmlDocPtr doc = NULL;
-  xmlNodePtr root = NULL;
-  xmlChar* prop = NULL;
+gf_array*
+entry_get_category_set(const gf_entry* entry, gf_category_kind kind) {
+  return kind == GF_CATEGORY_SUBJECT ? entry->subject_set : entry->keyword_set;
+}
+
+/*!
+** @brief Add a category to the subject set or the keyword set.
+**
+** The category is interned in the taxonomy of the entry, and the entry holds
+** only its index.
+*/
+
+gf_status
+entry_add_category(
+  gf_entry* entry, gf_category_kind kind, const gf_char* id,
+  const gf_char* name) {
+  gf_array* set = NULL;
+  gf_32u index = 0;
 
   gf_validate(entry);
+  gf_validate(entry->taxonomy);
 
-  _(entry_read_xml_file(&doc, root_path, entry));
-  assert(doc);
+  set = entry_get_category_set(entry, kind);
+  _(site_taxonomy_add(entry->taxonomy, kind, id, name, &index));
+  _(gf_array_add(set, (gf_any){ .u32 = index }));
 
-  root = xmlDocGetRootElement(doc);
-  if (!root) {
-    xmlFreeDoc(doc);
-    gf_raise(GF_E_DATA, "Invalid XML document.");
+  return GF_SUCCESS;
+}
+
+gf_status
+entry_get_category(
+  const gf_entry* entry, gf_category_kind kind, gf_size_t index,
+  gf_category** cat) {
+  gf_any any = { 0 };
+
+  gf_validate(entry);
+  gf_validate(entry->taxonomy);
+
+  _(gf_array_get(entry_get_category_set(entry, kind), index, &any));
+  _(site_taxonomy_get(entry->taxonomy, kind, any.u32, cat));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the category of an element such as <keyword id="...">Name</...>.
+*/
+
+static gf_status
+entry_set_category(gf_entry* entry, gf_category_kind kind, xmlNodePtr node) {
+  gf_status rc = 0;
+  xmlChar* id = NULL;
+
+  id = xmlGetProp(node, BAD_CAST"id");
+  if (!id) {
+    gf_raise(GF_E_DATA, "Invalid XML data.");
+  }
+  if (!xmlNodeIsText(node->children)) {
+    xmlFree(id);
+    gf_raise(GF_E_DATA, "Invalid XML data.");
+  }
+  rc = entry_add_category(
+    entry, kind, (const gf_char*)id, (const gf_char*)node->children->content);
+  xmlFree(id);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_set_subject_set(gf_entry* entry, xmlNodePtr node) {
+  xmlNodePtr subject_node = NULL;
+  
+  gf_validate(entry);
+  gf_validate(node);
+
+  // NOTE: We process the first child of the subject_set node.
+  subject_node = node->children;
+  if (subject_node->type != XML_ELEMENT_NODE) {
+    gf_raise(GF_E_DATA, "Invalid XML data.");
+  }
+  if (!!xmlStrcmp(subject_node->name, BAD_CAST"subject")) {
+    gf_raise(GF_E_DATA, "Invalid XML data.");
+  }
+  for (xmlNodePtr cur = subject_node->children; cur; cur = cur->next) {
+    if (cur->type == XML_ELEMENT_NODE) {
+      if (!xmlStrcmp(cur->name, BAD_CAST"subjectterm")) {
+        _(entry_set_category(entry, GF_CATEGORY_SUBJECT, cur));
+      }
+    }
+  }
+  
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_set_keyword_set(gf_entry* entry, xmlNodePtr node) {
+  gf_validate(entry);
+  gf_validate(node);
+
+  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
+    if (cur->type == XML_ELEMENT_NODE) {
+      if (!xmlStrcmp(cur->name, BAD_CAST"keyword")) {
+        _(entry_set_category(entry, GF_CATEGORY_KEYWORD, cur));
+      }
+    }
   }
+  
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_read_document_info(gf_entry* entry, xmlTextReaderPtr reader) {
+  gf_status rc = 0;
+  xmlNodePtr info = NULL;
+  xmlChar* prop = NULL;
+
+  gf_validate(entry);
+  gf_validate(reader);
+
+  /* The root element */
+  _(entry_move_to_element(reader, 0));
   /* gf_entry::type */
   entry->type = GF_ENTRY_TYPE_DOCUMENT;
   /* gf_entry::state */
   entry->state = GF_ENTRY_STATE_PUBLISHED; // By now, draft mode is unavailable.
   /* gf_entry::method */
-  prop = xmlGetProp(root, BAD_CAST"role");
+  prop = xmlTextReaderGetAttribute(reader, BAD_CAST"role");
   if (prop) {
     rc = gf_string_set(entry->method, (const char*)prop);
+    xmlFree(prop);
     if (rc != GF_SUCCESS) {
-      xmlFreeDoc(doc);
       gf_throw(rc);
     }
   } else {
-    rc = gf_string_set(entry->method, (const char*)root->name);
-    if (rc != GF_SUCCESS) {
-      xmlFreeDoc(doc);
-      gf_throw(rc);
-    }
+    _(gf_string_set(
+        entry->method, (const char*)xmlTextReaderConstLocalName(reader)));
   }
-  /* "info" elements */
-  root = root->children;
-  if (!root || !!xmlStrcmp(root->name, BAD_CAST"info")) {
-    xmlFreeDoc(doc);
+  /* "info" element, which must be the first child. The rest is not read. */
+  _(entry_move_to_element(reader, 1));
+  if (!!xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST"info")) {
     gf_raise(GF_E_DATA, "Invalid XML document.");
   }
-  for (xmlNodePtr cur = root->children; cur; cur = cur->next) {
+  _(entry_expand_element(reader, &info));
+  for (xmlNodePtr cur = info->children; cur; cur = cur->next) {
     if (!xmlStrcmp(cur->name, BAD_CAST"title")) {
-      rc = entry_set_title(entry, cur);
+      _(entry_set_title(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"author")) {
-      rc = entry_set_author(entry, cur);
+      _(entry_set_author(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"pubdate")) {
-      rc = entry_set_date(entry, cur);
+      _(entry_set_date(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"description")) {
-      rc = entry_set_description(entry, cur);
+      _(entry_set_description(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"subjectset")) {
-      rc = entry_set_subject_set(entry, cur);
+      _(entry_set_subject_set(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"keywordset")) {
-      rc = entry_set_keyword_set(entry, cur);
+      _(entry_set_keyword_set(entry, cur));
     } else {
       /* do nothing */
     }
-    if (rc != GF_SUCCESS) {
-      xmlFreeDoc(doc);
-      gf_throw(rc);
-    }
   }
-  
-  xmlFreeDoc(doc);
-  
+
   return GF_SUCCESS;
 }
 
 /* -------------------------------------------------------------------------- */
 
 static gf_status
-entry_set_meta_info(gf_entry* entry, const gf_path* root_path) {
-  gf_status rc = 0;
-  xmlDocPtr doc = NULL;
-  xmlNodePtr root = NULL;
-  
-  gf_validate(entry);
+entry_read_meta_info(gf_entry* entry, xmlTextReaderPtr reader) {
+  xmlNodePtr meta = NULL;
 
-  _(entry_read_xml_file(&doc, root_path, entry));
-  assert(doc);
+  gf_validate(entry);
+  gf_validate(reader);
 
   /* "meta" element */
-  root = xmlDocGetRootElement(doc);
-  if (!root) {
-    xmlFreeDoc(doc);
-    gf_raise(GF_E_DATA, "Invalid XML document.");
-  }
+  _(entry_move_to_element(reader, 0));
   /* gf_entry::type */
   entry->type = GF_ENTRY_TYPE_SECTION;
   /* gf_entry::method */
-  rc = gf_string_set(entry->method, "index");
-  if (rc != GF_SUCCESS) {
-    xmlFreeDoc(doc);
-    gf_throw(rc);
-  }
+  _(gf_string_set(entry->method, "index"));
   /* children of meta element */
-  for (xmlNodePtr cur = root->children; cur; cur = cur->next) {
+  _(entry_expand_element(reader, &meta));
+  for (xmlNodePtr cur = meta->children; cur; cur = cur->next) {
     if (!xmlStrcmp(cur->name, BAD_CAST"title")) {
-      rc = entry_set_title(entry, cur);
+      _(entry_set_title(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"author")) {
-      rc = entry_set_author(entry, cur);
+      _(entry_set_author(entry, cur));
     } else if (!xmlStrcmp(cur->name, BAD_CAST"description")) {
-      rc = entry_set_description(entry, cur);
+      _(entry_set_description(entry, cur));
     } else {
       /* do nothing */
     }
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Read the information of the entry file.
+**
+** The entry file is read as a document (index.dbk) or a meta file (meta.gf)
+** according to the type of the entry.
+**
+** @param [in, out] entry     The entry
+** @param [in]      root_path The root directory of the site
+** @param [in, out] reader    The reader to be reused. A new reader is created
+**                            if it is NULL. The caller frees it.
+*/
+
+static gf_status
+entry_read_info(
+  gf_entry* entry, const gf_path* root_path, xmlTextReaderPtr* reader) {
+  gf_validate(entry);
+  gf_validate(reader);
+
+  _(entry_open_reader(reader, root_path, entry));
+  if (gf_entry_is_document(entry)) {
+    _(entry_read_document_info(entry, *reader));
+  } else {
+    _(entry_read_meta_info(entry, *reader));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_set_info(gf_entry* entry, const gf_path* root_path) {
+  gf_status rc = 0;
+  xmlTextReaderPtr reader = NULL;
+
+  gf_validate(entry);
+
+  rc = entry_read_info(entry, root_path, &reader);
+  if (reader) {
+    xmlFreeTextReader(reader);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Clear the information read from the entry file.
+**
+** This is called before the entry file is read again, because the readers
+** append the strings and the categories to the entry.
+*/
+
+gf_status
+entry_reset_info(gf_entry* entry) {
+  gf_validate(entry);
+
+  _(gf_string_set(entry->title, ""));
+  _(gf_string_set(entry->author, ""));
+  entry->date = 0;
+  _(gf_array_clear(entry->description));
+  _(gf_array_clear(entry->subject_set));
+  _(gf_array_clear(entry->keyword_set));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+entry_copy_description(gf_array* dst, const gf_array* src) {
+  gf_status rc = 0;
+
+  for (gf_size_t i = 0; i < gf_array_size(src); i++) {
+    gf_any any = { 0 };
+    gf_string* str = NULL;
+
+    _(gf_array_get(src, i, &any));
+    _(gf_string_new(&str));
+    rc = gf_string_copy(str, (const gf_string*)any.ptr);
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_add(dst, (gf_any){ .ptr = str });
+    }
     if (rc != GF_SUCCESS) {
-      xmlFreeDoc(doc);
+      gf_string_free(str);
       gf_throw(rc);
     }
   }
-  
+
   return GF_SUCCESS;
 }
 
-/* -------------------------------------------------------------------------- */
+static gf_status
+entry_copy_category_set(
+  gf_entry* dst, const gf_entry* src, gf_category_kind kind) {
+  const gf_array* set = NULL;
+
+  set = entry_get_category_set(src, kind);
+  if (dst->taxonomy == src->taxonomy) {
+    for (gf_size_t i = 0; i < gf_array_size(set); i++) {
+      gf_any any = { 0 };
+
+      _(gf_array_get(set, i, &any));
+      _(gf_array_add(entry_get_category_set(dst, kind), any));
+    }
+    return GF_SUCCESS;
+  }
+  /* Between a site and a cache */
+  for (gf_size_t i = 0; i < gf_array_size(set); i++) {
+    gf_category* cat = NULL;
+
+    _(entry_get_category(src, kind, i, &cat));
+    _(entry_add_category(
+        dst, kind, gf_string_get(cat->id), gf_string_get(cat->name)));
+  }
+
+  return GF_SUCCESS;
+}
 
 /*!
-** @defgroup SiteStruct The website information and operations.
+** @brief Copy the information read from the entry file.
+**
+** The file information, the file set and the children are not copied.
 */
-/* @{ */
+
+gf_status
+entry_copy_info(gf_entry* dst, const gf_entry* src) {
+  gf_validate(dst);
+  gf_validate(src);
+
+  _(entry_reset_info(dst));
+  dst->type  = src->type;
+  dst->state = src->state;
+  dst->date  = src->date;
+  _(gf_string_copy(dst->title, src->title));
+  _(gf_string_copy(dst->author, src->author));
+  _(gf_string_copy(dst->method, src->method));
+  _(entry_copy_description(dst->description, src->description));
+  _(entry_copy_category_set(dst, src, GF_CATEGORY_SUBJECT));
+  _(entry_copy_category_set(dst, src, GF_CATEGORY_KEYWORD));
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
 
 /*!
-** @brief The website structure.
-**
-** This structure represents whole your website information. By this, you can
-** update or build the website.
+** @defgroup SiteStruct The website information and operations.
 */
+/* @{ */
 
-struct gf_site {
-  gf_array*     entry_set;  ///< Entries to process
-};
+void
+site_db_state_clear(site_db_state* state) {
+  if (state->entries) {
+    gf_map_free(state->entries);
+  }
+  if (state->children) {
+    gf_map_free(state->children);
+  }
+  *state = (site_db_state){ 0 };
+}
 
 /*!
 ** @brief Initialize a gf_site object.
@@ -791,6 +1244,14 @@ site_init(gf_site* site) {
   gf_validate(site);
 
   site->entry_set = NULL;
+  site->tree      = NULL;
+  site->taxonomy  = NULL;
+  site->db        = NULL;
+  site->overlay   = NULL;
+  site->by_date   = NULL;
+  site->methods   = NULL;
+  site->saved     = (site_db_state){ 0 };
+  site->scan_time = 0;
   
   return GF_SUCCESS;
 }
@@ -799,6 +1260,10 @@ static gf_status
 site_prepare(gf_site* site) {
   _(gf_array_new(&site->entry_set));
   _(gf_array_set_free_fn(site->entry_set, entry_free));
+  _(site_taxonomy_new(&site->taxonomy));
+  _(gf_array_new(&site->by_date));
+  _(gf_array_new(&site->methods));
+  _(gf_array_set_free_fn(site->methods, category_free));
   return GF_SUCCESS;
 }
 
@@ -828,6 +1293,16 @@ void
 gf_site_free(gf_site* site) {
   if (site) {
     (void)gf_site_reset(site);
+    if (site->entry_set) {
+      gf_array_free(site->entry_set);
+    }
+    site_taxonomy_free(site->taxonomy);
+    if (site->by_date) {
+      gf_array_free(site->by_date);
+    }
+    if (site->methods) {
+      gf_array_free(site->methods);
+    }
     gf_free(site);
   }
 }
@@ -836,9 +1311,33 @@ gf_status
 gf_site_reset(gf_site* site) {
   gf_validate(site);
 
+  /* The indices refer to the entries */
+  if (site->by_date) {
+    _(gf_array_clear(site->by_date));
+  }
+  if (site->methods) {
+    _(gf_array_clear(site->methods));
+  }
   if (site->entry_set) {
     _(gf_array_clear(site->entry_set));
   }
+  /* The entries refer to the categories and the nodes of the tree */
+  if (site->taxonomy) {
+    _(site_taxonomy_clear(site->taxonomy));
+  }
+  if (site->tree) {
+    gf_file_info_free(site->tree);
+    site->tree = NULL;
+  }
+  /* Closed after the entries, which read it on demand */
+  site_journal_overlay_free(site->overlay);
+  site->overlay = NULL;
+  if (site->db) {
+    gf_db_close(site->db);
+    site->db = NULL;
+  }
+  site_db_state_clear(&site->saved);
+  site->scan_time = 0;
   
   return GF_SUCCESS;
 }
@@ -863,916 +1362,789 @@ gf_site_get_root_entry(gf_site* site, gf_entry** entry) {
   return GF_SUCCESS;
 }
 
-static gf_bool
-site_does_file_name_equal(
-  const gf_file_info* file_info, const gf_char* file_name) {
-  gf_status rc = 0;
-  const gf_char* name = NULL;
-  gf_bool ret = GF_FALSE;
 
-  if (!file_info || !file_name) {
-    assert(0);
+gf_bool
+gf_site_find_category(
+  const gf_site* site, gf_category_kind kind, const gf_char* id,
+  const gf_category** cat) {
+  gf_any any = { 0 };
+  gf_category* found = NULL;
+
+  if (!site || gf_strnull(id)) {
     return GF_FALSE;
   }
-
-  rc = gf_file_info_get_file_name(file_info, &name);
-  if (rc != GF_SUCCESS) {
+  if (kind != GF_CATEGORY_SUBJECT && kind != GF_CATEGORY_KEYWORD) {
     return GF_FALSE;
   }
-  // TODO: strcmp must be wrapped by gf_strcmp
-  if (!strcmp(name, file_name)) {
-    ret = GF_TRUE;
-  } else {
-    ret = GF_FALSE;
+  /* The whole site is needed to list the entries of the categories */
+  if (site->db && site_load((gf_site*)site) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+  if (!gf_map_find(site->taxonomy->index[kind], id, &any)) {
+    return GF_FALSE;
+  }
+  if (site_taxonomy_get(site->taxonomy, kind, any.u32, &found) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+  if (cat) {
+    *cat = found;
   }
 
-  return ret;
+  return GF_TRUE;
 }
 
-typedef gf_bool (*does_file_name_equal_fn)(const gf_file_info* file_info);
+/*!
+** @brief Compare the entries in the order of the date index.
+**
+** The newer entry comes first, and the entries of the same date are in the
+** order of the entry tree.
+*/
 
-static gf_bool
-site_is_document_file(const gf_file_info* file_info) {
-  static const gf_char name[] = "index.dbk";
-  return site_does_file_name_equal(file_info, name);
+static gf_int
+site_compare_by_date(const gf_entry* lhs, const gf_entry* rhs) {
+  if (lhs->date != rhs->date) {
+    return lhs->date > rhs->date ? -1 : 1;
+  }
+  if (lhs->seq != rhs->seq) {
+    return lhs->seq < rhs->seq ? -1 : 1;
+  }
+
+  return 0;
 }
 
-static gf_bool
-site_is_meta_file(const gf_file_info* file_info) {
-  static const gf_char name[] = "meta.gf";
-  return site_does_file_name_equal(file_info, name);
+static gf_int
+site_compare_by_seq(const gf_entry* lhs, const gf_entry* rhs) {
+  if (lhs->seq != rhs->seq) {
+    return lhs->seq < rhs->seq ? -1 : 1;
+  }
+
+  return 0;
 }
 
-static gf_bool
-site_is_asset_directory(const gf_file_info* file_info) {
-  static const gf_char name[] = "_";
-  return site_does_file_name_equal(file_info, name);
+static int
+site_compare_any_by_date(const gf_any* lhs, const gf_any* rhs) {
+  return (int)site_compare_by_date(lhs->ptr, rhs->ptr);
 }
 
+/*!
+** @brief Find an entry in a list of the entries sorted by the function.
+**
+** @param [in]  list    The list of the entries
+** @param [in]  entry   The entry to be found
+** @param [in]  compare The function by which the list is sorted
+** @param [out] index   The index of the entry, or where it is to be inserted
+**
+** @return GF_TRUE if found, GF_FALSE otherwise.
+*/
+
 static gf_bool
-site_does_directory_have_file(
-  const gf_file_info* file_info, does_file_name_equal_fn equal_fn) {
-  gf_status rc = 0;
-  gf_size_t cnt = 0;
-  gf_bool ret = GF_FALSE;
+site_search_entry(
+  const gf_array* list, const gf_entry* entry,
+  gf_int (*compare)(const gf_entry*, const gf_entry*), gf_size_t* index) {
+  gf_size_t lo = 0;
+  gf_size_t hi = gf_array_size(list);
+
+  while (lo < hi) {
+    gf_size_t mid = lo + (hi - lo) / 2;
+    gf_any any = { 0 };
+    gf_int cmp = 0;
 
-  gf_validate(file_info);
-  gf_validate(equal_fn);
-  
-  if (!file_info) {
-    assert(0);
-    return GF_FALSE;
-  }
-  ret = GF_FALSE;
-  cnt = gf_file_info_count_children(file_info);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_file_info* child_info = 0;
-
-    rc = gf_file_info_get_child(file_info, i, &child_info);
-    if (rc != GF_SUCCESS) {
-      assert(0);
-      return GF_FALSE;
+    (void)gf_array_get(list, mid, &any);
+    cmp = compare(any.ptr, entry);
+    if (cmp == 0) {
+      *index = mid;
+      return GF_TRUE;
     }
-    if (equal_fn(child_info)) {
-      ret = GF_TRUE;
-      break;
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
   }
+  *index = lo;
 
-  return ret;
-}
-
-static gf_bool
-site_does_directory_have_meta_file(const gf_file_info* file_info) {
-  static const does_file_name_equal_fn fn = site_is_meta_file;
-  return site_does_directory_have_file(file_info, fn);
-}
-
-static gf_bool
-site_does_directory_have_document_file(const gf_file_info* file_info) {
-  static const does_file_name_equal_fn fn = site_is_document_file;
-  return site_does_directory_have_file(file_info, fn);
+  return GF_FALSE;
 }
 
 static gf_status
-site_collect_document_info(
-  gf_entry* entry, const gf_path* root, gf_file_info* file_info) {
-  gf_size_t cnt = 0;
-  gf_file_info* child_info = NULL;
-  
-  gf_validate(entry);
-  gf_validate(file_info);
-
-  cnt = gf_file_info_count_children(file_info);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    _(gf_file_info_get_child(file_info, i, &child_info));
-    if (site_is_document_file(child_info)) {
-      _(gf_entry_set_file_info(entry, child_info));
-      _(entry_set_document_info(entry, root));
-    }
+site_insert_entry(
+  gf_array* list, gf_entry* entry,
+  gf_int (*compare)(const gf_entry*, const gf_entry*)) {
+  gf_size_t index = 0;
+
+  /* The same category may be listed twice in an entry file */
+  if (!site_search_entry(list, entry, compare, &index)) {
+    _(gf_array_insert(list, index, (gf_any){ .ptr = entry }));
   }
 
   return GF_SUCCESS;
 }
 
 static gf_status
-site_collect_meta_info(
-  gf_entry* entry, const gf_path* root, gf_file_info* file_info) {
-  gf_size_t cnt = 0;
-  gf_file_info* child_info = NULL;
-  
-  gf_validate(entry);
-  gf_validate(file_info);
+site_remove_entry(
+  gf_array* list, const gf_entry* entry,
+  gf_int (*compare)(const gf_entry*, const gf_entry*)) {
+  gf_size_t index = 0;
 
-  cnt = gf_file_info_count_children(file_info);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    _(gf_file_info_get_child(file_info, i, &child_info));
-    if (site_is_meta_file(child_info)) {
-      _(gf_entry_set_file_info(entry, child_info));
-      _(entry_set_meta_info(entry, root));
-    }
+  if (site_search_entry(list, entry, compare, &index)) {
+    _(gf_array_remove(list, index));
   }
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_collect_file_info(gf_array* file_set, gf_file_info* root) {
-  gf_status rc = 0;
-  gf_size_t cnt = 0;
+static gf_bool
+site_search_method(
+  const gf_array* methods, const gf_char* method, gf_size_t* index) {
+  gf_size_t lo = 0;
+  gf_size_t hi = gf_array_size(methods);
 
-  cnt = gf_file_info_count_children(root);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_file_info* child = NULL;
-    
-    _(gf_file_info_get_child(root, i, &child));
+  while (lo < hi) {
+    gf_size_t mid = lo + (hi - lo) / 2;
+    gf_any any = { 0 };
+    int cmp = 0;
 
-    if (gf_file_info_is_directory(child)) {
-      if (!site_does_directory_have_document_file(child) &&
-          !site_does_directory_have_meta_file(child) &&
-          !gf_file_info_does_file_name_equal(child, GF_CONFIG_DIRECTORY)) {
-        _(site_collect_file_info(file_set, child));
-      }
+    (void)gf_array_get(methods, mid, &any);
+    cmp = strcmp(gf_string_get(((gf_category*)any.ptr)->id), method);
+    if (cmp == 0) {
+      *index = mid;
+      return GF_TRUE;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
     } else {
-      gf_file_info* info = NULL;
-
-      _(gf_file_info_clone(&info, child));
-      rc = gf_array_add(file_set, (gf_any){ .ptr = info });
-      if (rc != GF_SUCCESS) {
-        gf_file_info_free(info);
-        gf_throw(rc);
-      }
+      hi = mid;
     }
   }
+  *index = lo;
 
-  return GF_SUCCESS;
+  return GF_FALSE;
 }
 
+/*!
+** @brief Find or add the group of the entries processed by the method.
+*/
 
 static gf_status
-site_scan_directories(
-  gf_array* entry_set, const gf_path* root, gf_file_info* file_info) {
+site_get_method_group(gf_site* site, const gf_char* method, gf_category** cat) {
   gf_status rc = 0;
-  gf_size_t cnt = 0;
-  gf_entry* entry = NULL;
-  
-  gf_validate(entry_set);
-  gf_validate(file_info);
-
-  /* non-directory files are not our target */
-  if (!gf_file_info_is_directory(file_info)) {
-    return GF_SUCCESS;
-  }
-  /* asset directory is not our target */
-  if (site_is_asset_directory(file_info)) {
-    return GF_SUCCESS;
-  }
+  gf_category* tmp = NULL;
+  gf_size_t index = 0;
+  gf_any any = { 0 };
 
-  if (site_does_directory_have_document_file(file_info)) {
-    _(gf_entry_new(&entry));
-    rc = site_collect_document_info(entry, root, file_info);
-    if (rc != GF_SUCCESS) {
-      gf_entry_free(entry);
-      gf_throw(rc);
-    }
-    rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
-    if (rc != GF_SUCCESS) {
-      gf_entry_free(entry);
-      gf_throw(rc);
-    }
-  } else if (site_does_directory_have_meta_file(file_info)) {
-    _(gf_entry_new(&entry));
-    rc = site_collect_meta_info(entry, root, file_info);
-    if (rc != GF_SUCCESS) {
-      gf_entry_free(entry);
-      gf_throw(rc);
-    }
-    rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
-    if (rc != GF_SUCCESS) {
-      gf_entry_free(entry);
-      gf_throw(rc);
-    }
-  } else {
-    /* This directory is not our target */
+  if (site_search_method(site->methods, method, &index)) {
+    _(gf_array_get(site->methods, index, &any));
+    *cat = any.ptr;
     return GF_SUCCESS;
   }
-  if (entry) {
-    /* collect file info */
-    rc = site_collect_file_info(entry->file_set, file_info);
-    if (rc != GF_SUCCESS) {
-      gf_throw(rc);
-    }
-    /* process children  */
-    cnt = gf_file_info_count_children(file_info);
-    for (gf_size_t i = 0; i < cnt; i++) {
-      gf_file_info* child_info = NULL;
-      
-      _(gf_file_info_get_child(file_info, i, &child_info));
-      _(site_scan_directories(entry->children, root, child_info));
-    }
+  _(gf_category_new(&tmp));
+  rc = gf_string_set(tmp->id, method);
+  if (rc == GF_SUCCESS) {
+    rc = gf_string_set(tmp->name, method);
   }
-  
-  return GF_SUCCESS;
-}
-
-gf_status
-gf_site_scan(gf_site** site, const gf_path* path) {
-  gf_status rc = 0;
-  gf_site* tmp = NULL;
-  gf_file_info* file_info = NULL;
-  
-  gf_validate(site);
-  gf_validate(!gf_path_is_empty(path));
-
-  rc = gf_site_new(&tmp);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_insert(site->methods, index, (gf_any){ .ptr = tmp });
   }
-
-  /* Scan files */
-  _(gf_file_info_scan(&file_info, path));
-
-  /* Traverse */
-  rc = site_scan_directories(tmp->entry_set, path, file_info);
-  gf_file_info_free(file_info);
   if (rc != GF_SUCCESS) {
-    gf_site_free(tmp);
+    gf_category_free(tmp);
     gf_throw(rc);
   }
-
-  *site = tmp;
+  *cat = tmp;
 
   return GF_SUCCESS;
 }
 
-/* @} */
-
-/* -------------------------------------------------------------------------- */
 /*!
-** @defgroup WriteSite Writing gf_site object to an XML file.
+** @brief Add an entry to the lists of its categories and its method.
+**
+** The lists are in the order of the entry tree, which is kept by the
+** positions of the entries (see site_build_indices()).
 */
-/* @{ */
 
 static gf_status
-site_write_xml_file(xmlDocPtr doc, const char* path) {
-  FILE* fp = NULL;
-  int ret = 0;
-  
-  gf_validate(doc);
-  gf_validate(!gf_strnull(path));
+site_link_categories(gf_site* site, gf_entry* entry) {
+  gf_size_t cnt = 0;
 
-  fp = fopen(path, "w");
-  if (!fp) {
-    gf_raise(GF_E_OPEN, "Failed to open file.");
-  }
-  ret = xmlDocFormatDump(fp, doc, 1);
-  fclose(fp);
-  if (ret < 0) {
-    gf_raise(GF_E_OPEN, "Failed to open file.");
-  }
-  
-  return GF_SUCCESS;
-}
+  for (gf_size_t k = 0; k < 2; k++) {
+    gf_category_kind kind = (gf_category_kind)k;
 
-static gf_status
-site_add_xml_int16u(xmlNodePtr node, xmlChar* name, gf_16u value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
+    cnt = gf_array_size(entry_get_category_set(entry, kind));
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_category* cat = NULL;
 
-  snprintf(buf, 256, "%d", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+      _(entry_get_category(entry, kind, i, &cat));
+      _(site_insert_entry(cat->entries, entry, site_compare_by_seq));
+    }
   }
+  if (!gf_strnull(gf_string_get(entry->method))) {
+    gf_category* cat = NULL;
 
-  return GF_SUCCESS;
-}
-
-static gf_status
-site_add_xml_int16u_hex(xmlNodePtr node, xmlChar* name, gf_16u value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
-
-  snprintf(buf, 256, "%x", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+    _(site_get_method_group(site, gf_string_get(entry->method), &cat));
+    _(site_insert_entry(cat->entries, entry, site_compare_by_seq));
   }
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_int16s(xmlNodePtr node, xmlChar* name, gf_16s value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
-
-  snprintf(buf, 256, "%d", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-  }
-
-  return GF_SUCCESS;
-}
+/*!
+** @brief Add an entry to the indices built by site_build_indices().
+*/
 
 static gf_status
-site_add_xml_int32u(xmlNodePtr node, xmlChar* name, gf_32u value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
-
-  snprintf(buf, 256, "%d", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+site_link_entry(gf_site* site, gf_entry* entry) {
+  _(site_link_categories(site, entry));
+  if (entry->date) {
+    _(site_insert_entry(site->by_date, entry, site_compare_by_date));
   }
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_int64u(xmlNodePtr node, xmlChar* name, gf_64u value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
-
-  snprintf(buf, 256, "%lld", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-  }
-
-  return GF_SUCCESS;
-}
+/*!
+** @brief Remove an entry from the indices.
+**
+** The entry has to have the same date, method and categories as it was
+** added with.
+*/
 
 static gf_status
-site_add_xml_int64u_hex(xmlNodePtr node, xmlChar* name, gf_64u value) {
-  xmlNodePtr cur = NULL;
-  char buf[256] = { 0 };
-  
-  gf_validate(node);
-  gf_validate(name);
-
-  snprintf(buf, 256, "%llx", value);
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST buf);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-  }
+site_unlink_entry(gf_site* site, const gf_entry* entry) {
+  gf_size_t cnt = 0;
+  gf_size_t index = 0;
 
-  return GF_SUCCESS;
-}
+  for (gf_size_t k = 0; k < 2; k++) {
+    gf_category_kind kind = (gf_category_kind)k;
 
-static gf_status
-site_add_xml_string(xmlNodePtr node, xmlChar* name, const gf_string* value) {
-  xmlNodePtr cur = NULL;
+    cnt = gf_array_size(entry_get_category_set(entry, kind));
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_category* cat = NULL;
 
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
+      _(entry_get_category(entry, kind, i, &cat));
+      _(site_remove_entry(cat->entries, entry, site_compare_by_seq));
+    }
+  }
+  if (!gf_strnull(gf_string_get(entry->method)) &&
+      site_search_method(site->methods, gf_string_get(entry->method), &index)) {
+    gf_any any = { 0 };
 
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST gf_string_get(value));
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+    _(gf_array_get(site->methods, index, &any));
+    _(site_remove_entry(
+        ((gf_category*)any.ptr)->entries, entry, site_compare_by_seq));
+  }
+  if (entry->date) {
+    _(site_remove_entry(site->by_date, entry, site_compare_by_date));
   }
 
   return GF_SUCCESS;
 }
 
 static gf_status
-site_add_xml_date(xmlNodePtr node, xmlChar* name, gf_64u datetime) {
-  gf_status rc = 0;
-  gf_string* str = NULL;
-  xmlNodePtr cur = NULL;
+site_index_entry(gf_site* site, gf_entry* entry, gf_32u* seq) {
+  gf_size_t cnt = 0;
 
-  gf_validate(node);
-  gf_validate(name);
+  /* site_load() relies on this to read every part */
+  _(entry_load(entry, ENTRY_PENDING_ALL));
 
-  _(gf_string_new(&str));
-  if (datetime > 0) {
-    rc = gf_datetime_make_iso8061_string(str, (gf_datetime)datetime);
-    if (rc != GF_SUCCESS) {
-      gf_string_free(str);
-      gf_throw(rc);
-    }
+  entry->seq = (*seq)++;
+  _(site_link_categories(site, entry));
+  /* Sorted at last */
+  if (entry->date) {
+    _(gf_array_add(site->by_date, (gf_any){ .ptr = entry }));
   }
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST gf_string_get(str));
-  gf_string_free(str);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  cnt = gf_array_size(entry->children);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entry->children, i, &any));
+    _(site_index_entry(site, any.ptr, seq));
   }
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_description(
-  xmlNodePtr node, xmlChar* name, const gf_array* value) {
-  xmlNodePtr cur = NULL;
+/*!
+** @brief Rebuild the secondary indices of the entries.
+**
+** The entries are numbered in the order of the entry tree, and listed in
+** that order by the categories and the methods regardless of the order in
+** which the entry files are read. The date index is sorted by
+** site_compare_by_date(). The indices are kept up to date for a few changed
+** entries by site_unlink_entry() and site_link_entry() afterwards.
+*/
+
+gf_status
+site_build_indices(gf_site* site) {
   gf_size_t cnt = 0;
+  gf_32u seq = 0;
 
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
+  for (gf_size_t k = 0; k < 2; k++) {
+    cnt = gf_array_size(site->taxonomy->categories[k]);
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_any any = { 0 };
 
-  cur = xmlNewNode(NULL, BAD_CAST"description");
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-  }
-  cur = xmlAddChild(node, cur);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to add an XML node.");
+      _(gf_array_get(site->taxonomy->categories[k], i, &any));
+      _(gf_array_clear(((gf_category*)any.ptr)->entries));
+    }
   }
-  cnt = gf_array_size(value);
+  _(gf_array_clear(site->methods));
+  _(gf_array_clear(site->by_date));
+  cnt = gf_array_size(site->entry_set);
   for (gf_size_t i = 0; i < cnt; i++) {
     gf_any any = { 0 };
-    gf_string* str = NULL;
-    
-    _(gf_array_get(value, i, &any));
-    str = (gf_string*)(any.ptr);
-    _(site_add_xml_string(cur, BAD_CAST"p", str));
+
+    _(gf_array_get(site->entry_set, i, &any));
+    _(site_index_entry(site, any.ptr, &seq));
   }
+  _(gf_array_sort(site->by_date, site_compare_any_by_date));
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_path(xmlNodePtr node, xmlChar* name, const gf_path* value) {
-  xmlNodePtr cur = NULL;
-
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
-
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST gf_path_get_string(value));
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+gf_size_t
+gf_site_count_dated_entries(const gf_site* site) {
+  if (!site) {
+    return 0;
+  }
+  if (site->db && site_load((gf_site*)site) != GF_SUCCESS) {
+    return 0;
   }
 
-  return GF_SUCCESS;
+  return gf_array_size(site->by_date);
 }
 
-static gf_status
-site_add_xml_file_info_string(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, const gf_char**)) {
+gf_status
+gf_site_get_dated_entry(
+  const gf_site* site, gf_size_t index, gf_entry** entry) {
+  gf_any any = { 0 };
 
-  xmlNodePtr cur = NULL;
-  const gf_char* str = NULL;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
+  gf_validate(site);
+  gf_validate(entry);
 
-  _(fn(info, &str));
-  
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST str);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  if (site->db) {
+    _(site_load((gf_site*)site));
   }
+  _(gf_array_get(site->by_date, index, &any));
+  *entry = any.ptr;
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_file_info_hash(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_size_t, gf_8u*)) {
-
-  xmlNodePtr txt = NULL;
-  xmlNodePtr cur = NULL;
-  gf_16u hash_size = 0;
-  gf_8u buf[256] = { 0 };
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
-
-  _(fn(info, 256, buf));
+gf_bool
+gf_site_find_method(
+  const gf_site* site, const gf_char* method, const gf_category** cat) {
+  gf_size_t index = 0;
+  gf_any any = { 0 };
 
-  _(gf_file_info_get_hash_size(info, &hash_size));
-  
-  cur = xmlNewNode(NULL, name);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  if (!site || gf_strnull(method)) {
+    return GF_FALSE;
+  }
+  if (site->db && site_load((gf_site*)site) != GF_SUCCESS) {
+    return GF_FALSE;
   }
-  cur = xmlAddChild(node, cur);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  if (!site_search_method(site->methods, method, &index)) {
+    return GF_FALSE;
   }
-  txt = xmlNewTextLen(BAD_CAST buf, hash_size);
-  if (!txt) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  if (gf_array_get(site->methods, index, &any) != GF_SUCCESS) {
+    return GF_FALSE;
   }
-  txt = xmlAddChild(cur, txt);
-  if (!txt) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  if (cat) {
+    *cat = any.ptr;
   }
 
-  return GF_SUCCESS;
+  return GF_TRUE;
 }
 
-static gf_status
-site_add_xml_file_info_int16u(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_16u*)) {
-  gf_16u n = 0;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
-
-  _(fn(info, &n));
-  _(site_add_xml_int16u(node, name, n));
+static gf_bool
+site_does_file_name_equal(
+  const gf_file_info* file_info, const gf_char* file_name) {
+  gf_status rc = 0;
+  const gf_char* name = NULL;
+  gf_bool ret = GF_FALSE;
 
-  return GF_SUCCESS;
-}
+  if (!file_info || !file_name) {
+    assert(0);
+    return GF_FALSE;
+  }
 
-static gf_status
-site_add_xml_file_info_int16u_hex(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_16u*)) {
-  gf_16u n = 0;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
+  rc = gf_file_info_get_file_name(file_info, &name);
+  if (rc != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+  // TODO: strcmp must be wrapped by gf_strcmp
+  if (!strcmp(name, file_name)) {
+    ret = GF_TRUE;
+  } else {
+    ret = GF_FALSE;
+  }
 
-  _(fn(info, &n));
-  _(site_add_xml_int16u_hex(node, name, n));
+  return ret;
+}
 
-  return GF_SUCCESS;
+static gf_bool
+site_is_asset_directory(const gf_file_info* file_info) {
+  static const gf_char name[] = "_";
+  return site_does_file_name_equal(file_info, name);
 }
 
-static gf_status
-site_add_xml_file_info_int16s(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_16s*)) {
-  gf_16s n = 0;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
+/*!
+** @brief Find the file which makes the directory an entry.
+**
+** The document file (index.dbk) takes precedence over the meta file (meta.gf).
+**
+** @param [in]  file_info The directory
+** @param [out] document  GF_TRUE if the document file is found (may be NULL)
+**
+** @return The document or meta file, NULL if the directory is not an entry.
+*/
 
-  _(fn(info, &n));
-  _(site_add_xml_int16s(node, name, n));
+static gf_file_info*
+site_find_entry_file(const gf_file_info* file_info, gf_bool* document) {
+  static const gf_char document_name[] = "index.dbk";
+  static const gf_char meta_name[] = "meta.gf";
+  gf_file_info* child_info = NULL;
+  gf_bool found = GF_FALSE;
 
-  return GF_SUCCESS;
+  found = gf_file_info_find_child(file_info, document_name, &child_info);
+  if (document) {
+    *document = found;
+  }
+  if (!found &&
+      !gf_file_info_find_child(file_info, meta_name, &child_info)) {
+    return NULL;
+  }
+
+  return child_info;
 }
 
+/*!
+** @brief Let the entry refer to a node of the scanned tree.
+**
+** Unlike gf_entry_set_file_info(), the node is not cloned. It is freed with
+** the tree held by the site.
+*/
+
 static gf_status
-site_add_xml_file_info_int32u(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_32u*)) {
-  gf_32u n = 0;
-  
+site_entry_refer_file_info(gf_entry* entry, gf_file_info* info) {
+  gf_validate(entry);
   gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
 
-  _(fn(info, &n));
-  _(site_add_xml_int32u(node, name, n));
+  if (entry->file_info) {
+    gf_file_info_free(entry->file_info);
+  }
+  entry->file_info = info;
 
   return GF_SUCCESS;
 }
 
+/*!
+** @brief Set the entry file and the type of the entry.
+**
+** The entry file is read later by site_read_entries().
+*/
+
 static gf_status
-site_add_xml_file_info_int64u(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_64u*)) {
-  gf_64u n = 0;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
+site_collect_entry_info(
+  gf_entry* entry, gf_file_info* file_info, gf_bool document) {
+  gf_validate(entry);
+  gf_validate(file_info);
 
-  _(fn(info, &n));
-  _(site_add_xml_int64u(node, name, n));
+  _(site_entry_refer_file_info(entry, file_info));
+  if (document) {
+    entry->type = GF_ENTRY_TYPE_DOCUMENT;
+  } else {
+    entry->type = GF_ENTRY_TYPE_SECTION;
+  }
 
   return GF_SUCCESS;
 }
 
 static gf_status
-site_add_xml_file_info_int64u_hex(
-  xmlNodePtr node, const gf_file_info* info, xmlChar* name,
-  gf_status (*fn)(const gf_file_info*, gf_64u*)) {
-  gf_64u n = 0;
-  
-  gf_validate(info);
-  gf_validate(name);
-  gf_validate(fn);
+site_collect_file_info(gf_array* file_set, gf_file_info* root) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_file_info_count_children(root);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_file_info* child = NULL;
+    
+    _(gf_file_info_get_child(root, i, &child));
 
-  _(fn(info, &n));
-  _(site_add_xml_int64u_hex(node, name, n));
+    if (gf_file_info_is_directory(child)) {
+      if (!site_find_entry_file(child, NULL) &&
+          !gf_file_info_does_file_name_equal(child, GF_CONFIG_DIRECTORY)) {
+        _(site_collect_file_info(file_set, child));
+      }
+    } else {
+      /* The node is owned by the tree */
+      _(gf_array_add(file_set, (gf_any){ .ptr = child }));
+    }
+  }
 
   return GF_SUCCESS;
 }
 
+
 /*!
+** @brief Build the entry tree from the scanned tree.
 **
-** We do not write values of user_data and user_flag.
-**
-**
+** The entries are appended to @a pending in the order of the tree, so that
+** their entry files are read afterwards.
 */
 
 static gf_status
-site_add_xml_file_info(
-  xmlNodePtr node, xmlChar* name, const gf_file_info* value) {
-  xmlNodePtr cur = NULL;
+site_scan_directories(
+  site_taxonomy* taxonomy, gf_array* entry_set, gf_array* pending,
+  gf_file_info* file_info) {
+  gf_status rc = 0;
+  gf_size_t cnt = 0;
+  gf_entry* entry = NULL;
+  gf_file_info* entry_file = NULL;
+  gf_bool document = GF_FALSE;
   
-  gf_validate(node);
-  gf_validate(value);
-
-  cur = xmlNewNode(NULL, name);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-   }
-  cur = xmlAddChild(node, cur);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to add an XML node.");
-   }
-  _(site_add_xml_file_info_string(
-      cur, value, BAD_CAST"file-name", gf_file_info_get_file_name));
-  _(site_add_xml_file_info_string(
-      cur, value, BAD_CAST"full-path", gf_file_info_get_full_path));
-  _(site_add_xml_file_info_hash(
-      cur, value, BAD_CAST"hash", gf_file_info_get_hash_string));
-  _(site_add_xml_file_info_int16u(
-      cur, value, BAD_CAST"hash-size", gf_file_info_get_hash_size));
-  _(site_add_xml_file_info_int16u(
-      cur, value, BAD_CAST"inode", gf_file_info_get_inode));
-  _(site_add_xml_file_info_int16u_hex(
-      cur, value, BAD_CAST"mode", gf_file_info_get_mode));
-  _(site_add_xml_file_info_int16s(
-      cur, value, BAD_CAST"link-count", gf_file_info_get_link_count));
-  _(site_add_xml_file_info_int16s(
-      cur, value, BAD_CAST"uid", gf_file_info_get_uid));
-  _(site_add_xml_file_info_int16s(
-      cur, value, BAD_CAST"gid", gf_file_info_get_gid));
-  _(site_add_xml_file_info_int32u(
-      cur, value, BAD_CAST"device", gf_file_info_get_device));
-  _(site_add_xml_file_info_int32u(
-      cur, value, BAD_CAST"rdevice", gf_file_info_get_rdevice));
-  _(site_add_xml_file_info_int64u(
-      cur, value, BAD_CAST"file-size", gf_file_info_get_file_size));
-  _(site_add_xml_file_info_int64u_hex(
-      cur, value, BAD_CAST"access-time", gf_file_info_get_access_time));
-  _(site_add_xml_file_info_int64u_hex(
-      cur, value, BAD_CAST"modify-time", gf_file_info_get_modify_time));
-  _(site_add_xml_file_info_int64u_hex(
-      cur, value, BAD_CAST"create-time", gf_file_info_get_create_time));
-
-  return GF_SUCCESS;
-}
-
-static gf_status
-site_add_xml_category(
-  xmlNodePtr node, xmlChar* name, const gf_category* value) {
-  xmlNodePtr cur = NULL;
-
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
+  gf_validate(entry_set);
+  gf_validate(file_info);
 
-  // NOTE: We directly refer to the member gf_category::name. It may be
-  // preferable to access via getter functions.
-  cur = xmlNewTextChild(node, NULL, name, BAD_CAST gf_string_get(value->name));
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  /* non-directory files are not our target */
+  if (!gf_file_info_is_directory(file_info)) {
+    return GF_SUCCESS;
+  }
+  /* asset directory is not our target */
+  if (site_is_asset_directory(file_info)) {
+    return GF_SUCCESS;
   }
-  xmlSetProp(cur, BAD_CAST"xml:id", BAD_CAST gf_string_get(value->id));
-
-  return GF_SUCCESS;
-}
-
-static gf_status
-site_add_xml_file_set(xmlNodePtr node, xmlChar* name, const gf_array* value) {
-  xmlNodePtr cur = NULL;
-  gf_size_t cnt = 0;
 
-  cur = xmlNewNode(NULL, name);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  entry_file = site_find_entry_file(file_info, &document);
+  if (!entry_file) {
+    /* This directory is not our target */
+    return GF_SUCCESS;
   }
-  cur = xmlAddChild(node, cur);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to add an XML node.");
+  _(entry_new(&entry, taxonomy));
+  rc = site_collect_entry_info(entry, entry_file, document);
+  if (rc != GF_SUCCESS) {
+    gf_entry_free(entry);
+    gf_throw(rc);
   }
-  cnt = gf_array_size(value);
+  rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
+  if (rc != GF_SUCCESS) {
+    gf_entry_free(entry);
+    gf_throw(rc);
+  }
+  _(gf_array_add(pending, (gf_any){ .ptr = entry }));
+  /* collect file info */
+  _(site_collect_file_info(entry->file_set, file_info));
+  /* process children  */
+  cnt = gf_file_info_count_children(file_info);
   for (gf_size_t i = 0; i < cnt; i++) {
-    gf_any any = { 0 };
+    gf_file_info* child_info = NULL;
 
-    _(gf_array_get(value, i, &any));
-    _(site_add_xml_file_info(cur, BAD_CAST"file-info", (gf_file_info*)any.ptr));
+    _(gf_file_info_get_child(file_info, i, &child_info));
+    _(site_scan_directories(taxonomy, entry->children, pending, child_info));
   }
   
   return GF_SUCCESS;
 }
 
-static gf_status
-site_add_xml_category_set(
-  xmlNodePtr node, xmlChar* name, xmlChar* child_name, const gf_array* value) {
-  xmlNodePtr cur = NULL;
-  gf_size_t cnt = 0;
-  
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
+/*!
+** @brief Make the key to find the files of the same content.
+**
+** The key is "algorithm:hash". Empty files and the files without fingerprint
+** have no key, since they are not distinguishable.
+*/
+
+static gf_bool
+site_make_content_key(
+  const gf_file_info* info, gf_size_t size, gf_char* key) {
+  const gf_char* algorithm = NULL;
+  gf_16u hash_size = 0;
+  gf_64u file_size = 0;
+  gf_size_t len = 0;
 
-  cur = xmlNewNode(NULL, name);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+  (void)gf_file_info_get_hash_algorithm(info, &algorithm);
+  (void)gf_file_info_get_hash_size(info, &hash_size);
+  (void)gf_file_info_get_file_size(info, &file_size);
+  if (gf_strnull(algorithm) || hash_size == 0 || file_size == 0) {
+    return GF_FALSE;
   }
-  cur = xmlAddChild(node, cur);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to add an XML node.");
+  len = (gf_size_t)snprintf(key, size, "%s:", algorithm);
+  if (len + (gf_size_t)hash_size * 2 + 1 > size) {
+    return GF_FALSE;
   }
-  cnt = gf_array_size(value);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_any any = { 0 };
-
-    _(gf_array_get(value, i, &any));
-    _(site_add_xml_category(cur, child_name, (gf_category*)any.ptr));
+  if (gf_file_info_get_hash_string(
+        info, size - len, (gf_8u*)key + len) != GF_SUCCESS) {
+    return GF_FALSE;
   }
 
-  return GF_SUCCESS;
+  return GF_TRUE;
 }
 
-static gf_status
-site_add_xml_file_info_set(
-  xmlNodePtr node, xmlChar* name, const gf_array* value) {
-  xmlNodePtr cur = NULL;
-  gf_size_t cnt = 0;
-  
-  gf_validate(node);
-  gf_validate(name);
-  gf_validate(value);
+/* -------------------------------------------------------------------------- */
 
-  cur = xmlNewNode(NULL, name);
-  if (!cur) {
-    gf_raise(GF_E_API, "Failed to add an XML node.");
-  }
-  cnt = gf_array_size(value);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_any any = { 0 };
+/*!
+** @brief A job to read an entry file
+*/
 
-    _(gf_array_get(value, i, &any));
-    _(site_add_xml_file_info(cur, BAD_CAST"file-info", (gf_file_info*)(any.ptr)));
-  }
-  
-  return GF_SUCCESS;
-}
+typedef struct site_entry_job {
+  gf_entry*  entry;             ///< The entry to be filled
+  gf_status  status;            ///< The result of reading the entry file
+} site_entry_job;
 
-static gf_status
-site_make_entry_node(xmlNodePtr* node, gf_entry* entry) {
-  xmlNodePtr tmp = NULL;
-  xmlNodePtr children_node = NULL;
-  gf_size_t cnt = 0;
+/*!
+** @brief The jobs shared by the threads reading the entry files
+*/
 
-  tmp = xmlNewNode(NULL, BAD_CAST"entry");
-  if (!tmp) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
-  }
-
-  _(site_add_xml_int32u(tmp, BAD_CAST"type", entry->type));
-  _(site_add_xml_int32u(tmp, BAD_CAST"state", entry->state));
-  _(site_add_xml_string(tmp, BAD_CAST"title", entry->title));
-  _(site_add_xml_string(tmp, BAD_CAST"author", entry->author));
-  _(site_add_xml_date(tmp, BAD_CAST"date", entry->date));
-  _(site_add_xml_description(tmp, BAD_CAST"description", entry->description));
-  _(site_add_xml_file_info(tmp, BAD_CAST"file-info", entry->file_info));
-  _(site_add_xml_string(tmp, BAD_CAST"method", entry->method));
-  _(site_add_xml_path(tmp, BAD_CAST"output-path", entry->output_path));
-  _(site_add_xml_file_set(tmp, BAD_CAST"file-set", entry->file_set));
-  _(site_add_xml_category_set(
-      tmp, BAD_CAST"subject-set", BAD_CAST"subject", entry->subject_set));
-  _(site_add_xml_category_set(
-      tmp, BAD_CAST"keyword-set", BAD_CAST"keyword", entry->keyword_set));
-  _(site_add_xml_file_info_set(tmp, BAD_CAST"file-set", entry->file_set));
+typedef struct site_entry_reader {
+  const gf_path*  root;         ///< The root directory of the site
+  gf_entry_cache* cache;        ///< The cache of the entry files (may be NULL)
+  site_entry_job* jobs;         ///< The jobs in the order of the entry tree
+  gf_size_t       count;        ///< The number of the jobs
+  gf_size_t       next;         ///< The next job to be taken (guarded)
+  gf_mutex        lock;         ///< Guards 'next'
+} site_entry_reader;
 
-  /* Process children */
-  children_node = xmlNewNode(NULL, BAD_CAST"children");
-  if (!children_node) {
-    gf_raise(GF_E_API, "Failed to create an XML node.");
+/*!
+** @brief Fill the entry from the cache or from the entry file.
+*/
+
+static gf_status
+site_read_entry(
+  site_entry_reader* shared, gf_entry* entry, xmlTextReaderPtr* reader) {
+  gf_char key[SITE_CONTENT_KEY_SIZE] = { 0 };
+  const gf_entry* cached = NULL;
+  gf_bool keyed = GF_FALSE;
+
+  if (shared->cache) {
+    keyed = site_make_content_key(entry->file_info, sizeof(key), key);
   }
-  children_node = xmlAddChild(tmp, children_node);
-  if (!children_node) {
-    xmlFreeNode(children_node);
-    gf_raise(GF_E_API, "Failed to add an XML node.");
+  if (keyed && entry_cache_lookup(shared->cache, key, entry, &cached)) {
+    _(entry_copy_info(entry, cached));
+    return GF_SUCCESS;
   }
-  if (gf_entry_is_section(entry)) {
-    cnt = gf_array_size(entry->children);
-    for (gf_size_t i = 0; i < cnt; i++) {
-      gf_any any = { 0 };
-      xmlNodePtr child_node = NULL;
-      
-      _(gf_array_get(entry->children, i, &any));
-      _(site_make_entry_node(&child_node, (gf_entry*)any.ptr));
-    
-      child_node = xmlAddChild(children_node, child_node);
-      if (!children_node) {
-        gf_raise(GF_E_API, "Failed to add an XML node.");
-      }
-    }
+  _(entry_read_info(entry, shared->root, reader));
+  if (keyed) {
+    _(entry_cache_store(shared->cache, key, entry));
   }
-  
-  *node = tmp;
-  
+
   return GF_SUCCESS;
 }
 
-static gf_status
-site_write_content(xmlNodePtr root, const gf_site* site) {
-  gf_size_t cnt = 0;
+static void
+site_read_entries_run(gf_ptr data) {
+  site_entry_reader* shared = data;
+  xmlTextReaderPtr reader = NULL;
 
-  cnt = gf_array_size(site->entry_set);
-  for (gf_size_t i = 0; i < cnt; i++) {
-    gf_any any = { 0 };
+  for (;;) {
+    site_entry_job* job = NULL;
 
-    _(gf_array_get(site->entry_set, i, &any));
-    if (any.ptr) {
-      xmlNodePtr entry_node = NULL;
+    gf_mutex_lock(&shared->lock);
+    if (shared->next < shared->count) {
+      job = &shared->jobs[shared->next++];
+    }
+    gf_mutex_unlock(&shared->lock);
+    if (!job) {
+      break;
+    }
+    /* The reader (and its parser context) is reused within the thread */
+    job->status = site_read_entry(shared, job->entry, &reader);
+  }
+  if (reader) {
+    xmlFreeTextReader(reader);
+  }
+}
 
-      _(site_make_entry_node(&entry_node, (gf_entry*)any.ptr));
-      
-      entry_node = xmlAddChild(root, entry_node);
-      if (!entry_node) {
-        gf_raise(GF_E_API, "Failed to add an XML node.");
+/*!
+** @brief Report the failed jobs in the order of the entry tree.
+**
+** @return The status of the first failed job, GF_SUCCESS if none.
+*/
+
+static gf_status
+site_check_entry_jobs(const site_entry_job* jobs, gf_size_t count) {
+  gf_status rc = GF_SUCCESS;
+
+  for (gf_size_t i = 0; i < count; i++) {
+    if (jobs[i].status != GF_SUCCESS) {
+      gf_error("Failed to read the entry file '%s'.",
+               gf_entry_get_full_path_string(jobs[i].entry));
+      if (rc == GF_SUCCESS) {
+        rc = jobs[i].status;
       }
     }
   }
-  
-  return GF_SUCCESS;
-}
 
-gf_status
-gf_site_write_file(const gf_site* site, const gf_path* path) {
-  gf_status rc = 0;
-  xmlDocPtr doc = NULL;
-  xmlNodePtr root = NULL;
+  return rc;
+}
 
-  gf_validate(site);
-  gf_validate(!gf_path_is_empty(path));
+/*!
+** @brief Read the entry files of the pending entries in parallel.
+**
+** Every entry file is read even if some of them fail, and all the failures
+** are reported.
+**
+** @param [in] pending The entries collected by site_scan_directories()
+** @param [in] root    The root directory of the site
+** @param [in] threads The number of threads (0: one per processor)
+** @param [in] cache   The cache of the entry files (may be NULL)
+*/
 
-  doc = xmlNewDoc(BAD_CAST"1.0");
-  if (!doc) {
-    gf_raise(GF_E_API, "Failed to create an XML document on write.");
+static gf_status
+site_read_entries(
+  const gf_array* pending, const gf_path* root, gf_int threads,
+  gf_entry_cache* cache) {
+  gf_status rc = 0;
+  site_entry_reader shared = { 0 };
+  gf_thread* workers = NULL;
+  gf_size_t count = 0;
+  gf_size_t started = 0;
+
+  shared.root = root;
+  shared.cache = cache;
+  shared.count = gf_array_size(pending);
+  if (shared.count == 0) {
+    return GF_SUCCESS;
   }
-  /* Root element "site" */
-  // TODO: set namespace
-  root = xmlNewNode(NULL, BAD_CAST"site");
-  if (!root) {
-    gf_raise(GF_E_API, "Failed to create an XML element on write.");
+  _(gf_malloc((gf_ptr*)&shared.jobs, sizeof(*shared.jobs) * shared.count));
+  for (gf_size_t i = 0; i < shared.count; i++) {
+    gf_any any = { 0 };
+
+    (void)gf_array_get(pending, i, &any);
+    shared.jobs[i].entry = any.ptr;
+    shared.jobs[i].status = GF_SUCCESS;
   }
-  xmlDocSetRootElement(doc, root);
-  /* Build site content */
-  rc = site_write_content(root, site);
+  rc = gf_mutex_init(&shared.lock);
   if (rc != GF_SUCCESS) {
-    xmlFreeDoc(doc);
+    gf_free(shared.jobs);
     gf_throw(rc);
   }
-  /* Write file */
-  rc = site_write_xml_file(doc, gf_path_get_string(path));
-  xmlFreeDoc(doc);
+
+  count = gf_thread_resolve_count(threads);
+  if (count > shared.count) {
+    count = shared.count;
+  }
+  if (count > 1) {
+    /* LibXML2 must be initialized before it is used by the threads */
+    xmlInitParser();
+    rc = gf_malloc((gf_ptr*)&workers, sizeof(*workers) * count);
+    /* The calling thread works as the worker #0 */
+    for (gf_size_t i = 1; rc == GF_SUCCESS && i < count; i++) {
+      rc = gf_thread_create(&workers[i], site_read_entries_run, &shared);
+      if (rc == GF_SUCCESS) {
+        started += 1;
+      }
+    }
+    if (rc != GF_SUCCESS) {
+      gf_warn("Reading the entry files with %zu thread(s).", started + 1);
+    }
+  }
+  site_read_entries_run(&shared);
+  for (gf_size_t i = 1; i <= started; i++) {
+    (void)gf_thread_join(workers[i]);
+  }
+  gf_free(workers);
+  gf_mutex_destroy(&shared.lock);
+  gf_debug("Read %zu entry file(s) with %zu thread(s).",
+           shared.count, started + 1);
+
+  rc = site_check_entry_jobs(shared.jobs, shared.count);
+  gf_free(shared.jobs);
   if (rc != GF_SUCCESS) {
     gf_throw(rc);
   }
@@ -1780,473 +2152,2439 @@ gf_site_write_file(const gf_site* site, const gf_path* path) {
   return GF_SUCCESS;
 }
 
-/* @} */
-
-/* -------------------------------------------------------------------------- */
+gf_status
+gf_site_scan(gf_site** site, const gf_path* path) {
+  gf_file_info_scan_option option = { 0 };
 
-static gf_status
-site_read_xml_int16u(gf_16u* value, const xmlNodePtr node) {
-  gf_16u n = 0;
-  gf_char* e = NULL;
+  option.threads = 1;
 
-  gf_validate(value);
-  gf_validate(node);
+  return gf_site_scan_with_option(site, path, &option, NULL);
+}
 
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+gf_status
+gf_site_scan_with_option(
+  gf_site** site, const gf_path* path,
+  const gf_file_info_scan_option* option, gf_entry_cache* cache) {
+  gf_status rc = 0;
+  gf_site* tmp = NULL;
+  gf_file_info* file_info = NULL;
+  gf_array* pending = NULL;
+  
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(option);
+
+  rc = gf_site_new(&tmp);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
   }
-  n = strtoul((gf_char*)node->content, &e, 10);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+
+  /* Scan files; every stat is taken at or after the scan time */
+  tmp->scan_time = (gf_64u)time(NULL);
+  rc = gf_file_info_scan_with_option(&file_info, path, option);
+  if (rc != GF_SUCCESS) {
+    gf_site_free(tmp);
+    gf_throw(rc);
   }
-  *value = (gf_16u)n;
-  
+
+  /* Traverse, and then read the entry files */
+  tmp->tree = file_info;
+  rc = gf_array_new(&pending);
+  if (rc == GF_SUCCESS) {
+    rc = site_scan_directories(
+      tmp->taxonomy, tmp->entry_set, pending, file_info);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_read_entries(pending, path, (gf_int)option->threads, cache);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_build_indices(tmp);
+  }
+  gf_array_free(pending);
+  if (rc != GF_SUCCESS) {
+    gf_site_free(tmp);
+    gf_throw(rc);
+  }
+
+  *site = tmp;
+
   return GF_SUCCESS;
 }
 
-static gf_status
-site_read_xml_int16u_hex(gf_16u* value, const xmlNodePtr node) {
-  gf_16u n = 0;
-  gf_char* e = NULL;
+/* @} */
 
-  gf_validate(value);
-  gf_validate(node);
+/* -------------------------------------------------------------------------- */
+/*!
+** @defgroup WriteSite Writing gf_site object to an XML file.
+*/
+/* @{ */
 
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+static gf_status
+site_make_temporary_path(gf_path** tmp_path, const gf_path* path) {
+  gf_status rc = 0;
+  gf_string* str = NULL;
+
+  _(gf_string_new(&str));
+  rc = gf_string_set(str, gf_path_get_string(path));
+  if (rc == GF_SUCCESS) {
+    rc = gf_string_append(str, ".tmp");
   }
-  n = strtoul((gf_char*)node->content, &e, 16);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_new(tmp_path, gf_string_get(str));
   }
-  *value = (gf_16u)n;
-  
+  gf_string_free(str);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
   return GF_SUCCESS;
 }
 
 static gf_status
-site_read_xml_int16s(gf_16s* value, const xmlNodePtr node) {
-  gf_16s n = 0;
-  gf_char* e = NULL;
+site_open_xml_stream_low(site_xml_stream* stream) {
+  xmlOutputBufferPtr out = NULL;
 
-  gf_validate(value);
-  gf_validate(node);
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  /* The text mode is kept for the same output as xmlDocFormatDump() */
+  stream->fp = fopen(gf_path_get_string(stream->tmp_path), "w");
+  if (!stream->fp) {
+    gf_raise(GF_E_OPEN, "Failed to open file.");
   }
-  n = strtol((gf_char*)node->content, &e, 10);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  out = xmlOutputBufferCreateFile(stream->fp, NULL);
+  if (!out) {
+    gf_raise(GF_E_API, "Failed to create an XML writer.");
+  }
+  stream->writer = xmlNewTextWriter(out);
+  if (!stream->writer) {
+    xmlOutputBufferClose(out);
+    gf_raise(GF_E_API, "Failed to create an XML writer.");
+  }
+  if (xmlTextWriterSetIndent(stream->writer, 1) < 0 ||
+      xmlTextWriterSetIndentString(stream->writer, BAD_CAST"  ") < 0 ||
+      xmlTextWriterStartDocument(stream->writer, NULL, NULL, NULL) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write an XML file.");
   }
-  *value = (gf_16s)n;
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_read_xml_int32u(gf_32u* value, const xmlNodePtr node) {
-  gf_32u n = 0;
-  gf_char* e = NULL;
+static void
+site_discard_xml_stream(site_xml_stream* stream) {
+  if (stream->writer) {
+    xmlFreeTextWriter(stream->writer);
+    stream->writer = NULL;
+  }
+  if (stream->fp) {
+    fclose(stream->fp);
+    stream->fp = NULL;
+  }
+  if (stream->tmp_path) {
+    (void)remove(gf_path_get_string(stream->tmp_path));
+    gf_path_free(stream->tmp_path);
+    stream->tmp_path = NULL;
+  }
+}
 
-  gf_validate(value);
-  gf_validate(node);
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+gf_status
+site_open_xml_stream(site_xml_stream* stream, const gf_path* path) {
+  gf_status rc = 0;
+
+  stream->fp = NULL;
+  stream->writer = NULL;
+  stream->tmp_path = NULL;
+  _(site_make_temporary_path(&stream->tmp_path, path));
+  rc = site_open_xml_stream_low(stream);
+  if (rc != GF_SUCCESS) {
+    site_discard_xml_stream(stream);
+    gf_throw(rc);
   }
 
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Close the stream and replace the file with the written one.
+**
+** The temporary file is removed if the writing failed.
+**
+** @param [in, out] stream The stream
+** @param [in]      path   The file to be replaced
+** @param [in]      rc     The result of the writing
+*/
+
+gf_status
+site_close_xml_stream(
+  site_xml_stream* stream, const gf_path* path, gf_status rc) {
+  if (rc == GF_SUCCESS) {
+    if (xmlTextWriterEndDocument(stream->writer) < 0 ||
+        xmlTextWriterFlush(stream->writer) < 0) {
+      gf_error("Failed to write an XML file.");
+      rc = GF_E_WRITE;
+    }
   }
-  n = strtoul((gf_char*)node->content, &e, 10);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  xmlFreeTextWriter(stream->writer);
+  stream->writer = NULL;
+  if (fclose(stream->fp) != 0 && rc == GF_SUCCESS) {
+    gf_error("Failed to close file.");
+    rc = GF_E_WRITE;
+  }
+  stream->fp = NULL;
+  if (rc == GF_SUCCESS) {
+    rc = gf_shell_replace(path, stream->tmp_path);
+  }
+  site_discard_xml_stream(stream);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
   }
-  *value = (gf_32u)n;
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_read_xml_int64u(gf_64u* value, const xmlNodePtr node) {
-  gf_64u n = 0;
-  gf_char* e = NULL;
-
-  gf_validate(value);
-  gf_validate(node);
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+gf_status
+site_write_xml_start(xmlTextWriterPtr writer, const gf_char* name) {
+  if (xmlTextWriterStartElement(writer, BAD_CAST name) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write an XML element.");
   }
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+
+  return GF_SUCCESS;
+}
+
+gf_status
+site_write_xml_end(xmlTextWriterPtr writer) {
+  if (xmlTextWriterEndElement(writer) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write an XML element.");
   }
-  n = strtoul((gf_char*)node->content, &e, 10);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+
+  return GF_SUCCESS;
+}
+
+gf_status
+site_write_xml_attribute(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* value) {
+  if (xmlTextWriterWriteAttribute(
+        writer, BAD_CAST name, BAD_CAST(value ? value : "")) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write an XML attribute.");
   }
-  *value = (gf_64u)n;
 
   return GF_SUCCESS;
 }
 
 static gf_status
-site_read_xml_int64u_hex(gf_64u* value, const xmlNodePtr node) {
-  gf_64u n = 0;
-  gf_char* e = NULL;
+site_write_xml_raw(xmlTextWriterPtr writer, const gf_char* str, gf_size_t len) {
+  if (xmlTextWriterWriteRawLen(writer, BAD_CAST str, (int)len) < 0) {
+    gf_raise(GF_E_WRITE, "Failed to write an XML text.");
+  }
 
-  gf_validate(value);
-  gf_validate(node);
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the length of a UTF-8 sequence and its code point.
+**
+** @return The length, 0 if the sequence is invalid.
+*/
+
+static gf_size_t
+site_decode_utf8(const gf_8u* s, gf_32u* code) {
+  gf_size_t len = 0;
+
+  if (s[0] >= 0xF0 && s[0] < 0xF8) {
+    len = 4;
+    *code = s[0] & 0x07;
+  } else if (s[0] >= 0xE0) {
+    len = 3;
+    *code = s[0] & 0x0F;
+  } else if (s[0] >= 0xC0) {
+    len = 2;
+    *code = s[0] & 0x1F;
+  } else {
+    return 0;
   }
-  n = strtoul((gf_char*)node->content, &e, 16);
-  if (*e != '\0') {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  for (gf_size_t i = 1; i < len; i++) {
+    if ((s[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+    *code = (*code << 6) | (s[i] & 0x3F);
   }
-  *value = (gf_64u)n;
 
-  return GF_SUCCESS;
+  return len;
 }
 
+/*!
+** @brief Write the escaped text.
+**
+** The text is escaped as xmlDocFormatDump() does for a document without the
+** encoding declaration: the characters out of ASCII are written as the
+** character references.
+*/
+
 static gf_status
-site_read_xml_string(gf_string* value, const xmlNodePtr node) {
-  gf_validate(value);
-  gf_validate(node);
+site_write_xml_text(xmlTextWriterPtr writer, const gf_char* str) {
+  const gf_8u* s = (const gf_8u*)str;
+  gf_size_t run = 0;
+
+  while (s[run]) {
+    gf_8u c = s[run];
+    const gf_char* ref = NULL;
+    gf_char buf[16] = { 0 };
+    gf_size_t len = 1;
+    gf_32u code = 0;
+
+    if ((c >= 0x20 && c < 0x80 && c != '<' && c != '>' && c != '&') ||
+        c == '\n' || c == '\t') {
+      run++;
+      continue;
+    }
+    if (c == '<') {
+      ref = "&lt;";
+    } else if (c == '>') {
+      ref = "&gt;";
+    } else if (c == '&') {
+      ref = "&amp;";
+    } else {
+      len = c >= 0x80 ? site_decode_utf8(s + run, &code) : 1;
+      if (len == 0) {
+        /* Not UTF-8; the byte is written as it is */
+        len = 1;
+        code = c;
+      } else if (c < 0x80) {
+        code = c;
+      }
+      snprintf(buf, sizeof(buf), "&#x%X;", (unsigned int)code);
+      ref = buf;
+    }
+    _(site_write_xml_raw(writer, (const gf_char*)s, run));
+    _(site_write_xml_raw(writer, ref, strlen(ref)));
+    s += run + len;
+    run = 0;
+  }
+  _(site_write_xml_raw(writer, (const gf_char*)s, run));
 
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Write an element which has a text.
+**
+** The element is empty (<name/>) if @a value is NULL.
+*/
+
+gf_status
+site_write_xml_element(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* value) {
+  _(site_write_xml_start(writer, name));
+  if (value) {
+    _(site_write_xml_text(writer, value));
   }
-  _(gf_string_set(value, (gf_char*)node->content));
+  _(site_write_xml_end(writer));
 
   return GF_SUCCESS;
 }
 
-static gf_status
-site_read_xml_path(gf_path* value, const xmlNodePtr node) {
-  gf_validate(value);
-  gf_validate(node);
+/*!
+** @brief Write an element of a number.
+**
+** @param [in, out] writer The writer
+** @param [in]      name   The name of the element
+** @param [in]      format The format for snprintf (%llu, %llx or %lld)
+** @param [in]      value  The number cast to unsigned long long
+*/
 
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+static gf_status
+site_write_xml_number(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* format,
+  unsigned long long value) {
+  gf_char buf[32] = { 0 };
+  int len = 0;
+
+  len = snprintf(buf, sizeof(buf), format, value);
+  if (len < 0 || (gf_size_t)len >= sizeof(buf)) {
+    gf_raise(GF_E_INTERNAL, "Failed to format a number.");
   }
-  _(gf_path_set_string(value, (gf_char*)node->content));
-  
+  _(site_write_xml_start(writer, name));
+  _(site_write_xml_raw(writer, buf, (gf_size_t)len));
+  _(site_write_xml_end(writer));
+
   return GF_SUCCESS;
 }
 
 static gf_status
-site_read_xml_date(gf_datetime* value, const xmlNodePtr node) {
-  gf_validate(value);
-  gf_validate(node);
-  
-  if (!xmlNodeIsText(node)) {
-    gf_raise(GF_E_DATA, "Invalid site data.");
+site_write_xml_date(
+  xmlTextWriterPtr writer, const gf_char* name, gf_datetime datetime) {
+  gf_status rc = 0;
+  gf_string* str = NULL;
+
+  _(gf_string_new(&str));
+  if (datetime > 0) {
+    rc = gf_datetime_make_iso8061_string(str, datetime);
   }
-  _(gf_datetime_parse_iso8061_string((const gf_char*)node->content, value));
-  
+  if (rc == GF_SUCCESS) {
+    rc = site_write_xml_element(writer, name, gf_string_get(str));
+  }
+  gf_string_free(str);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
   return GF_SUCCESS;
 }
 
 static gf_status
-site_read_xml_description(gf_array* value, const xmlNodePtr node) {
-  gf_validate(value);
-  gf_validate(node);
+site_write_xml_description(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_array* value) {
+  gf_size_t cnt = 0;
 
-  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-    gf_status rc = 0;
-    gf_string* str = NULL;
-    xmlNodePtr txt = NULL;
-    
-    if (!xmlStrcmp(cur->name, BAD_CAST"p")) {
-      assert(0);
-      continue;
-    }
-    txt = cur->children;
-    if (!xmlNodeIsText(txt)) {
-      assert(0);
-      continue;
-    }
-    _(gf_string_new(&str));
-    rc = gf_string_set(str, (gf_char*)txt->content);
-    if (rc != GF_SUCCESS) {
-      gf_string_free(str);
-      gf_throw(rc);
-    }
-    rc = gf_array_add(value, (gf_any){ .ptr = str });
-    if (rc != GF_SUCCESS) {
-      gf_string_free(str);
-      gf_throw(rc);
-    }
+  _(site_write_xml_start(writer, name));
+  cnt = gf_array_size(value);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(value, i, &any));
+    _(site_write_xml_element(
+        writer, "p", gf_string_get((gf_string*)any.ptr)));
   }
+  _(site_write_xml_end(writer));
 
   return GF_SUCCESS;
 }
 
+/*!
+**
+** We do not write values of user_data and user_flag.
+**
+*/
+
 static gf_status
-site_read_xml_category(
-  gf_array* value, const xmlChar* name, const xmlNodePtr node) {
-  gf_status rc = 0;
+site_write_xml_file_info(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_file_info* value) {
+  const gf_char* str = NULL;
+  gf_8u hash[GF_HASH_BUFSIZE_MAX * 2 + 1] = { 0 };
+  gf_16u u16 = 0;
+  gf_16s s16 = 0;
+  gf_32u u32 = 0;
+  gf_64u u64 = 0;
 
   gf_validate(value);
-  gf_validate(name);
-  gf_validate(node);
 
-  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-    gf_category* cat = NULL;
-    gf_string* str = NULL;
-    xmlNodePtr txt = NULL;
-    xmlChar* id = NULL;
-    
-    if (!!xmlStrcmp(cur->name, name)) {
-      assert(0);
-      continue;
-    }
-    id = xmlGetProp(cur, BAD_CAST"id");
-    if (!id) {
-      assert(0);
-      continue;
-    }
-    txt = cur->children;
-    if (!txt || !xmlNodeIsText(txt)) {
-      assert(0);
-      continue;
-    }
+  _(site_write_xml_start(writer, name));
+  _(gf_file_info_get_file_name(value, &str));
+  _(site_write_xml_element(writer, "file-name", str));
+  _(gf_file_info_get_full_path(value, &str));
+  _(site_write_xml_element(writer, "full-path", str));
+  _(gf_file_info_get_hash_size(value, &u16));
+  _(gf_file_info_get_hash_string(value, sizeof(hash), hash));
+  hash[u16 * 2] = '\0';
+  _(site_write_xml_element(writer, "hash", (const gf_char*)hash));
+  _(site_write_xml_number(writer, "hash-size", "%llu", u16));
+  _(gf_file_info_get_hash_algorithm(value, &str));
+  _(site_write_xml_element(writer, "hash-algorithm", str));
+  _(gf_file_info_get_inode(value, &u64));
+  _(site_write_xml_number(writer, "inode", "%llu", u64));
+  _(gf_file_info_get_mode(value, &u16));
+  _(site_write_xml_number(writer, "mode", "%llx", u16));
+  _(gf_file_info_get_link_count(value, &s16));
+  _(site_write_xml_number(writer, "link-count", "%lld", (gf_64s)s16));
+  _(gf_file_info_get_uid(value, &s16));
+  _(site_write_xml_number(writer, "uid", "%lld", (gf_64s)s16));
+  _(gf_file_info_get_gid(value, &s16));
+  _(site_write_xml_number(writer, "gid", "%lld", (gf_64s)s16));
+  _(gf_file_info_get_device(value, &u32));
+  _(site_write_xml_number(writer, "device", "%llu", u32));
+  _(gf_file_info_get_rdevice(value, &u32));
+  _(site_write_xml_number(writer, "rdevice", "%llu", u32));
+  _(gf_file_info_get_file_size(value, &u64));
+  _(site_write_xml_number(writer, "file-size", "%llu", u64));
+  _(gf_file_info_get_access_time(value, &u64));
+  _(site_write_xml_number(writer, "access-time", "%llx", u64));
+  _(gf_file_info_get_modify_time(value, &u64));
+  _(site_write_xml_number(writer, "modify-time", "%llx", u64));
+  _(gf_file_info_get_create_time(value, &u64));
+  _(site_write_xml_number(writer, "create-time", "%llx", u64));
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
 
-    _(gf_category_new(&cat));
+static gf_status
+site_write_xml_file_set(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_array* value) {
+  gf_size_t cnt = 0;
 
-    rc = gf_string_new(&str);
-    if (rc != GF_SUCCESS) {
-      gf_category_free(cat);
-      gf_throw(rc);
-    }
-    gf_string_set(str, (gf_char*)id);
-    if (rc != GF_SUCCESS) {
-      gf_string_free(str);
-      gf_category_free(cat);
-      gf_throw(rc);
-    }
-    rc = gf_category_set_id(cat, str);
-    if (rc != GF_SUCCESS) {
-      gf_category_free(cat);
-      gf_throw(rc);
-    }
+  _(site_write_xml_start(writer, name));
+  cnt = gf_array_size(value);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(value, i, &any));
+    _(site_write_xml_file_info(writer, "file-info", (gf_file_info*)any.ptr));
+  }
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+site_write_xml_category_set(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* child_name,
+  const gf_entry* entry, gf_category_kind kind) {
+  gf_size_t cnt = 0;
+
+  _(site_write_xml_start(writer, name));
+  cnt = gf_array_size(entry_get_category_set(entry, kind));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_category* cat = NULL;
+
+    _(entry_get_category(entry, kind, i, &cat));
+    _(site_write_xml_start(writer, child_name));
+    _(site_write_xml_attribute(writer, "xml:id", gf_string_get(cat->id)));
+    if (gf_string_get(cat->name)) {
+      _(site_write_xml_text(writer, gf_string_get(cat->name)));
+    }
+    _(site_write_xml_end(writer));
+  }
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Write the information of an entry shared with the entry cache.
+*/
+
+gf_status
+site_write_xml_entry_info(xmlTextWriterPtr writer, const gf_entry* entry) {
+  _(site_write_xml_number(writer, "type", "%llu", entry->type));
+  _(site_write_xml_number(writer, "state", "%llu", entry->state));
+  _(site_write_xml_element(writer, "title", gf_string_get(entry->title)));
+  _(site_write_xml_element(writer, "author", gf_string_get(entry->author)));
+  _(site_write_xml_date(writer, "date", entry->date));
+  _(site_write_xml_description(writer, "description", entry->description));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_write_xml_entry(xmlTextWriterPtr writer, const gf_entry* entry) {
+  gf_size_t cnt = 0;
+
+  _(entry_load(entry, ENTRY_PENDING_ALL));
+  _(site_write_xml_start(writer, "entry"));
+  _(site_write_xml_entry_info(writer, entry));
+  _(site_write_xml_file_info(writer, "file-info", entry->file_info));
+  _(site_write_xml_element(writer, "method", gf_string_get(entry->method)));
+  _(site_write_xml_element(
+      writer, "output-path", gf_path_get_string(entry->output_path)));
+  _(site_write_xml_file_set(writer, "file-set", entry->file_set));
+  _(site_write_xml_category_set(
+      writer, "subject-set", "subject", entry, GF_CATEGORY_SUBJECT));
+  _(site_write_xml_category_set(
+      writer, "keyword-set", "keyword", entry, GF_CATEGORY_KEYWORD));
+
+  /* Process children */
+  _(site_write_xml_start(writer, "children"));
+  if (gf_entry_is_section(entry)) {
+    cnt = gf_array_size(entry->children);
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_any any = { 0 };
+
+      _(gf_array_get(entry->children, i, &any));
+      _(site_write_xml_entry(writer, (gf_entry*)any.ptr));
+    }
+  }
+  _(site_write_xml_end(writer));
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_write_xml_entry_refs(xmlTextWriterPtr writer, const gf_array* entries) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(entries);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entries, i, &any));
+    _(site_write_xml_start(writer, "ref"));
+    _(site_write_xml_attribute(
+        writer, "path", gf_entry_get_full_path_string(any.ptr)));
+    _(site_write_xml_end(writer));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Write the entry lists of the categories.
+**
+** The categories without entries are omitted.
+*/
+
+static gf_status
+site_write_xml_category_index(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* child_name,
+  const gf_array* categories) {
+  gf_size_t cnt = 0;
+
+  _(site_write_xml_start(writer, name));
+  cnt = gf_array_size(categories);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_category* cat = NULL;
+    gf_any any = { 0 };
+
+    _(gf_array_get(categories, i, &any));
+    cat = any.ptr;
+    if (gf_array_size(cat->entries) == 0) {
+      continue;
+    }
+    _(site_write_xml_start(writer, child_name));
+    _(site_write_xml_attribute(writer, "id", gf_string_get(cat->id)));
+    _(site_write_xml_attribute(writer, "name", gf_string_get(cat->name)));
+    _(site_write_xml_entry_refs(writer, cat->entries));
+    _(site_write_xml_end(writer));
+  }
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Write the secondary indices of the entries.
+**
+** The entries are referred to by the full paths of their entry files, so
+** that the stylesheets can look them up by a key.
+*/
+
+static gf_status
+site_write_xml_indices(xmlTextWriterPtr writer, const gf_site* site) {
+  /* The indices of a site opened by gf_site_open() are built on demand */
+  if (site->db) {
+    _(site_load((gf_site*)site));
+  }
+  _(site_write_xml_start(writer, "indices"));
+  _(site_write_xml_start(writer, "by-date"));
+  _(site_write_xml_entry_refs(writer, site->by_date));
+  _(site_write_xml_end(writer));
+  _(site_write_xml_category_index(
+      writer, "by-subject", "subject",
+      site->taxonomy->categories[GF_CATEGORY_SUBJECT]));
+  _(site_write_xml_category_index(
+      writer, "by-keyword", "keyword",
+      site->taxonomy->categories[GF_CATEGORY_KEYWORD]));
+  _(site_write_xml_category_index(
+      writer, "by-method", "method", site->methods));
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_write_content(xmlTextWriterPtr writer, const gf_site* site) {
+  gf_size_t cnt = 0;
+
+  /* Root element "site" */
+  // TODO: set namespace
+  _(site_write_xml_start(writer, "site"));
+  if (site->scan_time != 0) {
+    gf_char buf[32] = { 0 };
+
+    snprintf(buf, sizeof(buf), "%llx", (unsigned long long)site->scan_time);
+    _(site_write_xml_attribute(writer, "scan-time", buf));
+  }
+  cnt = gf_array_size(site->entry_set);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(site->entry_set, i, &any));
+    if (any.ptr) {
+      _(site_write_xml_entry(writer, (gf_entry*)any.ptr));
+    }
+  }
+  _(site_write_xml_indices(writer, site));
+  _(site_write_xml_end(writer));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_write_file(const gf_site* site, const gf_path* path) {
+  gf_status rc = 0;
+  site_xml_stream stream;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(site_open_xml_stream(&stream, path));
+  rc = site_write_content(stream.writer, site);
+  _(site_close_xml_stream(&stream, path, rc));
+
+  return GF_SUCCESS;
+}
+
+/* @} */
+
+/* -------------------------------------------------------------------------- */
+/*!
+** @defgroup ReadSite Reading gf_site object from an XML file.
+*/
+/* @{ */
+
+static const gf_char* site_xml_names_[SITE_XML_NAME_COUNT] = {
+  [SITE_XML_SITE] = "site",
+  [SITE_XML_ENTRY_CACHE] = "entry-cache",
+  [SITE_XML_ITEM] = "item",
+  [SITE_XML_ENTRY] = "entry",
+  [SITE_XML_INDICES] = "indices",
+  [SITE_XML_TYPE] = "type",
+  [SITE_XML_STATE] = "state",
+  [SITE_XML_TITLE] = "title",
+  [SITE_XML_AUTHOR] = "author",
+  [SITE_XML_DATE] = "date",
+  [SITE_XML_DESCRIPTION] = "description",
+  [SITE_XML_P] = "p",
+  [SITE_XML_METHOD] = "method",
+  [SITE_XML_OUTPUT_PATH] = "output-path",
+  [SITE_XML_FILE_INFO] = "file-info",
+  [SITE_XML_FILE_SET] = "file-set",
+  [SITE_XML_SUBJECT_SET] = "subject-set",
+  [SITE_XML_SUBJECT] = "subject",
+  [SITE_XML_KEYWORD_SET] = "keyword-set",
+  [SITE_XML_KEYWORD] = "keyword",
+  [SITE_XML_CHILDREN] = "children",
+  [SITE_XML_FILE_NAME] = "file-name",
+  [SITE_XML_FULL_PATH] = "full-path",
+  [SITE_XML_HASH] = "hash",
+  [SITE_XML_HASH_SIZE] = "hash-size",
+  [SITE_XML_HASH_ALGORITHM] = "hash-algorithm",
+  [SITE_XML_INODE] = "inode",
+  [SITE_XML_MODE] = "mode",
+  [SITE_XML_LINK_COUNT] = "link-count",
+  [SITE_XML_UID] = "uid",
+  [SITE_XML_GID] = "gid",
+  [SITE_XML_DEVICE] = "device",
+  [SITE_XML_RDEVICE] = "rdevice",
+  [SITE_XML_FILE_SIZE] = "file-size",
+  [SITE_XML_ACCESS_TIME] = "access-time",
+  [SITE_XML_MODIFY_TIME] = "modify-time",
+  [SITE_XML_CREATE_TIME] = "create-time",
+};
+
+/*!
+** @brief The key of an element name
+**
+** The length, the first and the last but one characters of the names above
+** are unique, so the key picks the only candidate of a name. A new name
+** which breaks it is rejected by the compiler as a duplicate case label.
+*/
+
+#define SITE_XML_KEY(len, c0, c1) (((len) << 16) | ((c0) << 8) | (c1))
+
+static site_xml_name
+site_xml_lookup_key(int key) {
+  switch (key) {
+  case SITE_XML_KEY(4, 's', 't'):
+    return SITE_XML_SITE;
+  case SITE_XML_KEY(11, 'e', 'h'):
+    return SITE_XML_ENTRY_CACHE;
+  case SITE_XML_KEY(4, 'i', 'e'):
+    return SITE_XML_ITEM;
+  case SITE_XML_KEY(5, 'e', 'r'):
+    return SITE_XML_ENTRY;
+  case SITE_XML_KEY(7, 'i', 'e'):
+    return SITE_XML_INDICES;
+  case SITE_XML_KEY(4, 't', 'p'):
+    return SITE_XML_TYPE;
+  case SITE_XML_KEY(5, 's', 't'):
+    return SITE_XML_STATE;
+  case SITE_XML_KEY(5, 't', 'l'):
+    return SITE_XML_TITLE;
+  case SITE_XML_KEY(6, 'a', 'o'):
+    return SITE_XML_AUTHOR;
+  case SITE_XML_KEY(4, 'd', 't'):
+    return SITE_XML_DATE;
+  case SITE_XML_KEY(11, 'd', 'o'):
+    return SITE_XML_DESCRIPTION;
+  case SITE_XML_KEY(1, 'p', 0):
+    return SITE_XML_P;
+  case SITE_XML_KEY(6, 'm', 'o'):
+    return SITE_XML_METHOD;
+  case SITE_XML_KEY(11, 'o', 't'):
+    return SITE_XML_OUTPUT_PATH;
+  case SITE_XML_KEY(9, 'f', 'f'):
+    return SITE_XML_FILE_INFO;
+  case SITE_XML_KEY(8, 'f', 'e'):
+    return SITE_XML_FILE_SET;
+  case SITE_XML_KEY(11, 's', 'e'):
+    return SITE_XML_SUBJECT_SET;
+  case SITE_XML_KEY(7, 's', 'c'):
+    return SITE_XML_SUBJECT;
+  case SITE_XML_KEY(11, 'k', 'e'):
+    return SITE_XML_KEYWORD_SET;
+  case SITE_XML_KEY(7, 'k', 'r'):
+    return SITE_XML_KEYWORD;
+  case SITE_XML_KEY(8, 'c', 'e'):
+    return SITE_XML_CHILDREN;
+  case SITE_XML_KEY(9, 'f', 'm'):
+    return SITE_XML_FILE_NAME;
+  case SITE_XML_KEY(9, 'f', 't'):
+    return SITE_XML_FULL_PATH;
+  case SITE_XML_KEY(4, 'h', 's'):
+    return SITE_XML_HASH;
+  case SITE_XML_KEY(9, 'h', 'z'):
+    return SITE_XML_HASH_SIZE;
+  case SITE_XML_KEY(14, 'h', 'h'):
+    return SITE_XML_HASH_ALGORITHM;
+  case SITE_XML_KEY(5, 'i', 'd'):
+    return SITE_XML_INODE;
+  case SITE_XML_KEY(4, 'm', 'd'):
+    return SITE_XML_MODE;
+  case SITE_XML_KEY(10, 'l', 'n'):
+    return SITE_XML_LINK_COUNT;
+  case SITE_XML_KEY(3, 'u', 'i'):
+    return SITE_XML_UID;
+  case SITE_XML_KEY(3, 'g', 'i'):
+    return SITE_XML_GID;
+  case SITE_XML_KEY(6, 'd', 'c'):
+    return SITE_XML_DEVICE;
+  case SITE_XML_KEY(7, 'r', 'c'):
+    return SITE_XML_RDEVICE;
+  case SITE_XML_KEY(9, 'f', 'z'):
+    return SITE_XML_FILE_SIZE;
+  case SITE_XML_KEY(11, 'a', 'm'):
+    return SITE_XML_ACCESS_TIME;
+  case SITE_XML_KEY(11, 'm', 'm'):
+    return SITE_XML_MODIFY_TIME;
+  case SITE_XML_KEY(11, 'c', 'm'):
+    return SITE_XML_CREATE_TIME;
+  default:
+    return SITE_XML_UNKNOWN;
+  }
+}
+
+static site_xml_name
+site_xml_lookup(const xmlChar* name) {
+  site_xml_name id = SITE_XML_UNKNOWN;
+  int len = 0;
+
+  if (!name) {
+    return SITE_XML_UNKNOWN;
+  }
+  len = xmlStrlen(name);
+  id = site_xml_lookup_key(
+    SITE_XML_KEY(len, name[0], len > 1 ? name[len - 2] : 0));
+  if (id == SITE_XML_UNKNOWN ||
+      !xmlStrEqual(name, BAD_CAST site_xml_names_[id])) {
+    return SITE_XML_UNKNOWN;
+  }
+
+  return id;
+}
+
+gf_status
+site_open_xml_loader(
+  site_xml_loader* loader, const gf_path* path, int option) {
+  loader->reader = NULL;
+  loader->text = NULL;
+  loader->size = 0;
+
+  loader->reader = xmlReaderForFile(gf_path_get_string(path), NULL, option);
+  if (!loader->reader) {
+    gf_raise(GF_E_API, "Failed to read an XML file.");
+  }
+
+  return GF_SUCCESS;
+}
+
+void
+site_close_xml_loader(site_xml_loader* loader) {
+  if (loader->reader) {
+    xmlFreeTextReader(loader->reader);
+    loader->reader = NULL;
+  }
+  if (loader->text) {
+    gf_free(loader->text);
+    loader->text = NULL;
+  }
+  loader->size = 0;
+}
+
+site_xml_name
+site_xml_get_name(const site_xml_loader* loader) {
+  return site_xml_lookup(xmlTextReaderConstLocalName(loader->reader));
+}
+
+/*!
+** @brief Move the reader to the next child element.
+**
+** The reader has to be on the start of the parent or on the last node of the
+** previous child, where the functions reading an element leave it. The nodes
+** other than elements are skipped.
+**
+** @param [in, out] loader The loader
+** @param [in]      depth  The depth of the parent
+** @param [out]     name   The name of the child, SITE_XML_NONE at the end
+*/
+
+gf_status
+site_xml_next_child(site_xml_loader* loader, int depth, site_xml_name* name) {
+  int ret = 0;
+
+  while ((ret = xmlTextReaderRead(loader->reader)) == 1) {
+    int type = xmlTextReaderNodeType(loader->reader);
+
+    if (type == XML_READER_TYPE_END_ELEMENT &&
+        xmlTextReaderDepth(loader->reader) <= depth) {
+      *name = SITE_XML_NONE;
+      return GF_SUCCESS;
+    }
+    if (type == XML_READER_TYPE_ELEMENT) {
+      *name = site_xml_get_name(loader);
+      return GF_SUCCESS;
+    }
+  }
+  if (ret < 0) {
+    gf_raise(GF_E_API, "Failed to read an XML file.");
+  }
+  gf_raise(GF_E_DATA, "Invalid XML document.");
+}
+
+/*!
+** @brief Move the reader to the first child element.
+**
+** @param [in, out] loader The loader on the parent
+** @param [out]     depth  The depth of the parent for site_xml_next_child()
+** @param [out]     name   The name of the child, SITE_XML_NONE if none
+*/
+
+gf_status
+site_xml_first_child(site_xml_loader* loader, int* depth, site_xml_name* name) {
+  *depth = xmlTextReaderDepth(loader->reader);
+  if (xmlTextReaderIsEmptyElement(loader->reader)) {
+    *name = SITE_XML_NONE;
+    return GF_SUCCESS;
+  }
+  _(site_xml_next_child(loader, *depth, name));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_xml_append_text(
+  site_xml_loader* loader, gf_size_t* used, const xmlChar* s) {
+  gf_size_t len = (gf_size_t)xmlStrlen(s);
+
+  if (*used + len + 1 > loader->size) {
+    gf_size_t size = loader->size ? loader->size : 64;
+
+    while (size < *used + len + 1) {
+      size *= 2;
+    }
+    _(gf_realloc((gf_ptr*)&loader->text, size));
+    loader->size = size;
+  }
+  _(gf_memcpy(&loader->text[*used], s, len));
+  *used += len;
+  loader->text[*used] = '\0';
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the text of the element.
+**
+** The text nodes directly under the element are joined, and the child
+** elements are skipped, so an unknown element is skipped by this function.
+** The reader is left on the end of the element.
+**
+** @param [in, out] loader The loader on an element
+** @param [out]     text   The text ("" if empty), valid until the next call
+*/
+
+gf_status
+site_xml_read_text(site_xml_loader* loader, const gf_char** text) {
+  gf_size_t used = 0;
+  int depth = 0;
+  int ret = 0;
+
+  *text = "";
+  if (xmlTextReaderIsEmptyElement(loader->reader)) {
+    return GF_SUCCESS;
+  }
+  depth = xmlTextReaderDepth(loader->reader);
+  while ((ret = xmlTextReaderRead(loader->reader)) == 1) {
+    int type = xmlTextReaderNodeType(loader->reader);
+    int cur = xmlTextReaderDepth(loader->reader);
+
+    if (cur <= depth) {
+      /* The end of the element */
+      if (used > 0) {
+        *text = loader->text;
+      }
+      return GF_SUCCESS;
+    }
+    if (cur == depth + 1 &&
+        (type == XML_READER_TYPE_TEXT ||
+         type == XML_READER_TYPE_CDATA ||
+         type == XML_READER_TYPE_WHITESPACE ||
+         type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE)) {
+      _(site_xml_append_text(
+          loader, &used, xmlTextReaderConstValue(loader->reader)));
+    }
+  }
+  if (ret < 0) {
+    gf_raise(GF_E_API, "Failed to read an XML file.");
+  }
+  gf_raise(GF_E_DATA, "Invalid XML document.");
+}
+
+static gf_status
+site_read_xml_int16u(gf_16u* value, const gf_char* text) {
+  gf_16u n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtoul(text, &e, 10);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_16u)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_int16u_hex(gf_16u* value, const gf_char* text) {
+  gf_16u n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtoul(text, &e, 16);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_16u)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_int16s(gf_16s* value, const gf_char* text) {
+  gf_16s n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtol(text, &e, 10);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_16s)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_int32u(gf_32u* value, const gf_char* text) {
+  gf_32u n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtoul(text, &e, 10);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_32u)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_int64u(gf_64u* value, const gf_char* text) {
+  gf_64u n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtoull(text, &e, 10);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_64u)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_int64u_hex(gf_64u* value, const gf_char* text) {
+  gf_64u n = 0;
+  gf_char* e = NULL;
+
+  gf_validate(value);
+  gf_validate(text);
+
+  n = strtoull(text, &e, 16);
+  if (*text == '\0' || *e != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site data.");
+  }
+  *value = (gf_64u)n;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_date(gf_datetime* value, const gf_char* text) {
+  gf_validate(value);
+  gf_validate(text);
+
+  if (*text == '\0') {
+    /* Empty element */
+    *value = 0;
+    return GF_SUCCESS;
+  }
+  _(gf_datetime_parse_iso8061_string(text, value));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_description(site_xml_loader* loader, gf_array* value) {
+  gf_status rc = 0;
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(value);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    const gf_char* text = NULL;
+    gf_string* str = NULL;
+
+    _(site_xml_read_text(loader, &text));
+    /* Empty paragraphs are dropped */
+    if (name == SITE_XML_P && *text != '\0') {
+      _(gf_string_new(&str));
+      rc = gf_string_set(str, text);
+      if (rc == GF_SUCCESS) {
+        rc = gf_array_add(value, (gf_any){ .ptr = str });
+      }
+      if (rc != GF_SUCCESS) {
+        gf_string_free(str);
+        gf_throw(rc);
+      }
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static xmlChar*
+site_xml_get_id(const site_xml_loader* loader) {
+  xmlChar* id = NULL;
+
+  /* The attribute is written as xml:id */
+  id = xmlTextReaderGetAttributeNs(
+    loader->reader, BAD_CAST"id", XML_XML_NAMESPACE);
+  if (!id) {
+    id = xmlTextReaderGetAttribute(loader->reader, BAD_CAST"id");
+  }
+
+  return id;
+}
+
+static gf_status
+site_read_xml_category(
+  site_xml_loader* loader, gf_entry* entry, gf_category_kind kind,
+  site_xml_name item) {
+  gf_status rc = 0;
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(entry);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    const gf_char* text = NULL;
+    xmlChar* id = NULL;
+
+    if (name == item) {
+      id = site_xml_get_id(loader);
+    }
+    rc = site_xml_read_text(loader, &text);
+    /* The categories without the ID or the name are dropped */
+    if (rc == GF_SUCCESS && id && *text != '\0') {
+      rc = entry_add_category(entry, kind, (const gf_char*)id, text);
+    }
+    if (id) {
+      xmlFree(id);
+    }
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read an element of the entry information.
+**
+** The elements shared by site.xml and the entry cache are read.
+**
+** @param [in, out] loader The loader on the element
+** @param [in, out] entry  The entry
+** @param [in]      name   The name of the element
+** @param [out]     found  GF_FALSE if the element is not read
+*/
+
+gf_status
+site_read_xml_entry_info(
+  site_xml_loader* loader, gf_entry* entry, site_xml_name name,
+  gf_bool* found) {
+  const gf_char* text = NULL;
+
+  gf_validate(loader);
+  gf_validate(entry);
+  gf_validate(found);
+
+  *found = GF_TRUE;
+  switch (name) {
+  case SITE_XML_TYPE:
+    _(site_xml_read_text(loader, &text));
+    _(site_read_xml_int32u(&entry->type, text));
+    break;
+  case SITE_XML_STATE:
+    _(site_xml_read_text(loader, &text));
+    _(site_read_xml_int32u(&entry->state, text));
+    break;
+  case SITE_XML_TITLE:
+    _(site_xml_read_text(loader, &text));
+    _(gf_string_set(entry->title, text));
+    break;
+  case SITE_XML_AUTHOR:
+    _(site_xml_read_text(loader, &text));
+    _(gf_string_set(entry->author, text));
+    break;
+  case SITE_XML_DATE:
+    _(site_xml_read_text(loader, &text));
+    _(site_read_xml_date(&entry->date, text));
+    break;
+  case SITE_XML_DESCRIPTION:
+    _(site_read_xml_description(loader, entry->description));
+    break;
+  case SITE_XML_METHOD:
+    _(site_xml_read_text(loader, &text));
+    _(gf_string_set(entry->method, text));
+    break;
+  case SITE_XML_SUBJECT_SET:
+    _(site_read_xml_category(
+        loader, entry, GF_CATEGORY_SUBJECT, SITE_XML_SUBJECT));
+    break;
+  case SITE_XML_KEYWORD_SET:
+    _(site_read_xml_category(
+        loader, entry, GF_CATEGORY_KEYWORD, SITE_XML_KEYWORD));
+    break;
+  default:
+    *found = GF_FALSE;
+    break;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_file_info_hash(gf_file_info* info, const gf_char* text) {
+  gf_size_t len = 0;
+
+  gf_validate(info);
+  gf_validate(text);
+
+  /* The hash of a directory is empty */
+  len = strlen(text);
+  if (len == 0) {
+    return GF_SUCCESS;
+  }
+  if (len % 2 != 0 || len > GF_HASH_BUFSIZE_MAX * 2) {
+    /* Broken; leave the hash empty so that the file is hashed again */
+    return GF_SUCCESS;
+  }
+  _(gf_file_info_set_hash_string(info, len / 2, (gf_8u*)text));
+  _(gf_file_info_set_hash_size(info, (gf_16u)(len / 2)));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_file_info_field(
+  gf_file_info* info, site_xml_name name, const gf_char* text) {
+  gf_16u u16 = 0;
+  gf_16s s16 = 0;
+  gf_32u u32 = 0;
+  gf_64u u64 = 0;
+
+  gf_validate(info);
+  gf_validate(text);
+
+  switch (name) {
+  case SITE_XML_FILE_NAME:
+    _(gf_file_info_set_file_name(info, text));
+    break;
+  case SITE_XML_FULL_PATH:
+    _(gf_file_info_set_full_path(info, text));
+    break;
+  case SITE_XML_HASH:
+    _(site_read_xml_file_info_hash(info, text));
+    break;
+  case SITE_XML_HASH_SIZE:
+    _(site_read_xml_int16u(&u16, text));
+    _(gf_file_info_set_hash_size(info, u16));
+    break;
+  case SITE_XML_HASH_ALGORITHM:
+    _(gf_file_info_set_hash_algorithm(info, text));
+    break;
+  case SITE_XML_INODE:
+    _(site_read_xml_int64u(&u64, text));
+    _(gf_file_info_set_inode(info, u64));
+    break;
+  case SITE_XML_MODE:
+    _(site_read_xml_int16u_hex(&u16, text));
+    _(gf_file_info_set_mode(info, u16));
+    break;
+  case SITE_XML_LINK_COUNT:
+    _(site_read_xml_int16s(&s16, text));
+    _(gf_file_info_set_link_count(info, s16));
+    break;
+  case SITE_XML_UID:
+    _(site_read_xml_int16s(&s16, text));
+    _(gf_file_info_set_uid(info, s16));
+    break;
+  case SITE_XML_GID:
+    _(site_read_xml_int16s(&s16, text));
+    _(gf_file_info_set_gid(info, s16));
+    break;
+  case SITE_XML_DEVICE:
+    _(site_read_xml_int32u(&u32, text));
+    _(gf_file_info_set_device(info, u32));
+    break;
+  case SITE_XML_RDEVICE:
+    _(site_read_xml_int32u(&u32, text));
+    _(gf_file_info_set_rdevice(info, u32));
+    break;
+  case SITE_XML_FILE_SIZE:
+    _(site_read_xml_int64u(&u64, text));
+    _(gf_file_info_set_file_size(info, u64));
+    break;
+  case SITE_XML_ACCESS_TIME:
+    _(site_read_xml_int64u_hex(&u64, text));
+    _(gf_file_info_set_access_time(info, u64));
+    break;
+  case SITE_XML_MODIFY_TIME:
+    _(site_read_xml_int64u_hex(&u64, text));
+    _(gf_file_info_set_modify_time(info, u64));
+    break;
+  case SITE_XML_CREATE_TIME:
+    _(site_read_xml_int64u_hex(&u64, text));
+    _(gf_file_info_set_create_time(info, u64));
+    break;
+  default:
+    /* Unknown element - ignore */
+    assert(0);
+    break;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_file_info(site_xml_loader* loader, gf_file_info* info) {
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(info);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    const gf_char* text = NULL;
+
+    _(site_xml_read_text(loader, &text));
+    _(site_read_xml_file_info_field(info, name, text));
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_file_set(site_xml_loader* loader, gf_array* file_set) {
+  gf_status rc = 0;
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(file_set);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    if (name == SITE_XML_FILE_INFO) {
+      gf_file_info* info = NULL;
+
+      _(gf_file_info_new(&info, NULL, NULL));
+      rc = gf_array_add(file_set, (gf_any){ .ptr = info });
+      if (rc != GF_SUCCESS) {
+        gf_file_info_free(info);
+        gf_throw(rc);
+      }
+      _(site_read_xml_file_info(loader, info));
+    } else {
+      const gf_char* text = NULL;
+
+      _(site_xml_read_text(loader, &text));
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status site_read_xml_entry_set(
+  site_xml_loader* loader, site_taxonomy* taxonomy, gf_array* entry_set);
+
+/*!
+** @brief Read an element of an entry which is only in site.xml.
+*/
+
+static gf_status
+site_read_xml_entry_content(
+  site_xml_loader* loader, site_taxonomy* taxonomy, gf_entry* entry,
+  site_xml_name name) {
+  const gf_char* text = NULL;
+
+  switch (name) {
+  case SITE_XML_FILE_INFO:
+    if (!entry->file_info) {
+      _(gf_file_info_new(&entry->file_info, NULL, NULL));
+    }
+    _(site_read_xml_file_info(loader, entry->file_info));
+    break;
+  case SITE_XML_OUTPUT_PATH:
+    _(site_xml_read_text(loader, &text));
+    _(gf_path_set_string(entry->output_path, text));
+    break;
+  case SITE_XML_FILE_SET:
+    _(site_read_xml_file_set(loader, entry->file_set));
+    break;
+  case SITE_XML_CHILDREN:
+    _(site_read_xml_entry_set(loader, taxonomy, entry->children));
+    break;
+  default:
+    /* Unknown element - ignore */
+    assert(0);
+    _(site_xml_read_text(loader, &text));
+    break;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_xml_entry(
+  site_xml_loader* loader, site_taxonomy* taxonomy, gf_array* entry_set) {
+  gf_status rc = 0;
+  gf_entry* entry = NULL;
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(entry_set);
+
+  rc = entry_new(&entry, taxonomy);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
+  if (rc != GF_SUCCESS) {
+    gf_entry_free(entry);
+    gf_throw(rc);
+  }
+  /* Process children */
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    gf_bool found = GF_FALSE;
+
+    _(site_read_xml_entry_info(loader, entry, name, &found));
+    if (!found) {
+      _(site_read_xml_entry_content(loader, taxonomy, entry, name));
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the entry elements under the element.
+*/
+
+static gf_status
+site_read_xml_entry_set(
+  site_xml_loader* loader, site_taxonomy* taxonomy, gf_array* entry_set) {
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+
+  gf_validate(loader);
+  gf_validate(entry_set);
+
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    if (name != SITE_XML_ENTRY) {
+      gf_raise(GF_E_DATA, "Invalid site file.");
+    }
+    _(site_read_xml_entry(loader, taxonomy, entry_set));
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_content(site_xml_loader* loader, gf_site* site) {
+  gf_status rc = 0;
+  xmlChar* prop = NULL;
+  int depth = 0;
+  site_xml_name name = SITE_XML_NONE;
+  const gf_char* text = NULL;
+
+  gf_validate(loader);
+  gf_validate(site);
+
+  _(entry_move_to_element(loader->reader, 0));
+  if (site_xml_get_name(loader) != SITE_XML_SITE) {
+    gf_raise(GF_E_DATA, "Invalid site file.");
+  }
+  /* The site files written before the scan time was recorded lack it */
+  prop = xmlTextReaderGetAttribute(loader->reader, BAD_CAST"scan-time");
+  if (prop) {
+    rc = site_read_xml_int64u_hex(&site->scan_time, (const gf_char*)prop);
+    xmlFree(prop);
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
+  }
+  assert(site->entry_set);
+  _(site_xml_first_child(loader, &depth, &name));
+  while (name != SITE_XML_NONE) {
+    if (name == SITE_XML_ENTRY) {
+      _(site_read_xml_entry(loader, site->taxonomy, site->entry_set));
+    } else if (name == SITE_XML_INDICES) {
+      /* Skipped, and rebuilt from the entries */
+      _(site_xml_read_text(loader, &text));
+    } else {
+      gf_raise(GF_E_DATA, "Invalid site file.");
+    }
+    _(site_xml_next_child(loader, depth, &name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_read_file(gf_site* site, const gf_path* path) {
+  gf_status rc = 0;
+  site_xml_loader loader;
+
+#ifdef GF_DEBUG_
+  /* The errors are reported, but the blank nodes are dropped as usual */
+  static const int option = XML_PARSE_NOBLANKS;
+#else
+  static const int option = GF_XML_PARSE_OPTIONS;
+#endif
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(site_open_xml_loader(&loader, path, option));
+  rc = site_read_content(&loader, site);
+  site_close_xml_loader(&loader);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  _(site_build_indices(site));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_read_file(gf_site** site, const gf_path* path) {
+  gf_status rc = 0;
+  gf_site* tmp = NULL;
+  
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+  
+  _(gf_site_new(&tmp));
+  
+  rc = site_read_file(tmp, path);
+  if (rc != GF_SUCCESS) {
+    gf_site_free(tmp);
+    gf_throw(rc);
+  }
+
+  *site = tmp;
+
+  return GF_SUCCESS;
+}
+
+/* @} */
+
+static gf_status
+site_add_file_info_to_map(gf_map* map, gf_file_info* info) {
+  const gf_char* full_path = NULL;
+
+  _(gf_file_info_get_full_path(info, &full_path));
+  if (!gf_strnull(full_path)) {
+    _(gf_map_set(map, full_path, (gf_any){ .ptr = info }));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_collect_entry_file_info(gf_map* map, const gf_array* entry_set) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(entry_set);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_entry* entry = NULL;
+
+    _(gf_array_get(entry_set, i, &any));
+    entry = any.ptr;
+    if (!entry) {
+      continue;
+    }
+    _(entry_load(entry, ENTRY_PENDING_ALL));
+    if (entry->file_info) {
+      _(site_add_file_info_to_map(map, entry->file_info));
+    }
+    for (gf_size_t j = 0; j < gf_array_size(entry->file_set); j++) {
+      _(gf_array_get(entry->file_set, j, &any));
+      _(site_add_file_info_to_map(map, (gf_file_info*)any.ptr));
+    }
+    _(site_collect_entry_file_info(map, entry->children));
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_64u
+gf_site_get_scan_time(const gf_site* site) {
+  return site ? site->scan_time : 0;
+}
+
+gf_status
+gf_site_collect_file_info(const gf_site* site, gf_map* map) {
+  gf_validate(site);
+  gf_validate(map);
+
+  _(site_collect_entry_file_info(map, site->entry_set));
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+/*!
+** @defgroup UpdateSite Updating a resident gf_site object.
+*/
+/* @{ */
+
+/*!
+** @brief Get the length of the directory part of the entry file path.
+**
+** For "/a/b/index.dbk", the length of "/a/b/" is returned.
+*/
+
+static gf_size_t
+site_get_entry_directory_length(const gf_entry* entry) {
+  const gf_char* full_path = NULL;
+  const gf_char* sep = NULL;
+
+  full_path = gf_entry_get_full_path_string(entry);
+  if (gf_strnull(full_path)) {
+    return 0;
+  }
+  sep = strrchr(full_path, GF_PATH_SEPARATOR_CHAR);
+  if (!sep) {
+    return 0;
+  }
+
+  return (gf_size_t)(sep - full_path) + 1;
+}
+
+static gf_bool
+site_does_entry_contain(const gf_entry* entry, const gf_char* full_path) {
+  gf_size_t len = 0;
+
+  len = site_get_entry_directory_length(entry);
+  if (len == 0) {
+    return GF_FALSE;
+  }
+  if (strncmp(gf_entry_get_full_path_string(entry), full_path, len)) {
+    return GF_FALSE;
+  }
+
+  return GF_TRUE;
+}
+
+gf_status
+gf_site_find_entries(
+  gf_site* site, const gf_char* full_path, gf_array* entries) {
+  gf_entry* entry = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_strnull(full_path));
+  gf_validate(entries);
+
+  _(gf_site_get_root_entry(site, &entry));
+  while (entry && site_does_entry_contain(entry, full_path)) {
+    gf_entry* next = NULL;
+
+    _(gf_array_add(entries, (gf_any){ .ptr = entry }));
+    for (gf_size_t i = 0; i < gf_entry_count_children(entry); i++) {
+      gf_entry* child = NULL;
+
+      _(gf_entry_get_child(entry, i, &child));
+      if (site_does_entry_contain(child, full_path)) {
+        next = child;
+        break;
+      }
+    }
+    entry = next;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Check whether the path is in the config directory
+*/
+
+static gf_bool
+site_is_config_path(const gf_char* full_path) {
+  static const gf_char name[] = GF_CONFIG_DIRECTORY;
+  const gf_char* cur = full_path;
+
+  while ((cur = strchr(cur, GF_PATH_SEPARATOR_CHAR)) != NULL) {
+    cur++;
+    if (!strncmp(cur, name, sizeof(name) - 1) &&
+        (cur[sizeof(name) - 1] == GF_PATH_SEPARATOR_CHAR ||
+         cur[sizeof(name) - 1] == '\0')) {
+      return GF_TRUE;
+    }
+  }
+
+  return GF_FALSE;
+}
+
+/*!
+** @brief Check whether a directory between the entry and the file has an
+** entry file.
+**
+** Such a file is not a part of the entry (see site_collect_file_info()).
+*/
+
+static gf_bool
+site_is_file_in_other_entry(
+  const gf_entry* entry, const gf_path* root, const gf_char* full_path) {
+  static const gf_char* const names[] = { "index.dbk", "meta.gf" };
+  gf_size_t len = 0;
+  gf_char* dir = NULL;
+  gf_bool ret = GF_FALSE;
+
+  len = site_get_entry_directory_length(entry);
+  if (gf_strdup(&dir, full_path) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+  for (gf_char* sep = strchr(dir + len, GF_PATH_SEPARATOR_CHAR);
+       sep && !ret; sep = strchr(sep + 1, GF_PATH_SEPARATOR_CHAR)) {
+    *sep = '\0';
+    for (gf_size_t i = 0; i < gf_countof(names) && !ret; i++) {
+      gf_path* path = NULL;
+      gf_path* file = NULL;
+
+      if (gf_path_append_string(&path, root, dir) != GF_SUCCESS) {
+        continue;
+      }
+      if (gf_path_append_string(&file, path, names[i]) == GF_SUCCESS) {
+        ret = gf_path_file_exists(file);
+        gf_path_free(file);
+      }
+      gf_path_free(path);
+    }
+    *sep = GF_PATH_SEPARATOR_CHAR;
+  }
+  gf_free(dir);
+
+  return ret;
+}
+
+static gf_bool
+site_find_file(
+  const gf_array* file_set, const gf_char* full_path, gf_size_t* index) {
+  for (gf_size_t i = 0; i < gf_array_size(file_set); i++) {
+    gf_any any = { 0 };
+    const gf_char* path = NULL;
+
+    if (gf_array_get(file_set, i, &any) != GF_SUCCESS) {
+      continue;
+    }
+    if (gf_file_info_get_full_path(any.ptr, &path) != GF_SUCCESS) {
+      continue;
+    }
+    if (!gf_strnull(path) && !strcmp(path, full_path)) {
+      *index = i;
+      return GF_TRUE;
+    }
+  }
+
+  return GF_FALSE;
+}
+
+static gf_status
+site_update_entry_file(
+  gf_entry* entry, const gf_path* root, const gf_path* path,
+  const gf_char* full_path, gf_site_change* change) {
+  gf_bool changed = GF_FALSE;
+  gf_size_t index = 0;
+
+  if (strcmp(full_path, gf_entry_get_full_path_string(entry)) ||
+      !gf_path_file_exists(path)) {
+    /* An entry is added or removed, or its type is changed */
+    *change = GF_SITE_CHANGE_STRUCTURE;
+    return GF_SUCCESS;
+  }
+  _(gf_file_info_refresh(entry->file_info, path, &changed));
+  if (!changed) {
+    return GF_SUCCESS;
+  }
+  /* The file set has a copy of the entry file */
+  if (site_find_file(entry->file_set, full_path, &index)) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entry->file_set, index, &any));
+    _(gf_file_info_copy(any.ptr, entry->file_info));
+  }
+  _(entry_reset_info(entry));
+  _(entry_set_info(entry, root));
+  *change = GF_SITE_CHANGE_ENTRY;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_add_file(
+  gf_entry* entry, const gf_path* path, const gf_char* full_path) {
+  gf_status rc = 0;
+  gf_file_info* info = NULL;
+  const gf_char* name = NULL;
+  const gf_char* algorithm = NULL;
+  gf_bool changed = GF_FALSE;
+
+  name = strrchr(full_path, GF_PATH_SEPARATOR_CHAR);
+  name = name ? name + 1 : full_path;
+  /* The file is hashed with the algorithm of the entry file */
+  if (entry->file_info) {
+    _(gf_file_info_get_hash_algorithm(entry->file_info, &algorithm));
+  }
+
+  _(gf_file_info_new(&info, NULL, NULL));
+  rc = gf_file_info_set_full_path(info, full_path);
+  if (rc == GF_SUCCESS) {
+    rc = gf_file_info_set_file_name(info, name);
+  }
+  if (rc == GF_SUCCESS && !gf_strnull(algorithm)) {
+    rc = gf_file_info_set_hash_algorithm(info, algorithm);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_file_info_refresh(info, path, &changed);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_add(entry->file_set, (gf_any){ .ptr = info });
+  }
+  if (rc != GF_SUCCESS) {
+    gf_file_info_free(info);
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_update_asset_file(
+  gf_entry* entry, const gf_path* root, const gf_path* path,
+  const gf_char* full_path, gf_site_change* change) {
+  gf_size_t index = 0;
+  gf_bool found = GF_FALSE;
+  gf_bool exists = GF_FALSE;
+
+  found = site_find_file(entry->file_set, full_path, &index);
+  exists = gf_path_file_exists(path);
+
+  if (exists && gf_path_is_directory(path)) {
+    /* A directory may contain entries */
+    *change = GF_SITE_CHANGE_STRUCTURE;
+  } else if (found && !exists) {
+    _(gf_array_remove(entry->file_set, index));
+    *change = GF_SITE_CHANGE_FILE;
+  } else if (found) {
+    gf_any any = { 0 };
+    gf_bool changed = GF_FALSE;
+
+    _(gf_array_get(entry->file_set, index, &any));
+    _(gf_file_info_refresh(any.ptr, path, &changed));
+    if (changed) {
+      *change = GF_SITE_CHANGE_FILE;
+    }
+  } else if (exists && !site_is_file_in_other_entry(entry, root, full_path)) {
+    _(site_add_file(entry, path, full_path));
+    *change = GF_SITE_CHANGE_FILE;
+  } else {
+    /* A temporary file has come and gone */
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_update_file(
+  gf_site* site, const gf_path* root, const gf_char* full_path,
+  gf_entry** entry, gf_site_change* change) {
+  gf_status rc = 0;
+  gf_array* lineage = NULL;
+  gf_entry* owner = NULL;
+  gf_path* path = NULL;
+  const gf_char* name = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(root));
+  gf_validate(!gf_strnull(full_path));
+  gf_validate(entry);
+  gf_validate(change);
+
+  *entry = NULL;
+  *change = GF_SITE_CHANGE_NONE;
+
+  if (site_is_config_path(full_path)) {
+    return GF_SUCCESS;
+  }
+  /* The indices are updated below */
+  if (site->db) {
+    _(site_load(site));
+  }
+  /* The saved records are the base of the next journal */
+  site_db_state_capture(site);
+  /* The deepest entry including the file */
+  _(gf_array_new(&lineage));
+  rc = gf_site_find_entries(site, full_path, lineage);
+  if (rc == GF_SUCCESS && gf_array_size(lineage) > 0) {
+    gf_any any = { 0 };
+
+    rc = gf_array_get(lineage, gf_array_size(lineage) - 1, &any);
+    owner = any.ptr;
+  }
+  gf_array_free(lineage);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  if (!owner) {
+    *change = GF_SITE_CHANGE_STRUCTURE;
+    return GF_SUCCESS;
+  }
+
+  _(gf_path_append_string(&path, root, full_path));
+  name = strrchr(full_path, GF_PATH_SEPARATOR_CHAR);
+  name = name ? name + 1 : full_path;
+  if (!strcmp(name, "index.dbk") || !strcmp(name, "meta.gf")) {
+    /* The entry is moved in the indices, whose order may depend on it */
+    rc = site_unlink_entry(site, owner);
+    if (rc == GF_SUCCESS) {
+      gf_status ret = 0;
+
+      rc = site_update_entry_file(owner, root, path, full_path, change);
+      ret = site_link_entry(site, owner);
+      if (rc == GF_SUCCESS) {
+        rc = ret;
+      }
+    }
+  } else {
+    rc = site_update_asset_file(owner, root, path, full_path, change);
+  }
+  gf_path_free(path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  *entry = owner;
+
+  return GF_SUCCESS;
+}
+
+gf_site_file_role
+gf_site_get_file_role(const gf_entry* entry, const gf_char* full_path) {
+  static const gf_char name[] = "_" GF_PATH_SEPARATOR;
+  const gf_char* entry_path = NULL;
+  gf_size_t len = 0;
+
+  if (!entry || gf_strnull(full_path)) {
+    return GF_SITE_FILE_NONE;
+  }
+  entry_path = gf_entry_get_full_path_string(entry);
+  len = site_get_entry_directory_length(entry);
+  if (len == 0 || strncmp(entry_path, full_path, len)) {
+    return GF_SITE_FILE_NONE;
+  }
+  if (!strcmp(entry_path, full_path)) {
+    if (gf_entry_is_document(entry)) {
+      return GF_SITE_FILE_DOCUMENT;
+    }
+    if (gf_entry_is_section(entry)) {
+      return GF_SITE_FILE_SECTION;
+    }
+  }
+  if (!strncmp(full_path + len, name, sizeof(name) - 1)) {
+    return GF_SITE_FILE_STATIC;
+  }
+
+  return GF_SITE_FILE_ASSET;
+}
+
+gf_bool
+gf_site_get_style_method(
+  const gf_char* path, gf_char* method, gf_size_t size) {
+  static const gf_char ext[] = ".xsl";
+  gf_size_t len = 0;
+
+  if (gf_strnull(path) || path[0] != GF_PATH_SEPARATOR_CHAR) {
+    return GF_FALSE;
+  }
+  path += 1;
+  len = gf_strlen(path);
+  if (len <= sizeof(ext) - 1 || strcmp(path + len - (sizeof(ext) - 1), ext) ||
+      strchr(path, GF_PATH_SEPARATOR_CHAR)) {
+    return GF_FALSE;
+  }
+  len -= sizeof(ext) - 1;
+  if (method) {
+    if (size <= len) {
+      return GF_FALSE;
+    }
+    memcpy(method, path, len);
+    method[len] = '\0';
+  }
+
+  return GF_TRUE;
+}
+
+/* @} */
+
+/* -------------------------------------------------------------------------- */
+/*!
+** @defgroup DiffSite Computing the differences between two sites.
+*/
+/* @{ */
+
+struct gf_site_change_set {
+  gf_array* items;              ///< Array of gf_site_diff_item objects
+};
 
-    gf_string_set(str, (gf_char*)txt->content);
-    if (rc != GF_SUCCESS) {
-      gf_string_free(str);
-      gf_category_free(cat);
-      gf_throw(rc);
-    }
-    rc = gf_category_set_name(cat, str);
-    gf_string_free(str);
-    if (rc != GF_SUCCESS) {
-      gf_category_free(cat);
-      gf_throw(rc);
+/*!
+** @brief The entries and the files of a site indexed by the full path.
+**
+** An entry is indexed by the full path of its entry file. The entries and
+** the file records are owned by the site object.
+*/
+
+typedef struct site_diff_index {
+  gf_array* files;              ///< The file records in the order of the tree
+  gf_map*   paths;              ///< The full path to the file record
+  gf_map*   owners;             ///< The full path to the entry of the file
+  gf_array* entries;            ///< The entries in the order of the tree
+  gf_map*   entry_paths;        ///< The path of the entry file to the entry
+} site_diff_index;
+
+static void
+site_diff_item_free(gf_any* any) {
+  gf_site_diff_item* item = NULL;
+
+  if (any && any->ptr) {
+    item = any->ptr;
+    if (item->path) {
+      gf_free(item->path);
     }
-    rc = gf_array_add(value, (gf_any){ .ptr = cat });
-    if (rc != GF_SUCCESS) {
-      gf_category_free(cat);
-      gf_throw(rc);
+    if (item->old_path) {
+      gf_free(item->old_path);
     }
+    gf_free(item);
+    any->ptr = NULL;
   }
-
-  return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_string(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, const gf_char*)) {
+void
+gf_site_change_set_free(gf_site_change_set* changes) {
+  if (changes) {
+    if (changes->items) {
+      gf_array_free(changes->items);
+      changes->items = NULL;
+    }
+    gf_free(changes);
+  }
+}
 
+static gf_status
+site_change_set_new(gf_site_change_set** changes) {
   gf_status rc = 0;
-  gf_string* str = NULL;
-
-  gf_validate(info);
-  gf_validate(str);
-  gf_validate(fn);
+  gf_site_change_set* tmp = NULL;
 
-  _(gf_string_new(&str));
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->items = NULL;
 
-  rc = site_read_xml_string(str, node);
+  rc = gf_array_new(&tmp->items);
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_set_free_fn(tmp->items, site_diff_item_free);
+  }
   if (rc != GF_SUCCESS) {
-    gf_string_free(str);
+    gf_site_change_set_free(tmp);
     gf_throw(rc);
   }
-  rc = fn(info, gf_string_get(str));
-  gf_string_free(str);
+  *changes = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_change_set_add(
+  gf_site_change_set* changes, gf_site_diff_target target,
+  gf_site_diff_type type, gf_bool entry, const gf_char* path,
+  const gf_char* old_path) {
+  gf_status rc = 0;
+  gf_site_diff_item* item = NULL;
+
+  _(gf_malloc((gf_ptr*)&item, sizeof(*item)));
+  item->target = target;
+  item->type = type;
+  item->entry = entry;
+  item->path = NULL;
+  item->old_path = NULL;
+
+  rc = gf_strdup(&item->path, path);
+  if (rc == GF_SUCCESS && old_path) {
+    rc = gf_strdup(&item->old_path, old_path);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_add(changes->items, (gf_any){ .ptr = item });
+  }
   if (rc != GF_SUCCESS) {
+    site_diff_item_free(&(gf_any){ .ptr = item });
     gf_throw(rc);
   }
 
   return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_int16u(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_16u)) {
-  gf_16u n = 0;
+gf_size_t
+gf_site_change_set_size(const gf_site_change_set* changes) {
+  return changes ? gf_array_size(changes->items) : 0;
+}
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+gf_size_t
+gf_site_change_set_count(
+  const gf_site_change_set* changes, gf_site_diff_target target,
+  gf_site_diff_type type) {
+  gf_size_t cnt = 0;
 
-  _(site_read_xml_int16u(&n, node));
-  _(fn(info, n));
+  for (gf_size_t i = 0; i < gf_site_change_set_size(changes); i++) {
+    gf_any any = { 0 };
+    const gf_site_diff_item* item = NULL;
 
-  return GF_SUCCESS;
+    if (gf_array_get(changes->items, i, &any) != GF_SUCCESS) {
+      continue;
+    }
+    item = any.ptr;
+    if (item->target == target && item->type == type) {
+      cnt++;
+    }
+  }
+
+  return cnt;
 }
 
 gf_status
-site_read_xml_file_info_int16u_hex(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_16u)) {
-  gf_16u n = 0;
+gf_site_change_set_get(
+  const gf_site_change_set* changes, gf_size_t index,
+  const gf_site_diff_item** item) {
+  gf_any any = { 0 };
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+  gf_validate(changes);
+  gf_validate(item);
 
-  _(site_read_xml_int16u_hex(&n, node));
-  _(fn(info, n));
+  _(gf_array_get(changes->items, index, &any));
+  *item = any.ptr;
 
   return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_int16s(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_16s)) {
-  gf_16s n = 0;
+/* -------------------------------------------------------------------------- */
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+static void
+site_diff_index_clear(site_diff_index* index) {
+  if (index->files) {
+    gf_array_free(index->files);
+    index->files = NULL;
+  }
+  if (index->paths) {
+    gf_map_free(index->paths);
+    index->paths = NULL;
+  }
+  if (index->owners) {
+    gf_map_free(index->owners);
+    index->owners = NULL;
+  }
+  if (index->entries) {
+    gf_array_free(index->entries);
+    index->entries = NULL;
+  }
+  if (index->entry_paths) {
+    gf_map_free(index->entry_paths);
+    index->entry_paths = NULL;
+  }
+}
+
+static gf_status
+site_diff_index_add(
+  site_diff_index* index, gf_file_info* info, gf_entry* entry) {
+  const gf_char* full_path = NULL;
 
-  _(site_read_xml_int16s(&n, node));
-  _(fn(info, n));
+  _(gf_file_info_get_full_path(info, &full_path));
+  if (gf_strnull(full_path)) {
+    return GF_SUCCESS;
+  }
+  if (!gf_map_find(index->paths, full_path, NULL)) {
+    _(gf_map_set(index->paths, full_path, (gf_any){ .ptr = info }));
+    _(gf_map_set(index->owners, full_path, (gf_any){ .ptr = entry }));
+    _(gf_array_add(index->files, (gf_any){ .ptr = info }));
+  }
 
   return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_int32u(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_32u)) {
-  gf_32u n = 0;
-
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+static gf_status
+site_diff_index_add_entry(site_diff_index* index, gf_entry* entry) {
+  const gf_char* full_path = NULL;
 
-  _(site_read_xml_int32u(&n, node));
-  _(fn(info, n));
+  full_path = gf_entry_get_full_path_string(entry);
+  if (gf_strnull(full_path) ||
+      gf_map_find(index->entry_paths, full_path, NULL)) {
+    return GF_SUCCESS;
+  }
+  _(gf_map_set(index->entry_paths, full_path, (gf_any){ .ptr = entry }));
+  _(gf_array_add(index->entries, (gf_any){ .ptr = entry }));
+  /* The entry file is listed in the file set as well */
+  _(site_diff_index_add(index, entry->file_info, entry));
 
   return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_int64u(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_64u)) {
-  gf_64u n = 0;
+static gf_status
+site_diff_index_entries(site_diff_index* index, const gf_array* entry_set) {
+  for (gf_size_t i = 0; i < gf_array_size(entry_set); i++) {
+    gf_any any = { 0 };
+    gf_entry* entry = NULL;
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+    _(gf_array_get(entry_set, i, &any));
+    entry = any.ptr;
+    if (!entry) {
+      continue;
+    }
+    _(entry_load(entry, ENTRY_PENDING_ALL));
+    if (entry->file_info) {
+      _(site_diff_index_add_entry(index, entry));
+    }
+    for (gf_size_t j = 0; j < gf_array_size(entry->file_set); j++) {
+      _(gf_array_get(entry->file_set, j, &any));
+      _(site_diff_index_add(index, (gf_file_info*)any.ptr, entry));
+    }
+    _(site_diff_index_entries(index, entry->children));
+  }
+
+  return GF_SUCCESS;
+}
 
-  _(site_read_xml_int64u(&n, node));
-  _(fn(info, n));
+static gf_status
+site_diff_index_site(site_diff_index* index, const gf_site* site) {
+  gf_status rc = 0;
+
+  rc = gf_array_new(&index->files);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_new(&index->paths);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_new(&index->owners);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_array_new(&index->entries);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_new(&index->entry_paths);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_diff_index_entries(index, site->entry_set);
+  }
+  if (rc != GF_SUCCESS) {
+    site_diff_index_clear(index);
+    gf_throw(rc);
+  }
 
   return GF_SUCCESS;
 }
 
-gf_status
-site_read_xml_file_info_int64u_hex(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_64u)) {
-  gf_64u n = 0;
+/*!
+** @brief The objects of the index compared as the specified target.
+*/
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+static const gf_array*
+site_diff_index_list(
+  const site_diff_index* index, gf_site_diff_target target) {
+  return target == GF_SITE_DIFF_ENTRY ? index->entries : index->files;
+}
 
-  _(site_read_xml_int64u_hex(&n, node));
-  _(fn(info, n));
+static const gf_map*
+site_diff_index_paths(
+  const site_diff_index* index, gf_site_diff_target target) {
+  return target == GF_SITE_DIFF_ENTRY ? index->entry_paths : index->paths;
+}
 
-  return GF_SUCCESS;
+/*!
+** @brief The file record which identifies an object of the index.
+*/
+
+static const gf_file_info*
+site_diff_get_file_info(gf_site_diff_target target, gf_ptr ptr) {
+  return target == GF_SITE_DIFF_ENTRY ? ((gf_entry*)ptr)->file_info : ptr;
 }
 
-gf_status
-site_read_xml_file_info_hash(
-  gf_file_info* info, const xmlNodePtr node,
-  gf_status (*fn)(gf_file_info*, gf_size_t, gf_8u*)) {
+/*!
+** @brief Check whether the contents of two file records are the same.
+**
+** The fingerprints are compared if they are computed with the same algorithm.
+** Otherwise the size and the modification time are compared.
+*/
 
-  gf_16u size = 0;
+static gf_bool
+site_diff_is_same_content(const gf_file_info* lhs, const gf_file_info* rhs) {
+  const gf_char* lhs_algo = NULL;
+  const gf_char* rhs_algo = NULL;
+  gf_16u lhs_size = 0;
+  gf_16u rhs_size = 0;
+  gf_8u lhs_hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u rhs_hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_64u lhs_value = 0;
+  gf_64u rhs_value = 0;
+
+  (void)gf_file_info_get_file_size(lhs, &lhs_value);
+  (void)gf_file_info_get_file_size(rhs, &rhs_value);
+  if (lhs_value != rhs_value) {
+    return GF_FALSE;
+  }
+  (void)gf_file_info_get_hash_algorithm(lhs, &lhs_algo);
+  (void)gf_file_info_get_hash_algorithm(rhs, &rhs_algo);
+  (void)gf_file_info_get_hash_size(lhs, &lhs_size);
+  (void)gf_file_info_get_hash_size(rhs, &rhs_size);
+  if (gf_strnull(lhs_algo) || gf_strnull(rhs_algo) ||
+      strcmp(lhs_algo, rhs_algo) || lhs_size != rhs_size || lhs_size == 0) {
+    (void)gf_file_info_get_modify_time(lhs, &lhs_value);
+    (void)gf_file_info_get_modify_time(rhs, &rhs_value);
+    return lhs_value == rhs_value ? GF_TRUE : GF_FALSE;
+  }
+  (void)gf_file_info_get_hash(lhs, sizeof(lhs_hash), lhs_hash);
+  (void)gf_file_info_get_hash(rhs, sizeof(rhs_hash), rhs_hash);
 
-  gf_validate(info);
-  gf_validate(node);
-  gf_validate(fn);
+  return !memcmp(lhs_hash, rhs_hash, lhs_size) ? GF_TRUE : GF_FALSE;
+}
 
-  _(gf_file_info_get_hash_size(info, &size));
-  _(fn(info, size, (gf_8u*)node->content));
+/*!
+** @brief Check whether an entry has the same files in two sites.
+**
+** The entry file is compared as well, since it is in the file set. A file
+** which belonged to another entry of the old site is regarded as changed.
+*/
 
-  return GF_SUCCESS;
+static gf_bool
+site_diff_is_same_entry(
+  const site_diff_index* old_index, const gf_entry* old_entry,
+  const gf_entry* new_entry) {
+  if (!site_diff_is_same_content(old_entry->file_info, new_entry->file_info) ||
+      gf_array_size(old_entry->file_set) !=
+      gf_array_size(new_entry->file_set)) {
+    return GF_FALSE;
+  }
+  for (gf_size_t i = 0; i < gf_array_size(new_entry->file_set); i++) {
+    gf_any any = { 0 };
+    gf_any old = { 0 };
+    gf_any owner = { 0 };
+    const gf_char* full_path = NULL;
+
+    if (gf_array_get(new_entry->file_set, i, &any) != GF_SUCCESS ||
+        gf_file_info_get_full_path(any.ptr, &full_path) != GF_SUCCESS ||
+        !gf_map_find(old_index->owners, full_path, &owner) ||
+        owner.ptr != old_entry ||
+        !gf_map_find(old_index->paths, full_path, &old) ||
+        !site_diff_is_same_content(old.ptr, any.ptr)) {
+      return GF_FALSE;
+    }
+  }
+
+  return GF_TRUE;
 }
 
+/*!
+** @brief Index the removed entries or files by their content.
+**
+** Only the first one of the removed objects of the same content is indexed;
+** the others are reported as removed.
+*/
+
 static gf_status
-site_read_xml_file_info(gf_file_info* info, const xmlNodePtr node) {
-  gf_validate(info);
-  gf_validate(node);
+site_diff_index_removed(
+  gf_map* removed, gf_site_diff_target target,
+  const site_diff_index* old_index, const site_diff_index* new_index) {
+  const gf_array* list = site_diff_index_list(old_index, target);
+  const gf_map* paths = site_diff_index_paths(new_index, target);
 
-  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-    if (!xmlStrcmp(cur->name, BAD_CAST"file-name")) {
-      _(site_read_xml_file_info_string(
-          info, cur->children, gf_file_info_set_file_name));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"full-path")) {
-      _(site_read_xml_file_info_string(
-          info, cur->children, gf_file_info_set_full_path));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"hash")) {
-      _(site_read_xml_file_info_hash(
-          info, cur->children, gf_file_info_set_hash_string));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"hash-size")) {
-      _(site_read_xml_file_info_int16u(
-          info, cur->children, gf_file_info_set_hash_size));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"inode")) {
-      _(site_read_xml_file_info_int16u(
-          info, cur->children, gf_file_info_set_inode));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"mode")) {
-      _(site_read_xml_file_info_int16u_hex(
-          info, cur->children, gf_file_info_set_mode));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"link-count")) {
-      _(site_read_xml_file_info_int16s(
-          info, cur->children, gf_file_info_set_link_count));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"uid")) {
-      _(site_read_xml_file_info_int16s(
-          info, cur->children, gf_file_info_set_uid));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"gid")) {
-      _(site_read_xml_file_info_int16s(
-          info, cur->children, gf_file_info_set_gid));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"device")) {
-      _(site_read_xml_file_info_int32u(
-          info, cur->children, gf_file_info_set_device));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"rdevice")) {
-      _(site_read_xml_file_info_int32u(
-          info, cur->children, gf_file_info_set_rdevice));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"file-size")) {
-      _(site_read_xml_file_info_int64u(
-          info, cur->children, gf_file_info_set_file_size));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"access-time")) {
-      _(site_read_xml_file_info_int64u_hex(
-          info, cur->children, gf_file_info_set_access_time));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"modify-time")) {
-      _(site_read_xml_file_info_int64u_hex(
-          info, cur->children, gf_file_info_set_modify_time));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"create-time")) {
-      _(site_read_xml_file_info_int64u_hex(
-          info, cur->children, gf_file_info_set_create_time));
-    } else {
-      /* Unknown element - ignore */
-      assert(0);
+  for (gf_size_t i = 0; i < gf_array_size(list); i++) {
+    gf_any any = { 0 };
+    const gf_file_info* info = NULL;
+    const gf_char* full_path = NULL;
+    gf_char key[SITE_CONTENT_KEY_SIZE] = { 0 };
+
+    _(gf_array_get(list, i, &any));
+    info = site_diff_get_file_info(target, any.ptr);
+    _(gf_file_info_get_full_path(info, &full_path));
+    if (gf_map_find(paths, full_path, NULL)) {
+      continue;
+    }
+    if (site_make_content_key(info, sizeof(key), key) &&
+        !gf_map_find(removed, key, NULL)) {
+      _(gf_map_set(removed, key, (gf_any){ .ptr = (gf_ptr)info }));
     }
   }
 
@@ -2254,145 +4592,212 @@ site_read_xml_file_info(gf_file_info* info, const xmlNodePtr node) {
 }
 
 static gf_status
-site_read_xml_file_set(gf_array* file_set, const xmlNodePtr node) {
-  gf_status rc = 0;
+site_diff_added(
+  gf_site_change_set* changes, gf_site_diff_target target, gf_map* removed,
+  gf_map* moved, const gf_file_info* info, gf_bool entry) {
+  const gf_char* full_path = NULL;
+  const gf_char* old_path = NULL;
+  gf_char key[SITE_CONTENT_KEY_SIZE] = { 0 };
+  gf_any any = { 0 };
 
-  gf_validate(file_set);
-  gf_validate(node);
-  
-  for (xmlNodePtr cur = node->children; cur; cur = cur->next) {
-    if (!xmlStrcmp(cur->name, BAD_CAST"file-info")) {
-      gf_file_info* info = NULL;
+  _(gf_file_info_get_full_path(info, &full_path));
+  if (site_make_content_key(info, sizeof(key), key) &&
+      gf_map_find(removed, key, &any)) {
+    _(gf_file_info_get_full_path(any.ptr, &old_path));
+    _(gf_map_remove(removed, key));
+    _(gf_map_set(moved, old_path, (gf_any){ .ptr = NULL }));
+    _(site_change_set_add(
+        changes, target, GF_SITE_DIFF_MOVED, entry, full_path, old_path));
+  } else {
+    _(site_change_set_add(
+        changes, target, GF_SITE_DIFF_ADDED, entry, full_path, NULL));
+  }
 
-      _(gf_file_info_new(&info, NULL, NULL));
-      rc = gf_array_add(file_set, (gf_any){ .ptr = info });
-      if (rc != GF_SUCCESS) {
-        gf_file_info_free(info);
-        gf_throw(rc);
-      }
+  return GF_SUCCESS;
+}
+
+static gf_bool
+site_diff_is_same(
+  gf_site_diff_target target, const site_diff_index* old_index,
+  gf_ptr old_ptr, gf_ptr new_ptr) {
+  if (target == GF_SITE_DIFF_ENTRY) {
+    return site_diff_is_same_entry(old_index, old_ptr, new_ptr);
+  }
+  return site_diff_is_same_content(old_ptr, new_ptr);
+}
+
+static gf_status
+site_diff_indices(
+  gf_site_change_set* changes, gf_site_diff_target target,
+  const site_diff_index* old_index, const site_diff_index* new_index,
+  gf_map* removed, gf_map* moved) {
+  const gf_array* old_list = site_diff_index_list(old_index, target);
+  const gf_array* new_list = site_diff_index_list(new_index, target);
+  const gf_map* old_paths = site_diff_index_paths(old_index, target);
+  const gf_map* new_paths = site_diff_index_paths(new_index, target);
+
+  _(site_diff_index_removed(removed, target, old_index, new_index));
+
+  /* Added, modified and moved objects in the order of the new site */
+  for (gf_size_t i = 0; i < gf_array_size(new_list); i++) {
+    gf_any any = { 0 };
+    gf_any old = { 0 };
+    const gf_file_info* info = NULL;
+    const gf_char* full_path = NULL;
+    gf_bool entry = GF_FALSE;
+
+    _(gf_array_get(new_list, i, &any));
+    info = site_diff_get_file_info(target, any.ptr);
+    _(gf_file_info_get_full_path(info, &full_path));
+    entry = gf_map_find(new_index->entry_paths, full_path, NULL);
+    if (!gf_map_find(old_paths, full_path, &old)) {
+      _(site_diff_added(changes, target, removed, moved, info, entry));
+    } else if (!site_diff_is_same(target, old_index, old.ptr, any.ptr)) {
+      _(site_change_set_add(
+          changes, target, GF_SITE_DIFF_MODIFIED, entry, full_path, NULL));
+    }
+  }
+  /* Removed objects in the order of the old site */
+  for (gf_size_t i = 0; i < gf_array_size(old_list); i++) {
+    gf_any any = { 0 };
+    const gf_file_info* info = NULL;
+    const gf_char* full_path = NULL;
+    gf_bool entry = GF_FALSE;
+
+    _(gf_array_get(old_list, i, &any));
+    info = site_diff_get_file_info(target, any.ptr);
+    _(gf_file_info_get_full_path(info, &full_path));
+    if (gf_map_find(new_paths, full_path, NULL) ||
+        gf_map_find(moved, full_path, NULL)) {
+      continue;
     }
+    entry = gf_map_find(old_index->entry_paths, full_path, NULL);
+    _(site_change_set_add(
+        changes, target, GF_SITE_DIFF_REMOVED, entry, full_path, NULL));
   }
 
   return GF_SUCCESS;
 }
 
 static gf_status
-site_read_xml_entry(gf_array* entry_set, const xmlNodePtr root) {
+site_diff_target(
+  gf_site_change_set* changes, gf_site_diff_target target,
+  const site_diff_index* old_index, const site_diff_index* new_index) {
   gf_status rc = 0;
-  gf_entry* entry = NULL;
-  
-  gf_validate(entry_set);
-  gf_validate(root);
+  gf_map* removed = NULL;
+  gf_map* moved = NULL;
 
-  if (!!xmlStrcmp(root->name, BAD_CAST"entry")) {
-    gf_raise(GF_E_DATA, "Invalid site file.");
+  rc = gf_map_new(&removed);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_new(&moved);
   }
-  rc = gf_entry_new(&entry);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
+  if (rc == GF_SUCCESS) {
+    rc = site_diff_indices(
+      changes, target, old_index, new_index, removed, moved);
   }
-  rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
+  gf_map_free(moved);
+  gf_map_free(removed);
   if (rc != GF_SUCCESS) {
-    gf_entry_free(entry);
     gf_throw(rc);
   }
-  /* Process children */
-  for (xmlNodePtr cur = root->children; cur; cur = cur->next) {
-    if (!xmlStrcmp(cur->name, BAD_CAST"type")) {
-      _(site_read_xml_int32u(&entry->type, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"state")) {
-      _(site_read_xml_int32u(&entry->state, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"title")) {
-      _(site_read_xml_string(entry->title, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"author")) {
-      _(site_read_xml_string(entry->author, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"date")) {
-      _(site_read_xml_date(&entry->date, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"description")) {
-      _(site_read_xml_description(entry->description, cur));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"file-info")) {
-      _(site_read_xml_file_info(entry->file_info, cur));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"method")) {
-      _(site_read_xml_string(entry->method, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"output-path")) {
-      _(site_read_xml_path(entry->output_path, cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"file-set")) {
-      _(site_read_xml_file_set(entry->file_set, cur));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"subject-set")) {
-      _(site_read_xml_category(
-          entry->subject_set, BAD_CAST"subject", cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"keyword-set")) {
-      _(site_read_xml_category(
-          entry->keyword_set, BAD_CAST"keyword", cur->children));
-    } else if (!xmlStrcmp(cur->name, BAD_CAST"children")) {
-      for (xmlNodePtr child = cur->children; child; child = child->next) {
-        _(site_read_xml_entry(entry->children, child));
-      }
-    } else {
-      /* Unknown element - ignore */
-      assert(0);
-    }
-  }
-  
+
   return GF_SUCCESS;
 }
 
-
-static gf_status
-site_read_file(gf_site* site, const gf_path* path) {
+gf_status
+gf_site_diff(
+  gf_site_change_set** changes, const gf_site* old_site,
+  const gf_site* new_site) {
   gf_status rc = 0;
-  xmlDocPtr doc = NULL;
-  xmlNodePtr root = NULL;
+  gf_site_change_set* tmp = NULL;
+  site_diff_index old_index = { 0 };
+  site_diff_index new_index = { 0 };
 
-#ifdef GF_DEBUG_
-  static const int option = 0;
-#else
-  static const int option = GF_XML_PARSE_OPTIONS;
-#endif
+  gf_validate(changes);
+  gf_validate(old_site);
+  gf_validate(new_site);
 
-  gf_validate(site);
-  gf_validate(!gf_path_is_empty(path));
-  
-  doc = xmlReadFile(gf_path_get_string(path), NULL, option);
-  if (!doc) {
-    gf_raise(GF_E_API, "Failed to read an XML file.");
+  _(site_change_set_new(&tmp));
+
+  rc = site_diff_index_site(&old_index, old_site);
+  if (rc == GF_SUCCESS) {
+    rc = site_diff_index_site(&new_index, new_site);
   }
-  root = xmlDocGetRootElement(doc);
-  if (!root) {
-    xmlFreeDoc(doc);
-    gf_raise(GF_E_API, "Failed to read an XML file.");
+  if (rc == GF_SUCCESS) {
+    rc = site_diff_target(tmp, GF_SITE_DIFF_ENTRY, &old_index, &new_index);
   }
-  if (!!xmlStrcmp(root->name, BAD_CAST"site")) {
-    gf_raise(GF_E_DATA, "Invalid site file.");
+  if (rc == GF_SUCCESS) {
+    rc = site_diff_target(tmp, GF_SITE_DIFF_FILE, &old_index, &new_index);
   }
-  root = root->children;
-  assert(site->entry_set);
-  rc = site_read_xml_entry(site->entry_set, root);
-  xmlFreeDoc(doc);
+  site_diff_index_clear(&new_index);
+  site_diff_index_clear(&old_index);
   if (rc != GF_SUCCESS) {
+    gf_site_change_set_free(tmp);
     gf_throw(rc);
   }
-  
+
+  *changes = tmp;
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static gf_status
+site_write_xml_diff_item(
+  xmlTextWriterPtr writer, const gf_site_diff_item* item) {
+  static const char* names[] = {
+    [GF_SITE_DIFF_ADDED]    = "added",
+    [GF_SITE_DIFF_REMOVED]  = "removed",
+    [GF_SITE_DIFF_MODIFIED] = "modified",
+    [GF_SITE_DIFF_MOVED]    = "moved",
+  };
+
+  if ((gf_size_t)item->type >= gf_countof(names) || !names[item->type]) {
+    gf_raise(GF_E_PARAM, "Unknown type of a change.");
+  }
+  _(site_write_xml_start(writer, names[item->type]));
+  if (item->target == GF_SITE_DIFF_ENTRY) {
+    _(site_write_xml_attribute(writer, "target", "entry"));
+  }
+  _(site_write_xml_attribute(writer, "path", item->path));
+  if (item->old_path) {
+    _(site_write_xml_attribute(writer, "from", item->old_path));
+  }
+  if (item->target == GF_SITE_DIFF_FILE && item->entry) {
+    _(site_write_xml_attribute(writer, "entry", "true"));
+  }
+  _(site_write_xml_end(writer));
+
   return GF_SUCCESS;
 }
 
 gf_status
-gf_site_read_file(gf_site** site, const gf_path* path) {
+gf_site_change_set_write_file(
+  const gf_site_change_set* changes, const gf_path* path) {
   gf_status rc = 0;
-  gf_site* tmp = NULL;
-  
-  gf_validate(site);
+  site_xml_stream stream;
+
+  gf_validate(changes);
   gf_validate(!gf_path_is_empty(path));
-  
-  _(gf_site_new(&tmp));
-  
-  rc = site_read_file(tmp, path);
-  gf_site_free(tmp);
-  if (rc != GF_SUCCESS) {
-    gf_throw(rc);
-  }
 
-  *site = tmp;
+  _(site_open_xml_stream(&stream, path));
+  rc = site_write_xml_start(stream.writer, "changes");
+  for (gf_size_t i = 0;
+       rc == GF_SUCCESS && i < gf_site_change_set_size(changes); i++) {
+    const gf_site_diff_item* item = NULL;
+
+    rc = gf_site_change_set_get(changes, i, &item);
+    if (rc == GF_SUCCESS) {
+      rc = site_write_xml_diff_item(stream.writer, item);
+    }
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_write_xml_end(stream.writer);
+  }
+  _(site_close_xml_stream(&stream, path, rc));
 
   return GF_SUCCESS;
 }
+
+/* @} */
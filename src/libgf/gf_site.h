@@ -18,7 +18,10 @@
 #include <libgf/gf_path.h>
 #include <libgf/gf_string.h>
 #include <libgf/gf_datetime.h>
+#include <libgf/gf_array.h>
+#include <libgf/gf_map.h>
 #include <libgf/gf_file_info.h>
+#include <libgf/gf_entry_cache.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,6 +56,17 @@ enum gf_entry_state {
 
 typedef enum gf_entry_state gf_entry_state;
 
+/*!
+** @brief Kinds of a gf_category object
+*/
+
+enum gf_category_kind {
+  GF_CATEGORY_SUBJECT = 0,  ///< A subject (subjectset in the entry file)
+  GF_CATEGORY_KEYWORD = 1,  ///< A keyword (keywordset in the entry file)
+};
+
+typedef enum gf_category_kind gf_category_kind;
+
 /* -------------------------------------------------------------------------- */
 
 /*!
@@ -85,6 +99,9 @@ extern gf_status gf_category_set_id(gf_category* cat, const gf_string* id);
 
 extern gf_status gf_category_set_name(gf_category* cat, const gf_string* name);
 
+extern const gf_char* gf_category_get_id_string(const gf_category* cat);
+extern const gf_char* gf_category_get_name_string(const gf_category* cat);
+
 /* -------------------------------------------------------------------------- */
 
 /*!
@@ -125,10 +142,47 @@ extern gf_bool gf_entry_is_section(const gf_entry* entry);
 
 extern gf_bool gf_entry_is_document(const gf_entry* entry);
 
+/*!
+** @brief Get the process type, which is the base name of the XSLT file.
+*/
+
+extern const gf_char* gf_entry_get_method_string(const gf_entry* entry);
+
+extern gf_entry_type gf_entry_get_type(const gf_entry* entry);
+extern gf_entry_state gf_entry_get_state(const gf_entry* entry);
+extern const gf_char* gf_entry_get_title_string(const gf_entry* entry);
+
+/*!
+** @brief The lists of an entry: the children, the files and the paragraphs
+** of the description.
+**
+** The lists of an entry of a site opened by gf_site_open() are read from the
+** database when an item is first got. Counting the items does not read them.
+*/
+
 extern gf_size_t gf_entry_count_children(const gf_entry* entry);
 extern gf_status gf_entry_get_child(
   gf_entry* entry, gf_size_t index, gf_entry** child);
 
+extern gf_size_t gf_entry_count_files(const gf_entry* entry);
+extern gf_status gf_entry_get_file(
+  gf_entry* entry, gf_size_t index, gf_file_info** info);
+
+extern gf_size_t gf_entry_count_paragraphs(const gf_entry* entry);
+extern gf_status gf_entry_get_paragraph_string(
+  gf_entry* entry, gf_size_t index, const gf_char** str);
+
+/*!
+** @brief The entries referring to a category of a site.
+**
+** The entries are listed in the order of the entry tree. The list is kept up
+** to date by gf_site_scan(), gf_site_read_file() and gf_site_update_file().
+*/
+
+extern gf_size_t gf_category_count_entries(const gf_category* cat);
+extern gf_status gf_category_get_entry(
+  const gf_category* cat, gf_size_t index, gf_entry** entry);
+
 /* -------------------------------------------------------------------------- */
 
 typedef struct gf_site gf_site;
@@ -156,6 +210,25 @@ extern gf_status gf_site_new(gf_site** site);
 
 extern gf_status gf_site_scan(gf_site** site, const gf_path* path);
 
+/*!
+** @brief Traverse the directory tree with the specified scan options.
+**
+** The entry files are read by option->threads threads. If @a cache is
+** specified, the entry files whose fingerprint is found in it are not read,
+** and the information of the others is added to it.
+**
+** @param [out] site   The pointer to the site object
+** @param [in]  path   The start point for traversing the files
+** @param [in]  option The options passed to gf_file_info_scan_with_option()
+** @param [in]  cache  The cache of the entry files (may be NULL)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_scan_with_option(
+  gf_site** site, const gf_path* path,
+  const gf_file_info_scan_option* option, gf_entry_cache* cache);
+
 /*!
 ** @brief Destruct a site object.
 **
@@ -177,6 +250,52 @@ extern gf_status gf_site_reset(gf_site* site);
 
 extern gf_status gf_site_get_root_entry(gf_site* site, gf_entry** entry);
 
+/*!
+** @brief Find a category of the site by its ID.
+**
+** Each category is stored once in the site, and the entries refer to it.
+** The entries of the category are listed by gf_category_get_entry().
+**
+** @param [in]  site The site object
+** @param [in]  kind The kind of the category
+** @param [in]  id   The ID string of the category
+** @param [out] cat  The category found (may be NULL)
+**
+** @return GF_TRUE if found, GF_FALSE otherwise.
+*/
+
+extern gf_bool gf_site_find_category(
+  const gf_site* site, gf_category_kind kind, const gf_char* id,
+  const gf_category** cat);
+
+/*!
+** @brief The entries of the site which have the date, newest first.
+**
+** The entries of the same date are in the order of the entry tree. The index
+** is kept up to date as the category lists are, and the site file has it in
+** the 'indices' element.
+*/
+
+extern gf_size_t gf_site_count_dated_entries(const gf_site* site);
+extern gf_status gf_site_get_dated_entry(
+  const gf_site* site, gf_size_t index, gf_entry** entry);
+
+/*!
+** @brief Find the group of the entries processed by a method.
+**
+** The group is a category whose ID and name are the method. Its entries are
+** listed by gf_category_get_entry() in the order of the entry tree.
+**
+** @param [in]  site   The site object
+** @param [in]  method The method string of the entries
+** @param [out] cat    The group found (may be NULL)
+**
+** @return GF_TRUE if found, GF_FALSE otherwise.
+*/
+
+extern gf_bool gf_site_find_method(
+  const gf_site* site, const gf_char* method, const gf_category** cat);
+
 /*!
 ** @brief Write directory information to specified file.
 **
@@ -199,6 +318,306 @@ extern gf_status gf_site_write_file(const gf_site* site, const gf_path* path);
 
 extern gf_status gf_site_read_file(gf_site** site, const gf_path* path);
 
+/*!
+** @brief Write the site to a site database (site.gfdb).
+**
+** The entries are stored in the preorder of the entry tree with their files
+** and categories. See gf_db.h for the layout. The journal of the old
+** database is removed.
+**
+** @param [in] site The pointer to the site object
+** @param [in] path The file path to be written
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_write_db(const gf_site* site, const gf_path* path);
+
+/*!
+** @brief Save a site to a site database, appending to its journal.
+**
+** The changes from @a prev, which is the site read from or last saved to
+** @a path, are appended to the journal of the database as the records of the
+** added or modified entries, the changed lists of the children, and the
+** removed entries. So a small change writes a few records instead of the
+** whole database. If @a prev is NULL, @a site itself is the base, which is
+** the case of a site updated in place by gf_site_update_file().
+**
+** The whole database is written instead, and the journal is removed, if the
+** base is not the current content of @a path, or the journal would grow over
+** @a ratio percent of the database (compaction). The journal is not used if
+** @a ratio is 0.
+**
+** @param [in, out] site  The pointer to the site object
+** @param [in]      prev  The site of the current database (may be NULL)
+** @param [in]      path  The file path of the database
+** @param [in]      ratio The maximum size of the journal in percent of the
+**                        database
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_save_db(
+  gf_site* site, const gf_site* prev, const gf_path* path, gf_size_t ratio);
+
+/*!
+** @brief Read a site from a site database written by gf_site_write_db().
+**
+** The records of the journal of the database are applied to the site.
+**
+** @param [out] site The pointer to the new site object
+** @param [in]  path The file path to be read
+**
+** @return GF_SUCCESS on success, GF_E_DATA if the database is broken or of
+**         another version, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_read_db(gf_site** site, const gf_path* path);
+
+/*!
+** @brief Open a site database to read the entries on demand.
+**
+** Unlike gf_site_read_db(), only the top-level entries are read at first.
+** The children, the files and the description of an entry are read when they
+** are first used through the gf_entry_get_* functions, or by the functions of
+** the site which need them, e.g. gf_site_write_file(). The database is kept
+** open until the site is freed. gf_site_find_category() and the other
+** functions of the indices read the whole site to list the entries. The
+** records of the journal are applied to each entry as it is read.
+**
+** The entries are read without a lock, so the site must not be used by more
+** than one thread at a time.
+**
+** @param [out] site The pointer to the new site object
+** @param [in]  path The file path of the database
+**
+** @return GF_SUCCESS on success, GF_E_DATA if the database is broken or of
+**         another version, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_open(gf_site** site, const gf_path* path);
+
+/*!
+** @brief Collect the file records of the site keyed by the full path.
+**
+** The records are owned by the site object, so the map must not outlive it
+** and must not have a free callback.
+**
+** @param [in]      site The pointer to the site object
+** @param [in, out] map  The map to which the records are added
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_collect_file_info(const gf_site* site, gf_map* map);
+
+/*!
+** @brief Get the time when the files of the site were scanned.
+**
+** The time is in seconds as the stat times of the files, and 0 if unknown
+** (e.g. the site file was written by an older version). Pass it as
+** gf_file_info_scan_option::cache_time with the records of the site.
+*/
+
+extern gf_64u gf_site_get_scan_time(const gf_site* site);
+
+/*!
+** @brief Kinds of the change made by gf_site_update_file()
+*/
+
+enum gf_site_change {
+  GF_SITE_CHANGE_NONE,          ///< The site is not affected
+  GF_SITE_CHANGE_FILE,          ///< A file of an entry is added, updated etc.
+  GF_SITE_CHANGE_ENTRY,         ///< The entry file is updated and read again
+  GF_SITE_CHANGE_STRUCTURE,     ///< Entries may be added or removed
+};
+
+typedef enum gf_site_change gf_site_change;
+
+/*!
+** @brief Find the entries whose directory includes the file.
+**
+** The entries from the root to the deepest one are added to the array in
+** order. The entries are owned by the site object.
+**
+** @param [in]      site      The pointer to the site object
+** @param [in]      full_path The path of the file relative to the source root
+** @param [in, out] entries   The array to which the entries are added
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_find_entries(
+  gf_site* site, const gf_char* full_path, gf_array* entries);
+
+/*!
+** @brief Apply the change of a source file to the site.
+**
+** The record of the file is read again, added or removed in the deepest entry
+** including the file. If the file is the entry file (index.dbk, meta.gf) and
+** its content has changed, the entry information is read again. A change
+** which may add or remove entries, such as a new directory or a new entry
+** file, is not applied; GF_SITE_CHANGE_STRUCTURE is returned and the caller
+** is expected to scan the directory again.
+**
+** @param [in, out] site      The pointer to the site object
+** @param [in]      root      The root path of the source files
+** @param [in]      full_path The path of the file relative to @a root
+** @param [out]     entry     The entry including the file (may be NULL)
+** @param [out]     change    The kind of the change
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_update_file(
+  gf_site* site, const gf_path* root, const gf_char* full_path,
+  gf_entry** entry, gf_site_change* change);
+
+/*!
+** @brief Kinds of the files of an entry, by the outputs they affect
+*/
+
+enum gf_site_file_role {
+  GF_SITE_FILE_NONE,            ///< The file is not in the entry directory
+  GF_SITE_FILE_DOCUMENT,        ///< The entry file of a document (index.dbk)
+  GF_SITE_FILE_SECTION,         ///< The entry file of a section (meta.gf)
+  GF_SITE_FILE_STATIC,          ///< A file in the static directory ('_')
+  GF_SITE_FILE_ASSET,           ///< Any other file of the entry
+};
+
+typedef enum gf_site_file_role gf_site_file_role;
+
+/*!
+** @brief Classify a file in the directory of an entry.
+**
+** @param [in] entry     The entry, such as the one given by
+**                       gf_site_update_file()
+** @param [in] full_path The path of the file relative to the source root
+**
+** @return The role of the file in the entry.
+*/
+
+extern gf_site_file_role gf_site_get_file_role(
+  const gf_entry* entry, const gf_char* full_path);
+
+/*!
+** @brief Get the method whose stylesheet is the file.
+**
+** Only a stylesheet at the top of the style directory (`/<method>.xsl') is
+** the stylesheet of a method. Any other file, such as an included
+** stylesheet, may affect all the entries.
+**
+** @param [in]  path   The path of the file relative to the style directory
+** @param [out] method The buffer of the method (may be NULL)
+** @param [in]  size   The size of @a method
+**
+** @return GF_TRUE if the file is the stylesheet of a method.
+*/
+
+extern gf_bool gf_site_get_style_method(
+  const gf_char* path, gf_char* method, gf_size_t size);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Kinds of the difference between two sites
+*/
+
+enum gf_site_diff_type {
+  GF_SITE_DIFF_ADDED    = 1,    ///< The file exists only in the new site
+  GF_SITE_DIFF_REMOVED  = 2,    ///< The file exists only in the old site
+  GF_SITE_DIFF_MODIFIED = 3,    ///< The content of the file has changed
+  GF_SITE_DIFF_MOVED    = 4,    ///< The same content is found at a new path
+};
+
+typedef enum gf_site_diff_type gf_site_diff_type;
+
+/*!
+** @brief Kinds of the objects compared between two sites
+*/
+
+enum gf_site_diff_target {
+  GF_SITE_DIFF_FILE     = 1,    ///< A file of the site
+  GF_SITE_DIFF_ENTRY    = 2,    ///< An entry of the site tree
+};
+
+typedef enum gf_site_diff_target gf_site_diff_target;
+
+/*!
+** @brief A difference of an entry or a file between two sites
+**
+** An entry is identified by the full path of its entry file. It is modified
+** if its entry file or one of the files of the entry has changed, and moved
+** if its entry file is found with the same content at a new path.
+**
+** The strings are owned by the change set.
+*/
+
+typedef struct gf_site_diff_item {
+  gf_site_diff_target target;
+  gf_site_diff_type type;
+  gf_bool           entry;      ///< The file is an entry file (index.dbk etc.)
+  gf_char*          path;       ///< The path in the new site (old if removed)
+  gf_char*          old_path;   ///< The path in the old site if moved
+} gf_site_diff_item;
+
+/*!
+** @brief The list of the differences between two sites
+*/
+
+typedef struct gf_site_change_set gf_site_change_set;
+
+/*!
+** @brief Compute the differences between two sites.
+**
+** The entries and the files of both sites are indexed by their full path,
+** and the file records found in both sites are compared by their
+** fingerprint. An entry or a file removed from the old site and added to the
+** new one with the same fingerprint is reported as moved.
+**
+** The differences of the entries are listed first, then those of the files.
+** Each are listed in the order of the new site, followed by the removed ones
+** in the order of the old site.
+**
+** @param [out] changes  The pointer to the new change set
+** @param [in]  old_site The previous site
+** @param [in]  new_site The current site
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_diff(
+  gf_site_change_set** changes, const gf_site* old_site,
+  const gf_site* new_site);
+
+extern void gf_site_change_set_free(gf_site_change_set* changes);
+
+extern gf_size_t gf_site_change_set_size(const gf_site_change_set* changes);
+
+/*!
+** @brief Count the differences of the specified kind of the entries or files.
+*/
+
+extern gf_size_t gf_site_change_set_count(
+  const gf_site_change_set* changes, gf_site_diff_target target,
+  gf_site_diff_type type);
+
+extern gf_status gf_site_change_set_get(
+  const gf_site_change_set* changes, gf_size_t index,
+  const gf_site_diff_item** item);
+
+/*!
+** @brief Write the change set to an XML file.
+**
+** @param [in] changes The change set
+** @param [in] path    The file path to be written
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_site_change_set_write_file(
+  const gf_site_change_set* changes, const gf_path* path);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,2427 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_site_db.c
+** @brief Conversion between a site and a site database, and its journal.
+*/
+#include <string.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_array.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_path.h>
+#include <libgf/gf_shell.h>
+#include <libgf/gf_hash.h>
+#include <libgf/gf_file_info.h>
+#include <libgf/gf_db.h>
+#include <libgf/gf_site.h>
+
+#include "gf_local.h"
+#include "gf_site_local.h"
+
+/*!
+** @defgroup SiteDatabase Conversion between a site and a site database.
+*/
+/* @{ */
+
+/*!
+** @brief The state while a site is written to a database
+*/
+
+typedef struct site_db_writer {
+  gf_db_builder*       builder;     ///< The database under construction
+  const site_taxonomy* taxonomy;    ///< The taxonomy of the site
+  gf_32u               base[2];     ///< The index of the first category
+  gf_array*            postings[2]; ///< The entry indices of each category
+  gf_array*            refs;        ///< Work area of a list
+} site_db_writer;
+
+static void
+site_db_free_refs(gf_any* any) {
+  if (any) {
+    gf_array_free((gf_array*)any->ptr);
+  }
+}
+
+static void
+site_db_writer_clear(site_db_writer* writer) {
+  gf_db_builder_free(writer->builder);
+  for (gf_size_t k = 0; k < 2; k++) {
+    if (writer->postings[k]) {
+      gf_array_free(writer->postings[k]);
+    }
+  }
+  if (writer->refs) {
+    gf_array_free(writer->refs);
+  }
+}
+
+static gf_status
+site_db_writer_prepare(site_db_writer* writer) {
+  const site_taxonomy* taxonomy = writer->taxonomy;
+  gf_size_t cnt = 0;
+
+  _(gf_db_builder_new(&writer->builder));
+  _(gf_array_new(&writer->refs));
+  for (gf_size_t k = 0; k < 2; k++) {
+    _(gf_array_new(&writer->postings[k]));
+    _(gf_array_set_free_fn(writer->postings[k], site_db_free_refs));
+    cnt = gf_array_size(taxonomy->categories[k]);
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_status rc = 0;
+      gf_array* entries = NULL;
+
+      _(gf_array_new(&entries));
+      rc = gf_array_add(writer->postings[k], (gf_any){ .ptr = entries });
+      if (rc != GF_SUCCESS) {
+        gf_array_free(entries);
+        gf_throw(rc);
+      }
+    }
+  }
+  /* The keywords follow the subjects in the categories section */
+  writer->base[GF_CATEGORY_SUBJECT] = 0;
+  writer->base[GF_CATEGORY_KEYWORD] =
+    (gf_32u)gf_array_size(taxonomy->categories[GF_CATEGORY_SUBJECT]);
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_refs(
+  gf_db_builder* builder, const gf_array* refs, gf_db_list* list) {
+  gf_status rc = 0;
+  gf_32u* values = NULL;
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(refs);
+  if (cnt == 0) {
+    _(gf_db_builder_add_refs(builder, NULL, 0, list));
+    return GF_SUCCESS;
+  }
+  _(gf_malloc((gf_ptr*)&values, cnt * sizeof(*values)));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    rc = gf_array_get(refs, i, &any);
+    if (rc != GF_SUCCESS) {
+      gf_free(values);
+      gf_throw(rc);
+    }
+    values[i] = any.u32;
+  }
+  rc = gf_db_builder_add_refs(builder, values, cnt, list);
+  gf_free(values);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the fields of a file record other than the strings.
+*/
+
+static gf_status
+site_db_get_file_fields(const gf_file_info* info, gf_db_file* rec) {
+  _(gf_file_info_get_hash_size(info, &rec->hash_size));
+  _(gf_file_info_get_hash(info, sizeof(rec->hash), rec->hash));
+  _(gf_file_info_get_inode(info, &rec->inode));
+  _(gf_file_info_get_mode(info, &rec->mode));
+  _(gf_file_info_get_link_count(info, &rec->link_count));
+  _(gf_file_info_get_uid(info, &rec->uid));
+  _(gf_file_info_get_gid(info, &rec->gid));
+  _(gf_file_info_get_device(info, &rec->device));
+  _(gf_file_info_get_rdevice(info, &rec->rdevice));
+  _(gf_file_info_get_file_size(info, &rec->file_size));
+  _(gf_file_info_get_access_time(info, &rec->access_time));
+  _(gf_file_info_get_modify_time(info, &rec->modify_time));
+  _(gf_file_info_get_create_time(info, &rec->create_time));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_file(
+  gf_db_builder* builder, const gf_file_info* info, gf_32u* index) {
+  gf_db_file rec = { 0 };
+  const gf_char* str = NULL;
+
+  _(gf_file_info_get_file_name(info, &str));
+  _(gf_db_builder_add_string(builder, str, &rec.file_name));
+  _(gf_file_info_get_full_path(info, &str));
+  _(gf_db_builder_add_string(builder, str, &rec.full_path));
+  _(gf_file_info_get_hash_algorithm(info, &str));
+  _(gf_db_builder_add_string(builder, str, &rec.hash_algorithm));
+  _(site_db_get_file_fields(info, &rec));
+  _(gf_db_builder_add_file(builder, &rec, index));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_file_set(
+  site_db_writer* writer, const gf_array* file_set, gf_db_list* list) {
+  gf_size_t cnt = 0;
+
+  _(gf_array_clear(writer->refs));
+  cnt = gf_array_size(file_set);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_32u index = 0;
+
+    _(gf_array_get(file_set, i, &any));
+    _(site_db_add_file(writer->builder, (gf_file_info*)any.ptr, &index));
+    _(gf_array_add(writer->refs, (gf_any){ .u32 = index }));
+  }
+  _(site_db_add_refs(writer->builder, writer->refs, list));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_description(
+  site_db_writer* writer, const gf_array* description, gf_db_list* list) {
+  gf_size_t cnt = 0;
+
+  _(gf_array_clear(writer->refs));
+  cnt = gf_array_size(description);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_32u offset = 0;
+
+    _(gf_array_get(description, i, &any));
+    _(gf_db_builder_add_string(
+        writer->builder, gf_string_get((gf_string*)any.ptr), &offset));
+    _(gf_array_add(writer->refs, (gf_any){ .u32 = offset }));
+  }
+  _(site_db_add_refs(writer->builder, writer->refs, list));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the category set of an entry.
+**
+** The entry is also added to the lists of the categories in the same way as
+** site_index_entry().
+*/
+
+static gf_status
+site_db_add_category_set(
+  site_db_writer* writer, const gf_entry* entry, gf_32u index,
+  gf_category_kind kind, gf_db_list* list) {
+  const gf_array* set = NULL;
+  gf_size_t cnt = 0;
+
+  _(gf_array_clear(writer->refs));
+  set = entry_get_category_set(entry, kind);
+  cnt = gf_array_size(set);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_any last = { 0 };
+    gf_array* entries = NULL;
+    gf_size_t size = 0;
+
+    _(gf_array_get(set, i, &any));
+    _(gf_array_add(
+        writer->refs, (gf_any){ .u32 = writer->base[kind] + any.u32 }));
+    _(gf_array_get(writer->postings[kind], any.u32, &any));
+    entries = (gf_array*)any.ptr;
+    size = gf_array_size(entries);
+    if (size > 0) {
+      _(gf_array_get(entries, size - 1, &last));
+      if (last.u32 == index) {
+        continue;
+      }
+    }
+    _(gf_array_add(entries, (gf_any){ .u32 = index }));
+  }
+  _(site_db_add_refs(writer->builder, writer->refs, list));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_children(
+  site_db_writer* writer, const gf_entry* entry, gf_32u index,
+  gf_db_list* list);
+
+/*!
+** @brief Add an entry and its descendants in preorder.
+*/
+
+static gf_status
+site_db_add_entry(
+  site_db_writer* writer, const gf_entry* entry, gf_32u parent,
+  gf_32u* index) {
+  gf_db_builder* builder = writer->builder;
+  gf_db_entry rec = { 0 };
+  gf_db_entry* added = NULL;
+  gf_db_list subject_set = { 0, 0 };
+  gf_db_list keyword_set = { 0, 0 };
+  gf_db_list children = { 0, 0 };
+  gf_32u self = 0;
+
+  _(entry_load(entry, ENTRY_PENDING_ALL));
+  rec.type = (gf_32u)entry->type;
+  rec.state = (gf_32u)entry->state;
+  rec.date = entry->date;
+  _(gf_db_builder_add_string(builder, gf_string_get(entry->title), &rec.title));
+  _(gf_db_builder_add_string(
+      builder, gf_string_get(entry->author), &rec.author));
+  _(gf_db_builder_add_string(
+      builder, gf_string_get(entry->method), &rec.method));
+  _(gf_db_builder_add_string(
+      builder, gf_path_get_string(entry->output_path), &rec.output_path));
+  rec.parent = parent;
+  rec.file_info = GF_DB_NONE;
+  if (entry->file_info) {
+    _(site_db_add_file(builder, entry->file_info, &rec.file_info));
+  }
+  _(site_db_add_file_set(writer, entry->file_set, &rec.file_set));
+  _(site_db_add_description(writer, entry->description, &rec.description));
+  _(gf_db_builder_add_entry(builder, &rec, &self));
+
+  /* The lists below need the index of this entry */
+  _(site_db_add_category_set(
+      writer, entry, self, GF_CATEGORY_SUBJECT, &subject_set));
+  _(site_db_add_category_set(
+      writer, entry, self, GF_CATEGORY_KEYWORD, &keyword_set));
+  if (gf_entry_is_section(entry)) {
+    _(site_db_add_children(writer, entry, self, &children));
+  }
+  added = gf_db_builder_get_entry(builder, self);
+  if (!added) {
+    gf_raise(GF_E_STATE, "Failed to build the site database.");
+  }
+  added->subject_set = subject_set;
+  added->keyword_set = keyword_set;
+  added->children = children;
+  if (index) {
+    *index = self;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_children(
+  site_db_writer* writer, const gf_entry* entry, gf_32u index,
+  gf_db_list* list) {
+  gf_status rc = 0;
+  gf_array* children = NULL;
+  gf_size_t cnt = 0;
+
+  /* The work area of the writer is used by the descendants */
+  _(gf_array_new(&children));
+  cnt = gf_array_size(entry->children);
+  for (gf_size_t i = 0; rc == GF_SUCCESS && i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_32u child = 0;
+
+    rc = gf_array_get(entry->children, i, &any);
+    if (rc == GF_SUCCESS) {
+      rc = site_db_add_entry(writer, (gf_entry*)any.ptr, index, &child);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_add(children, (gf_any){ .u32 = child });
+    }
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_db_add_refs(writer->builder, children, list);
+  }
+  gf_array_free(children);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_add_categories(site_db_writer* writer) {
+  gf_size_t cnt = 0;
+
+  for (gf_size_t k = 0; k < 2; k++) {
+    cnt = gf_array_size(writer->taxonomy->categories[k]);
+    for (gf_size_t i = 0; i < cnt; i++) {
+      gf_db_category rec = { 0 };
+      gf_category* cat = NULL;
+      gf_any any = { 0 };
+
+      _(gf_array_get(writer->taxonomy->categories[k], i, &any));
+      cat = (gf_category*)any.ptr;
+      rec.kind = (gf_32u)k;
+      _(gf_db_builder_add_string(
+          writer->builder, gf_string_get(cat->id), &rec.id));
+      _(gf_db_builder_add_string(
+          writer->builder, gf_string_get(cat->name), &rec.name));
+      _(gf_array_get(writer->postings[k], i, &any));
+      _(site_db_add_refs(writer->builder, (gf_array*)any.ptr, &rec.entries));
+      _(gf_db_builder_add_category(writer->builder, &rec, NULL));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_write_content(site_db_writer* writer, const gf_site* site) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(site->entry_set);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(site->entry_set, i, &any));
+    if (any.ptr) {
+      _(site_db_add_entry(writer, (gf_entry*)any.ptr, GF_DB_NONE, NULL));
+    }
+  }
+  _(site_db_add_categories(writer));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_write_db(const gf_site* site, const gf_path* path) {
+  gf_status rc = 0;
+  site_db_writer writer = { 0 };
+  gf_path* journal_path = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  writer.taxonomy = site->taxonomy;
+  rc = site_db_writer_prepare(&writer);
+  if (rc == GF_SUCCESS) {
+    gf_db_builder_set_scan_time(writer.builder, site->scan_time);
+    rc = site_db_write_content(&writer, site);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_db_builder_write_file(writer.builder, path);
+  }
+  site_db_writer_clear(&writer);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  /* The journal of the old database is ignored anyway */
+  _(gf_db_make_journal_path(&journal_path, path));
+  if (gf_path_file_exists(journal_path) &&
+      gf_shell_remove_file(journal_path) != GF_SUCCESS) {
+    gf_debug("Failed to remove the old journal.");
+  }
+  gf_path_free(journal_path);
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_get_string(const gf_db* db, gf_32u offset, const gf_char** str) {
+  *str = gf_db_get_string(db, offset);
+  if (!*str) {
+    gf_raise(GF_E_DATA, "Invalid site database.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Set the file information from a file record and its strings.
+*/
+
+static gf_status
+site_set_file_info(
+  gf_file_info* info, const gf_char* file_name, const gf_char* full_path,
+  const gf_char* hash_algorithm, const gf_db_file* rec) {
+  /* An empty string is left unset as site_read_xml_file_info_field() does */
+  if (*file_name) {
+    _(gf_file_info_set_file_name(info, file_name));
+  }
+  if (*full_path) {
+    _(gf_file_info_set_full_path(info, full_path));
+  }
+  if (*hash_algorithm) {
+    _(gf_file_info_set_hash_algorithm(info, hash_algorithm));
+  }
+  if (rec->hash_size > GF_HASH_BUFSIZE_MAX) {
+    gf_raise(GF_E_DATA, "Invalid site database.");
+  }
+  if (rec->hash_size > 0) {
+    _(gf_file_info_set_hash(info, rec->hash_size, (gf_8u*)rec->hash));
+    _(gf_file_info_set_hash_size(info, rec->hash_size));
+  }
+  _(gf_file_info_set_inode(info, rec->inode));
+  _(gf_file_info_set_mode(info, rec->mode));
+  _(gf_file_info_set_link_count(info, rec->link_count));
+  _(gf_file_info_set_uid(info, rec->uid));
+  _(gf_file_info_set_gid(info, rec->gid));
+  _(gf_file_info_set_device(info, rec->device));
+  _(gf_file_info_set_rdevice(info, rec->rdevice));
+  _(gf_file_info_set_file_size(info, rec->file_size));
+  _(gf_file_info_set_access_time(info, rec->access_time));
+  _(gf_file_info_set_modify_time(info, rec->modify_time));
+  _(gf_file_info_set_create_time(info, rec->create_time));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_set_file_info(
+  gf_file_info* info, const gf_db* db, const gf_db_file* rec) {
+  const gf_char* file_name = NULL;
+  const gf_char* full_path = NULL;
+  const gf_char* hash_algorithm = NULL;
+
+  _(site_db_get_string(db, rec->file_name, &file_name));
+  _(site_db_get_string(db, rec->full_path, &full_path));
+  _(site_db_get_string(db, rec->hash_algorithm, &hash_algorithm));
+  _(site_set_file_info(info, file_name, full_path, hash_algorithm, rec));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_file_info(gf_file_info** info, const gf_db* db, gf_32u index) {
+  gf_status rc = 0;
+  const gf_db_file* rec = NULL;
+  gf_file_info* tmp = NULL;
+
+  rec = gf_db_get_file(db, index);
+  if (!rec) {
+    gf_raise(GF_E_DATA, "Invalid site database.");
+  }
+  _(gf_file_info_new(&tmp, NULL, NULL));
+  rc = site_db_set_file_info(tmp, db, rec);
+  if (rc != GF_SUCCESS) {
+    gf_file_info_free(tmp);
+    gf_throw(rc);
+  }
+  *info = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_file_set(
+  gf_array* file_set, const gf_db* db, const gf_db_list* list) {
+  gf_status rc = 0;
+
+  for (gf_32u i = 0; i < list->count; i++) {
+    gf_file_info* info = NULL;
+
+    _(site_db_read_file_info(&info, db, gf_db_get_ref(db, list, i)));
+    rc = gf_array_add(file_set, (gf_any){ .ptr = info });
+    if (rc != GF_SUCCESS) {
+      gf_file_info_free(info);
+      gf_throw(rc);
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_description(
+  gf_array* description, const gf_db* db, const gf_db_list* list) {
+  gf_status rc = 0;
+
+  for (gf_32u i = 0; i < list->count; i++) {
+    const gf_char* str = NULL;
+    gf_string* paragraph = NULL;
+
+    _(site_db_get_string(db, gf_db_get_ref(db, list, i), &str));
+    _(gf_string_new(&paragraph));
+    rc = gf_string_set(paragraph, str);
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_add(description, (gf_any){ .ptr = paragraph });
+    }
+    if (rc != GF_SUCCESS) {
+      gf_string_free(paragraph);
+      gf_throw(rc);
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_category_set(
+  gf_entry* entry, gf_category_kind kind, const gf_db* db,
+  const gf_db_list* list) {
+  for (gf_32u i = 0; i < list->count; i++) {
+    const gf_db_category* rec = NULL;
+    const gf_char* id = NULL;
+    const gf_char* name = NULL;
+
+    rec = gf_db_get_category(db, gf_db_get_ref(db, list, i));
+    if (!rec || rec->kind != (gf_32u)kind) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+    _(site_db_get_string(db, rec->id, &id));
+    _(site_db_get_string(db, rec->name, &name));
+    _(entry_add_category(entry, kind, id, name));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_entry(
+  site_taxonomy* taxonomy, gf_array* entry_set, const gf_db* db,
+  site_overlay* overlay, gf_32u index, gf_bool lazy);
+static gf_status site_read_journal(
+  gf_site* site, const gf_path* path, const gf_db* db);
+static gf_status site_open_journal(gf_site* site, const gf_path* path);
+static gf_status site_journal_overlay_apply_entry(gf_entry* entry);
+static gf_status site_journal_overlay_read_children(
+  gf_entry* entry, gf_bool lazy);
+static gf_status site_journal_overlay_read_site(gf_site* site);
+
+static gf_status
+site_db_set_entry(
+  gf_entry* entry, const gf_db* db, const gf_db_entry* rec, gf_32u index) {
+  const gf_char* str = NULL;
+
+  entry->type = (gf_entry_type)rec->type;
+  entry->state = (gf_entry_state)rec->state;
+  entry->date = (gf_datetime)rec->date;
+  _(site_db_get_string(db, rec->title, &str));
+  _(gf_string_set(entry->title, str));
+  _(site_db_get_string(db, rec->author, &str));
+  _(gf_string_set(entry->author, str));
+  _(site_db_get_string(db, rec->method, &str));
+  _(gf_string_set(entry->method, str));
+  _(site_db_get_string(db, rec->output_path, &str));
+  _(gf_path_set_string(entry->output_path, str));
+  if (rec->file_info != GF_DB_NONE) {
+    _(site_db_read_file_info(&entry->file_info, db, rec->file_info));
+  }
+  _(site_db_read_category_set(
+      entry, GF_CATEGORY_SUBJECT, db, &rec->subject_set));
+  _(site_db_read_category_set(
+      entry, GF_CATEGORY_KEYWORD, db, &rec->keyword_set));
+  /* The lists are read by site_db_load_entry() */
+  entry->db = db;
+  entry->db_index = index;
+  entry->pending = ENTRY_PENDING_ALL;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_children(
+  gf_entry* entry, const gf_db_entry* rec, gf_bool lazy) {
+  if (entry->overlay) {
+    _(site_journal_overlay_read_children(entry, lazy));
+    return GF_SUCCESS;
+  }
+  for (gf_32u i = 0; i < rec->children.count; i++) {
+    gf_32u child = gf_db_get_ref(entry->db, &rec->children, i);
+
+    /* The children follow the parent in preorder, so a loop is rejected */
+    if (child == GF_DB_NONE || child <= entry->db_index) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+    _(site_db_read_entry(
+        entry->taxonomy, entry->children, entry->db, NULL, child, lazy));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the pending parts of an entry from the database.
+**
+** A part which fails to be read is left empty and pending.
+**
+** @param [in, out] entry The entry made by site_db_set_entry()
+** @param [in]      parts ENTRY_PENDING_* to be read
+** @param [in]      lazy  GF_TRUE to leave the parts of the children pending
+*/
+
+static gf_status
+site_db_load_entry(gf_entry* entry, gf_32u parts, gf_bool lazy) {
+  gf_status rc = 0;
+  const gf_db_entry* rec = NULL;
+
+  parts &= entry->pending;
+  if (!parts) {
+    return GF_SUCCESS;
+  }
+  /* An entry made from the journal has only the children pending */
+  if (entry->db_index != GF_DB_NONE) {
+    rec = gf_db_get_entry(entry->db, entry->db_index);
+    if (!rec) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+  }
+  if (parts & ENTRY_PENDING_FILE_SET) {
+    rc = site_db_read_file_set(entry->file_set, entry->db, &rec->file_set);
+    if (rc != GF_SUCCESS) {
+      (void)gf_array_clear(entry->file_set);
+      gf_throw(rc);
+    }
+    entry->pending &= ~(gf_32u)ENTRY_PENDING_FILE_SET;
+  }
+  if (parts & ENTRY_PENDING_DESCRIPTION) {
+    rc = site_db_read_description(
+      entry->description, entry->db, &rec->description);
+    if (rc != GF_SUCCESS) {
+      (void)gf_array_clear(entry->description);
+      gf_throw(rc);
+    }
+    entry->pending &= ~(gf_32u)ENTRY_PENDING_DESCRIPTION;
+  }
+  if (parts & ENTRY_PENDING_CHILDREN) {
+    rc = site_db_read_children(entry, rec, lazy);
+    if (rc != GF_SUCCESS) {
+      (void)gf_array_clear(entry->children);
+      gf_throw(rc);
+    }
+    entry->pending &= ~(gf_32u)ENTRY_PENDING_CHILDREN;
+  }
+  if (!entry->pending) {
+    entry->db = NULL;
+    entry->overlay = NULL;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the pending parts of an entry of a site opened by gf_site_open().
+**
+** Reading the parts does not change the content of the entry, so this is
+** done through a const entry as well. The entries not from the database
+** have nothing pending.
+*/
+
+gf_status
+entry_load(const gf_entry* entry, gf_32u parts) {
+  gf_validate(entry);
+
+  _(site_db_load_entry((gf_entry*)entry, parts, GF_TRUE));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_db_read_entry(
+  site_taxonomy* taxonomy, gf_array* entry_set, const gf_db* db,
+  site_overlay* overlay, gf_32u index, gf_bool lazy) {
+  gf_status rc = 0;
+  const gf_db_entry* rec = NULL;
+  gf_entry* entry = NULL;
+
+  rec = gf_db_get_entry(db, index);
+  if (!rec) {
+    gf_raise(GF_E_DATA, "Invalid site database.");
+  }
+  _(entry_new(&entry, taxonomy));
+  rc = gf_array_add(entry_set, (gf_any){ .ptr = entry });
+  if (rc != GF_SUCCESS) {
+    gf_entry_free(entry);
+    gf_throw(rc);
+  }
+  _(site_db_set_entry(entry, db, rec, index));
+  if (overlay) {
+    entry->overlay = overlay;
+    _(site_journal_overlay_apply_entry(entry));
+  }
+  if (!lazy) {
+    _(site_db_load_entry(entry, ENTRY_PENDING_ALL, GF_FALSE));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the index of the entry after the subtree of an entry.
+**
+** The entries are in preorder, so the subtree ends at the last descendant
+** reached through the last children.
+*/
+
+static gf_status
+site_db_skip_subtree(const gf_db* db, gf_32u index, gf_32u* next) {
+  const gf_db_entry* rec = gf_db_get_entry(db, index);
+
+  while (rec && rec->children.count > 0) {
+    gf_32u last = gf_db_get_ref(db, &rec->children, rec->children.count - 1);
+
+    if (last == GF_DB_NONE || last <= index) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+    index = last;
+    rec = gf_db_get_entry(db, index);
+  }
+  if (!rec) {
+    gf_raise(GF_E_DATA, "Invalid site database.");
+  }
+  *next = index + 1;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the top-level entries of the database.
+**
+** @param [in, out] site The site to which the entries are added
+** @param [in]      db   The database
+** @param [in]      lazy GF_TRUE to leave the parts of the entries pending
+*/
+
+static gf_status
+site_read_db(gf_site* site, const gf_db* db, gf_bool lazy) {
+  gf_size_t cnt = 0;
+  gf_32u next = 0;
+
+  cnt = gf_db_count_entries(db);
+  for (gf_32u i = 0; i < cnt; i = next) {
+    const gf_db_entry* rec = gf_db_get_entry(db, i);
+
+    if (!rec || rec->parent != GF_DB_NONE) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+    _(site_db_read_entry(
+        site->taxonomy, site->entry_set, db, NULL, i, lazy));
+    _(site_db_skip_subtree(db, i, &next));
+  }
+  if (!lazy) {
+    _(site_build_indices(site));
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_read_db(gf_site** site, const gf_path* path) {
+  gf_status rc = 0;
+  gf_db* db = NULL;
+  gf_site* tmp = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(gf_db_open(&db, path));
+  rc = gf_site_new(&tmp);
+  if (rc == GF_SUCCESS) {
+    /* The journal keeps the older scan time, which only rehashes more */
+    tmp->scan_time = gf_db_get_scan_time(db);
+    rc = site_read_db(tmp, db, GF_FALSE);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = site_read_journal(tmp, path, db);
+  }
+  gf_db_close(db);
+  if (rc != GF_SUCCESS) {
+    gf_site_free(tmp);
+    gf_throw(rc);
+  }
+  *site = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_open(gf_site** site, const gf_path* path) {
+  gf_status rc = 0;
+  gf_site* tmp = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(gf_site_new(&tmp));
+  /* The database is closed by gf_site_free() */
+  rc = gf_db_open(&tmp->db, path);
+  if (rc == GF_SUCCESS) {
+    tmp->scan_time = gf_db_get_scan_time(tmp->db);
+    rc = site_open_journal(tmp, path);
+  }
+  if (rc == GF_SUCCESS) {
+    /* The journal is applied to each entry as it is read */
+    rc = tmp->overlay ?
+      site_journal_overlay_read_site(tmp) :
+      site_read_db(tmp, tmp->db, GF_TRUE);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_site_free(tmp);
+    gf_throw(rc);
+  }
+  *site = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read all the pending parts of a site opened by gf_site_open().
+**
+** The categories list their entries afterwards, and the database is closed.
+*/
+
+gf_status
+site_load(gf_site* site) {
+  gf_validate(site);
+
+  if (!site->db) {
+    return GF_SUCCESS;
+  }
+  /* Every entry is read while the categories are indexed */
+  _(site_build_indices(site));
+  site_journal_overlay_free(site->overlay);
+  site->overlay = NULL;
+  gf_db_close(site->db);
+  site->db = NULL;
+
+  return GF_SUCCESS;
+}
+
+/* @} */
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @defgroup SiteJournal The journal of a site database.
+**
+** A record of the journal is one of the following, keyed by the full path of
+** the entry file. The records of a batch are in this order, so that the
+** entries exist when they are listed as children, and the children moved out
+** of a removed entry are not removed with it.
+**
+**   - SITE_JOURNAL_ENTRY    : an added or modified entry without its children
+**   - SITE_JOURNAL_CHILDREN : the keys of the children of a section (the
+**                             empty key: the top-level entries)
+**   - SITE_JOURNAL_REMOVE   : a removed entry
+**
+** A string is its length, the characters and the terminating NUL.
+*/
+/* @{ */
+
+enum {
+  SITE_JOURNAL_ENTRY    = 1,
+  SITE_JOURNAL_CHILDREN = 2,
+  SITE_JOURNAL_REMOVE   = 3,
+};
+
+/*!
+** @brief The payload of a record under construction
+*/
+
+typedef struct site_journal_buffer {
+  gf_8u*    data;
+  gf_size_t size;
+  gf_size_t capacity;
+} site_journal_buffer;
+
+static gf_status
+site_journal_put(site_journal_buffer* buf, gf_const_ptr data, gf_size_t size) {
+  if (buf->size + size > buf->capacity) {
+    gf_size_t capacity = buf->capacity ? buf->capacity : 1024;
+
+    while (capacity < buf->size + size) {
+      capacity *= 2;
+    }
+    _(gf_realloc((gf_ptr*)&buf->data, capacity));
+    buf->capacity = capacity;
+  }
+  _(gf_memcpy(buf->data + buf->size, data, size));
+  buf->size += size;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_32u(site_journal_buffer* buf, gf_32u value) {
+  _(site_journal_put(buf, &value, sizeof(value)));
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_64u(site_journal_buffer* buf, gf_64u value) {
+  _(site_journal_put(buf, &value, sizeof(value)));
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_string(site_journal_buffer* buf, const gf_char* str) {
+  gf_size_t len = 0;
+
+  if (!str) {
+    str = "";
+  }
+  len = strlen(str);
+  if (len >= (gf_size_t)UINT32_MAX) {
+    gf_raise(GF_E_DATA, "Too long string for the journal.");
+  }
+  _(site_journal_put_32u(buf, (gf_32u)len));
+  _(site_journal_put(buf, str, len + 1));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_file_info(
+  site_journal_buffer* buf, const gf_file_info* info) {
+  gf_db_file rec = { 0 };
+  const gf_char* str = NULL;
+
+  /* The string fields of the record are not used */
+  _(gf_file_info_get_file_name(info, &str));
+  _(site_journal_put_string(buf, str));
+  _(gf_file_info_get_full_path(info, &str));
+  _(site_journal_put_string(buf, str));
+  _(gf_file_info_get_hash_algorithm(info, &str));
+  _(site_journal_put_string(buf, str));
+  _(site_db_get_file_fields(info, &rec));
+  _(site_journal_put(buf, &rec, sizeof(rec)));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_category_set(
+  site_journal_buffer* buf, const gf_entry* entry, gf_category_kind kind) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(entry_get_category_set(entry, kind));
+  _(site_journal_put_32u(buf, (gf_32u)cnt));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_category* cat = NULL;
+
+    _(entry_get_category(entry, kind, i, &cat));
+    _(site_journal_put_string(buf, gf_string_get(cat->id)));
+    _(site_journal_put_string(buf, gf_string_get(cat->name)));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_entry(
+  site_journal_buffer* buf, const gf_entry* entry, const gf_char* key) {
+  gf_size_t cnt = 0;
+
+  _(site_journal_put_string(buf, key));
+  _(site_journal_put_32u(buf, (gf_32u)entry->type));
+  _(site_journal_put_32u(buf, (gf_32u)entry->state));
+  _(site_journal_put_64u(buf, (gf_64u)entry->date));
+  _(site_journal_put_string(buf, gf_string_get(entry->title)));
+  _(site_journal_put_string(buf, gf_string_get(entry->author)));
+  _(site_journal_put_string(buf, gf_string_get(entry->method)));
+  _(site_journal_put_string(buf, gf_path_get_string(entry->output_path)));
+  _(site_journal_put_32u(buf, entry->file_info ? 1 : 0));
+  if (entry->file_info) {
+    _(site_journal_put_file_info(buf, entry->file_info));
+  }
+  cnt = gf_array_size(entry->file_set);
+  _(site_journal_put_32u(buf, (gf_32u)cnt));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entry->file_set, i, &any));
+    _(site_journal_put_file_info(buf, (gf_file_info*)any.ptr));
+  }
+  cnt = gf_array_size(entry->description);
+  _(site_journal_put_32u(buf, (gf_32u)cnt));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(entry->description, i, &any));
+    _(site_journal_put_string(buf, gf_string_get((gf_string*)any.ptr)));
+  }
+  _(site_journal_put_category_set(buf, entry, GF_CATEGORY_SUBJECT));
+  _(site_journal_put_category_set(buf, entry, GF_CATEGORY_KEYWORD));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The payload of a record being read
+*/
+
+typedef struct site_journal_cursor {
+  const gf_8u* data;
+  gf_size_t    size;
+  gf_size_t    offset;
+} site_journal_cursor;
+
+static gf_status
+site_journal_get(site_journal_cursor* cur, gf_ptr data, gf_size_t size) {
+  if (cur->size - cur->offset < size) {
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+  memcpy(data, cur->data + cur->offset, size);
+  cur->offset += size;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_get_32u(site_journal_cursor* cur, gf_32u* value) {
+  _(site_journal_get(cur, value, sizeof(*value)));
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_get_64u(site_journal_cursor* cur, gf_64u* value) {
+  _(site_journal_get(cur, value, sizeof(*value)));
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get a string, which points into the payload.
+*/
+
+static gf_status
+site_journal_get_string(site_journal_cursor* cur, const gf_char** str) {
+  gf_32u len = 0;
+
+  _(site_journal_get_32u(cur, &len));
+  if (cur->size - cur->offset <= (gf_size_t)len ||
+      cur->data[cur->offset + len] != '\0') {
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+  *str = (const gf_char*)(cur->data + cur->offset);
+  cur->offset += (gf_size_t)len + 1;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_get_file_info(site_journal_cursor* cur, gf_file_info** info) {
+  gf_status rc = 0;
+  gf_db_file rec = { 0 };
+  const gf_char* file_name = NULL;
+  const gf_char* full_path = NULL;
+  const gf_char* hash_algorithm = NULL;
+  gf_file_info* tmp = NULL;
+
+  _(site_journal_get_string(cur, &file_name));
+  _(site_journal_get_string(cur, &full_path));
+  _(site_journal_get_string(cur, &hash_algorithm));
+  _(site_journal_get(cur, &rec, sizeof(rec)));
+  _(gf_file_info_new(&tmp, NULL, NULL));
+  rc = site_set_file_info(tmp, file_name, full_path, hash_algorithm, &rec);
+  if (rc != GF_SUCCESS) {
+    gf_file_info_free(tmp);
+    gf_throw(rc);
+  }
+  *info = tmp;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_get_category_set(
+  site_journal_cursor* cur, gf_entry* entry, gf_category_kind kind) {
+  gf_32u cnt = 0;
+
+  _(site_journal_get_32u(cur, &cnt));
+  for (gf_32u i = 0; i < cnt; i++) {
+    const gf_char* id = NULL;
+    const gf_char* name = NULL;
+
+    _(site_journal_get_string(cur, &id));
+    _(site_journal_get_string(cur, &name));
+    _(entry_add_category(entry, kind, id, name));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Replace the content of an entry with the payload of its record.
+**
+** The key has been read. The children are kept.
+*/
+
+static gf_status
+site_journal_get_entry(site_journal_cursor* cur, gf_entry* entry) {
+  gf_status rc = 0;
+  const gf_char* str = NULL;
+  gf_32u value = 0;
+  gf_32u cnt = 0;
+
+  _(entry_reset_info(entry));
+  _(site_journal_get_32u(cur, &value));
+  entry->type = (gf_entry_type)value;
+  _(site_journal_get_32u(cur, &value));
+  entry->state = (gf_entry_state)value;
+  _(site_journal_get_64u(cur, &entry->date));
+  _(site_journal_get_string(cur, &str));
+  _(gf_string_set(entry->title, str));
+  _(site_journal_get_string(cur, &str));
+  _(gf_string_set(entry->author, str));
+  _(site_journal_get_string(cur, &str));
+  _(gf_string_set(entry->method, str));
+  _(site_journal_get_string(cur, &str));
+  _(gf_path_set_string(entry->output_path, str));
+  if (entry->file_info) {
+    gf_file_info_free(entry->file_info);
+    entry->file_info = NULL;
+  }
+  _(site_journal_get_32u(cur, &value));
+  if (value) {
+    _(site_journal_get_file_info(cur, &entry->file_info));
+  }
+  _(gf_array_clear(entry->file_set));
+  _(site_journal_get_32u(cur, &cnt));
+  for (gf_32u i = 0; i < cnt; i++) {
+    gf_file_info* info = NULL;
+
+    _(site_journal_get_file_info(cur, &info));
+    rc = gf_array_add(entry->file_set, (gf_any){ .ptr = info });
+    if (rc != GF_SUCCESS) {
+      gf_file_info_free(info);
+      gf_throw(rc);
+    }
+  }
+  _(site_journal_get_32u(cur, &cnt));
+  for (gf_32u i = 0; i < cnt; i++) {
+    gf_string* paragraph = NULL;
+
+    _(site_journal_get_string(cur, &str));
+    _(gf_string_new(&paragraph));
+    rc = gf_string_set(paragraph, str);
+    if (rc == GF_SUCCESS) {
+      rc = gf_array_add(entry->description, (gf_any){ .ptr = paragraph });
+    }
+    if (rc != GF_SUCCESS) {
+      gf_string_free(paragraph);
+      gf_throw(rc);
+    }
+  }
+  _(site_journal_get_category_set(cur, entry, GF_CATEGORY_SUBJECT));
+  _(site_journal_get_category_set(cur, entry, GF_CATEGORY_KEYWORD));
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The state while the changes of a site are put into a batch
+**
+** The fingerprints of the records are compared with the saved ones, and
+** only the changed records are added to the batch.
+*/
+
+typedef struct site_journal_writer {
+  gf_db_journal*      journal;        ///< The batch (NULL: fingerprints only)
+  site_journal_buffer buf;            ///< Work area of a payload
+  const gf_map*       saved_entries;  ///< The saved fingerprints (may be NULL)
+  const gf_map*       saved_children; ///< The saved fingerprints (may be NULL)
+  gf_map*             entries;        ///< The fingerprints of the site
+  gf_map*             children;       ///< The fingerprints of the site
+} site_journal_writer;
+
+static void
+site_journal_writer_clear(site_journal_writer* writer) {
+  gf_db_journal_free(writer->journal);
+  if (writer->buf.data) {
+    gf_free(writer->buf.data);
+  }
+  if (writer->entries) {
+    gf_map_free(writer->entries);
+  }
+  if (writer->children) {
+    gf_map_free(writer->children);
+  }
+}
+
+static gf_status
+site_journal_writer_prepare(site_journal_writer* writer, gf_bool journal) {
+  if (journal) {
+    _(gf_db_journal_new(&writer->journal));
+  }
+  _(gf_map_new(&writer->entries));
+  _(gf_map_new(&writer->children));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_get_key(const gf_entry* entry, const gf_char** key) {
+  *key = gf_entry_get_full_path_string(entry);
+  if (gf_strnull(*key)) {
+    gf_raise(GF_E_STATE, "An entry without the entry file is not journaled.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Add the payload in the work area to the batch if it is changed.
+*/
+
+static gf_status
+site_journal_put_record(
+  site_journal_writer* writer, gf_32u type, const gf_char* key,
+  const gf_map* saved, gf_map* current) {
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_any any = { 0 };
+  gf_64u fingerprint = 0;
+
+  _(gf_hash_buffer(
+      gf_hash_get_default(), digest, sizeof(digest), writer->buf.data,
+      writer->buf.size));
+  memcpy(&fingerprint, digest, sizeof(fingerprint));
+  if (gf_map_find(current, key, NULL)) {
+    gf_raise(GF_E_STATE, "The entry appears twice. (%s)", key);
+  }
+  _(gf_map_set(current, key, (gf_any){ .u64 = fingerprint }));
+  if (!writer->journal) {
+    return GF_SUCCESS;
+  }
+  if (saved && gf_map_find(saved, key, &any) && any.u64 == fingerprint) {
+    return GF_SUCCESS;
+  }
+  _(gf_db_journal_add(
+      writer->journal, type, writer->buf.data, writer->buf.size));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_children(
+  site_journal_writer* writer, const gf_array* entries, const gf_char* key) {
+  gf_size_t cnt = 0;
+
+  writer->buf.size = 0;
+  cnt = gf_array_size(entries);
+  _(site_journal_put_string(&writer->buf, key));
+  _(site_journal_put_32u(&writer->buf, (gf_32u)cnt));
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    const gf_char* child = NULL;
+
+    _(gf_array_get(entries, i, &any));
+    _(site_journal_get_key((gf_entry*)any.ptr, &child));
+    _(site_journal_put_string(&writer->buf, child));
+  }
+  _(site_journal_put_record(
+      writer, SITE_JOURNAL_CHILDREN, key, writer->saved_children,
+      writer->children));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Put the records of the entries and their descendants of a type.
+**
+** @param [in, out] writer  The writer
+** @param [in]      entries The entries
+** @param [in]      key     The key of the parent of @a entries
+** @param [in]      type    SITE_JOURNAL_ENTRY or SITE_JOURNAL_CHILDREN
+*/
+
+static gf_status
+site_journal_put_entries(
+  site_journal_writer* writer, const gf_array* entries, const gf_char* key,
+  gf_32u type) {
+  gf_size_t cnt = 0;
+
+  if (type == SITE_JOURNAL_CHILDREN) {
+    _(site_journal_put_children(writer, entries, key));
+  }
+  cnt = gf_array_size(entries);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    const gf_entry* entry = NULL;
+    const gf_char* child = NULL;
+
+    _(gf_array_get(entries, i, &any));
+    entry = (const gf_entry*)any.ptr;
+    _(entry_load(entry, ENTRY_PENDING_ALL));
+    _(site_journal_get_key(entry, &child));
+    if (type == SITE_JOURNAL_ENTRY) {
+      writer->buf.size = 0;
+      _(site_journal_put_entry(&writer->buf, entry, child));
+      _(site_journal_put_record(
+          writer, type, child, writer->saved_entries, writer->entries));
+    }
+    if (gf_entry_is_section(entry)) {
+      _(site_journal_put_entries(writer, entry->children, child, type));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_removed(const gf_char* key, gf_any value, gf_ptr data) {
+  site_journal_writer* writer = (site_journal_writer*)data;
+
+  (void)value;
+  if (gf_map_find(writer->entries, key, NULL)) {
+    return GF_SUCCESS;
+  }
+  writer->buf.size = 0;
+  _(site_journal_put_string(&writer->buf, key));
+  _(gf_db_journal_add(
+      writer->journal, SITE_JOURNAL_REMOVE, writer->buf.data,
+      writer->buf.size));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_put_site(site_journal_writer* writer, const gf_site* site) {
+  _(site_journal_put_entries(
+      writer, site->entry_set, "", SITE_JOURNAL_ENTRY));
+  _(site_journal_put_entries(
+      writer, site->entry_set, "", SITE_JOURNAL_CHILDREN));
+  if (writer->journal && writer->saved_entries) {
+    _(gf_map_foreach(
+        writer->saved_entries, site_journal_put_removed, writer));
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Take the fingerprints of the records of a site.
+*/
+
+static gf_status
+site_journal_capture(
+  const gf_site* site, gf_map** entries, gf_map** children) {
+  gf_status rc = 0;
+  site_journal_writer writer = { 0 };
+
+  rc = site_journal_writer_prepare(&writer, GF_FALSE);
+  if (rc == GF_SUCCESS) {
+    rc = site_journal_put_site(&writer, site);
+  }
+  if (rc == GF_SUCCESS) {
+    *entries = writer.entries;
+    *children = writer.children;
+    writer.entries = NULL;
+    writer.children = NULL;
+  }
+  site_journal_writer_clear(&writer);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Take the fingerprints of a saved site before it is changed in place.
+**
+** If they cannot be taken, the site is saved as a whole next time.
+*/
+
+void
+site_db_state_capture(gf_site* site) {
+  site_db_state* state = &site->saved;
+
+  if (state->generation == 0 || state->entries) {
+    return;
+  }
+  if (site_journal_capture(site, &state->entries, &state->children) !=
+      GF_SUCCESS) {
+    site_db_state_clear(state);
+  }
+}
+
+/*!
+** @brief Append the changes of a site from its base to the journal.
+**
+** @param [in, out] site  The site to be saved
+** @param [in]      base  The site of the current database
+** @param [in]      path  The path of the database
+** @param [in]      ratio The maximum size of the journal in percent
+** @param [out]     done  GF_FALSE if the whole database has to be written
+*/
+
+static gf_status
+site_append_journal(
+  gf_site* site, const gf_site* base, const gf_path* path, gf_size_t ratio,
+  gf_bool* done) {
+  gf_status rc = 0;
+  site_db_state state = base->saved;
+  site_journal_writer writer = { 0 };
+  gf_map* entries = NULL;
+  gf_map* children = NULL;
+  gf_path* journal_path = NULL;
+  gf_db* db = NULL;
+  gf_bool compact = GF_FALSE;
+
+  *done = GF_FALSE;
+  if (state.generation == 0 || ratio == 0) {
+    return GF_SUCCESS;
+  }
+  _(gf_db_open(&db, path));
+  if (gf_db_get_generation(db) != state.generation) {
+    gf_db_close(db);
+    gf_debug("The site database was written by another process.");
+    return GF_SUCCESS;
+  }
+  gf_db_close(db);
+  if (!state.entries) {
+    _(site_journal_capture(base, &entries, &children));
+    state.entries = entries;
+    state.children = children;
+  }
+
+  writer.saved_entries = state.entries;
+  writer.saved_children = state.children;
+  rc = site_journal_writer_prepare(&writer, GF_TRUE);
+  if (rc == GF_SUCCESS) {
+    rc = site_journal_put_site(&writer, site);
+  }
+  if (rc == GF_SUCCESS && gf_db_journal_count(writer.journal) > 0) {
+    compact = (state.journal_size + gf_db_journal_size(writer.journal)) *
+      100 > (gf_64u)ratio * state.db_size;
+    if (compact) {
+      gf_debug("The journal is compacted into the site database.");
+    } else {
+      rc = gf_db_make_journal_path(&journal_path, path);
+      if (rc == GF_SUCCESS) {
+        rc = gf_db_journal_write_file(
+          writer.journal, journal_path, state.generation, &state.journal_size);
+      }
+      gf_path_free(journal_path);
+    }
+  }
+  if (rc == GF_SUCCESS && !compact) {
+    gf_debug("%zu record(s) appended to the journal.",
+             gf_db_journal_count(writer.journal));
+    /* The saved fingerprints may be the ones of the site itself */
+    site_db_state_clear(&site->saved);
+    site->saved.generation = state.generation;
+    site->saved.db_size = state.db_size;
+    site->saved.journal_size = state.journal_size;
+    site->saved.entries = writer.entries;
+    site->saved.children = writer.children;
+    writer.entries = NULL;
+    writer.children = NULL;
+    *done = GF_TRUE;
+  }
+  site_journal_writer_clear(&writer);
+  if (entries) {
+    gf_map_free(entries);
+  }
+  if (children) {
+    gf_map_free(children);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_site_save_db(
+  gf_site* site, const gf_site* prev, const gf_path* path, gf_size_t ratio) {
+  gf_bool done = GF_FALSE;
+  gf_db* db = NULL;
+
+  gf_validate(site);
+  gf_validate(!gf_path_is_empty(path));
+
+  if (site->db) {
+    _(site_load(site));
+  }
+  if (site_append_journal(site, prev ? prev : site, path, ratio, &done) !=
+      GF_SUCCESS) {
+    /* A batch interrupted halfway is discarded by the readers */
+    gf_debug("Failed to append to the journal; the database is written.");
+    done = GF_FALSE;
+  }
+  if (done) {
+    return GF_SUCCESS;
+  }
+  _(gf_site_write_db(site, path));
+  site_db_state_clear(&site->saved);
+  _(gf_db_open(&db, path));
+  site->saved.generation = gf_db_get_generation(db);
+  site->saved.db_size = gf_db_get_size(db);
+  gf_db_close(db);
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief An entry of a site to which a journal is applied
+*/
+
+typedef struct site_journal_item {
+  gf_entry* entry;              ///< The entry
+  gf_array* owner;              ///< The array holding the entry (NULL: none)
+} site_journal_item;
+
+static void
+site_journal_item_free(gf_any* any) {
+  if (any && any->ptr) {
+    site_journal_item* item = (site_journal_item*)any->ptr;
+
+    /* An entry held by no array is not in the site */
+    if (!item->owner) {
+      gf_entry_free(item->entry);
+    }
+    gf_free(item);
+  }
+}
+
+/*!
+** @brief The state while a journal is applied to a site
+*/
+
+typedef struct site_journal_reader {
+  gf_site* site;                ///< The site read from the database
+  gf_map*  items;               ///< Key -> site_journal_item (lazily made)
+} site_journal_reader;
+
+static gf_status
+site_journal_add_item(
+  gf_map* items, const gf_char* key, gf_entry* entry, gf_array* owner,
+  site_journal_item** item) {
+  gf_status rc = 0;
+  site_journal_item* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->entry = entry;
+  tmp->owner = owner;
+  rc = gf_map_set(items, key, (gf_any){ .ptr = tmp });
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  if (item) {
+    *item = tmp;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_add_items(gf_map* items, gf_array* entries) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(entries);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    gf_entry* entry = NULL;
+    const gf_char* key = NULL;
+
+    _(gf_array_get(entries, i, &any));
+    entry = (gf_entry*)any.ptr;
+    key = gf_entry_get_full_path_string(entry);
+    if (!gf_strnull(key)) {
+      _(site_journal_add_item(items, key, entry, entries, NULL));
+    }
+    _(site_journal_add_items(items, entry->children));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_reader_prepare(site_journal_reader* reader) {
+  /* The records may change any part of the site */
+  _(site_load(reader->site));
+  _(gf_map_new(&reader->items));
+  _(gf_map_set_free_fn(reader->items, site_journal_item_free));
+  _(site_journal_add_items(reader->items, reader->site->entry_set));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_find_item(
+  const site_journal_reader* reader, const gf_char* key,
+  site_journal_item** item) {
+  gf_any any = { 0 };
+
+  if (!gf_map_find(reader->items, key, &any)) {
+    gf_raise(GF_E_DATA, "Invalid site journal. (%s)", key);
+  }
+  *item = (site_journal_item*)any.ptr;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Take an entry out of the array holding it.
+*/
+
+static gf_status
+site_journal_detach(site_journal_item* item) {
+  gf_size_t cnt = 0;
+
+  if (!item->owner) {
+    return GF_SUCCESS;
+  }
+  cnt = gf_array_size(item->owner);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+
+    _(gf_array_get(item->owner, i, &any));
+    if (any.ptr == item->entry) {
+      /* Cleared not to be freed */
+      _(gf_array_set(item->owner, i, (gf_any){ .ptr = NULL }));
+      _(gf_array_remove(item->owner, i));
+      break;
+    }
+  }
+  item->owner = NULL;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_read_entry(
+  site_journal_reader* reader, const gf_char* key,
+  site_journal_cursor* cur) {
+  gf_status rc = 0;
+  gf_any any = { 0 };
+  site_journal_item* item = NULL;
+  gf_entry* entry = NULL;
+
+  if (gf_map_find(reader->items, key, &any)) {
+    item = (site_journal_item*)any.ptr;
+  } else {
+    /* A new entry is held by no array until it is listed as a child */
+    _(entry_new(&entry, reader->site->taxonomy));
+    rc = site_journal_add_item(reader->items, key, entry, NULL, &item);
+    if (rc != GF_SUCCESS) {
+      gf_entry_free(entry);
+      gf_throw(rc);
+    }
+  }
+  _(site_journal_get_entry(cur, item->entry));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_read_children(
+  site_journal_reader* reader, const gf_char* key,
+  site_journal_cursor* cur) {
+  site_journal_item* item = NULL;
+  gf_array* children = NULL;
+  gf_size_t size = 0;
+  gf_32u cnt = 0;
+
+  if (gf_strnull(key)) {
+    children = reader->site->entry_set;
+  } else {
+    _(site_journal_find_item(reader, key, &item));
+    children = item->entry->children;
+  }
+  /* The current children are held again if they are listed */
+  size = gf_array_size(children);
+  for (gf_size_t i = 0; i < size; i++) {
+    gf_any any = { 0 };
+    const gf_char* child = NULL;
+
+    _(gf_array_get(children, i, &any));
+    child = gf_entry_get_full_path_string((gf_entry*)any.ptr);
+    if (!gf_strnull(child) && gf_map_find(reader->items, child, &any)) {
+      ((site_journal_item*)any.ptr)->owner = NULL;
+      _(gf_array_set(children, i, (gf_any){ .ptr = NULL }));
+    }
+  }
+  _(gf_array_clear(children));
+  _(site_journal_get_32u(cur, &cnt));
+  for (gf_32u i = 0; i < cnt; i++) {
+    const gf_char* child = NULL;
+
+    _(site_journal_get_string(cur, &child));
+    _(site_journal_find_item(reader, child, &item));
+    _(site_journal_detach(item));
+    _(gf_array_add(children, (gf_any){ .ptr = item->entry }));
+    item->owner = children;
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Forget the descendants of an entry to be removed.
+*/
+
+static gf_status
+site_journal_forget(gf_map* items, const gf_entry* entry) {
+  gf_size_t cnt = 0;
+
+  cnt = gf_array_size(entry->children);
+  for (gf_size_t i = 0; i < cnt; i++) {
+    gf_any any = { 0 };
+    const gf_char* key = NULL;
+
+    _(gf_array_get(entry->children, i, &any));
+    _(site_journal_forget(items, (gf_entry*)any.ptr));
+    key = gf_entry_get_full_path_string((gf_entry*)any.ptr);
+    if (!gf_strnull(key)) {
+      _(gf_map_remove(items, key));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_read_remove(site_journal_reader* reader, const gf_char* key) {
+  gf_any any = { 0 };
+  site_journal_item* item = NULL;
+
+  /* The entry may have been removed with its parent */
+  if (!gf_map_find(reader->items, key, &any)) {
+    return GF_SUCCESS;
+  }
+  item = (site_journal_item*)any.ptr;
+  _(site_journal_detach(item));
+  _(site_journal_forget(reader->items, item->entry));
+  /* The entry is freed with the item */
+  _(gf_map_remove(reader->items, key));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_read_record(
+  gf_32u type, const gf_8u* data, gf_size_t size, gf_ptr user) {
+  site_journal_reader* reader = (site_journal_reader*)user;
+  site_journal_cursor cur = { data, size, 0 };
+  const gf_char* key = NULL;
+
+  if (!reader->items) {
+    _(site_journal_reader_prepare(reader));
+  }
+  _(site_journal_get_string(&cur, &key));
+  switch (type) {
+  case SITE_JOURNAL_ENTRY:
+    _(site_journal_read_entry(reader, key, &cur));
+    break;
+  case SITE_JOURNAL_CHILDREN:
+    _(site_journal_read_children(reader, key, &cur));
+    break;
+  case SITE_JOURNAL_REMOVE:
+    _(site_journal_read_remove(reader, key));
+    break;
+  default:
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+  if (cur.offset != cur.size) {
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Apply the journal of a database to the site read from it.
+**
+** The records change the site read as a whole. A site opened by
+** gf_site_open() keeps them by entry instead. See site_open_journal().
+**
+** @param [in, out] site The site read from @a db
+** @param [in]      path The path of the database
+** @param [in]      db   The database
+*/
+
+static gf_status
+site_read_journal(gf_site* site, const gf_path* path, const gf_db* db) {
+  gf_status rc = 0;
+  site_journal_reader reader = { site, NULL };
+  gf_path* journal_path = NULL;
+
+  site->saved.generation = gf_db_get_generation(db);
+  site->saved.db_size = gf_db_get_size(db);
+  _(gf_db_make_journal_path(&journal_path, path));
+  rc = gf_db_journal_read_file(
+    journal_path, site->saved.generation, site_journal_read_record, &reader,
+    &site->saved.journal_size);
+  gf_path_free(journal_path);
+  if (reader.items) {
+    /* The entries left out of the site are freed */
+    gf_map_free(reader.items);
+    if (rc == GF_SUCCESS) {
+      rc = site_build_indices(site);
+    }
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The last records of the journal on a key
+**
+** The payloads are copied from the records, key included.
+*/
+
+typedef struct site_journal_patch {
+  gf_8u*    entry;              ///< The SITE_JOURNAL_ENTRY payload (or NULL)
+  gf_size_t entry_size;         ///< The size of 'entry'
+  gf_8u*    children;           ///< The SITE_JOURNAL_CHILDREN payload (or NULL)
+  gf_size_t children_size;      ///< The size of 'children'
+  gf_char*  parent;             ///< The key of the last list of the entry
+  gf_bool   removed;            ///< The entry in the database was removed
+} site_journal_patch;
+
+/*!
+** @brief The journal of a site opened by gf_site_open()
+**
+** The records are kept by key and applied when an entry is read from the
+** database, so that the entries are still read on demand.
+**
+** An entry belongs to the list of the last SITE_JOURNAL_CHILDREN record
+** naming it, or to the one in the database if there is no such record. An
+** entry once removed is not read from the database again, which is the same
+** as site_journal_read_remove() forgetting the entry.
+*/
+
+struct site_overlay {
+  const gf_db* db;              ///< The database of the site
+  gf_map*      patches;         ///< Key -> site_journal_patch
+  gf_map*      index;           ///< Key -> the entry index (lazily made)
+};
+
+/*!
+** @brief The callback called on a child by site_journal_overlay_foreach()
+**
+** @param [in] key   The key of the child (NULL: none)
+** @param [in] index The index of the child in the database (GF_DB_NONE: none)
+** @param [in] data  The user data
+*/
+
+typedef gf_status (*site_journal_child_fn)(
+  const gf_char* key, gf_32u index, gf_ptr data);
+
+static void
+site_journal_patch_clear(site_journal_patch* patch) {
+  gf_free(patch->entry);
+  gf_free(patch->children);
+  gf_free(patch->parent);
+  patch->entry = NULL;
+  patch->entry_size = 0;
+  patch->children = NULL;
+  patch->children_size = 0;
+  patch->parent = NULL;
+}
+
+static void
+site_journal_patch_free(gf_any* any) {
+  if (any && any->ptr) {
+    site_journal_patch* patch = (site_journal_patch*)any->ptr;
+
+    site_journal_patch_clear(patch);
+    gf_free(patch);
+  }
+}
+
+void
+site_journal_overlay_free(site_overlay* overlay) {
+  if (overlay) {
+    if (overlay->patches) {
+      gf_map_free(overlay->patches);
+    }
+    if (overlay->index) {
+      gf_map_free(overlay->index);
+    }
+    gf_free(overlay);
+  }
+}
+
+static gf_status
+site_journal_overlay_new(site_overlay** overlay, const gf_db* db) {
+  gf_status rc = 0;
+  site_overlay* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->db = db;
+  tmp->patches = NULL;
+  tmp->index = NULL;
+  rc = gf_map_new(&tmp->patches);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set_free_fn(tmp->patches, site_journal_patch_free);
+  }
+  if (rc != GF_SUCCESS) {
+    site_journal_overlay_free(tmp);
+    gf_throw(rc);
+  }
+  *overlay = tmp;
+
+  return GF_SUCCESS;
+}
+
+static site_journal_patch*
+site_journal_overlay_find(
+  const site_overlay* overlay, const gf_char* key) {
+  gf_any any = { 0 };
+
+  /* The empty key is the one of the top-level entries */
+  if (!key || !gf_map_find(overlay->patches, key, &any)) {
+    return NULL;
+  }
+
+  return (site_journal_patch*)any.ptr;
+}
+
+static gf_status
+site_journal_overlay_get(
+  site_overlay* overlay, const gf_char* key,
+  site_journal_patch** patch) {
+  gf_status rc = 0;
+  site_journal_patch* tmp = NULL;
+
+  tmp = site_journal_overlay_find(overlay, key);
+  if (!tmp) {
+    _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+    *tmp = (site_journal_patch){ 0 };
+    rc = gf_map_set(overlay->patches, key, (gf_any){ .ptr = tmp });
+    if (rc != GF_SUCCESS) {
+      gf_free(tmp);
+      gf_throw(rc);
+    }
+  }
+  *patch = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Get the key of an entry of the database.
+**
+** @return The full path of the entry file, or NULL if it has none.
+*/
+
+static const gf_char*
+site_journal_overlay_get_key(
+  const site_overlay* overlay, gf_32u index) {
+  const gf_db_entry* rec = NULL;
+  const gf_db_file* file = NULL;
+  const gf_char* key = NULL;
+
+  rec = gf_db_get_entry(overlay->db, index);
+  if (!rec || rec->file_info == GF_DB_NONE) {
+    return NULL;
+  }
+  file = gf_db_get_file(overlay->db, rec->file_info);
+  if (!file) {
+    return NULL;
+  }
+  key = gf_db_get_string(overlay->db, file->full_path);
+
+  return gf_strnull(key) ? NULL : key;
+}
+
+/*!
+** @brief Get the index of the entry of a key in the database.
+**
+** @return GF_DB_NONE if the entry is not read from the database.
+*/
+
+static gf_32u
+site_journal_overlay_resolve(
+  site_overlay* overlay, const gf_char* key) {
+  const site_journal_patch* patch = NULL;
+  gf_any any = { 0 };
+
+  patch = site_journal_overlay_find(overlay, key);
+  if (gf_strnull(key) || (patch && patch->removed)) {
+    return GF_DB_NONE;
+  }
+  if (!overlay->index) {
+    gf_size_t cnt = gf_db_count_entries(overlay->db);
+
+    if (gf_map_new(&overlay->index) != GF_SUCCESS) {
+      return GF_DB_NONE;
+    }
+    for (gf_32u i = 0; i < cnt; i++) {
+      const gf_char* str = site_journal_overlay_get_key(overlay, i);
+
+      if (str && gf_map_set(overlay->index, str, (gf_any){ .u32 = i }) !=
+          GF_SUCCESS) {
+        gf_map_free(overlay->index);
+        overlay->index = NULL;
+        return GF_DB_NONE;
+      }
+    }
+  }
+  if (!gf_map_find(overlay->index, key, &any)) {
+    return GF_DB_NONE;
+  }
+
+  return any.u32;
+}
+
+/*!
+** @brief Check if an entry listed by a parent still belongs to it.
+*/
+
+static gf_bool
+site_journal_overlay_is_child(
+  const site_overlay* overlay, const gf_char* key,
+  const gf_char* parent) {
+  const site_journal_patch* patch = NULL;
+
+  patch = site_journal_overlay_find(overlay, key);
+  if (!patch) {
+    return GF_TRUE;
+  }
+  if (patch->parent) {
+    return parent && strcmp(patch->parent, parent) == 0;
+  }
+
+  return !patch->removed;
+}
+
+static gf_status
+site_journal_overlay_call(
+  site_overlay* overlay, const gf_char* key, const gf_char* parent,
+  gf_32u index, site_journal_child_fn fn, gf_ptr data) {
+  if (key && !site_journal_overlay_is_child(overlay, key, parent)) {
+    return GF_SUCCESS;
+  }
+  _(fn(key, index, data));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Call a function on each child of an entry.
+**
+** @param [in] overlay The journal
+** @param [in] key     The key of the entry ("": the top-level entries)
+** @param [in] index   The index of the entry in the database
+** @param [in] fn      The callback called on each child
+** @param [in] data    The user data of the callback
+*/
+
+static gf_status
+site_journal_overlay_foreach(
+  site_overlay* overlay, const gf_char* key, gf_32u index,
+  site_journal_child_fn fn, gf_ptr data) {
+  const site_journal_patch* patch = NULL;
+  const gf_db* db = overlay->db;
+  gf_32u next = 0;
+
+  patch = site_journal_overlay_find(overlay, key);
+  if (patch && patch->children) {
+    site_journal_cursor cur = { patch->children, patch->children_size, 0 };
+    const gf_char* str = NULL;
+    gf_32u cnt = 0;
+
+    _(site_journal_get_string(&cur, &str));
+    _(site_journal_get_32u(&cur, &cnt));
+    for (gf_32u i = 0; i < cnt; i++) {
+      _(site_journal_get_string(&cur, &str));
+      _(site_journal_overlay_call(
+          overlay, str, key, site_journal_overlay_resolve(overlay, str),
+          fn, data));
+    }
+    return GF_SUCCESS;
+  }
+  if (key && !*key) {
+    /* The top-level entries are in the database unless listed again */
+    for (gf_32u i = 0; i < gf_db_count_entries(db); i = next) {
+      _(site_journal_overlay_call(
+          overlay, site_journal_overlay_get_key(overlay, i), key, i,
+          fn, data));
+      _(site_db_skip_subtree(db, i, &next));
+    }
+  } else if (index != GF_DB_NONE) {
+    const gf_db_entry* rec = gf_db_get_entry(db, index);
+
+    if (!rec) {
+      gf_raise(GF_E_DATA, "Invalid site database.");
+    }
+    for (gf_32u i = 0; i < rec->children.count; i++) {
+      gf_32u child = gf_db_get_ref(db, &rec->children, i);
+
+      if (child == GF_DB_NONE || child <= index) {
+        gf_raise(GF_E_DATA, "Invalid site database.");
+      }
+      _(site_journal_overlay_call(
+          overlay, site_journal_overlay_get_key(overlay, child), key, child,
+          fn, data));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_count_child(
+  const gf_char* key, gf_32u index, gf_ptr data) {
+  (void)key;
+  (void)index;
+  *(gf_size_t*)data += 1;
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+site_journal_overlay_count_children(const gf_entry* entry) {
+  gf_size_t cnt = 0;
+
+  if (site_journal_overlay_foreach(
+        entry->overlay, gf_entry_get_full_path_string(entry), entry->db_index,
+        site_journal_overlay_count_child, &cnt) != GF_SUCCESS) {
+    return 0;
+  }
+
+  return cnt;
+}
+
+/*!
+** @brief Forget an entry and its descendants of the moment.
+*/
+
+static gf_status
+site_journal_overlay_forget(const gf_char* key, gf_32u index, gf_ptr data) {
+  site_overlay* overlay = (site_overlay*)data;
+  site_journal_patch* patch = NULL;
+
+  /* The children are listed before the patch is cleared */
+  _(site_journal_overlay_foreach(
+      overlay, key, index, site_journal_overlay_forget, overlay));
+  if (key) {
+    _(site_journal_overlay_get(overlay, key, &patch));
+    site_journal_patch_clear(patch);
+    patch->removed = GF_TRUE;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_copy(
+  gf_8u** buf, gf_size_t* buf_size, const gf_8u* data, gf_size_t size) {
+  gf_8u* tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, size));
+  memcpy(tmp, data, size);
+  gf_free(*buf);
+  *buf = tmp;
+  *buf_size = size;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_keep_children(
+  site_overlay* overlay, const gf_char* key,
+  site_journal_cursor* cur) {
+  site_journal_patch* patch = NULL;
+  gf_32u cnt = 0;
+
+  _(site_journal_get_32u(cur, &cnt));
+  for (gf_32u i = 0; i < cnt; i++) {
+    const gf_char* child = NULL;
+
+    _(site_journal_get_string(cur, &child));
+    _(site_journal_overlay_get(overlay, child, &patch));
+    gf_free(patch->parent);
+    patch->parent = NULL;
+    _(gf_strdup(&patch->parent, key));
+  }
+  _(site_journal_overlay_get(overlay, key, &patch));
+  _(site_journal_overlay_copy(
+      &patch->children, &patch->children_size, cur->data, cur->size));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_keep(
+  gf_32u type, const gf_8u* data, gf_size_t size, gf_ptr user) {
+  site_overlay* overlay = (site_overlay*)user;
+  site_journal_cursor cur = { data, size, 0 };
+  site_journal_patch* patch = NULL;
+  const gf_char* key = NULL;
+
+  _(site_journal_get_string(&cur, &key));
+  switch (type) {
+  case SITE_JOURNAL_ENTRY:
+    /* The rest is checked when the entry is read */
+    _(site_journal_overlay_get(overlay, key, &patch));
+    _(site_journal_overlay_copy(&patch->entry, &patch->entry_size, data, size));
+    cur.offset = cur.size;
+    break;
+  case SITE_JOURNAL_CHILDREN:
+    _(site_journal_overlay_keep_children(overlay, key, &cur));
+    break;
+  case SITE_JOURNAL_REMOVE:
+    _(site_journal_overlay_forget(
+        key, site_journal_overlay_resolve(overlay, key), overlay));
+    break;
+  default:
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+  if (cur.offset != cur.size) {
+    gf_raise(GF_E_DATA, "Invalid site journal.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Read the journal of a site opened by gf_site_open().
+**
+** The records are kept in site->overlay, which is left NULL if the journal
+** has none.
+*/
+
+static gf_status
+site_open_journal(gf_site* site, const gf_path* path) {
+  gf_status rc = 0;
+  site_overlay* overlay = NULL;
+  gf_path* journal_path = NULL;
+
+  site->saved.generation = gf_db_get_generation(site->db);
+  site->saved.db_size = gf_db_get_size(site->db);
+  _(site_journal_overlay_new(&overlay, site->db));
+  rc = gf_db_make_journal_path(&journal_path, path);
+  if (rc == GF_SUCCESS) {
+    rc = gf_db_journal_read_file(
+      journal_path, site->saved.generation, site_journal_overlay_keep,
+      overlay, &site->saved.journal_size);
+  }
+  gf_path_free(journal_path);
+  if (rc != GF_SUCCESS || gf_map_size(overlay->patches) == 0) {
+    site_journal_overlay_free(overlay);
+    if (rc != GF_SUCCESS) {
+      gf_throw(rc);
+    }
+    return GF_SUCCESS;
+  }
+  site->overlay = overlay;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Apply the last SITE_JOURNAL_ENTRY record of an entry.
+**
+** The lists of the record replace the ones pending in the database.
+*/
+
+static gf_status
+site_journal_overlay_apply(gf_entry* entry, const site_journal_patch* patch) {
+  site_journal_cursor cur = { 0 };
+  const gf_char* key = NULL;
+
+  if (!patch || !patch->entry) {
+    return GF_SUCCESS;
+  }
+  cur = (site_journal_cursor){ patch->entry, patch->entry_size, 0 };
+  _(site_journal_get_string(&cur, &key));
+  _(site_journal_get_entry(&cur, entry));
+  if (cur.offset != cur.size) {
+    gf_raise(GF_E_DATA, "Invalid site journal. (%s)", key);
+  }
+  entry->pending &=
+    ~(gf_32u)(ENTRY_PENDING_FILE_SET | ENTRY_PENDING_DESCRIPTION);
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_apply_entry(gf_entry* entry) {
+  const site_journal_patch* patch = NULL;
+
+  patch = site_journal_overlay_find(
+    entry->overlay, gf_entry_get_full_path_string(entry));
+  _(site_journal_overlay_apply(entry, patch));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief The list to which the children are read
+*/
+
+typedef struct site_overlay_reader {
+  site_overlay*  overlay;      ///< The journal
+  site_taxonomy* taxonomy;     ///< The categories of the site
+  gf_array*      entries;      ///< The list of the children
+  gf_bool        lazy;         ///< Leave the parts of the children pending
+} site_overlay_reader;
+
+/*!
+** @brief Read a child, which is made from the journal if it is not read from
+** the database.
+*/
+
+static gf_status
+site_journal_overlay_read_child(
+  const gf_char* key, gf_32u index, gf_ptr data) {
+  gf_status rc = 0;
+  site_overlay_reader* reader = (site_overlay_reader*)data;
+  const site_journal_patch* patch = NULL;
+  gf_entry* entry = NULL;
+
+  if (index != GF_DB_NONE) {
+    _(site_db_read_entry(
+        reader->taxonomy, reader->entries, reader->overlay->db,
+        reader->overlay, index, reader->lazy));
+    return GF_SUCCESS;
+  }
+  patch = site_journal_overlay_find(reader->overlay, key);
+  if (!patch || !patch->entry) {
+    gf_raise(GF_E_DATA, "Invalid site journal. (%s)", key ? key : "");
+  }
+  _(entry_new(&entry, reader->taxonomy));
+  rc = gf_array_add(reader->entries, (gf_any){ .ptr = entry });
+  if (rc != GF_SUCCESS) {
+    gf_entry_free(entry);
+    gf_throw(rc);
+  }
+  entry->db = reader->overlay->db;
+  entry->db_index = GF_DB_NONE;
+  entry->overlay = reader->overlay;
+  entry->pending = ENTRY_PENDING_CHILDREN;
+  _(site_journal_overlay_apply(entry, patch));
+  if (!reader->lazy) {
+    _(site_db_load_entry(entry, ENTRY_PENDING_ALL, GF_FALSE));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_read_children(gf_entry* entry, gf_bool lazy) {
+  site_overlay_reader reader = {
+    entry->overlay, entry->taxonomy, entry->children, lazy
+  };
+
+  _(site_journal_overlay_foreach(
+      entry->overlay, gf_entry_get_full_path_string(entry), entry->db_index,
+      site_journal_overlay_read_child, &reader));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+site_journal_overlay_read_site(gf_site* site) {
+  site_overlay_reader reader = {
+    site->overlay, site->taxonomy, site->entry_set, GF_TRUE
+  };
+
+  _(site_journal_overlay_foreach(
+      site->overlay, "", GF_DB_NONE, site_journal_overlay_read_child,
+      &reader));
+
+  return GF_SUCCESS;
+}
+
+/* @} */
@@ -0,0 +1,304 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_site_local.h
+** @brief Local definitions shared by the modules of the site.
+**
+** The site objects are defined in gf_site.c. The entry cache in
+** gf_entry_cache.c and the site database codec and its journal in
+** gf_site_db.c read and write the entries through the definitions here.
+*/
+#ifndef LIBGF_GF_SITE_LOCAL_H
+#define LIBGF_GF_SITE_LOCAL_H
+
+#pragma once
+
+#include <stdio.h>
+
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_db.h>
+#include <libgf/gf_site.h>
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief A subject of entries
+**
+*/
+
+struct gf_category {
+  gf_string* id;      ///< String usable for a URL or an identifier etc.
+  gf_string* name;    ///< Printable name
+  gf_array*  entries; ///< Entries referring to this (set by the site)
+};
+
+/*!
+** @brief The categories shared by the entries of a site or a cache.
+**
+** Each category is stored once per kind, and the entries refer to it by its
+** index in 'categories'. The categories are kept until the taxonomy is
+** cleared, so the indices held by the entries stay valid. The entry files
+** are read in parallel, and thus the tables are guarded by the lock.
+*/
+
+typedef struct site_taxonomy {
+  gf_array* categories[2];    ///< gf_category objects by gf_category_kind
+  gf_map*   index[2];         ///< ID string -> the index in 'categories'
+  gf_mutex  lock;             ///< Guards the tables while reading entries
+} site_taxonomy;
+
+extern gf_status site_taxonomy_new(site_taxonomy** taxonomy);
+extern void site_taxonomy_free(site_taxonomy* taxonomy);
+
+/*!
+** @brief The journal applied to the entries read on demand
+*/
+
+typedef struct site_overlay site_overlay;
+
+/*!
+** @brief Site entry object.
+**
+** An entry is a resource of the website, which is determined to be processed by
+** the Grayfish convertion processor. Not the all source files in the website
+** are regarded as entry objects. Only the following files are processed as
+** site entries.
+**
+**   - First, the directory including meta.gf file is treated as a section entry
+**   - Second, the index.dbk is regarded as a main document entry.
+*/
+
+struct gf_entry {
+  gf_entry_type  type;        ///< Type of a entry
+  gf_entry_state state;       ///< State of a entry
+  gf_string*     title;       ///< Entry title retrieved from an entry file
+  gf_string*     author;      ///< Name of an author read from an entry file
+  gf_datetime    date;        ///< Published date read from an entry file
+  gf_array*      description; ///< A description composed with paragraph strings
+  gf_file_info*  file_info;   ///< The info file. (meta.gf, index.dbk ...)
+  gf_string*     method;      ///< The process type linked to the XSLT file name
+  gf_site*       site;        ///< The site object which includes this object
+  gf_path*       output_path; ///< The output path 
+  site_taxonomy* taxonomy;    ///< The categories referred by the sets
+  gf_array*      subject_set; ///< Indices of the subjects in the taxonomy
+  gf_array*      keyword_set; ///< Indices of the keywords in the taxonomy
+  gf_array*      file_set;    ///< Array of gf_file_info objects
+  gf_array*      children;    ///< Entry children
+  const gf_db*   db;          ///< The database of the pending parts
+  gf_32u         db_index;    ///< The index of the entry in the database
+  gf_32u         pending;     ///< ENTRY_PENDING_* not read from the database
+  site_overlay*  overlay;     ///< The journal of the pending parts
+  gf_32u         seq;         ///< The position in the preorder of the site
+};
+
+/*!
+** @brief The parts of an entry read from the database on demand
+**
+** See gf_site_open().
+*/
+
+enum {
+  ENTRY_PENDING_CHILDREN    = 0x01,
+  ENTRY_PENDING_FILE_SET    = 0x02,
+  ENTRY_PENDING_DESCRIPTION = 0x04,
+  ENTRY_PENDING_ALL         = 0x07,
+};
+
+extern gf_status entry_new(gf_entry** entry, site_taxonomy* taxonomy);
+extern gf_status entry_copy_info(gf_entry* dst, const gf_entry* src);
+extern gf_array* entry_get_category_set(
+  const gf_entry* entry, gf_category_kind kind);
+extern gf_status entry_add_category(
+  gf_entry* entry, gf_category_kind kind, const gf_char* id,
+  const gf_char* name);
+extern gf_status entry_load(const gf_entry* entry, gf_32u parts);
+extern gf_status entry_get_category(
+  const gf_entry* entry, gf_category_kind kind, gf_size_t index,
+  gf_category** cat);
+extern gf_status entry_reset_info(gf_entry* entry);
+
+/*!
+** @brief The database which a site was read from or saved to
+**
+** This is the base of the journal appended by gf_site_save_db(). The
+** fingerprints are taken when they are first needed, i.e. before the site
+** is changed in place or when the journal is appended.
+*/
+
+typedef struct site_db_state {
+  gf_32u  generation;   ///< The generation of the database (0: none)
+  gf_64u  db_size;      ///< The size of the database
+  gf_64u  journal_size; ///< The size of the valid part of the journal
+  gf_map* entries;      ///< Key -> the fingerprint of the entry record
+  gf_map* children;     ///< Key -> the fingerprint of the children record
+} site_db_state;
+
+extern void site_db_state_clear(site_db_state* state);
+
+/*!
+** @brief The website structure.
+**
+** This structure represents whole your website information. By this, you can
+** update or build the website.
+*/
+
+struct gf_site {
+  gf_array*      entry_set; ///< Entries to process
+  gf_file_info*  tree;      ///< The scanned tree referred by the entries
+  site_taxonomy* taxonomy;  ///< The categories referred by the entries
+  gf_db*         db;        ///< The database read on demand (gf_site_open)
+  site_overlay*  overlay;   ///< The journal of the database (or NULL)
+  gf_array*      by_date;   ///< The entries with the date, newest first
+  gf_array*      methods;   ///< gf_category objects of methods, sorted by ID
+  site_db_state  saved;     ///< The database of the site
+  gf_64u         scan_time; ///< The time the files were scanned (0: unknown)
+};
+
+extern gf_status site_build_indices(gf_site* site);
+extern gf_status site_load(gf_site* site);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The names of the elements in site.xml and the entry cache
+*/
+
+enum site_xml_name {
+  SITE_XML_NONE = 0,            ///< No more child elements
+  SITE_XML_UNKNOWN,             ///< An element of another name
+  SITE_XML_SITE,
+  SITE_XML_ENTRY_CACHE,
+  SITE_XML_ITEM,
+  SITE_XML_ENTRY,
+  SITE_XML_INDICES,
+  SITE_XML_TYPE,
+  SITE_XML_STATE,
+  SITE_XML_TITLE,
+  SITE_XML_AUTHOR,
+  SITE_XML_DATE,
+  SITE_XML_DESCRIPTION,
+  SITE_XML_P,
+  SITE_XML_METHOD,
+  SITE_XML_OUTPUT_PATH,
+  SITE_XML_FILE_INFO,
+  SITE_XML_FILE_SET,
+  SITE_XML_SUBJECT_SET,
+  SITE_XML_SUBJECT,
+  SITE_XML_KEYWORD_SET,
+  SITE_XML_KEYWORD,
+  SITE_XML_CHILDREN,
+  SITE_XML_FILE_NAME,
+  SITE_XML_FULL_PATH,
+  SITE_XML_HASH,
+  SITE_XML_HASH_SIZE,
+  SITE_XML_HASH_ALGORITHM,
+  SITE_XML_INODE,
+  SITE_XML_MODE,
+  SITE_XML_LINK_COUNT,
+  SITE_XML_UID,
+  SITE_XML_GID,
+  SITE_XML_DEVICE,
+  SITE_XML_RDEVICE,
+  SITE_XML_FILE_SIZE,
+  SITE_XML_ACCESS_TIME,
+  SITE_XML_MODIFY_TIME,
+  SITE_XML_CREATE_TIME,
+  SITE_XML_NAME_COUNT,
+};
+
+typedef enum site_xml_name site_xml_name;
+
+/*!
+** @brief A stream to which an XML file is written
+**
+** The elements are written to the buffered file as soon as they are made, so
+** the document tree is never built in memory. The file is written to a
+** temporary file, which replaces the file when the stream is closed.
+*/
+
+typedef struct site_xml_stream {
+  FILE*            fp;       ///< The temporary file
+  xmlTextWriterPtr writer;   ///< The writer on the temporary file
+  gf_path*         tmp_path; ///< The path of the temporary file
+} site_xml_stream;
+
+extern gf_status site_open_xml_stream(
+  site_xml_stream* stream, const gf_path* path);
+extern gf_status site_close_xml_stream(
+  site_xml_stream* stream, const gf_path* path, gf_status rc);
+extern gf_status site_write_xml_start(
+  xmlTextWriterPtr writer, const gf_char* name);
+extern gf_status site_write_xml_end(xmlTextWriterPtr writer);
+extern gf_status site_write_xml_attribute(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* value);
+extern gf_status site_write_xml_element(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* value);
+extern gf_status site_write_xml_category_set(
+  xmlTextWriterPtr writer, const gf_char* name, const gf_char* child_name,
+  const gf_entry* entry, gf_category_kind kind);
+extern gf_status site_write_xml_entry_info(
+  xmlTextWriterPtr writer, const gf_entry* entry);
+
+/*!
+** @brief A streaming reader of site.xml and the entry cache
+**
+** The file is read node by node, and the objects are made from the elements
+** as they are read. The reader frees the nodes which have been passed, so the
+** memory used for parsing does not depend on the size of the file.
+*/
+
+typedef struct site_xml_loader {
+  xmlTextReaderPtr reader;      ///< The reader on the file
+  gf_char*         text;        ///< The buffer of the text of an element
+  gf_size_t        size;        ///< The size of the buffer
+} site_xml_loader;
+
+extern gf_status site_open_xml_loader(
+  site_xml_loader* loader, const gf_path* path, int option);
+extern void site_close_xml_loader(site_xml_loader* loader);
+extern site_xml_name site_xml_get_name(const site_xml_loader* loader);
+extern gf_status site_xml_first_child(
+  site_xml_loader* loader, int* depth, site_xml_name* name);
+extern gf_status site_xml_next_child(
+  site_xml_loader* loader, int depth, site_xml_name* name);
+extern gf_status site_xml_read_text(
+  site_xml_loader* loader, const gf_char** text);
+extern gf_status site_read_xml_entry_info(
+  site_xml_loader* loader, gf_entry* entry, site_xml_name name,
+  gf_bool* found);
+extern gf_status entry_move_to_element(xmlTextReaderPtr reader, int depth);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The journal of a site database.
+**
+** See gf_site_db.c.
+*/
+
+extern void site_db_state_capture(gf_site* site);
+extern void site_journal_overlay_free(site_overlay* overlay);
+extern gf_size_t site_journal_overlay_count_children(const gf_entry* entry);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The records of the entry cache used while a site is scanned.
+**
+** See gf_entry_cache.c.
+*/
+
+extern gf_bool entry_cache_lookup(
+  gf_entry_cache* cache, const gf_char* key, const gf_entry* entry,
+  const gf_entry** found);
+extern gf_status entry_cache_store(
+  gf_entry_cache* cache, const gf_char* key, const gf_entry* entry);
+
+#endif  /* LIBGF_GF_SITE_LOCAL_H */
@@ -36,7 +36,7 @@ gf_strdup(char** dst, const char* src) {
   
   _(gf_malloc((gf_ptr *)&str, bufsize));
   str[len] = '\0';
-  memcpy_s(str, bufsize, src, len);
+  memcpy(str, src, len);
   *dst = str;
   
   return GF_SUCCESS;
@@ -34,7 +34,6 @@ extern "C" {
 /*!
 ** @brief Swap the values of the two objects.
 **
-** @note The function memcpy_s() is 
 ** @note This macro does not check if the two object is the same type.
 ** 
 ** @param [in, out] lhs 
@@ -43,9 +42,9 @@ extern "C" {
 
 #define gf_swap(lhs, rhs) do {                      \
     unsigned char tmp_[gf_sizeof(lhs, rhs)];        \
-    memcpy_s(tmp_, sizeof(lhs), &rhs, sizeof(lhs)); \
-    memcpy_s(&rhs, sizeof(lhs), &lhs, sizeof(lhs)); \
-    memcpy_s(&lhs, sizeof(lhs), tmp_, sizeof(lhs)); \
+    memcpy(tmp_, &rhs, sizeof(lhs));                \
+    memcpy(&rhs, &lhs, sizeof(lhs));                \
+    memcpy(&lhs, tmp_, sizeof(lhs));                \
   } while (0);
 
 #ifdef __cplusplus
@@ -0,0 +1,182 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_thread.c
+** @brief Thread and synchronization primitives.
+*/
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_thread.h>
+
+#include "gf_local.h"
+
+typedef struct thread_start {
+  gf_thread_fn fn;
+  gf_ptr       data;
+} thread_start;
+
+static void*
+thread_entry(void* arg) {
+  thread_start start = *(thread_start*)arg;
+
+  gf_free(arg);
+  start.fn(start.data);
+
+  return NULL;
+}
+
+gf_status
+gf_thread_create(gf_thread* thread, gf_thread_fn fn, gf_ptr data) {
+  int ret = 0;
+  thread_start* start = NULL;
+
+  gf_validate(thread);
+  gf_validate(fn);
+
+  _(gf_malloc((gf_ptr*)&start, sizeof(*start)));
+  start->fn = fn;
+  start->data = data;
+
+  ret = pthread_create(thread, NULL, thread_entry, start);
+  if (ret != 0) {
+    gf_free(start);
+    gf_raise(GF_E_API, "Failed to create a thread.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_thread_join(gf_thread thread) {
+  int ret = 0;
+
+  ret = pthread_join(thread, NULL);
+  if (ret != 0) {
+    gf_raise(GF_E_API, "Failed to join a thread.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_size_t
+gf_thread_count_cores(void) {
+  gf_size_t cores = 0;
+
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+
+  GetSystemInfo(&info);
+  cores = (gf_size_t)info.dwNumberOfProcessors;
+#else
+  long ret = sysconf(_SC_NPROCESSORS_ONLN);
+
+  cores = ret > 0 ? (gf_size_t)ret : 0;
+#endif
+
+  return cores > 0 ? cores : 1;
+}
+
+gf_size_t
+gf_thread_resolve_count(gf_int threads) {
+  return threads > 0 ? (gf_size_t)threads : gf_thread_count_cores();
+}
+
+void
+gf_thread_call_once(gf_thread_once* once, void (*fn)(void)) {
+  (void)pthread_once(once, fn);
+}
+
+gf_status
+gf_thread_key_create(gf_thread_key* key, void (*fn)(gf_ptr value)) {
+  gf_validate(key);
+
+  if (pthread_key_create(key, fn) != 0) {
+    gf_raise(GF_E_API, "Failed to create a thread specific data key.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_ptr
+gf_thread_key_get(gf_thread_key key) {
+  return pthread_getspecific(key);
+}
+
+gf_status
+gf_thread_key_set(gf_thread_key key, gf_ptr value) {
+  if (pthread_setspecific(key, value) != 0) {
+    gf_raise(GF_E_API, "Failed to set thread specific data.");
+  }
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+gf_status
+gf_mutex_init(gf_mutex* mutex) {
+  gf_validate(mutex);
+
+  if (pthread_mutex_init(mutex, NULL) != 0) {
+    gf_raise(GF_E_API, "Failed to initialize a mutex.");
+  }
+
+  return GF_SUCCESS;
+}
+
+void
+gf_mutex_destroy(gf_mutex* mutex) {
+  if (mutex) {
+    (void)pthread_mutex_destroy(mutex);
+  }
+}
+
+void
+gf_mutex_lock(gf_mutex* mutex) {
+  (void)pthread_mutex_lock(mutex);
+}
+
+void
+gf_mutex_unlock(gf_mutex* mutex) {
+  (void)pthread_mutex_unlock(mutex);
+}
+
+gf_status
+gf_cond_init(gf_cond* cond) {
+  gf_validate(cond);
+
+  if (pthread_cond_init(cond, NULL) != 0) {
+    gf_raise(GF_E_API, "Failed to initialize a condition variable.");
+  }
+
+  return GF_SUCCESS;
+}
+
+void
+gf_cond_destroy(gf_cond* cond) {
+  if (cond) {
+    (void)pthread_cond_destroy(cond);
+  }
+}
+
+void
+gf_cond_wait(gf_cond* cond, gf_mutex* mutex) {
+  (void)pthread_cond_wait(cond, mutex);
+}
+
+void
+gf_cond_signal(gf_cond* cond) {
+  (void)pthread_cond_signal(cond);
+}
+
+void
+gf_cond_broadcast(gf_cond* cond) {
+  (void)pthread_cond_broadcast(cond);
+}
@@ -0,0 +1,123 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_thread.h
+** @brief Thread and synchronization primitives.
+*/
+#ifndef LIBGF_GF_THREAD_H
+#define LIBGF_GF_THREAD_H
+
+#pragma once
+
+#include <pthread.h>
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef pthread_t       gf_thread;
+typedef pthread_mutex_t gf_mutex;
+typedef pthread_cond_t  gf_cond;
+typedef pthread_key_t   gf_thread_key;
+typedef pthread_once_t  gf_thread_once;
+
+#define GF_THREAD_ONCE_INIT PTHREAD_ONCE_INIT
+
+/*!
+** @brief Entry point of a thread
+**
+** @param [in] data The user data passed to gf_thread_create()
+*/
+
+typedef void (*gf_thread_fn)(gf_ptr data);
+
+/*!
+** @brief Start a new thread
+**
+** @param [out] thread The handle of the new thread
+** @param [in]  fn     The entry point of the thread
+** @param [in]  data   The user data passed to @a fn
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_thread_create(
+  gf_thread* thread, gf_thread_fn fn, gf_ptr data);
+
+/*!
+** @brief Wait for the thread to finish
+**
+** @param [in] thread The thread handle returned by gf_thread_create()
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_thread_join(gf_thread thread);
+
+/*!
+** @brief Count the processors available to this process
+**
+** @return The number of processors (at least 1)
+*/
+
+extern gf_size_t gf_thread_count_cores(void);
+
+/*!
+** @brief Resolve the number of worker threads from a configured value
+**
+** A value of zero (or less) means one worker per processor.
+**
+** @param [in] threads The configured number of threads
+**
+** @return The number of worker threads (at least 1)
+*/
+
+extern gf_size_t gf_thread_resolve_count(gf_int threads);
+
+/*!
+** @brief Call the function exactly once in the process
+**
+** @param [in] once The flag initialized with GF_THREAD_ONCE_INIT
+** @param [in] fn   The function to be called
+*/
+
+extern void gf_thread_call_once(gf_thread_once* once, void (*fn)(void));
+
+/*!
+** @brief Create a key of thread specific data
+**
+** @param [out] key The key to be created
+** @param [in]  fn  Called with the value on exit of each thread (may be NULL)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_thread_key_create(
+  gf_thread_key* key, void (*fn)(gf_ptr value));
+
+extern gf_ptr gf_thread_key_get(gf_thread_key key);
+extern gf_status gf_thread_key_set(gf_thread_key key, gf_ptr value);
+
+extern gf_status gf_mutex_init(gf_mutex* mutex);
+extern void gf_mutex_destroy(gf_mutex* mutex);
+extern void gf_mutex_lock(gf_mutex* mutex);
+extern void gf_mutex_unlock(gf_mutex* mutex);
+
+extern gf_status gf_cond_init(gf_cond* cond);
+extern void gf_cond_destroy(gf_cond* cond);
+extern void gf_cond_wait(gf_cond* cond, gf_mutex* mutex);
+extern void gf_cond_signal(gf_cond* cond);
+extern void gf_cond_broadcast(gf_cond* cond);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_THREAD_H */
@@ -0,0 +1,620 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_watch.c
+** @brief Notification of the changes in directory trees.
+*/
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_string.h>
+#include <libgf/gf_shell.h>
+#include <libgf/gf_watch.h>
+
+#include "gf_local.h"
+
+/* The size of the buffer into which the changes are read */
+#define WATCH_BUFSIZE (64 * 1024)
+
+#if defined(_WIN32)
+
+/*
+** Each tree is watched through the handle of its root directory, which is
+** read by ReadDirectoryChangesW recursively with an overlapped I/O. The
+** events of the overlapped I/Os are waited for at once.
+*/
+
+typedef struct watch_root {
+  HANDLE     dir;
+  OVERLAPPED overlapped;
+  DWORD      buf[WATCH_BUFSIZE / sizeof(DWORD)];
+} watch_root;
+
+struct gf_watch {
+  watch_root** roots;
+  gf_size_t    count;
+};
+
+static const DWORD WATCH_FILTER =
+  FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+  FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+static void
+watch_root_free(watch_root* root) {
+  if (root) {
+    if (root->dir != INVALID_HANDLE_VALUE) {
+      CancelIo(root->dir);
+      CloseHandle(root->dir);
+    }
+    if (root->overlapped.hEvent) {
+      CloseHandle(root->overlapped.hEvent);
+    }
+    gf_free(root);
+  }
+}
+
+static gf_status
+watch_root_read(watch_root* root) {
+  BOOL ret = FALSE;
+
+  ret = ReadDirectoryChangesW(
+    root->dir, root->buf, sizeof(root->buf), TRUE, WATCH_FILTER, NULL,
+    &root->overlapped, NULL);
+  if (!ret) {
+    gf_raise(GF_E_API, "Failed to watch a directory.");
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_watch_new(gf_watch** watch) {
+  gf_watch* tmp = NULL;
+
+  gf_validate(watch);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->roots = NULL;
+  tmp->count = 0;
+
+  *watch = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_watch_free(gf_watch* watch) {
+  if (watch) {
+    for (gf_size_t i = 0; i < watch->count; i++) {
+      watch_root_free(watch->roots[i]);
+    }
+    gf_free(watch->roots);
+    gf_free(watch);
+  }
+}
+
+gf_status
+gf_watch_add_tree(gf_watch* watch, const gf_path* path, gf_size_t* root) {
+  gf_status rc = 0;
+  watch_root* tmp = NULL;
+
+  gf_validate(watch);
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(root);
+
+  if (watch->count >= MAXIMUM_WAIT_OBJECTS) {
+    gf_raise(GF_E_PARAM, "Too many directories to be watched.");
+  }
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  memset(tmp, 0, sizeof(*tmp));
+  tmp->dir = CreateFile(
+    gf_path_get_string(path), FILE_LIST_DIRECTORY,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+  if (tmp->dir == INVALID_HANDLE_VALUE) {
+    watch_root_free(tmp);
+    gf_raise(GF_E_OPEN, "Failed to open a directory. (%s)",
+             gf_path_get_string(path));
+  }
+  tmp->overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (!tmp->overlapped.hEvent) {
+    watch_root_free(tmp);
+    gf_raise(GF_E_API, "Failed to create an event.");
+  }
+  rc = watch_root_read(tmp);
+  if (rc == GF_SUCCESS) {
+    rc = gf_realloc((gf_ptr*)&watch->roots,
+                    sizeof(*watch->roots) * (watch->count + 1));
+  }
+  if (rc != GF_SUCCESS) {
+    watch_root_free(tmp);
+    gf_throw(rc);
+  }
+  watch->roots[watch->count] = tmp;
+  *root = watch->count++;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_notify(
+  gf_size_t index, const FILE_NOTIFY_INFORMATION* info,
+  gf_watch_fn fn, gf_ptr data) {
+  gf_char buf[MAX_PATH * 2 + 2] = { 0 };
+  gf_32u flags = 0;
+  int len = 0;
+
+  /* The path is relative to the root, which is separated by '/' */
+  buf[0] = GF_PATH_SEPARATOR_CHAR;
+  len = WideCharToMultiByte(
+    CP_ACP, 0, info->FileName, (int)(info->FileNameLength / sizeof(WCHAR)),
+    buf + 1, (int)sizeof(buf) - 2, NULL, NULL);
+  if (len <= 0) {
+    gf_warn("Failed to convert a changed file name.");
+    return GF_SUCCESS;
+  }
+  for (int i = 1; i <= len; i++) {
+    if (buf[i] == '\\') {
+      buf[i] = GF_PATH_SEPARATOR_CHAR;
+    }
+  }
+  switch (info->Action) {
+  case FILE_ACTION_REMOVED:
+  case FILE_ACTION_RENAMED_OLD_NAME:
+    flags = GF_WATCH_REMOVE;
+    break;
+  default:
+    flags = GF_WATCH_MODIFY;
+    break;
+  }
+
+  return fn(index, buf, flags, data);
+}
+
+static gf_status
+watch_read_root(
+  gf_watch* watch, gf_size_t index, gf_watch_fn fn, gf_ptr data,
+  gf_size_t* count) {
+  watch_root* root = watch->roots[index];
+  DWORD size = 0;
+  const gf_8u* cur = NULL;
+
+  if (!GetOverlappedResult(root->dir, &root->overlapped, &size, FALSE)) {
+    gf_raise(GF_E_READ, "Failed to read the changes of a directory.");
+  }
+  ResetEvent(root->overlapped.hEvent);
+  if (size == 0) {
+    /* The buffer of the system has overflowed */
+    _(fn(index, "", GF_WATCH_OVERFLOW, data));
+    (*count)++;
+  } else {
+    cur = (const gf_8u*)root->buf;
+    for (;;) {
+      const FILE_NOTIFY_INFORMATION* info = (const void*)cur;
+
+      _(watch_notify(index, info, fn, data));
+      (*count)++;
+      if (!info->NextEntryOffset) {
+        break;
+      }
+      cur += info->NextEntryOffset;
+    }
+  }
+  _(watch_root_read(root));
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_watch_wait(
+  gf_watch* watch, gf_int timeout, gf_watch_fn fn, gf_ptr data,
+  gf_size_t* count) {
+  HANDLE events[MAXIMUM_WAIT_OBJECTS] = { 0 };
+  DWORD ret = 0;
+
+  gf_validate(watch);
+  gf_validate(watch->count > 0);
+  gf_validate(fn);
+  gf_validate(count);
+
+  *count = 0;
+  for (gf_size_t i = 0; i < watch->count; i++) {
+    events[i] = watch->roots[i]->overlapped.hEvent;
+  }
+  ret = WaitForMultipleObjects(
+    (DWORD)watch->count, events, FALSE, timeout < 0 ? INFINITE : timeout);
+  if (ret == WAIT_TIMEOUT) {
+    return GF_SUCCESS;
+  }
+  if (ret >= WAIT_OBJECT_0 + watch->count) {
+    gf_raise(GF_E_API, "Failed to wait for the changes.");
+  }
+  /* Read the signaled tree and the others which are ready as well */
+  for (gf_size_t i = ret - WAIT_OBJECT_0; i < watch->count; i++) {
+    if (WaitForSingleObject(events[i], 0) == WAIT_OBJECT_0) {
+      _(watch_read_root(watch, i, fn, data, count));
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+#else
+
+/*
+** inotify does not watch a tree recursively, so every directory in the trees
+** is watched. The watch descriptors are allocated in increasing order, so the
+** records are appended to a sorted array and looked up by binary search.
+*/
+
+typedef struct watch_dir {
+  int       wd;                 ///< The watch descriptor
+  gf_size_t root;               ///< The index of the tree
+  gf_char*  path;               ///< The path relative to the root ("" or "/a")
+} watch_dir;
+
+struct gf_watch {
+  int        fd;                ///< The inotify instance
+  gf_char**  roots;             ///< The real paths of the trees
+  gf_size_t  root_count;
+  watch_dir* dirs;              ///< The watched directories sorted by wd
+  gf_size_t  dir_count;
+  gf_size_t  dir_capacity;
+};
+
+static const uint32_t WATCH_MASK =
+  IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+  IN_ONLYDIR | IN_DONT_FOLLOW;
+
+gf_status
+gf_watch_new(gf_watch** watch) {
+  gf_watch* tmp = NULL;
+
+  gf_validate(watch);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  memset(tmp, 0, sizeof(*tmp));
+  tmp->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (tmp->fd < 0) {
+    gf_free(tmp);
+    gf_raise(GF_E_API, "Failed to initialize inotify.");
+  }
+
+  *watch = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_watch_free(gf_watch* watch) {
+  if (watch) {
+    for (gf_size_t i = 0; i < watch->dir_count; i++) {
+      gf_free(watch->dirs[i].path);
+    }
+    for (gf_size_t i = 0; i < watch->root_count; i++) {
+      gf_free(watch->roots[i]);
+    }
+    gf_free(watch->dirs);
+    gf_free(watch->roots);
+    if (watch->fd >= 0) {
+      close(watch->fd);
+    }
+    gf_free(watch);
+  }
+}
+
+static watch_dir*
+watch_find_dir(gf_watch* watch, int wd) {
+  gf_size_t lo = 0;
+  gf_size_t hi = watch->dir_count;
+
+  while (lo < hi) {
+    gf_size_t mid = lo + (hi - lo) / 2;
+
+    if (watch->dirs[mid].wd < wd) {
+      lo = mid + 1;
+    } else if (watch->dirs[mid].wd > wd) {
+      hi = mid;
+    } else {
+      return &watch->dirs[mid];
+    }
+  }
+
+  return NULL;
+}
+
+static void
+watch_remove_dir(gf_watch* watch, watch_dir* dir) {
+  gf_size_t index = (gf_size_t)(dir - watch->dirs);
+
+  gf_free(dir->path);
+  memmove(dir, dir + 1, sizeof(*dir) * (watch->dir_count - index - 1));
+  watch->dir_count--;
+}
+
+static gf_status
+watch_add_dir(
+  gf_watch* watch, gf_size_t root, const gf_char* real_path,
+  const gf_char* path) {
+  int wd = 0;
+  gf_char* tmp = NULL;
+  gf_size_t index = 0;
+  watch_dir* dir = NULL;
+
+  wd = inotify_add_watch(watch->fd, real_path, WATCH_MASK);
+  if (wd < 0) {
+    if (errno == ENOENT || errno == ENOTDIR) {
+      /* Already removed */
+      return GF_SUCCESS;
+    }
+    gf_raise(GF_E_API, "Failed to watch a directory. (%s)", real_path);
+  }
+  _(gf_strdup(&tmp, path));
+  /* The directory may be watched already */
+  dir = watch_find_dir(watch, wd);
+  if (dir) {
+    gf_free(dir->path);
+    dir->root = root;
+    dir->path = tmp;
+    return GF_SUCCESS;
+  }
+  if (watch->dir_count == watch->dir_capacity) {
+    gf_size_t capacity = watch->dir_capacity ? watch->dir_capacity * 2 : 64;
+    gf_status rc = 0;
+
+    rc = gf_realloc((gf_ptr*)&watch->dirs, sizeof(*watch->dirs) * capacity);
+    if (rc != GF_SUCCESS) {
+      gf_free(tmp);
+      gf_throw(rc);
+    }
+    watch->dir_capacity = capacity;
+  }
+  /* Usually appended to the end */
+  index = watch->dir_count;
+  while (index > 0 && watch->dirs[index - 1].wd > wd) {
+    index--;
+  }
+  memmove(&watch->dirs[index + 1], &watch->dirs[index],
+          sizeof(*watch->dirs) * (watch->dir_count - index));
+  watch->dirs[index].wd = wd;
+  watch->dirs[index].root = root;
+  watch->dirs[index].path = tmp;
+  watch->dir_count++;
+
+  return GF_SUCCESS;
+}
+
+typedef struct watch_add_context {
+  gf_watch* watch;
+  gf_size_t root;
+  gf_size_t root_len;           ///< The length of the real path of the root
+} watch_add_context;
+
+static gf_status
+watch_add_sub_directory(
+  const gf_path* path, const gf_path* trace, gf_ptr find_data, gf_ptr data) {
+  const gf_shell_entry* entry = find_data;
+  const watch_add_context* ctxt = data;
+  const gf_char* s = NULL;
+
+  (void)trace;
+
+  if (!entry->is_directory) {
+    return GF_SUCCESS;
+  }
+  s = gf_path_get_string(path);
+  _(watch_add_dir(ctxt->watch, ctxt->root, s, s + ctxt->root_len));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Watch the directory and its sub-directories
+**
+** @param [in] path The path of the directory relative to the root
+*/
+
+static gf_status
+watch_add_directories(gf_watch* watch, gf_size_t root, const gf_char* path) {
+  gf_status rc = 0;
+  gf_path* real_path = NULL;
+  gf_char* buf = NULL;
+  gf_size_t len = 0;
+  watch_add_context ctxt = { 0 };
+
+  ctxt.watch = watch;
+  ctxt.root = root;
+  ctxt.root_len = gf_strlen(watch->roots[root]);
+
+  /* The relative path begins with the separator */
+  len = ctxt.root_len + gf_strlen(path);
+  _(gf_malloc((gf_ptr*)&buf, len + 1));
+  snprintf(buf, len + 1, "%s%s", watch->roots[root], path);
+  rc = gf_path_new(&real_path, buf);
+  gf_free(buf);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  rc = watch_add_dir(watch, root, gf_path_get_string(real_path), path);
+  if (rc == GF_SUCCESS) {
+    rc = gf_shell_traverse_tree(
+      real_path, NULL, GF_SHELL_TRAVERSE_PREORDER,
+      watch_add_sub_directory, &ctxt);
+  }
+  gf_path_free(real_path);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Stop watching the directory and its sub-directories
+**
+** This is needed when a directory is moved away, because the watches of the
+** sub-directories would report the changes with the old paths.
+*/
+
+static void
+watch_remove_directories(gf_watch* watch, gf_size_t root, const gf_char* path) {
+  gf_size_t len = gf_strlen(path);
+  gf_size_t i = 0;
+
+  while (i < watch->dir_count) {
+    watch_dir* dir = &watch->dirs[i];
+
+    if (dir->root == root && !strncmp(dir->path, path, len) &&
+        (dir->path[len] == '\0' || dir->path[len] == GF_PATH_SEPARATOR_CHAR)) {
+      (void)inotify_rm_watch(watch->fd, dir->wd);
+      watch_remove_dir(watch, dir);
+    } else {
+      i++;
+    }
+  }
+}
+
+gf_status
+gf_watch_add_tree(gf_watch* watch, const gf_path* path, gf_size_t* root) {
+  gf_status rc = 0;
+  gf_char* tmp = NULL;
+
+  gf_validate(watch);
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(root);
+
+  _(gf_strdup(&tmp, gf_path_get_string(path)));
+  rc = gf_realloc((gf_ptr*)&watch->roots,
+                  sizeof(*watch->roots) * (watch->root_count + 1));
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  watch->roots[watch->root_count] = tmp;
+  *root = watch->root_count++;
+  _(watch_add_directories(watch, *root, ""));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+watch_notify(
+  gf_watch* watch, const struct inotify_event* event,
+  gf_watch_fn fn, gf_ptr data, gf_size_t* count) {
+  gf_status rc = 0;
+  watch_dir* dir = NULL;
+  gf_char* path = NULL;
+  gf_size_t root = 0;
+  gf_size_t len = 0;
+  gf_32u flags = 0;
+
+  if (event->mask & IN_Q_OVERFLOW) {
+    for (gf_size_t i = 0; i < watch->root_count; i++) {
+      _(fn(i, "", GF_WATCH_OVERFLOW, data));
+      (*count)++;
+    }
+    return GF_SUCCESS;
+  }
+  dir = watch_find_dir(watch, event->wd);
+  if (!dir) {
+    return GF_SUCCESS;
+  }
+  if (event->mask & IN_IGNORED) {
+    /* The directory is removed */
+    watch_remove_dir(watch, dir);
+    return GF_SUCCESS;
+  }
+  if (!event->len) {
+    return GF_SUCCESS;
+  }
+  root = dir->root;
+  /* The path relative to the root */
+  len = gf_strlen(dir->path) + 1 + gf_strlen(event->name);
+  _(gf_malloc((gf_ptr*)&path, len + 1));
+  snprintf(path, len + 1, "%s" GF_PATH_SEPARATOR "%s", dir->path, event->name);
+
+  flags = (event->mask & (IN_DELETE | IN_MOVED_FROM)) ?
+    GF_WATCH_REMOVE : GF_WATCH_MODIFY;
+  if (event->mask & IN_ISDIR) {
+    flags |= GF_WATCH_DIRECTORY;
+    /* The records of the directory may be updated */
+    if (event->mask & IN_MOVED_FROM) {
+      watch_remove_directories(watch, root, path);
+    } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+      rc = watch_add_directories(watch, root, path);
+    }
+  }
+  if (rc == GF_SUCCESS) {
+    rc = fn(root, path, flags, data);
+    (*count)++;
+  }
+  gf_free(path);
+  gf_throw(rc);
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_watch_wait(
+  gf_watch* watch, gf_int timeout, gf_watch_fn fn, gf_ptr data,
+  gf_size_t* count) {
+  struct pollfd pfd = { 0 };
+  int ret = 0;
+  union {
+    struct inotify_event event;
+    gf_char buf[WATCH_BUFSIZE];
+  } u;
+
+  gf_validate(watch);
+  gf_validate(fn);
+  gf_validate(count);
+
+  *count = 0;
+  pfd.fd = watch->fd;
+  pfd.events = POLLIN;
+  do {
+    ret = poll(&pfd, 1, timeout < 0 ? -1 : timeout);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0) {
+    gf_raise(GF_E_API, "Failed to wait for the changes.");
+  }
+  if (ret == 0) {
+    return GF_SUCCESS;
+  }
+  /* Drain the pending events */
+  for (;;) {
+    ssize_t size = read(watch->fd, u.buf, sizeof(u.buf));
+
+    if (size < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      gf_raise(GF_E_READ, "Failed to read the changes.");
+    }
+    for (gf_char* cur = u.buf; cur < u.buf + size; ) {
+      const struct inotify_event* event = (const void*)cur;
+
+      _(watch_notify(watch, event, fn, data, count));
+      cur += sizeof(*event) + event->len;
+    }
+  }
+
+  return GF_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file libgf/gf_watch.h
+** @brief Notification of the changes in directory trees.
+*/
+#ifndef LIBGF_GF_WATCH_H
+#define LIBGF_GF_WATCH_H
+
+#pragma once
+
+#include <libgf/config.h>
+
+#include <libgf/gf_datatype.h>
+#include <libgf/gf_error.h>
+#include <libgf/gf_path.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+** @brief Flags of a change passed to gf_watch_fn
+*/
+
+enum {
+  GF_WATCH_MODIFY    = 0x01,    ///< The file is created or written
+  GF_WATCH_REMOVE    = 0x02,    ///< The file is removed or moved away
+  GF_WATCH_DIRECTORY = 0x04,    ///< The file is a directory (if known)
+  GF_WATCH_OVERFLOW  = 0x08,    ///< Changes are lost; the path is empty
+};
+
+typedef struct gf_watch gf_watch;
+
+/*!
+** @brief Callback of gf_watch_wait()
+**
+** @param [in] root  The index of the tree returned by gf_watch_add_tree()
+** @param [in] path  The path relative to the root of the tree ("/a/b.xml")
+** @param [in] flags GF_WATCH_* flags
+** @param [in] data  The user data
+*/
+
+typedef gf_status (*gf_watch_fn)(
+  gf_size_t root, const gf_char* path, gf_32u flags, gf_ptr data);
+
+/*!
+** @brief Create a new watch object.
+**
+** The changes are notified by inotify on Linux and by ReadDirectoryChangesW
+** on Windows.
+**
+** @param [out] watch The pointer to the new watch object
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_watch_new(gf_watch** watch);
+
+extern void gf_watch_free(gf_watch* watch);
+
+/*!
+** @brief Watch a whole directory tree.
+**
+** The directories created in the tree later are watched as well.
+**
+** @param [in, out] watch The watch object
+** @param [in]      path  The root directory of the tree
+** @param [out]     root  The index of the tree passed to gf_watch_fn
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_watch_add_tree(
+  gf_watch* watch, const gf_path* path, gf_size_t* root);
+
+/*!
+** @brief Wait for changes and pass them to the callback.
+**
+** This function waits until a change is notified or the timeout expires, and
+** then passes all the pending changes to @a fn. The same file may be passed
+** more than once.
+**
+** @param [in, out] watch   The watch object
+** @param [in]      timeout The timeout in milliseconds (negative: infinite)
+** @param [in]      fn      The callback
+** @param [in]      data    The user data passed to @a fn
+** @param [out]     count   The number of changes (0 if timed out)
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_watch_wait(
+  gf_watch* watch, gf_int timeout, gf_watch_fn fn, gf_ptr data,
+  gf_size_t* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* LIBGF_GF_WATCH_H */
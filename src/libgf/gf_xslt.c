@@ -6,7 +6,10 @@
 ** @file libgf/gf_xslt.c
 ** @brief Abstract API to xslt files.
 */
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <libxml/xmlmemory.h>
 #include <libxml/debugXML.h>
@@ -15,14 +18,23 @@
 #include <libxml/xinclude.h>
 #include <libxml/catalog.h>
 
+#include <libxml/uri.h>
+
 #include <libxslt/xslt.h>
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
+#include <libxslt/security.h>
 
 #include <libexslt/exslt.h>
 
 #include <libgf/gf_memory.h>
 #include <libgf/gf_string.h>
+#include <libgf/gf_map.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_hash.h>
+#include <libgf/gf_log.h>
+#include <libgf/gf_job.h>
 #include <libgf/gf_xslt.h>
 
 #include "gf_local.h"
@@ -308,6 +320,22 @@ struct gf_xslt {
   xsltStylesheetPtr xsl;
   xmlDocPtr         res;   ///< Result XML tree
   gf_xslt_param *   param;
+  gf_bool           shared; ///< The stylesheet is owned by a cache
+  gf_xslt_output_fn output_fn;   ///< Called for each file written
+  gf_ptr            output_data; ///< The user data of output_fn
+  gf_status         output_rc;   ///< The first error of output_fn
+};
+
+/*!
+** @brief The stylesheets compiled once and shared by the contexts
+*/
+
+struct gf_xslt_cache {
+  gf_map*   styles;       ///< Absolute path -> xslt_cache_item
+  gf_mutex  lock;         ///< Guards the members
+  gf_size_t hits;         ///< Requests served by compiled stylesheets
+  gf_size_t misses;       ///< Requests compiling stylesheets
+  gf_64u    compile_time; ///< Nanoseconds spent compiling stylesheets
 };
 
 static gf_status
@@ -317,6 +345,10 @@ xslt_init(gf_xslt* xslt) {
   xslt->xsl = NULL;
   xslt->res = NULL;
   xslt->param = NULL;
+  xslt->shared = GF_FALSE;
+  xslt->output_fn = NULL;
+  xslt->output_data = NULL;
+  xslt->output_rc = GF_SUCCESS;
 
   return GF_SUCCESS;
 }
@@ -358,6 +390,10 @@ void
 gf_xslt_free(gf_xslt* xslt) {
   if (xslt) {
     (void)gf_xslt_reset(xslt);
+    if (xslt->res) {
+      xmlFreeDoc(xslt->res);
+    }
+    gf_xslt_param_free(xslt->param);
     gf_free(xslt);
   }
 }
@@ -367,28 +403,46 @@ gf_xslt_reset(gf_xslt* xslt) {
   gf_validate(xslt);
 
   if (xslt->xsl) {
-    xsltFreeStylesheet(xslt->xsl);
+    if (!xslt->shared) {
+      xsltFreeStylesheet(xslt->xsl);
+    }
     xslt->xsl = NULL;
+    xslt->shared = GF_FALSE;
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+xslt_compile(xsltStylesheetPtr* xsl, const gf_path* path) {
+  xmlDocPtr doc = NULL;
+  xsltStylesheetPtr tmp = NULL;
+
+  doc = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
+  if (!doc) {
+    gf_raise(GF_E_READ,
+             "Failed to read style file. (%s)", gf_path_get_string(path));
   }
+  /* The document is owned by the stylesheet once it is compiled */
+  tmp = xsltParseStylesheetDoc(doc);
+  if (!tmp) {
+    xmlFreeDoc(doc);
+    gf_raise(GF_E_READ,
+             "Failed to compile style file. (%s)", gf_path_get_string(path));
+  }
+  *xsl = tmp;
 
   return GF_SUCCESS;
 }
 
 gf_status
 gf_xslt_read_template(gf_xslt* xslt, const gf_path* path) {
-  xmlDocPtr tmp = NULL;
   xsltStylesheetPtr xsl = NULL;
   
   gf_validate(xslt);
   gf_validate(path);
 
-  tmp = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
-  if (!tmp) {
-    gf_raise(GF_E_READ,
-             "Failed to read style file. (%s)", gf_path_get_string(path));
-  }
-  xsl = xsltParseStylesheetDoc(tmp);
-  // TODO: Add error handling.
+  _(xslt_compile(&xsl, path));
   if (xslt->xsl) {
     _(gf_xslt_reset(xslt));
   }
@@ -397,6 +451,156 @@ gf_xslt_read_template(gf_xslt* xslt, const gf_path* path) {
   return GF_SUCCESS;
 }
 
+/*!
+** @brief A stylesheet compiled by a cache
+*/
+
+typedef struct xslt_cache_item {
+  xsltStylesheetPtr xsl;        ///< The compiled stylesheet
+  gf_char*          fingerprint; ///< The fingerprint of the files (lazily)
+} xslt_cache_item;
+
+static void
+xslt_cache_item_free(gf_any* any) {
+  if (any && any->ptr) {
+    xslt_cache_item* item = any->ptr;
+
+    xsltFreeStylesheet(item->xsl);
+    gf_free(item->fingerprint);
+    gf_free(item);
+    any->ptr = NULL;
+  }
+}
+
+static gf_status
+xslt_cache_add(
+  gf_xslt_cache* cache, const gf_char* key, const gf_path* path,
+  xslt_cache_item** item) {
+  gf_status rc = 0;
+  xslt_cache_item* tmp = NULL;
+  gf_64u start = 0;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->xsl = NULL;
+  tmp->fingerprint = NULL;
+  start = gf_datetime_get_monotonic_ns();
+  rc = xslt_compile(&tmp->xsl, path);
+  cache->compile_time += gf_datetime_get_monotonic_ns() - start;
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set(cache->styles, key, (gf_any){ .ptr = tmp });
+  }
+  if (rc != GF_SUCCESS) {
+    xslt_cache_item_free(&(gf_any){ .ptr = tmp });
+    gf_throw(rc);
+  }
+  cache->misses++;
+  gf_debug("Compiled the style file. (%s)", key);
+  *item = tmp;
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Find the compiled stylesheet, compiling it at the first request.
+**
+** The caller must hold the lock of the cache.
+*/
+
+static gf_status
+xslt_cache_get(
+  gf_xslt_cache* cache, const gf_path* path, xslt_cache_item** item) {
+  gf_status rc = 0;
+  gf_path* key = NULL;
+  gf_any any = { 0 };
+
+  _(gf_path_clone(&key, path));
+  /* An unresolved path is used as it is */
+  if (gf_path_absolute_path(key) != GF_SUCCESS) {
+    gf_debug("Failed to resolve the style file. (%s)",
+             gf_path_get_string(path));
+  }
+  if (gf_map_find(cache->styles, gf_path_get_string(key), &any)) {
+    cache->hits++;
+    *item = any.ptr;
+  } else {
+    rc = xslt_cache_add(cache, gf_path_get_string(key), path, item);
+  }
+  gf_path_free(key);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_use_template(
+  gf_xslt* xslt, gf_xslt_cache* cache, const gf_path* path) {
+  gf_status rc = 0;
+  xslt_cache_item* item = NULL;
+
+  gf_validate(xslt);
+  gf_validate(cache);
+  gf_validate(!gf_path_is_empty(path));
+
+  /*
+  ** The lock is held while compiling, so that a stylesheet requested by
+  ** several threads at once is compiled only once.
+  */
+  gf_mutex_lock(&cache->lock);
+  rc = xslt_cache_get(cache, path, &item);
+  gf_mutex_unlock(&cache->lock);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  if (xslt->xsl) {
+    _(gf_xslt_reset(xslt));
+  }
+  xslt->xsl = item->xsl;
+  xslt->shared = GF_TRUE;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_set_output_fn(gf_xslt* xslt, gf_xslt_output_fn fn, gf_ptr data) {
+  gf_validate(xslt);
+
+  xslt->output_fn = fn;
+  xslt->output_data = data;
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+xslt_notify_output(gf_xslt* xslt, const gf_char* path) {
+  gf_status rc = 0;
+
+  if (xslt->output_fn) {
+    rc = xslt->output_fn(path, xslt->output_data);
+    if (rc != GF_SUCCESS && xslt->output_rc == GF_SUCCESS) {
+      xslt->output_rc = rc;
+    }
+  }
+
+  return rc;
+}
+
+/*!
+** @brief Report a file written by the stylesheet (exsl:document etc.).
+**
+** This is the security check of libxslt, so the write is refused if the
+** callback fails.
+*/
+
+static int
+xslt_check_write(
+  xsltSecurityPrefsPtr sec, xsltTransformContextPtr ctxt, const char* value) {
+  (void)sec;
+
+  return xslt_notify_output(ctxt->_private, value) == GF_SUCCESS ? 1 : 0;
+}
+
 gf_status
 gf_xslt_set_param(gf_xslt* xslt, const gf_char* key, const gf_char* value) {
   gf_validate(xslt);
@@ -421,33 +625,93 @@ xslt_release_result(gf_xslt* xslt) {
 }
 
 gf_status
-gf_xslt_process(gf_xslt* xslt, const gf_path* path) {
-  gf_status rc = 0;
-  xmlDocPtr doc = NULL;
-  xmlDocPtr res = NULL;
-  
-  gf_validate(xslt);
+gf_xslt_read_document(xmlDocPtr* doc, const gf_path* path) {
+  xmlDocPtr tmp = NULL;
+
+  gf_validate(doc);
   gf_validate(!gf_path_is_empty(path));
 
-  doc = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
-  if (!doc) {
+  tmp = xmlReadFile(gf_path_get_string(path), NULL, GF_XML_PARSE_OPTIONS);
+  if (!tmp) {
     gf_raise(GF_E_READ,
              "Failed to read source file. (%s)", gf_path_get_string(path));
   }
-  xmlXIncludeProcessFlags(doc, XSLT_PARSE_OPTIONS);
+  xmlXIncludeProcessFlags(tmp, XSLT_PARSE_OPTIONS);
+  *doc = tmp;
 
-  res = xsltApplyStylesheet(
-    xslt->xsl, doc, XSLT_TUPLE_ITEM_TO_PARAM_ARRAY(xslt->param->item));
-  xmlFreeDoc(doc);
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_process_doc(gf_xslt* xslt, xmlDocPtr doc) {
+  gf_status rc = 0;
+  xmlDocPtr res = NULL;
+
+  xsltTransformContextPtr ctxt = NULL;
+  xsltSecurityPrefsPtr sec = NULL;
+
+  gf_validate(xslt);
+  gf_validate(xslt->xsl);
+  gf_validate(doc);
+
+  ctxt = xsltNewTransformContext(xslt->xsl, doc);
+  if (!ctxt) {
+    gf_raise(GF_E_API, "Failed to create a transform context.");
+  }
+  /* The messages go to the (thread-local) handler of the calling thread */
+  xsltSetTransformErrorFunc(ctxt, xmlGenericErrorContext, xmlGenericError);
+  /* The files written by the stylesheet are reported to the callback */
+  if (xslt->output_fn) {
+    sec = xsltNewSecurityPrefs();
+    if (!sec ||
+        xsltSetSecurityPrefs(sec, XSLT_SECPREF_WRITE_FILE, xslt_check_write) ||
+        xsltSetCtxtSecurityPrefs(sec, ctxt)) {
+      xsltFreeSecurityPrefs(sec);
+      xsltFreeTransformContext(ctxt);
+      gf_raise(GF_E_API, "Failed to create a transform context.");
+    }
+    ctxt->_private = xslt;
+  }
+  xslt->output_rc = GF_SUCCESS;
+  res = xsltApplyStylesheetUser(
+    xslt->xsl, doc, XSLT_TUPLE_ITEM_TO_PARAM_ARRAY(xslt->param->item),
+    NULL, NULL, ctxt);
+  xsltFreeTransformContext(ctxt);
+  if (sec) {
+    xsltFreeSecurityPrefs(sec);
+  }
+  if (res && xslt->output_rc != GF_SUCCESS) {
+    xmlFreeDoc(res);
+    gf_throw(xslt->output_rc);
+  }
   if (!res) {
-    gf_raise(GF_E_API,
-             "Failed to transform the file. (%s)", gf_path_get_string(path));
+    gf_raise(GF_E_API, "Failed to transform the file. (%s)",
+             doc->URL ? (const char*)doc->URL : "-");
   }
   rc = xslt_release_result(xslt);
   if (rc != GF_SUCCESS) {
+    xmlFreeDoc(res);
     gf_throw(rc);
   }
   xslt->res = res;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_process(gf_xslt* xslt, const gf_path* path) {
+  gf_status rc = 0;
+  xmlDocPtr doc = NULL;
+  
+  gf_validate(xslt);
+  gf_validate(!gf_path_is_empty(path));
+
+  _(gf_xslt_read_document(&doc, path));
+  rc = gf_xslt_process_doc(xslt, doc);
+  xmlFreeDoc(doc);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
     
   return GF_SUCCESS;
 }
@@ -468,6 +732,328 @@ gf_xslt_write_file(gf_xslt* xslt, const gf_path* path) {
   if (ret < 0) {
     gf_raise(GF_E_OPEN, "Failed to save file. (%s)", gf_path_get_string(path));
   }
+  _(xslt_notify_output(xslt, gf_path_get_string(path)));
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+gf_status
+gf_xslt_cache_new(gf_xslt_cache** cache) {
+  gf_status rc = 0;
+  gf_xslt_cache* tmp = NULL;
+
+  gf_validate(cache);
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp)));
+  tmp->styles = NULL;
+  tmp->hits = 0;
+  tmp->misses = 0;
+  tmp->compile_time = 0;
+  rc = gf_mutex_init(&tmp->lock);
+  if (rc != GF_SUCCESS) {
+    gf_free(tmp);
+    gf_throw(rc);
+  }
+  rc = gf_map_new(&tmp->styles);
+  if (rc == GF_SUCCESS) {
+    rc = gf_map_set_free_fn(tmp->styles, xslt_cache_item_free);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_xslt_cache_free(tmp);
+    gf_throw(rc);
+  }
+  *cache = tmp;
+
+  return GF_SUCCESS;
+}
+
+void
+gf_xslt_cache_free(gf_xslt_cache* cache) {
+  if (cache) {
+    if (cache->styles) {
+      gf_map_free(cache->styles);
+    }
+    gf_mutex_destroy(&cache->lock);
+    gf_free(cache);
+  }
+}
+
+gf_size_t
+gf_xslt_cache_count_hits(const gf_xslt_cache* cache) {
+  return cache ? cache->hits : 0;
+}
+
+gf_size_t
+gf_xslt_cache_count_misses(const gf_xslt_cache* cache) {
+  return cache ? cache->misses : 0;
+}
+
+gf_64u
+gf_xslt_cache_get_compile_time(const gf_xslt_cache* cache) {
+  return cache ? cache->compile_time : 0;
+}
+
+static gf_status
+xslt_hash_style_file(
+  gf_hash_context* ctx, const gf_hash_provider* provider, gf_map* files,
+  const xmlChar* url) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  xmlURIPtr uri = NULL;
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  if (!url || gf_map_find(files, (const gf_char*)url, NULL)) {
+    return GF_SUCCESS;
+  }
+  _(gf_map_set(files, (const gf_char*)url, (gf_any){ .u64 = 0 }));
+  _(provider->update(ctx, url, (gf_size_t)xmlStrlen(url) + 1));
+
+  uri = xmlParseURI((const char*)url);
+  if (uri && (!uri->scheme || !strcmp(uri->scheme, "file")) && uri->path) {
+    rc = gf_path_new(&path, uri->path);
+  } else {
+    rc = gf_path_new(&path, (const gf_char*)url);
+  }
+  xmlFreeURI(uri);
+  if (rc == GF_SUCCESS) {
+    rc = gf_hash_file_with(provider, digest, sizeof(digest), path);
+    gf_path_free(path);
+  }
+  if (rc != GF_SUCCESS) {
+    /* The file is told apart only by its name, e.g., a remote one */
+    gf_debug("Failed to hash the style file. (%s)", (const gf_char*)url);
+    return GF_SUCCESS;
+  }
+  _(provider->update(ctx, digest, provider->size));
+
+  return GF_SUCCESS;
+}
+
+/*!
+** @brief Hash the files of a stylesheet and of its includes and imports.
+**
+** The files are visited in the same order as long as they are unchanged.
+*/
+
+static gf_status
+xslt_hash_style(
+  gf_hash_context* ctx, const gf_hash_provider* provider, gf_map* files,
+  xsltStylesheetPtr style) {
+  if (style->doc) {
+    _(xslt_hash_style_file(ctx, provider, files, style->doc->URL));
+  }
+  for (xsltDocumentPtr cur = style->docList; cur; cur = cur->next) {
+    if (cur->doc) {
+      _(xslt_hash_style_file(ctx, provider, files, cur->doc->URL));
+    }
+  }
+  for (xsltStylesheetPtr cur = style->imports; cur; cur = cur->next) {
+    _(xslt_hash_style(ctx, provider, files, cur));
+  }
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+xslt_make_fingerprint(gf_char** fingerprint, xsltStylesheetPtr style) {
+  gf_status rc = 0;
+  const gf_hash_provider* provider = gf_hash_get_default();
+  gf_hash_context ctx;
+  gf_map* files = NULL;
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_char* tmp = NULL;
+
+  _(gf_map_new(&files));
+  rc = provider->init(&ctx);
+  if (rc == GF_SUCCESS) {
+    rc = xslt_hash_style(&ctx, provider, files, style);
+  }
+  gf_map_free(files);
+  if (rc == GF_SUCCESS) {
+    rc = provider->final(&ctx, digest);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_malloc((gf_ptr*)&tmp, provider->size * 2 + 1);
+  }
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  for (gf_size_t i = 0; i < provider->size; i++) {
+    snprintf(&tmp[i * 2], 3, "%02x", digest[i]);
+  }
+  *fingerprint = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_cache_get_fingerprint(
+  gf_xslt_cache* cache, const gf_path* path, const gf_char** fingerprint) {
+  gf_status rc = 0;
+  xslt_cache_item* item = NULL;
+
+  gf_validate(cache);
+  gf_validate(!gf_path_is_empty(path));
+  gf_validate(fingerprint);
+
+  gf_mutex_lock(&cache->lock);
+  rc = xslt_cache_get(cache, path, &item);
+  if (rc == GF_SUCCESS && !item->fingerprint) {
+    rc = xslt_make_fingerprint(&item->fingerprint, item->xsl);
+  }
+  gf_mutex_unlock(&cache->lock);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+  *fingerprint = item->fingerprint;
+
+  return GF_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The transform jobs and their logs
+*/
+
+typedef struct xslt_job_set {
+  gf_job_fn      fn;            ///< The callback which runs a job
+  gf_ptr         data;          ///< The user data of the callback
+  gf_string**    logs;          ///< The log kept for each job
+} xslt_job_set;
+
+/*!
+** @brief Keep a message of libxml2 or libxslt in the log of the job.
+**
+** @param [in] ctx The pointer to the log of the running job
+*/
+
+static void
+xslt_keep_message(void* ctx, const char* msg, ...) {
+  gf_string** log = ctx;
+  gf_char buf[1024] = { 0 };
+  va_list args;
+
+  va_start(args, msg);
+  vsnprintf(buf, sizeof(buf), msg, args);
+  va_end(args);
+  if (*log) {
+    (void)gf_string_append(*log, buf);
+  }
+}
+
+/*!
+** @brief Run a transform job keeping its messages in its log (gf_job_fn).
+*/
+
+static gf_status
+xslt_run_job(gf_size_t index, gf_ptr data) {
+  xslt_job_set* set = data;
+  xmlGenericErrorFunc handler = xmlGenericError;
+  void* context = xmlGenericErrorContext;
+  gf_status rc = 0;
+
+  /* The handler of libxml2 is thread-local, so it is set on the thread */
+  xmlSetGenericErrorFunc(&set->logs[index], xslt_keep_message);
+  (void)gf_log_capture(set->logs[index]);
+  rc = set->fn(index, set->data);
+  (void)gf_log_capture(NULL);
+  xmlSetGenericErrorFunc(context, handler);
+
+  return rc;
+}
+
+static void
+xslt_free_logs(gf_string** logs, gf_size_t count) {
+  if (logs) {
+    for (gf_size_t i = 0; i < count; i++) {
+      gf_string_free(logs[i]);
+    }
+    gf_free(logs);
+  }
+}
+
+static gf_status
+xslt_new_logs(gf_string*** logs, gf_size_t count) {
+  gf_status rc = 0;
+  gf_string** tmp = NULL;
+
+  _(gf_malloc((gf_ptr*)&tmp, sizeof(*tmp) * count));
+  for (gf_size_t i = 0; i < count; i++) {
+    tmp[i] = NULL;
+  }
+  for (gf_size_t i = 0; i < count; i++) {
+    rc = gf_string_new(&tmp[i]);
+    if (rc != GF_SUCCESS) {
+      xslt_free_logs(tmp, count);
+      gf_throw(rc);
+    }
+  }
+  *logs = tmp;
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_run_graph(
+  gf_job_graph* graph, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status) {
+  gf_status rc = 0;
+  xslt_job_set set = { 0 };
+  gf_size_t count = 0;
+
+  gf_validate(graph);
+  gf_validate(fn);
+
+  count = gf_job_graph_count_jobs(graph);
+  if (count == 0) {
+    return GF_SUCCESS;
+  }
+  set.fn = fn;
+  set.data = data;
+  _(xslt_new_logs(&set.logs, count));
+  /* LibXML2 must be initialized before it is used by the threads */
+  xmlInitParser();
+  rc = gf_job_graph_run(graph, xslt_run_job, &set, threads, fail_fast, status);
+  /* The logs are written in the order of the jobs */
+  for (gf_size_t i = 0; i < count; i++) {
+    (void)gf_log_flush(set.logs[i]);
+  }
+  xslt_free_logs(set.logs, count);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
+
+  return GF_SUCCESS;
+}
+
+gf_status
+gf_xslt_run_jobs(
+  gf_size_t count, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status) {
+  gf_status rc = 0;
+  gf_job_graph* graph = NULL;
+
+  gf_validate(fn);
+  gf_validate(status || count == 0);
+
+  if (count == 0) {
+    return GF_SUCCESS;
+  }
+  /* The jobs are independent, so they are taken in the order of the index */
+  _(gf_job_graph_new(&graph));
+  for (gf_size_t i = 0; rc == GF_SUCCESS && i < count; i++) {
+    rc = gf_job_graph_add_job(graph, NULL);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_xslt_run_graph(graph, fn, data, threads, fail_fast, status);
+  }
+  gf_job_graph_free(graph);
+  if (rc != GF_SUCCESS) {
+    gf_throw(rc);
+  }
 
   return GF_SUCCESS;
 }
@@ -13,9 +13,12 @@
 
 #include <libgf/config.h>
 
+#include <libxml/tree.h>
+
 #include <libgf/gf_datatype.h>
 #include <libgf/gf_error.h>
 #include <libgf/gf_path.h>
+#include <libgf/gf_job.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +63,16 @@ extern gf_status gf_xslt_param_get_value(
 /* -------------------------------------------------------------------------- */
 
 typedef struct gf_xslt gf_xslt;
+typedef struct gf_xslt_cache gf_xslt_cache;
+
+/*!
+** @brief The callback told of a file written by a transform.
+**
+** @param [in] path The path of the file
+** @param [in] data The user data
+*/
+
+typedef gf_status (*gf_xslt_output_fn)(const gf_char* path, gf_ptr data);
 
 /*!
 ** @param [out] xslt A pointer to the pointer, which points to the new context
@@ -93,10 +106,45 @@ extern gf_status gf_xslt_reset(gf_xslt* xslt);
 
 extern gf_status gf_xslt_read_template(gf_xslt* xslt, const gf_path* path);
 
+/*!
+** @brief Use the stylesheet compiled by a cache.
+**
+** The stylesheet is compiled at the first request of the path, and the
+** compiled one is shared by all the contexts using the same file. It is
+** owned by the cache, so the cache must outlive the contexts.
+**
+** @param [in, out] xslt  The xslt context obejct
+** @param [in, out] cache The stylesheet cache
+** @param [in]      path  The template path
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_use_template(
+  gf_xslt* xslt, gf_xslt_cache* cache, const gf_path* path);
+
 
 extern gf_status gf_xslt_set_param(
   gf_xslt* xslt, const gf_char* key, const gf_char* value);
 
+/*!
+** @brief Set the callback told of the files written.
+**
+** The callback is called for each file the stylesheet writes by itself
+** (e.g., exsl:document) during gf_xslt_process_doc(), and for the file
+** written by gf_xslt_write_file(). A file is not written if the callback
+** fails.
+**
+** @param [in, out] xslt The xslt context obejct
+** @param [in]      fn   The callback (NULL: none)
+** @param [in]      data The user data passed to the callback
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_set_output_fn(
+  gf_xslt* xslt, gf_xslt_output_fn fn, gf_ptr data);
+
 /*!
 ** @brief Do the XSLT processing.
 **
@@ -108,6 +156,30 @@ extern gf_status gf_xslt_set_param(
 
 extern gf_status gf_xslt_process(gf_xslt* xslt, const gf_path* path);
 
+/*!
+** @brief Do the XSLT processing with a document already read.
+**
+** The document is not modified, and is still owned by the caller.
+**
+** @param [in, out] xslt File xslt context
+** @param [in]      doc  XML document read by gf_xslt_read_document()
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_process_doc(gf_xslt* xslt, xmlDocPtr doc);
+
+/*!
+** @brief Read a source document and process its XIncludes.
+**
+** @param [out] doc  The document read, freed by xmlFreeDoc()
+** @param [in]  path XML file path
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_read_document(xmlDocPtr* doc, const gf_path* path);
+
 /*!
 ** @brief Write a result file.
 **
@@ -119,6 +191,101 @@ extern gf_status gf_xslt_process(gf_xslt* xslt, const gf_path* path);
 
 extern gf_status gf_xslt_write_file(gf_xslt* xslt, const gf_path* path);
 
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Create a cache of compiled stylesheets.
+**
+** The stylesheets are keyed by their absolute paths. The cache can be used
+** by multiple threads.
+**
+** @param [out] cache The new cache
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_cache_new(gf_xslt_cache** cache);
+extern void gf_xslt_cache_free(gf_xslt_cache* cache);
+
+/*!
+** @brief Count the requests served by compiled stylesheets and compiles.
+*/
+
+extern gf_size_t gf_xslt_cache_count_hits(const gf_xslt_cache* cache);
+extern gf_size_t gf_xslt_cache_count_misses(const gf_xslt_cache* cache);
+
+/*!
+** @brief Get the total time spent compiling stylesheets in nanoseconds.
+*/
+
+extern gf_64u gf_xslt_cache_get_compile_time(const gf_xslt_cache* cache);
+
+/*!
+** @brief Get the fingerprint of a stylesheet.
+**
+** The fingerprint covers the contents of the stylesheet and of all the files
+** it includes or imports, so it changes if any of them is changed. The
+** stylesheet is compiled if it is not yet.
+**
+** @param [in, out] cache       The stylesheet cache
+** @param [in]      path        The template path
+** @param [out]     fingerprint The hex string, valid while the cache lives
+**
+** @return GF_SUCCESS on success, GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_cache_get_fingerprint(
+  gf_xslt_cache* cache, const gf_path* path, const gf_char** fingerprint);
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief Run transform jobs on a pool of threads.
+**
+** The jobs are taken in the order of the index; the transforms of the jobs
+** may share the stylesheets of a cache. The log of each job, including the
+** messages of libxml2 and libxslt, is kept apart and written in the order of
+** the index after all the jobs end, so it does not depend on the threads.
+**
+** A failed job does not stop the others unless @a fail_fast is set; then no
+** job is started after the failure, while the running ones are finished.
+**
+** @param [in]  count     The number of the jobs
+** @param [in]  fn        The callback which runs a job
+** @param [in]  data      The user data passed to the callback
+** @param [in]  threads   The number of threads (0: one per core)
+** @param [in]  fail_fast GF_TRUE to start no job after a failure
+** @param [out] status    The results of the jobs (@a count entries); the
+**                        jobs not started are left GF_E_STATE
+**
+** @return GF_SUCCESS if the jobs were run (whatever their results),
+**         GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_run_jobs(
+  gf_size_t count, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status);
+
+/*!
+** @brief Run the transform jobs of a graph on a pool of threads.
+**
+** The jobs are run by gf_job_graph_run(), and their logs are kept and
+** written as gf_xslt_run_jobs() does.
+**
+** @param [in, out] graph     The graph, which keeps the times of the jobs
+** @param [in]      fn        The callback which runs a job
+** @param [in]      data      The user data passed to the callback
+** @param [in]      threads   The number of threads (0: one per core)
+** @param [in]      fail_fast GF_TRUE to start no job after a failure
+** @param [out]     status    The results of the jobs (one for each job)
+**
+** @return GF_SUCCESS if the jobs were run (whatever their results),
+**         GF_E_* otherwise.
+*/
+
+extern gf_status gf_xslt_run_graph(
+  gf_job_graph* graph, gf_job_fn fn, gf_ptr data, gf_int threads,
+  gf_bool fail_fast, gf_status* status);
 
 #ifdef __cplusplus
 }
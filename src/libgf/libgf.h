@@ -27,17 +27,20 @@
 #include <libgf/gf_config.h>
 #include <libgf/gf_args.h>
 #include <libgf/gf_site.h>
+#include <libgf/gf_db.h>
 #include <libgf/gf_xslt.h>
 
 #include <libgf/gf_cmd_base.h>
 #include <libgf/gf_cmd_build.h>
 #include <libgf/gf_cmd_clean.h>
 #include <libgf/gf_cmd_config.h>
+#include <libgf/gf_cmd_db.h>
 #include <libgf/gf_cmd_help.h>
 #include <libgf/gf_cmd_list.h>
 #include <libgf/gf_cmd_main.h>
 #include <libgf/gf_cmd_setup.h>
 #include <libgf/gf_cmd_update.h>
 #include <libgf/gf_cmd_version.h>
+#include <libgf/gf_cmd_watch.h>
 
 #endif  /* LIBGF_H */
@@ -0,0 +1,198 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/bench/bench-hash.c
+** @brief Throughput benchmark of the hash providers.
+**
+** Usage: gf-bench-hash [FILE...]
+**
+** Each provider hashes the specified files (or a generated 256 MiB file if no
+** file is specified) and the throughput is printed in MiB/s. The in-memory
+** throughput of the first 64 MiB is printed too, so that the cost of the
+** file I/O can be told apart from that of the algorithm.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_hash.h>
+
+#define BENCH_GENERATED_FILE  "gf-bench-hash.tmp"
+#define BENCH_GENERATED_SIZE  (256 * 1024 * 1024)
+#define BENCH_MEMORY_SIZE     (64 * 1024 * 1024)
+#define BENCH_CHUNK_SIZE      (1024 * 1024)
+#define BENCH_REPEAT          3
+
+static double
+bench_now(void) {
+  struct timespec ts = { 0 };
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double
+bench_mib_per_sec(gf_64u bytes, double sec) {
+  if (sec <= 0) {
+    return 0;
+  }
+  return (double)bytes / (1024.0 * 1024.0) / sec;
+}
+
+/*!
+** @brief Fill the buffer with pseudo random bytes (xorshift64)
+*/
+
+static void
+bench_fill(gf_8u* buf, gf_size_t size, gf_64u* seed) {
+  gf_64u x = *seed;
+
+  for (gf_size_t i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    buf[i] = (gf_8u)x;
+  }
+  *seed = x;
+}
+
+static gf_status
+bench_generate_file(const char* name, gf_size_t size) {
+  FILE* fp = NULL;
+  gf_8u* buf = NULL;
+  gf_64u seed = 88172645463325252ULL;
+  gf_status rc = GF_SUCCESS;
+
+  gf_throw(gf_malloc((gf_ptr*)&buf, BENCH_CHUNK_SIZE));
+  fp = fopen(name, "wb");
+  if (!fp) {
+    gf_free(buf);
+    return GF_E_OPEN;
+  }
+  for (gf_size_t done = 0; done < size; done += BENCH_CHUNK_SIZE) {
+    bench_fill(buf, BENCH_CHUNK_SIZE, &seed);
+    if (fwrite(buf, 1, BENCH_CHUNK_SIZE, fp) != BENCH_CHUNK_SIZE) {
+      rc = GF_E_WRITE;
+      break;
+    }
+  }
+  fclose(fp);
+  gf_free(buf);
+
+  return rc;
+}
+
+static gf_64u
+bench_file_size(const char* name) {
+  FILE* fp = NULL;
+  long size = 0;
+
+  fp = fopen(name, "rb");
+  if (!fp) {
+    return 0;
+  }
+  if (!fseek(fp, 0, SEEK_END)) {
+    size = ftell(fp);
+  }
+  fclose(fp);
+
+  return size > 0 ? (gf_64u)size : 0;
+}
+
+static gf_status
+bench_file(const gf_hash_provider* hash, int count, char** names) {
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_64u bytes = 0;
+  double start = 0;
+  double sec = 0;
+
+  for (int i = 0; i < count; i++) {
+    bytes += bench_file_size(names[i]);
+  }
+  /* Warm up the page cache, then measure */
+  for (int r = 0; r <= BENCH_REPEAT; r++) {
+    start = bench_now();
+    for (int i = 0; i < count; i++) {
+      gf_path* path = NULL;
+      gf_status rc = 0;
+
+      gf_throw(gf_path_new(&path, names[i]));
+      rc = gf_hash_file_with(hash, digest, sizeof(digest), path);
+      gf_path_free(path);
+      gf_throw(rc);
+    }
+    if (r > 0) {
+      sec += bench_now() - start;
+    }
+  }
+  printf("%-8s file   %10.1f MiB/s\n",
+         hash->name, bench_mib_per_sec(bytes * BENCH_REPEAT, sec));
+
+  return GF_SUCCESS;
+}
+
+static gf_status
+bench_memory(const gf_hash_provider* hash, const gf_8u* buf, gf_size_t size) {
+  gf_8u digest[GF_HASH_BUFSIZE_MAX] = { 0 };
+  double start = 0;
+
+  start = bench_now();
+  for (int r = 0; r < BENCH_REPEAT; r++) {
+    gf_throw(gf_hash_buffer(hash, digest, sizeof(digest), buf, size));
+  }
+  printf("%-8s memory %10.1f MiB/s\n",
+         hash->name,
+         bench_mib_per_sec((gf_64u)size * BENCH_REPEAT, bench_now() - start));
+
+  return GF_SUCCESS;
+}
+
+int
+main(int argc, char** argv) {
+  gf_status rc = GF_SUCCESS;
+  char* generated[] = { BENCH_GENERATED_FILE };
+  char** names = argv + 1;
+  int count = argc - 1;
+  gf_8u* buf = NULL;
+  gf_64u seed = 2463534242ULL;
+
+  if (count == 0) {
+    rc = bench_generate_file(BENCH_GENERATED_FILE, BENCH_GENERATED_SIZE);
+    if (rc != GF_SUCCESS) {
+      fprintf(stderr, "Failed to create %s.\n", BENCH_GENERATED_FILE);
+      return 1;
+    }
+    names = generated;
+    count = 1;
+  }
+
+  rc = gf_malloc((gf_ptr*)&buf, BENCH_MEMORY_SIZE);
+  if (rc == GF_SUCCESS) {
+    bench_fill(buf, BENCH_MEMORY_SIZE, &seed);
+  }
+  for (gf_size_t i = 0; i < gf_hash_count_providers(); i++) {
+    const gf_hash_provider* hash = gf_hash_get_provider(i);
+
+    if (rc == GF_SUCCESS) {
+      rc = bench_file(hash, count, names);
+    }
+    if (rc == GF_SUCCESS) {
+      rc = bench_memory(hash, buf, BENCH_MEMORY_SIZE);
+    }
+  }
+  gf_free(buf);
+
+  if (names == generated) {
+    remove(BENCH_GENERATED_FILE);
+  }
+  if (rc != GF_SUCCESS) {
+    fprintf(stderr, "Benchmark failed (%d).\n", rc);
+    return 1;
+  }
+
+  return 0;
+}
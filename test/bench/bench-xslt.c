@@ -0,0 +1,218 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/bench/bench-xslt.c
+** @brief Scaling benchmark of the parallel document transforms.
+**
+** Usage: gf-bench-xslt [DOCUMENTS]
+**
+** The specified number of documents (256 by default) and a stylesheet are
+** generated, and the documents are transformed by gf_xslt_run_jobs() with 1,
+** 2, 4, 8 and 16 threads sharing the compiled stylesheet. The throughput is
+** printed in documents per second with the speedup over one thread.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <libgf/gf_memory.h>
+#include <libgf/gf_path.h>
+#include <libgf/gf_thread.h>
+#include <libgf/gf_xslt.h>
+
+#define BENCH_STYLE_FILE      "gf-bench-xslt.xsl"
+#define BENCH_DOCUMENT_FILE   "gf-bench-xslt-%04zu.xml"
+#define BENCH_DOCUMENTS       256
+#define BENCH_SECTIONS        200
+#define BENCH_PARAGRAPHS      10
+#define BENCH_REPEAT          3
+
+/* Sorts and numbers the sections, and counts the words of the paragraphs */
+static const char bench_style_[] =
+  "<?xml version=\"1.0\"?>\n"
+  "<xsl:stylesheet version=\"1.0\"\n"
+  "    xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+  "  <xsl:output method=\"html\"/>\n"
+  "  <xsl:template match=\"/article\">\n"
+  "    <html><body>\n"
+  "      <ol>\n"
+  "        <xsl:for-each select=\"section\">\n"
+  "          <xsl:sort select=\"@key\"/>\n"
+  "          <li><xsl:number/>: <xsl:value-of select=\"title\"/></li>\n"
+  "        </xsl:for-each>\n"
+  "      </ol>\n"
+  "      <xsl:apply-templates select=\"section\"/>\n"
+  "    </body></html>\n"
+  "  </xsl:template>\n"
+  "  <xsl:template match=\"section\">\n"
+  "    <h2 id=\"{generate-id()}\"><xsl:value-of select=\"title\"/></h2>\n"
+  "    <xsl:for-each select=\"para\">\n"
+  "      <p title=\"{string-length(normalize-space(.)) -\n"
+  "          string-length(translate(normalize-space(.), ' ', '')) + 1}\">\n"
+  "        <xsl:value-of select=\"translate(., 'abc', 'ABC')\"/>\n"
+  "      </p>\n"
+  "    </xsl:for-each>\n"
+  "  </xsl:template>\n"
+  "</xsl:stylesheet>\n";
+
+typedef struct bench_set {
+  gf_xslt_cache* cache;
+  gf_path*       style;
+  gf_size_t      count;
+} bench_set;
+
+static double
+bench_now(void) {
+  struct timespec ts = { 0 };
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static gf_status
+bench_generate_files(gf_size_t count) {
+  FILE* fp = NULL;
+
+  fp = fopen(BENCH_STYLE_FILE, "w");
+  if (!fp) {
+    return GF_E_OPEN;
+  }
+  fputs(bench_style_, fp);
+  fclose(fp);
+
+  for (gf_size_t i = 0; i < count; i++) {
+    char name[64] = { 0 };
+
+    snprintf(name, sizeof(name), BENCH_DOCUMENT_FILE, i);
+    fp = fopen(name, "w");
+    if (!fp) {
+      return GF_E_OPEN;
+    }
+    fputs("<?xml version=\"1.0\"?>\n<article>\n", fp);
+    for (int s = 0; s < BENCH_SECTIONS; s++) {
+      fprintf(fp, "<section key=\"%d\"><title>Section %d</title>\n",
+              (s * 7919) % BENCH_SECTIONS, s);
+      for (int p = 0; p < BENCH_PARAGRAPHS; p++) {
+        fputs("<para>The quick brown fox jumps over the lazy dog, "
+              "and the cat watches the bird in the tree.</para>\n", fp);
+      }
+      fputs("</section>\n", fp);
+    }
+    fputs("</article>\n", fp);
+    fclose(fp);
+  }
+
+  return GF_SUCCESS;
+}
+
+static void
+bench_remove_files(gf_size_t count) {
+  for (gf_size_t i = 0; i < count; i++) {
+    char name[64] = { 0 };
+
+    snprintf(name, sizeof(name), BENCH_DOCUMENT_FILE, i);
+    remove(name);
+  }
+  remove(BENCH_STYLE_FILE);
+}
+
+static gf_status
+bench_transform(gf_size_t index, gf_ptr data) {
+  gf_status rc = 0;
+  bench_set* set = data;
+  gf_xslt* xslt = NULL;
+  gf_path* path = NULL;
+  char name[64] = { 0 };
+
+  snprintf(name, sizeof(name), BENCH_DOCUMENT_FILE, index);
+  gf_throw(gf_xslt_new(&xslt));
+  rc = gf_xslt_use_template(xslt, set->cache, set->style);
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_new(&path, name);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_xslt_process(xslt, path);
+  }
+  gf_path_free(path);
+  gf_xslt_free(xslt);
+
+  return rc;
+}
+
+static gf_status
+bench_run(bench_set* set, gf_int threads, gf_status* status, double* sec) {
+  double start = 0;
+
+  *sec = 0;
+  for (int r = 0; r < BENCH_REPEAT; r++) {
+    start = bench_now();
+    gf_throw(gf_xslt_run_jobs(
+      set->count, bench_transform, set, threads, GF_FALSE, status));
+    *sec += bench_now() - start;
+    for (gf_size_t i = 0; i < set->count; i++) {
+      gf_throw(status[i]);
+    }
+  }
+  *sec /= BENCH_REPEAT;
+
+  return GF_SUCCESS;
+}
+
+int
+main(int argc, char** argv) {
+  static const gf_int threads[] = { 1, 2, 4, 8, 16 };
+  gf_status rc = GF_SUCCESS;
+  bench_set set = { 0 };
+  gf_status* status = NULL;
+  double base = 0;
+
+  set.count = argc > 1 ? (gf_size_t)strtoul(argv[1], NULL, 10) : 0;
+  if (set.count == 0) {
+    set.count = BENCH_DOCUMENTS;
+  }
+  rc = bench_generate_files(set.count);
+  if (rc != GF_SUCCESS) {
+    fprintf(stderr, "Failed to create the documents.\n");
+    bench_remove_files(set.count);
+    return 1;
+  }
+  printf("%zu document(s), %zu core(s)\n", set.count, gf_thread_count_cores());
+
+  rc = gf_xslt_cache_new(&set.cache);
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_new(&set.style, BENCH_STYLE_FILE);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_malloc((gf_ptr*)&status, sizeof(*status) * set.count);
+  }
+  /* Compile the stylesheet and warm up the page cache */
+  if (rc == GF_SUCCESS) {
+    rc = bench_run(&set, 1, status, &base);
+  }
+  for (gf_size_t i = 0; rc == GF_SUCCESS && i < 5; i++) {
+    double sec = 0;
+
+    rc = bench_run(&set, threads[i], status, &sec);
+    if (rc == GF_SUCCESS) {
+      if (i == 0) {
+        base = sec;
+      }
+      printf("%2d thread(s) %10.1f doc/s %6.2fx\n",
+             (int)threads[i], (double)set.count / sec, base / sec);
+    }
+  }
+  gf_free(status);
+  gf_path_free(set.style);
+  gf_xslt_cache_free(set.cache);
+
+  bench_remove_files(set.count);
+  if (rc != GF_SUCCESS) {
+    fprintf(stderr, "Benchmark failed (%d).\n", rc);
+    return 1;
+  }
+
+  return 0;
+}
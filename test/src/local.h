@@ -21,9 +21,13 @@ extern void gft_string_add_tests(void);
 extern void gft_path_add_tests(void);
 extern void gft_shell_add_tests(void);
 extern void gft_array_add_tests(void);
+extern void gft_map_add_tests(void);
+extern void gft_hash_add_tests(void);
 extern void gft_file_info_add_tests(void);
 extern void gft_site_add_tests(void);
+extern void gft_job_add_tests(void);
 extern void gft_xslt_add_tests(void);
+extern void gft_manifest_add_tests(void);
 
 #ifdef __cplusplus
 }
@@ -8,7 +8,7 @@
 */
 #include <stdlib.h>
 
-#include <CUnit/Cunit.h>
+#include <CUnit/CUnit.h>
 #include <CUnit/Basic.h>
 
 #include "local.h"
@@ -36,9 +36,13 @@ gft_prepare(void) {
   gft_path_add_tests();        // gf_path
   gft_shell_add_tests();       // gf_shell
   gft_array_add_tests();       // gf_array
+  gft_map_add_tests();         // gf_map
+  gft_hash_add_tests();        // gf_hash
   gft_file_info_add_tests();   // gf_file_info
   gft_site_add_tests();        // gf_site
+  gft_job_add_tests();         // gf_job
   gft_xslt_add_tests();        // gf_xslt
+  gft_manifest_add_tests();    // gf_manifest
 }
 
 /*!
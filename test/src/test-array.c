@@ -65,7 +65,40 @@ add_get_normal(void) {
   gf_array_free(ary);
 }
 
+static void
+insert_normal(void) {
+  gf_status rc = 0;
+  gf_array* ary = NULL;
+  gf_any out = { 0 };
 
+  rc = gf_array_new(&ary);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* Over the first chunk */
+  for (gf_size_t i = 0; i < 16; i++) {
+    rc = gf_array_add(ary, (gf_any){ .u64 = i * 2 + 1 });
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  }
+  rc = gf_array_insert(ary, 0, (gf_any){ .u64 = 0 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_array_insert(ary, 2, (gf_any){ .u64 = 2 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_array_insert(ary, gf_array_size(ary), (gf_any){ .u64 = 33 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_array_insert(ary, gf_array_size(ary) + 1, (gf_any){ .u64 = 35 });
+  CU_ASSERT_EQUAL(rc, GF_E_PARAM);
+  CU_ASSERT_EQUAL(gf_array_size(ary), 19);
+  for (gf_size_t i = 0; i < 3; i++) {
+    rc = gf_array_get(ary, i, &out);
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+    CU_ASSERT_EQUAL(out.u64, i);
+  }
+  rc = gf_array_get(ary, 18, &out);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(out.u64, 33);
+
+  gf_array_free(ary);
+}
 
 /* -------------------------------------------------------------------------- */
 
@@ -84,4 +117,5 @@ gft_array_add_tests(void) {
   CU_add_test(s, "New/free with NULL",        new_free_with_null);
   /* add */
   CU_add_test(s, "Add/get element in normal", add_get_normal);
+  CU_add_test(s, "Insert elements",           insert_normal);
 }
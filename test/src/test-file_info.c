@@ -6,8 +6,12 @@
 ** @file test/test-file_info.c
 ** @brief Testing module for gf_file_info.
 */
+#include <string.h>
+
 #include <CUnit/CUnit.h>
 
+#include <libgf/gf_hash.h>
+#include <libgf/gf_map.h>
 #include <libgf/gf_file_info.h>
 
 #include "local.h"
@@ -33,6 +37,318 @@ new_free_normal(void) {
 
 /* -------------------------------------------------------------------------- */
 
+static gf_bool
+are_trees_equal(const gf_file_info* lhs, const gf_file_info* rhs) {
+  gf_size_t count = 0;
+  const gf_char* lpath = NULL;
+  const gf_char* rpath = NULL;
+  gf_8u lhash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u rhash[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  count = gf_file_info_count_children(lhs);
+  if (count != gf_file_info_count_children(rhs)) {
+    return GF_FALSE;
+  }
+  if (gf_file_info_get_full_path(lhs, &lpath) != GF_SUCCESS ||
+      gf_file_info_get_full_path(rhs, &rpath) != GF_SUCCESS ||
+      strcmp(lpath, rpath)) {
+    return GF_FALSE;
+  }
+  if (gf_file_info_get_hash(lhs, sizeof(lhash), lhash) != GF_SUCCESS ||
+      gf_file_info_get_hash(rhs, sizeof(rhash), rhash) != GF_SUCCESS ||
+      memcmp(lhash, rhash, sizeof(lhash))) {
+    return GF_FALSE;
+  }
+  for (gf_size_t i = 0; i < count; i++) {
+    gf_file_info* lchild = NULL;
+    gf_file_info* rchild = NULL;
+
+    if (gf_file_info_get_child(lhs, i, &lchild) != GF_SUCCESS ||
+        gf_file_info_get_child(rhs, i, &rchild) != GF_SUCCESS ||
+        !are_trees_equal(lchild, rchild)) {
+      return GF_FALSE;
+    }
+  }
+  return GF_TRUE;
+}
+
+static void
+scan_parallel(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_file_info* single = NULL;
+  gf_file_info* multi = NULL;
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_file_info_scan(&single, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  option.threads = 4;
+  rc = gf_file_info_scan_with_option(&multi, path, &option);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+
+  CU_ASSERT(gf_file_info_count_children(single) > 0);
+  CU_ASSERT(are_trees_equal(single, multi));
+
+  gf_file_info_free(single);
+  gf_file_info_free(multi);
+}
+
+static gf_size_t
+count_files(const gf_file_info* info) {
+  gf_size_t count = gf_file_info_is_file(info) ? 1 : 0;
+
+  for (gf_size_t i = 0; i < gf_file_info_count_children(info); i++) {
+    gf_file_info* child = NULL;
+
+    if (gf_file_info_get_child(info, i, &child) == GF_SUCCESS) {
+      count += count_files(child);
+    }
+  }
+  return count;
+}
+
+static void
+scan_pipelined(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_file_info* single = NULL;
+  gf_file_info* multi = NULL;
+  gf_file_info_scan_option option = { 0 };
+  gf_file_info_scan_stats stats = { 0 };
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_file_info_scan(&single, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* The smallest queue makes the walkers wait for the hash workers */
+  option.threads = 2;
+  option.hash_threads = 3;
+  option.queue_depth = 1;
+  option.stats = &stats;
+  rc = gf_file_info_scan_with_option(&multi, path, &option);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+
+  CU_ASSERT(are_trees_equal(single, multi));
+  CU_ASSERT_EQUAL(stats.walkers, 2);
+  CU_ASSERT_EQUAL(stats.hashers, 3);
+  /* Other tests may leave files in the directory, so count them */
+  CU_ASSERT(count_files(single) > 0);
+  CU_ASSERT_EQUAL(stats.hashed, count_files(single));
+  CU_ASSERT_EQUAL(stats.reused, 0);
+  CU_ASSERT(stats.walk_nsec <= stats.total_nsec);
+
+  gf_file_info_free(single);
+  gf_file_info_free(multi);
+}
+
+static gf_status
+add_records(gf_map* map, gf_file_info* info) {
+  const gf_char* full_path = NULL;
+
+  gf_throw(gf_file_info_get_full_path(info, &full_path));
+  gf_throw(gf_map_set(map, full_path, (gf_any){ .ptr = info }));
+  for (gf_size_t i = 0; i < gf_file_info_count_children(info); i++) {
+    gf_file_info* child = NULL;
+
+    gf_throw(gf_file_info_get_child(info, i, &child));
+    gf_throw(add_records(map, child));
+  }
+  return GF_SUCCESS;
+}
+
+static void
+scan_with_cache(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_file_info* prev = NULL;
+  gf_file_info* next = NULL;
+  gf_file_info* child = NULL;
+  gf_map* cache = NULL;
+  gf_any any = { 0 };
+  gf_64u mtime = 0;
+  gf_8u hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u out[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_file_info_scan(&prev, path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_map_new(&cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = add_records(cache, prev);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* A record whose stat is unchanged keeps its (fake) hash */
+  CU_ASSERT_TRUE_FATAL(gf_map_find(cache, "/meta.gf", &any));
+  memset(hash, 0xAB, sizeof(hash));
+  rc = gf_file_info_set_hash(any.ptr, GF_HASH_BUFSIZE_FP128, hash);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_file_info_get_modify_time(any.ptr, &mtime);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* ... but not if the hash was computed by another algorithm */
+  CU_ASSERT_TRUE_FATAL(gf_map_find(cache, "/_/style.css", &any));
+  rc = gf_file_info_set_hash(any.ptr, GF_HASH_BUFSIZE_FP128, hash);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_file_info_set_hash_algorithm(any.ptr, GF_HASH_NAME_SHA512);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  option.threads = 2;
+  option.cache = cache;
+  option.cache_time = mtime + 1;
+  rc = gf_file_info_scan_with_option(&next, path, &option);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+
+  for (gf_size_t i = 0; i < gf_file_info_count_children(next); i++) {
+    CU_ASSERT_EQUAL(gf_file_info_get_child(next, i, &child), GF_SUCCESS);
+    if (gf_file_info_does_file_name_equal(child, "meta.gf")) {
+      CU_ASSERT_EQUAL(gf_file_info_get_hash(child, sizeof(out), out),
+                      GF_SUCCESS);
+      CU_ASSERT_EQUAL(memcmp(out, hash, GF_HASH_BUFSIZE_FP128), 0);
+    }
+    if (gf_file_info_does_file_name_equal(child, "_")) {
+      CU_ASSERT_EQUAL_FATAL(gf_file_info_get_child(child, 0, &child),
+                            GF_SUCCESS);
+      CU_ASSERT_EQUAL(gf_file_info_get_hash(child, sizeof(out), out),
+                      GF_SUCCESS);
+      CU_ASSERT_NOT_EQUAL(memcmp(out, hash, GF_HASH_BUFSIZE_FP128), 0);
+    }
+  }
+
+  gf_map_free(cache);
+  gf_file_info_free(prev);
+  gf_file_info_free(next);
+}
+
+/*!
+** @brief Rescan the sample with a fake hash recorded for meta.gf.
+**
+** @param [in] change 0: no change, 1: the record is racily clean,
+**                    2: another create time, 3: another inode above 16 bits
+** @return GF_TRUE if the fake hash is reused
+*/
+
+static gf_bool
+rescan_with_fake_hash(int change) {
+  gf_bool reused = GF_FALSE;
+  gf_path* path = NULL;
+  gf_file_info* prev = NULL;
+  gf_file_info* next = NULL;
+  gf_file_info* child = NULL;
+  gf_map* cache = NULL;
+  gf_any any = { 0 };
+  gf_64u u64 = 0;
+  gf_8u hash[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u out[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_file_info_scan_option option = { 0 };
+
+  CU_ASSERT_EQUAL_FATAL(
+    gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample"), GF_SUCCESS);
+  CU_ASSERT_EQUAL_FATAL(gf_file_info_scan(&prev, path), GF_SUCCESS);
+  CU_ASSERT_EQUAL_FATAL(gf_map_new(&cache), GF_SUCCESS);
+  CU_ASSERT_EQUAL(add_records(cache, prev), GF_SUCCESS);
+  CU_ASSERT_TRUE_FATAL(gf_map_find(cache, "/meta.gf", &any));
+  memset(hash, 0xAB, sizeof(hash));
+  CU_ASSERT_EQUAL(gf_file_info_set_hash(any.ptr, GF_HASH_BUFSIZE_FP128, hash),
+                  GF_SUCCESS);
+
+  CU_ASSERT_EQUAL(gf_file_info_get_modify_time(any.ptr, &u64), GF_SUCCESS);
+  option.cache = cache;
+  option.cache_time = change == 1 ? u64 : u64 + 1;
+  if (change == 2) {
+    CU_ASSERT_EQUAL(gf_file_info_get_create_time(any.ptr, &u64), GF_SUCCESS);
+    CU_ASSERT_EQUAL(gf_file_info_set_create_time(any.ptr, u64 + 1),
+                    GF_SUCCESS);
+  }
+  if (change == 3) {
+    CU_ASSERT_EQUAL(gf_file_info_get_inode(any.ptr, &u64), GF_SUCCESS);
+    CU_ASSERT_EQUAL(gf_file_info_set_inode(any.ptr, u64 ^ 0x10000),
+                    GF_SUCCESS);
+  }
+  CU_ASSERT_EQUAL(gf_file_info_scan_with_option(&next, path, &option),
+                  GF_SUCCESS);
+  gf_path_free(path);
+
+  if (gf_file_info_find_child(next, "meta.gf", &child)) {
+    CU_ASSERT_EQUAL(gf_file_info_get_hash(child, sizeof(out), out),
+                    GF_SUCCESS);
+    reused = memcmp(out, hash, GF_HASH_BUFSIZE_FP128) == 0;
+  }
+
+  gf_map_free(cache);
+  gf_file_info_free(prev);
+  gf_file_info_free(next);
+  return reused;
+}
+
+static void
+scan_with_stale_cache(void) {
+  /* Only an unchanged record scanned after its last modification is reused */
+  CU_ASSERT(rescan_with_fake_hash(0));
+  CU_ASSERT(!rescan_with_fake_hash(1));
+  CU_ASSERT(!rescan_with_fake_hash(2));
+  CU_ASSERT(!rescan_with_fake_hash(3));
+}
+
+static void
+scan_with_null(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_file_info* info = NULL;
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_file_info_scan_with_option(&info, path, NULL);
+  CU_ASSERT_EQUAL(rc, GF_E_PARAM);
+  gf_path_free(path);
+}
+
+static void
+find_child(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_file_info* info = NULL;
+  gf_file_info* child = NULL;
+  const gf_char* name = NULL;
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_file_info_scan(&info, path);
+  gf_path_free(path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* Every child is found at its own position */
+  for (gf_size_t i = 0; i < gf_file_info_count_children(info); i++) {
+    gf_file_info* found = NULL;
+
+    CU_ASSERT_EQUAL(gf_file_info_get_child(info, i, &child), GF_SUCCESS);
+    CU_ASSERT_EQUAL(gf_file_info_get_file_name(child, &name), GF_SUCCESS);
+    CU_ASSERT(gf_file_info_find_child(info, name, &found));
+    CU_ASSERT_PTR_EQUAL(found, child);
+  }
+  CU_ASSERT(gf_file_info_find_child(info, "meta.gf", NULL));
+  CU_ASSERT(!gf_file_info_find_child(info, "index.dbk", NULL));
+  CU_ASSERT(!gf_file_info_find_child(info, "", NULL));
+
+  CU_ASSERT(gf_file_info_find_child(info, "about-grayfish", &child));
+  CU_ASSERT(gf_file_info_find_child(child, "index.dbk", NULL));
+
+  gf_file_info_free(info);
+}
+
+/* -------------------------------------------------------------------------- */
+
 /*!
 ** @brief The interface function for the test of gf_file_info.
 **
@@ -45,5 +361,13 @@ gft_file_info_add_tests(void) {
 
   /* new/free */
   CU_add_test(s, "New/free in noraml case",   new_free_normal);
+  /* scan */
+  CU_add_test(s, "Scan with multiple threads", scan_parallel);
+  CU_add_test(s, "Scan with hash workers",     scan_pipelined);
+  CU_add_test(s, "Scan with previous records", scan_with_cache);
+  CU_add_test(s, "Scan with stale records",    scan_with_stale_cache);
+  CU_add_test(s, "Scan with NULL option",      scan_with_null);
+  /* children */
+  CU_add_test(s, "Find a child by the name",   find_child);
 }
 
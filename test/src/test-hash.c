@@ -0,0 +1,238 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/test-hash.c
+** @brief Testing module for gf_hash.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CUnit/CUnit.h>
+
+#include <libgf/gf_hash.h>
+
+#include "local.h"
+
+/* -------------------------------------------------------------------------- */
+
+static void
+find_normal(void) {
+  const gf_hash_provider* hash = NULL;
+
+  hash = gf_hash_find(GF_HASH_NAME_FP128);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(hash);
+  CU_ASSERT_EQUAL(hash->size, GF_HASH_BUFSIZE_FP128);
+  CU_ASSERT_PTR_EQUAL(hash, gf_hash_get_default());
+
+  hash = gf_hash_find(GF_HASH_NAME_SHA512);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(hash);
+  CU_ASSERT_EQUAL(hash->size, GF_HASH_BUFSIZE_SHA512);
+
+  CU_ASSERT_EQUAL(gf_hash_count_providers(), 2);
+  CU_ASSERT_PTR_NULL(gf_hash_get_provider(gf_hash_count_providers()));
+}
+
+static void
+find_unknown(void) {
+  CU_ASSERT_PTR_NULL(gf_hash_find("md5"));
+  CU_ASSERT_PTR_NULL(gf_hash_find(""));
+  CU_ASSERT_PTR_NULL(gf_hash_find(NULL));
+}
+
+static void
+buffer_sha512(void) {
+  gf_status rc = 0;
+  gf_8u out[GF_HASH_BUFSIZE_MAX] = { 0 };
+  /* SHA-512("abc") */
+  static const gf_8u expected[GF_HASH_BUFSIZE_SHA512] = {
+    0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba,
+    0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+    0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+    0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+    0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+    0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+    0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+    0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f,
+  };
+
+  rc = gf_hash_buffer(gf_hash_find(GF_HASH_NAME_SHA512),
+                      out, sizeof(out), (const gf_8u*)"abc", 3);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(memcmp(out, expected, sizeof(expected)), 0);
+}
+
+static void
+buffer_fp128(void) {
+  gf_status rc = 0;
+  const gf_hash_provider* hash = gf_hash_find(GF_HASH_NAME_FP128);
+  gf_8u data[1000] = { 0 };
+  gf_8u a[GF_HASH_BUFSIZE_FP128] = { 0 };
+  gf_8u b[GF_HASH_BUFSIZE_FP128] = { 0 };
+  gf_hash_context ctx;
+
+  for (gf_size_t i = 0; i < sizeof(data); i++) {
+    data[i] = (gf_8u)(i * 7);
+  }
+  rc = gf_hash_buffer(hash, a, sizeof(a), data, sizeof(data));
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* The digest does not depend on how the data is split */
+  CU_ASSERT_EQUAL_FATAL(hash->init(&ctx), GF_SUCCESS);
+  CU_ASSERT_EQUAL(hash->update(&ctx, data, 1), GF_SUCCESS);
+  CU_ASSERT_EQUAL(hash->update(&ctx, data + 1, 100), GF_SUCCESS);
+  CU_ASSERT_EQUAL(hash->update(&ctx, data + 101, 899), GF_SUCCESS);
+  CU_ASSERT_EQUAL(hash->final(&ctx, b), GF_SUCCESS);
+  CU_ASSERT_EQUAL(memcmp(a, b, sizeof(a)), 0);
+
+  /* A single bit flip changes the digest */
+  data[500] ^= 1;
+  rc = gf_hash_buffer(hash, b, sizeof(b), data, sizeof(data));
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_NOT_EQUAL(memcmp(a, b, sizeof(a)), 0);
+
+  /* So does the length */
+  data[500] ^= 1;
+  rc = gf_hash_buffer(hash, b, sizeof(b), data, sizeof(data) - 1);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_NOT_EQUAL(memcmp(a, b, sizeof(a)), 0);
+}
+
+static void
+buffer_with_small_buffer(void) {
+  gf_status rc = 0;
+  gf_8u out[GF_HASH_BUFSIZE_FP128] = { 0 };
+
+  rc = gf_hash_buffer(gf_hash_find(GF_HASH_NAME_SHA512),
+                      out, sizeof(out), (const gf_8u*)"abc", 3);
+  CU_ASSERT_EQUAL(rc, GF_E_PARAM);
+}
+
+static void
+file_normal(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  FILE* fp = NULL;
+  gf_8u data[10000] = { 0 };
+  gf_size_t len = 0;
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site/sample/meta.gf");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  fp = fopen(gf_path_get_string(path), "rb");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+  len = fread(data, 1, sizeof(data), fp);
+  fclose(fp);
+
+  /* The digest of a file equals to that of its content */
+  for (gf_size_t i = 0; i < gf_hash_count_providers(); i++) {
+    const gf_hash_provider* hash = gf_hash_get_provider(i);
+    gf_8u a[GF_HASH_BUFSIZE_MAX] = { 0 };
+    gf_8u b[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+    rc = gf_hash_file_with(hash, a, sizeof(a), path);
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+    rc = gf_hash_buffer(hash, b, sizeof(b), data, len);
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+    CU_ASSERT_EQUAL(memcmp(a, b, hash->size), 0);
+  }
+  gf_path_free(path);
+}
+
+static void
+file_map_and_read(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  FILE* fp = NULL;
+  gf_8u* data = NULL;
+  gf_size_t len = GF_HASH_BUFSIZE_READ * 3 + 123;
+  gf_hash_stats stats = { 0 };
+  const gf_hash_provider* hash = gf_hash_get_default();
+  gf_8u a[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u b[GF_HASH_BUFSIZE_MAX] = { 0 };
+  gf_8u c[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  /* Larger than the read buffer, so that it is read in several chunks */
+  data = malloc(len);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(data);
+  for (gf_size_t i = 0; i < len; i++) {
+    data[i] = (gf_8u)(i ^ (i >> 8));
+  }
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_hash.tmp");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  fp = fopen(gf_path_get_string(path), "wb");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+  CU_ASSERT_EQUAL(fwrite(data, 1, len, fp), len);
+  fclose(fp);
+
+  gf_hash_reset_stats();
+
+  /* Memory mapping */
+  gf_hash_set_mmap_threshold(1);
+  rc = gf_hash_file_with(hash, a, sizeof(a), path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  /* Positional reads */
+  gf_hash_set_mmap_threshold(len + 1);
+  rc = gf_hash_file_with(hash, b, sizeof(b), path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  /* No file is mapped, as in gf watch */
+  gf_hash_set_mmap_threshold(GF_HASH_MMAP_THRESHOLD_NEVER);
+  rc = gf_hash_file_with(hash, b, sizeof(b), path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_hash_set_mmap_threshold(GF_HASH_MMAP_THRESHOLD_DEFAULT);
+
+  rc = gf_hash_buffer(hash, c, sizeof(c), data, len);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(memcmp(a, c, hash->size), 0);
+  CU_ASSERT_EQUAL(memcmp(b, c, hash->size), 0);
+
+  CU_ASSERT_EQUAL(gf_hash_get_stats(GF_HASH_IO_MAP, &stats), GF_SUCCESS);
+  CU_ASSERT_EQUAL(stats.files, 1);
+  CU_ASSERT_EQUAL(stats.bytes, len);
+  CU_ASSERT_EQUAL(gf_hash_get_stats(GF_HASH_IO_READ, &stats), GF_SUCCESS);
+  CU_ASSERT_EQUAL(stats.files, 2);
+  CU_ASSERT_EQUAL(stats.bytes, len * 2);
+
+  remove(gf_path_get_string(path));
+  gf_path_free(path);
+  free(data);
+}
+
+static void
+file_not_found(void) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+  gf_8u out[GF_HASH_BUFSIZE_MAX] = { 0 };
+
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/no-such-file");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_hash_file_with(gf_hash_get_default(), out, sizeof(out), path);
+  CU_ASSERT_EQUAL(rc, GF_E_OPEN);
+  gf_path_free(path);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The interface function for the test of gf_hash.
+**
+** Registers the tests of gf_hash module.
+*/
+
+void
+gft_hash_add_tests(void) {
+  CU_pSuite s = CU_add_suite("Tests for gf_hash", NULL, NULL);
+
+  /* find */
+  CU_add_test(s, "Find providers",               find_normal);
+  CU_add_test(s, "Find unknown providers",       find_unknown);
+  /* buffer */
+  CU_add_test(s, "SHA-512 of a buffer",          buffer_sha512);
+  CU_add_test(s, "FP128 of a buffer",            buffer_fp128);
+  CU_add_test(s, "Hash with too small a buffer", buffer_with_small_buffer);
+  /* file */
+  CU_add_test(s, "Hash of a file",               file_normal);
+  CU_add_test(s, "Hash of a file by mmap/read",  file_map_and_read);
+  CU_add_test(s, "Hash of a missing file",       file_not_found);
+}
@@ -0,0 +1,142 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/test-job.c
+** @brief Testing module for gf_job.
+*/
+#include <CUnit/CUnit.h>
+
+#include <libgf/gf_thread.h>
+#include <libgf/gf_datetime.h>
+#include <libgf/gf_job.h>
+
+#include "local.h"
+
+/* -------------------------------------------------------------------------- */
+
+#define GRAPH_JOB_COUNT 6
+#define GRAPH_SLOW_JOB  2
+#define GRAPH_SLOW_NSEC 5000000
+
+typedef struct graph_set {
+  gf_mutex  lock;
+  gf_size_t order[GRAPH_JOB_COUNT]; ///< The position each job was run at
+  gf_size_t next;
+  gf_size_t fail;                   ///< The index of the failing job
+} graph_set;
+
+static gf_status
+run_graph_job(gf_size_t index, gf_ptr data) {
+  graph_set* set = data;
+
+  gf_mutex_lock(&set->lock);
+  set->order[index] = set->next++;
+  gf_mutex_unlock(&set->lock);
+  /* The slow job makes the critical path */
+  if (index == GRAPH_SLOW_JOB) {
+    gf_64u start = gf_datetime_get_monotonic_ns();
+
+    while (gf_datetime_get_monotonic_ns() - start < GRAPH_SLOW_NSEC) {
+      /* wait */
+    }
+  }
+
+  return index == set->fail ? GF_E_EXEC : GF_SUCCESS;
+}
+
+void
+test_job_graph(void) {
+  gf_status rc = 0;
+  gf_job_graph* graph = NULL;
+  graph_set set = { .fail = GRAPH_JOB_COUNT };
+  gf_status status[GRAPH_JOB_COUNT] = { 0 };
+  gf_size_t path[GRAPH_JOB_COUNT] = { 0 };
+  gf_size_t cnt = 0;
+  gf_64u nsec = 0;
+
+  rc = gf_mutex_init(&set.lock);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_job_graph_new(&graph);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  for (gf_size_t i = 0; i < GRAPH_JOB_COUNT; i++) {
+    gf_size_t index = 0;
+
+    rc = gf_job_graph_add_job(graph, &index);
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+    CU_ASSERT_EQUAL(index, i);
+  }
+  /* 0 -> {1, 2} -> 3 -> 4; 5 is independent */
+  CU_ASSERT_EQUAL(gf_job_graph_add_edge(graph, 0, 1), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_add_edge(graph, 0, 2), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_add_edge(graph, 1, 3), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_add_edge(graph, 2, 3), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_add_edge(graph, 3, 4), GF_SUCCESS);
+  /* An edge to an earlier job could make a cycle */
+  CU_ASSERT_NOT_EQUAL(gf_job_graph_add_edge(graph, 4, 0), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_count_jobs(graph), GRAPH_JOB_COUNT);
+
+  /* The jobs run after the jobs they depend on */
+  rc = gf_job_graph_run(graph, run_graph_job, &set, 4, GF_FALSE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  for (gf_size_t i = 0; i < GRAPH_JOB_COUNT; i++) {
+    CU_ASSERT_EQUAL(status[i], GF_SUCCESS);
+  }
+  CU_ASSERT(set.order[0] < set.order[1]);
+  CU_ASSERT(set.order[0] < set.order[2]);
+  CU_ASSERT(set.order[1] < set.order[3]);
+  CU_ASSERT(set.order[2] < set.order[3]);
+  CU_ASSERT(set.order[3] < set.order[4]);
+
+  /* The critical path goes through the slow job */
+  rc = gf_job_graph_get_critical_path(graph, path, &cnt, &nsec);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(cnt, 4);
+  CU_ASSERT_EQUAL(path[0], 0);
+  CU_ASSERT_EQUAL(path[1], GRAPH_SLOW_JOB);
+  CU_ASSERT_EQUAL(path[2], 3);
+  CU_ASSERT_EQUAL(path[3], 4);
+  CU_ASSERT(nsec >= GRAPH_SLOW_NSEC);
+
+  /* A failure stops only the jobs depending on it */
+  set.next = 0;
+  set.fail = 1;
+  rc = gf_job_graph_run(graph, run_graph_job, &set, 4, GF_FALSE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(status[0], GF_SUCCESS);
+  CU_ASSERT_NOT_EQUAL(status[1], GF_SUCCESS);
+  CU_ASSERT_EQUAL(status[2], GF_SUCCESS);
+  CU_ASSERT_EQUAL(status[3], GF_E_STATE);
+  CU_ASSERT_EQUAL(status[4], GF_E_STATE);
+  CU_ASSERT_EQUAL(status[5], GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_job_graph_get_job_time(graph, 3), 0);
+
+  /* No job is started after the failure with fail-fast */
+  set.next = 0;
+  set.fail = 0;
+  rc = gf_job_graph_run(graph, run_graph_job, &set, 1, GF_TRUE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_NOT_EQUAL(status[0], GF_SUCCESS);
+  for (gf_size_t i = 1; i < GRAPH_JOB_COUNT; i++) {
+    CU_ASSERT_EQUAL(status[i], GF_E_STATE);
+  }
+
+  gf_job_graph_free(graph);
+  gf_mutex_destroy(&set.lock);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The interface function for the test of gf_job.
+**
+** Registers the tests of gf_job module.
+*/
+
+void
+gft_job_add_tests(void) {
+  CU_pSuite s = CU_add_suite("Tests for gf_job", NULL, NULL);
+
+  CU_add_test(s, "Job graph", test_job_graph);
+}
@@ -0,0 +1,208 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/test-manifest.c
+** @brief Testing module for gf_manifest.
+*/
+#include <assert.h>
+#include <stdio.h>
+
+#include <CUnit/CUnit.h>
+
+#include <libgf/gf_manifest.h>
+#include <libgf/gf_shell.h>
+
+#include "util.h"
+#include "local.h"
+
+#define MANIFEST_FILE "build-manifest.xml"
+
+static gft_test_ctxt* ctxt_ = NULL;
+
+/* -------------------------------------------------------------------------- */
+
+static void
+touch(const gf_char* file) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+
+  rc = gf_path_new(&path, file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_shell_touch(path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+}
+
+static gf_bool
+exists(const gf_char* file) {
+  gf_path* path = NULL;
+  gf_bool ret = GF_FALSE;
+
+  if (gf_path_new(&path, file) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+  ret = gf_shell_file_exists(path);
+  gf_path_free(path);
+
+  return ret;
+}
+
+static void
+add_unit(
+  gf_manifest* manifest, const gf_char* key, const gf_char* fingerprint,
+  const gf_char* output) {
+  gf_status rc = 0;
+  gf_manifest_unit* unit = NULL;
+
+  rc = gf_manifest_add_unit(manifest, key, fingerprint, &unit);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  if (output) {
+    rc = gf_manifest_unit_add_output(unit, output);
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+    touch(output);
+  }
+}
+
+static void
+write_manifest(const gf_manifest* manifest) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+
+  rc = gf_path_new(&path, MANIFEST_FILE);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_manifest_write_file(manifest, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+}
+
+static gf_manifest*
+read_manifest(void) {
+  gf_status rc = 0;
+  gf_manifest* manifest = NULL;
+  gf_path* path = NULL;
+
+  rc = gf_manifest_new(&manifest);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&path, MANIFEST_FILE);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_manifest_read_file(manifest, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(path);
+
+  return manifest;
+}
+
+static void
+keep_unit(void) {
+  gf_status rc = 0;
+  gf_manifest* manifest = NULL;
+  gf_bool ret = GF_FALSE;
+
+  rc = gf_manifest_new(&manifest);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  ret = gf_manifest_keep_unit(manifest, "document:/a", "01");
+  CU_ASSERT_EQUAL(ret, GF_FALSE);
+  add_unit(manifest, "document:/a", "01", "a.html");
+  add_unit(manifest, "document:/b", "02", "b.html");
+  add_unit(manifest, "document:/c", "", "c.html");
+  CU_ASSERT_EQUAL(gf_manifest_count_added_units(manifest), 3);
+  write_manifest(manifest);
+  gf_manifest_free(manifest);
+
+  manifest = read_manifest();
+  /* The fingerprint has changed */
+  ret = gf_manifest_keep_unit(manifest, "document:/a", "03");
+  CU_ASSERT_EQUAL(ret, GF_FALSE);
+  ret = gf_manifest_keep_unit(manifest, "document:/a", "01");
+  CU_ASSERT_EQUAL(ret, GF_TRUE);
+  /* The output has been removed */
+  CU_ASSERT_EQUAL(remove("b.html"), 0);
+  ret = gf_manifest_keep_unit(manifest, "document:/b", "02");
+  CU_ASSERT_EQUAL(ret, GF_FALSE);
+  /* An empty fingerprint is never up to date */
+  ret = gf_manifest_keep_unit(manifest, "document:/c", "");
+  CU_ASSERT_EQUAL(ret, GF_FALSE);
+  CU_ASSERT_EQUAL(gf_manifest_count_kept_units(manifest), 1);
+  CU_ASSERT_EQUAL(gf_manifest_count_added_units(manifest), 0);
+  gf_manifest_free(manifest);
+}
+
+static void
+remove_stale_outputs(void) {
+  gf_status rc = 0;
+  gf_manifest* manifest = NULL;
+  gf_manifest_unit* unit = NULL;
+  gf_size_t cnt = 0;
+
+  rc = gf_manifest_new(&manifest);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_manifest_add_unit(manifest, "process:/:index:x.html", "01", &unit);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_manifest_unit_add_output(unit, "x.html");
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_manifest_unit_add_output(unit, "y.html");
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  touch("x.html");
+  touch("y.html");
+  add_unit(manifest, "document:/z", "02", "z.html");
+  write_manifest(manifest);
+  gf_manifest_free(manifest);
+
+  /* The process no longer writes y.html, and the document is removed */
+  manifest = read_manifest();
+  add_unit(manifest, "process:/:index:x.html", "03", "x.html");
+  rc = gf_manifest_remove_stale_outputs(manifest, &cnt);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(cnt, 2);
+  CU_ASSERT_EQUAL(exists("x.html"), GF_TRUE);
+  CU_ASSERT_EQUAL(exists("y.html"), GF_FALSE);
+  CU_ASSERT_EQUAL(exists("z.html"), GF_FALSE);
+  write_manifest(manifest);
+  gf_manifest_free(manifest);
+
+  /* Only the live unit is written */
+  manifest = read_manifest();
+  CU_ASSERT_EQUAL(
+    gf_manifest_keep_unit(manifest, "process:/:index:x.html", "03"), GF_TRUE);
+  CU_ASSERT_EQUAL(
+    gf_manifest_keep_unit(manifest, "document:/z", "02"), GF_FALSE);
+  rc = gf_manifest_remove_stale_outputs(manifest, &cnt);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(cnt, 0);
+  gf_manifest_free(manifest);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int
+manifest_init(void) {
+  assert(ctxt_ == NULL);
+
+  return gft_test_ctxt_new(&ctxt_);
+}
+
+static int
+manifest_cleanup(void) {
+  if (ctxt_) {
+    gft_test_ctxt_free(ctxt_);
+    ctxt_ = NULL;
+  }
+  return 0;
+}
+
+/*!
+** @brief The interface function for the test of gf_manifest.
+**
+** Registers the tests of gf_manifest module.
+*/
+
+void
+gft_manifest_add_tests(void) {
+  CU_pSuite s = CU_add_suite(
+    "Tests for gf_manifest", manifest_init, manifest_cleanup);
+
+  CU_add_test(s, "Keep a unit", keep_unit);
+  CU_add_test(s, "Remove stale outputs", remove_stale_outputs);
+}
@@ -0,0 +1,117 @@
+/*-
+ * This file is part of Grayfish project. For license details, see the file
+ * 'LICENSE.md' in this package.
+ */
+/*!
+** @file test/test-map.c
+** @brief Testing module for gf_map.
+*/
+#include <stdio.h>
+
+#include <CUnit/CUnit.h>
+
+#include <libgf/gf_map.h>
+
+#include "local.h"
+
+/* -------------------------------------------------------------------------- */
+
+static void
+new_free_normal(void) {
+  gf_status rc = 0;
+  gf_map* map = NULL;
+
+  rc = gf_map_new(&map);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_map_size(map), 0);
+
+  gf_map_free(map);
+}
+
+static void
+new_free_with_null(void) {
+  gf_status rc = 0;
+
+  rc = gf_map_new(NULL);
+  CU_ASSERT_EQUAL(rc, GF_E_PARAM);
+}
+
+static void
+set_find_normal(void) {
+  gf_status rc = 0;
+  gf_map* map = NULL;
+  gf_any out = { 0 };
+
+  rc = gf_map_new(&map);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_map_set(map, "/index.dbk", (gf_any){ .u64 = 1 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_map_set(map, "/meta.gf", (gf_any){ .u64 = 2 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_map_size(map), 2);
+
+  CU_ASSERT_TRUE(gf_map_find(map, "/index.dbk", &out));
+  CU_ASSERT_EQUAL(out.u64, 1);
+  CU_ASSERT_FALSE(gf_map_find(map, "/unknown", &out));
+
+  /* Overwrite */
+  rc = gf_map_set(map, "/index.dbk", (gf_any){ .u64 = 3 });
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_map_size(map), 2);
+  CU_ASSERT_TRUE(gf_map_find(map, "/index.dbk", &out));
+  CU_ASSERT_EQUAL(out.u64, 3);
+
+  /* Remove */
+  rc = gf_map_remove(map, "/index.dbk");
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_map_size(map), 1);
+  CU_ASSERT_FALSE(gf_map_find(map, "/index.dbk", NULL));
+
+  gf_map_free(map);
+}
+
+static void
+set_find_many(void) {
+  gf_status rc = 0;
+  gf_map* map = NULL;
+  gf_char key[32] = { 0 };
+  gf_any out = { 0 };
+
+  rc = gf_map_new(&map);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  for (gf_size_t i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "/dir/%zu", i);
+    rc = gf_map_set(map, key, (gf_any){ .u64 = i });
+    CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  }
+  CU_ASSERT_EQUAL(gf_map_size(map), 1000);
+  for (gf_size_t i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "/dir/%zu", i);
+    CU_ASSERT_TRUE(gf_map_find(map, key, &out));
+    CU_ASSERT_EQUAL(out.u64, i);
+  }
+
+  gf_map_free(map);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*!
+** @brief The interface function for the test of gf_map.
+**
+** Registers the tests of gf_map module.
+*/
+
+void
+gft_map_add_tests(void) {
+  CU_pSuite s = CU_add_suite("Tests for gf_map", NULL, NULL);
+
+  /* new/free */
+  CU_add_test(s, "New/free in noraml case",   new_free_normal);
+  CU_add_test(s, "New/free with NULL",        new_free_with_null);
+  /* set/find */
+  CU_add_test(s, "Set/find element in normal", set_find_normal);
+  CU_add_test(s, "Set/find many elements",     set_find_many);
+}
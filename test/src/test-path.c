@@ -9,7 +9,9 @@
 #include <CUnit/CUnit.h>
 
 #include <libgf/gf_path.h>
+#include <libgf/gf_shell.h>
 
+#include "util.h"
 #include "local.h"
 
 /* -------------------------------------------------------------------------- */
@@ -239,6 +241,40 @@ copy_paths_with_null_ptr(void) {
 
 /* -------------------------------------------------------------------------- */
 
+static void
+evacuate_existing_directory(void) {
+  int ret = 0;
+  gf_status rc = 0;
+  gf_path* dir = NULL;
+  gf_path* file = NULL;
+  gft_test_ctxt* ctxt = NULL;
+
+  /* The evacuated directory is removed with the work directory */
+  ret = gft_test_ctxt_new(&ctxt);
+  CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+  rc = gf_path_new(&dir, "dst");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&file, "dst/f");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_shell_make_directory(dir);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_shell_touch(file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The directory is moved away and an empty one is made */
+  rc = gf_path_evacuate(dir);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(gf_path_is_directory(dir));
+  CU_ASSERT(!gf_path_file_exists(file));
+
+  gf_path_free(file);
+  gf_path_free(dir);
+  gft_test_ctxt_free(ctxt);
+}
+
+/* -------------------------------------------------------------------------- */
+
 /*!
 ** @brief The interface function for the test of gf_path.
 **
@@ -265,4 +301,6 @@ gft_path_add_tests(void) {
   /* copy */
   CU_add_test(s, "Copy paths in normal cond",   copy_paths_in_normal_cond);
   CU_add_test(s, "Copy paths with null ptr",    copy_paths_with_null_ptr);
+  /* evacuate */
+  CU_add_test(s, "Evacuate existing directory", evacuate_existing_directory);
 }
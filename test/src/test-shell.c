@@ -65,9 +65,9 @@ create_file_with_null(void) {
 
   rc = gf_shell_touch(NULL);
   CU_ASSERT_NOT_EQUAL(rc, GF_SUCCESS);
-  ret = gf_shell_is_normal_file(path);
+  ret = gf_shell_is_normal_file(NULL);
   CU_ASSERT_EQUAL(ret, GF_FALSE);
-  ret = gf_shell_is_directory(path);
+  ret = gf_shell_is_directory(NULL);
   CU_ASSERT_EQUAL(ret, GF_FALSE);
   rc = gf_shell_remove_file(NULL);
   CU_ASSERT_NOT_EQUAL(rc, GF_SUCCESS);
@@ -388,16 +388,16 @@ copy_tree_in_normal(void) {
 
   rc = gf_path_new(&s_dir1, "d1");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&s_dir2, "d1\\d2");
+  rc = gf_path_new(&s_dir2, "d1/d2");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&s_file, "d1\\d2\\f");
+  rc = gf_path_new(&s_file, "d1/d2/f");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
 
   rc = gf_path_new(&d_dir1, "dst");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&d_dir2, "dst\\d2");
+  rc = gf_path_new(&d_dir2, "dst/d2");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&d_file, "dst\\d2\\f");
+  rc = gf_path_new(&d_file, "dst/d2/f");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
   
   rc = gf_shell_make_directory(s_dir1);
@@ -455,9 +455,9 @@ remove_tree_in_normal(void) {
 
   rc = gf_path_new(&s_dir1, "d1");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&s_dir2, "d1\\d2");
+  rc = gf_path_new(&s_dir2, "d1/d2");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
-  rc = gf_path_new(&s_file, "d1\\d2\\f");
+  rc = gf_path_new(&s_file, "d1/d2/f");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
   
   rc = gf_shell_make_directory(s_dir1);
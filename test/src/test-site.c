@@ -7,8 +7,14 @@
 ** @file test/test-site.c
 ** @brief Testing module for gf_site.
 */
+#include <stdio.h>
+#include <string.h>
+
 #include <CUnit/CUnit.h>
 
+#include <libgf/gf_cmd_update.h>
+#include <libgf/gf_db.h>
+#include <libgf/gf_shell.h>
 #include <libgf/gf_site.h>
 
 #include "local.h"
@@ -54,6 +60,1003 @@ scan_website(void) {
   CU_ASSERT_EQUAL(rc, GF_SUCCESS);
 }
 
+static gf_bool
+are_entries_equal(gf_entry* lhs, gf_entry* rhs) {
+  gf_size_t count = gf_entry_count_children(lhs);
+
+  if (count != gf_entry_count_children(rhs) ||
+      strcmp(gf_entry_get_full_path_string(lhs),
+             gf_entry_get_full_path_string(rhs)) ||
+      strcmp(gf_entry_get_method_string(lhs),
+             gf_entry_get_method_string(rhs))) {
+    return GF_FALSE;
+  }
+  for (gf_size_t i = 0; i < count; i++) {
+    gf_entry* lchild = NULL;
+    gf_entry* rchild = NULL;
+
+    if (gf_entry_get_child(lhs, i, &lchild) != GF_SUCCESS ||
+        gf_entry_get_child(rhs, i, &rchild) != GF_SUCCESS ||
+        !are_entries_equal(lchild, rchild)) {
+      return GF_FALSE;
+    }
+  }
+
+  return GF_TRUE;
+}
+
+static void
+scan_website_parallel(void) {
+  gf_status rc = 0;
+  gf_site* single = NULL;
+  gf_site* multi = NULL;
+  gf_path* site_path = NULL;
+  gf_entry* lhs = NULL;
+  gf_entry* rhs = NULL;
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_scan(&single, site_path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  option.threads = 4;
+  rc = gf_site_scan_with_option(&multi, site_path, &option, NULL);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_path_free(site_path);
+
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(single, &lhs), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(multi, &rhs), GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(lhs);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(rhs);
+  CU_ASSERT(gf_entry_count_children(lhs) > 0);
+  CU_ASSERT(are_entries_equal(lhs, rhs));
+
+  gf_site_free(single);
+  gf_site_free(multi);
+}
+
+static void
+scan_broken_website(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_path* site_path = NULL;
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/broken");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The document without the info element is reported */
+  option.threads = 2;
+  rc = gf_site_scan_with_option(&site, site_path, &option, NULL);
+  CU_ASSERT_EQUAL(rc, GF_E_DATA);
+  gf_path_free(site_path);
+}
+
+static gf_bool
+is_category_of(
+  const gf_site* site, gf_category_kind kind, const gf_char* id,
+  const gf_char* path) {
+  const gf_category* cat = NULL;
+  gf_entry* entry = NULL;
+
+  if (!gf_site_find_category(site, kind, id, &cat) ||
+      gf_category_count_entries(cat) != 1 ||
+      gf_category_get_entry(cat, 0, &entry) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+
+  if (strcmp(gf_entry_get_full_path_string(entry), path)) {
+    return GF_FALSE;
+  }
+
+  return GF_TRUE;
+}
+
+static void
+list_category_entries(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site* loaded = NULL;
+  gf_path* site_path = NULL;
+  gf_path* site_file = NULL;
+  const gf_category* cat = NULL;
+
+  static const char DOCUMENT[] = "/about-grayfish/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&site_file, GFT_TEST_SITE_ROOT "/sample/site.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT(is_category_of(site, GF_CATEGORY_SUBJECT, "web", DOCUMENT));
+  CU_ASSERT(is_category_of(site, GF_CATEGORY_KEYWORD, "grayfish", DOCUMENT));
+  CU_ASSERT(gf_site_find_category(site, GF_CATEGORY_SUBJECT, "web", &cat));
+  CU_ASSERT_STRING_EQUAL(gf_category_get_name_string(cat), "web");
+  /* The subjects and the keywords are separated */
+  CU_ASSERT(!gf_site_find_category(
+              site, GF_CATEGORY_SUBJECT, "grayfish", NULL));
+  CU_ASSERT(!gf_site_find_category(site, GF_CATEGORY_KEYWORD, "none", NULL));
+
+  /* The site file refers to the same categories */
+  rc = gf_site_write_file(site, site_file);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_read_file(&loaded, site_file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT(is_category_of(
+              loaded, GF_CATEGORY_SUBJECT, "c-cpp-lang", DOCUMENT));
+  CU_ASSERT(is_category_of(
+              loaded, GF_CATEGORY_KEYWORD, "static-website", DOCUMENT));
+  /* ... and keeps the time of the scan */
+  CU_ASSERT_NOT_EQUAL(gf_site_get_scan_time(site), 0);
+  CU_ASSERT_EQUAL(gf_site_get_scan_time(loaded), gf_site_get_scan_time(site));
+
+  gf_site_free(loaded);
+  gf_site_free(site);
+  gf_path_free(site_file);
+  gf_path_free(site_path);
+}
+
+static gf_bool
+is_dated_entry(const gf_site* site, gf_size_t index, const gf_char* path) {
+  gf_entry* entry = NULL;
+
+  if (gf_site_get_dated_entry(site, index, &entry) != GF_SUCCESS) {
+    return GF_FALSE;
+  }
+
+  return !strcmp(gf_entry_get_full_path_string(entry), path);
+}
+
+static gf_bool
+is_method_of(const gf_site* site, const gf_char* method, const gf_char* path) {
+  const gf_category* cat = NULL;
+
+  if (!gf_site_find_method(site, method, &cat)) {
+    return GF_FALSE;
+  }
+  for (gf_size_t i = 0; i < gf_category_count_entries(cat); i++) {
+    gf_entry* entry = NULL;
+
+    if (gf_category_get_entry(cat, i, &entry) != GF_SUCCESS) {
+      return GF_FALSE;
+    }
+    if (!strcmp(gf_entry_get_full_path_string(entry), path)) {
+      return GF_TRUE;
+    }
+  }
+
+  return GF_FALSE;
+}
+
+static void
+index_entries(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site* loaded = NULL;
+  gf_path* site_path = NULL;
+  gf_path* site_file = NULL;
+  const gf_category* cat = NULL;
+
+  static const char FIRST[] = "/first/index.dbk";
+  static const char SECOND[] = "/second/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/dated");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&site_file, GFT_TEST_SITE_ROOT "/dated/site.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  /* The newest first, and the section has no date */
+  CU_ASSERT_EQUAL(gf_site_count_dated_entries(site), 2);
+  CU_ASSERT(is_dated_entry(site, 0, SECOND));
+  CU_ASSERT(is_dated_entry(site, 1, FIRST));
+  CU_ASSERT(gf_site_find_method(site, "article", &cat));
+  CU_ASSERT_EQUAL(gf_category_count_entries(cat), 2);
+  CU_ASSERT(is_method_of(site, "article", FIRST));
+  CU_ASSERT(is_method_of(site, "index", "/meta.gf"));
+  CU_ASSERT(!gf_site_find_method(site, "none", NULL));
+
+  /* The indices are rebuilt from the site file */
+  rc = gf_site_write_file(site, site_file);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_read_file(&loaded, site_file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_count_dated_entries(loaded), 2);
+  CU_ASSERT(is_dated_entry(loaded, 0, SECOND));
+  CU_ASSERT(is_method_of(loaded, "article", SECOND));
+
+  gf_site_free(loaded);
+  gf_site_free(site);
+  gf_path_free(site_file);
+  gf_path_free(site_path);
+}
+
+static gf_bool
+write_text_file(const gf_char* path, const gf_char* text) {
+  FILE* fp = fopen(path, "w");
+
+  if (!fp) {
+    return GF_FALSE;
+  }
+  fputs(text, fp);
+
+  return fclose(fp) == 0;
+}
+
+/* The first article of the dated site, rewritten and restored by the tests */
+static const char FIRST_PATH[] = GFT_TEST_SITE_ROOT "/dated/first/index.dbk";
+static const char FIRST_UPDATED[] =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  "<article xmlns=\"http://docbook.org/ns/docbook\" version=\"5.0\""
+  " role=\"note\">\n"
+  "  <info>\n"
+  "    <title>The First Article</title>\n"
+  "    <pubdate>2022-01-01 09:00:00</pubdate>\n"
+  "  </info>\n"
+  "  <para>The first article, updated.</para>\n"
+  "</article>\n";
+static const char FIRST_ORIGINAL[] =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+  "<article xmlns=\"http://docbook.org/ns/docbook\" version=\"5.0\">\r\n"
+  "  <info>\r\n"
+  "    <title>The First Article</title>\r\n"
+  "    <pubdate>2021-01-01 09:00:00</pubdate>\r\n"
+  "  </info>\r\n"
+  "  <para>The first article.</para>\r\n"
+  "</article>\r\n";
+
+static void
+update_indices(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_path* site_path = NULL;
+  gf_entry* entry = NULL;
+  gf_site_change change = GF_SITE_CHANGE_NONE;
+
+  static const char FIRST[] = "/first/index.dbk";
+  static const char SECOND[] = "/second/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/dated");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT(is_dated_entry(site, 0, SECOND));
+
+  /* The entry moves in the indices */
+  CU_ASSERT_FATAL(write_text_file(FIRST_PATH, FIRST_UPDATED));
+  rc = gf_site_update_file(site, site_path, FIRST, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_ENTRY);
+  CU_ASSERT_EQUAL(gf_site_count_dated_entries(site), 2);
+  CU_ASSERT(is_dated_entry(site, 0, FIRST));
+  CU_ASSERT(is_dated_entry(site, 1, SECOND));
+  CU_ASSERT(is_method_of(site, "note", FIRST));
+  CU_ASSERT(!is_method_of(site, "article", FIRST));
+  CU_ASSERT(is_method_of(site, "article", SECOND));
+
+  /* And back */
+  CU_ASSERT_FATAL(write_text_file(FIRST_PATH, FIRST_ORIGINAL));
+  rc = gf_site_update_file(site, site_path, FIRST, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_ENTRY);
+  CU_ASSERT(is_dated_entry(site, 0, SECOND));
+  CU_ASSERT(is_dated_entry(site, 1, FIRST));
+  CU_ASSERT(is_method_of(site, "article", FIRST));
+  CU_ASSERT(!is_method_of(site, "note", FIRST));
+
+  gf_site_free(site);
+  gf_path_free(site_path);
+}
+
+static void
+update_files(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_path* site_path = NULL;
+  gf_entry* entry = NULL;
+  gf_site_change change = GF_SITE_CHANGE_NONE;
+
+  static const char NOTE[] = "/first/note.txt";
+  static const char NOTE_PATH[] = GFT_TEST_SITE_ROOT "/dated/first/note.txt";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/dated");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* An added file belongs to the deepest entry */
+  CU_ASSERT_FATAL(write_text_file(NOTE_PATH, "note"));
+  rc = gf_site_update_file(site, site_path, NOTE, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_FILE);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+  CU_ASSERT_STRING_EQUAL(
+    gf_entry_get_full_path_string(entry), "/first/index.dbk");
+  /* The same file is not changed again */
+  rc = gf_site_update_file(site, site_path, NOTE, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_NONE);
+  /* The file is modified */
+  CU_ASSERT_FATAL(write_text_file(NOTE_PATH, "another note"));
+  rc = gf_site_update_file(site, site_path, NOTE, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_FILE);
+  /* The file is removed */
+  CU_ASSERT_FATAL(remove(NOTE_PATH) == 0);
+  rc = gf_site_update_file(site, site_path, NOTE, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_FILE);
+  rc = gf_site_update_file(site, site_path, NOTE, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_NONE);
+
+  /* A new entry changes the structure of the site */
+  rc = gf_site_update_file(
+    site, site_path, "/third/index.dbk", &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_STRUCTURE);
+  /* So does a new directory */
+  rc = gf_site_update_file(site, site_path, "/first", &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_STRUCTURE);
+  /* The files of the config directory are ignored */
+  rc = gf_site_update_file(
+    site, site_path, "/.gf/site.gfdb", &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(change, GF_SITE_CHANGE_NONE);
+  CU_ASSERT_PTR_NULL(entry);
+
+  gf_site_free(site);
+  gf_path_free(site_path);
+}
+
+static void
+classify_files(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_path* site_path = NULL;
+  gf_entry* root = NULL;
+  gf_entry* document = NULL;
+  gf_array* lineage = NULL;
+  gf_any any = { 0 };
+  gf_char method[16] = { 0 };
+
+  static const char DOCUMENT[] = "/about-grayfish/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(site, &root), GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(root);
+  rc = gf_array_new(&lineage);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_find_entries(site, DOCUMENT, lineage);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL_FATAL(gf_array_size(lineage), 2);
+  CU_ASSERT_EQUAL(gf_array_get(lineage, 1, &any), GF_SUCCESS);
+  gf_array_free(lineage);
+  document = any.ptr;
+  CU_ASSERT_PTR_NOT_NULL_FATAL(document);
+
+  /* The files of the entries */
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(root, "/meta.gf"), GF_SITE_FILE_SECTION);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(document, DOCUMENT), GF_SITE_FILE_DOCUMENT);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(root, "/_/style.css"), GF_SITE_FILE_STATIC);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(root, "/_note.txt"), GF_SITE_FILE_ASSET);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(document, "/about-grayfish/logo.png"),
+    GF_SITE_FILE_ASSET);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(document, "/about-grayfish/_/logo.png"),
+    GF_SITE_FILE_STATIC);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(document, "/meta.gf"), GF_SITE_FILE_NONE);
+  CU_ASSERT_EQUAL(
+    gf_site_get_file_role(document, "/about/index.dbk"), GF_SITE_FILE_NONE);
+
+  /* The stylesheets of the methods */
+  CU_ASSERT(gf_site_get_style_method("/article.xsl", method, sizeof(method)));
+  CU_ASSERT_STRING_EQUAL(method, "article");
+  CU_ASSERT(gf_site_get_style_method("/note.xsl", NULL, 0));
+  CU_ASSERT(!gf_site_get_style_method("/inc/common.xsl", NULL, 0));
+  CU_ASSERT(!gf_site_get_style_method("/style.css", NULL, 0));
+  CU_ASSERT(!gf_site_get_style_method("/.xsl", NULL, 0));
+  CU_ASSERT(!gf_site_get_style_method("article.xsl", NULL, 0));
+  CU_ASSERT(!gf_site_get_style_method("/article.xsl", method, 4));
+
+  gf_site_free(site);
+  gf_path_free(site_path);
+}
+
+static void
+read_write_database(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site* loaded = NULL;
+  gf_path* site_path = NULL;
+  gf_path* db_file = NULL;
+  gf_entry* lhs = NULL;
+  gf_entry* rhs = NULL;
+  gf_site_change_set* changes = NULL;
+  FILE* fp = NULL;
+
+  static const char DOCUMENT[] = "/about-grayfish/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&db_file, GFT_TEST_SITE_ROOT "/sample/site.gfdb");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_write_db(site, db_file);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_read_db(&loaded, db_file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(site, &lhs), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(loaded, &rhs), GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(lhs);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(rhs);
+  CU_ASSERT(are_entries_equal(lhs, rhs));
+  CU_ASSERT(is_category_of(loaded, GF_CATEGORY_SUBJECT, "web", DOCUMENT));
+  CU_ASSERT(is_category_of(
+              loaded, GF_CATEGORY_KEYWORD, "grayfish", DOCUMENT));
+  CU_ASSERT_EQUAL(gf_site_get_scan_time(loaded), gf_site_get_scan_time(site));
+  /* The hashes are kept */
+  rc = gf_site_diff(&changes, site, loaded);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_change_set_size(changes), 0);
+  gf_site_change_set_free(changes);
+  gf_site_free(loaded);
+  loaded = NULL;
+
+  /* A file of another format is rejected */
+  fp = fopen(gf_path_get_string(db_file), "wb");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+  fputs("<site></site>", fp);
+  fclose(fp);
+  rc = gf_site_read_db(&loaded, db_file);
+  CU_ASSERT_EQUAL(rc, GF_E_DATA);
+  CU_ASSERT_PTR_NULL(loaded);
+
+  gf_site_free(site);
+  gf_path_free(db_file);
+  gf_path_free(site_path);
+}
+
+static void
+open_database_lazily(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site* opened = NULL;
+  gf_path* site_path = NULL;
+  gf_path* db_file = NULL;
+  gf_entry* lhs = NULL;
+  gf_entry* rhs = NULL;
+  gf_site_change_set* changes = NULL;
+
+  static const char DOCUMENT[] = "/about-grayfish/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&db_file, GFT_TEST_SITE_ROOT "/sample/site.gfdb");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_write_db(site, db_file);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_open(&opened, db_file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(site, &lhs), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(opened, &rhs), GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(lhs);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(rhs);
+  /* The lists are counted before they are read */
+  CU_ASSERT(gf_entry_count_children(rhs) > 0);
+  CU_ASSERT_EQUAL(gf_entry_count_files(rhs), gf_entry_count_files(lhs));
+  CU_ASSERT_EQUAL(
+    gf_entry_count_paragraphs(rhs), gf_entry_count_paragraphs(lhs));
+  for (gf_size_t i = 0; i < gf_entry_count_paragraphs(lhs); i++) {
+    const gf_char* lstr = NULL;
+    const gf_char* rstr = NULL;
+
+    CU_ASSERT_EQUAL(gf_entry_get_paragraph_string(lhs, i, &lstr), GF_SUCCESS);
+    CU_ASSERT_EQUAL(gf_entry_get_paragraph_string(rhs, i, &rstr), GF_SUCCESS);
+    CU_ASSERT_STRING_EQUAL(lstr, rstr);
+  }
+  CU_ASSERT(are_entries_equal(lhs, rhs));
+  /* The files of the entries are read by the diff */
+  rc = gf_site_diff(&changes, site, opened);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_change_set_size(changes), 0);
+  gf_site_change_set_free(changes);
+  /* The whole site is read to list the entries of the categories */
+  CU_ASSERT(is_category_of(opened, GF_CATEGORY_SUBJECT, "web", DOCUMENT));
+
+  gf_site_free(opened);
+  gf_site_free(site);
+  gf_path_free(db_file);
+  gf_path_free(site_path);
+}
+
+static gf_status
+check_journal_database(
+  const gf_path* db_file, gf_site* saved, gf_size_t count,
+  const gf_char* newest) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_entry* lhs = NULL;
+  gf_entry* rhs = NULL;
+  gf_site_change_set* changes = NULL;
+  gf_bool ok = GF_TRUE;
+
+  /* Both of the readers apply the journal */
+  rc = gf_site_read_db(&site, db_file);
+  if (rc != GF_SUCCESS) {
+    return rc;
+  }
+  ok = gf_site_count_dated_entries(site) == count &&
+    is_dated_entry(site, 0, newest);
+  gf_site_free(site);
+  site = NULL;
+  rc = gf_site_open(&site, db_file);
+  if (rc != GF_SUCCESS) {
+    return rc;
+  }
+  /* The journal is applied to the entries as they are read */
+  ok = ok && gf_site_get_root_entry(saved, &lhs) == GF_SUCCESS &&
+    gf_site_get_root_entry(site, &rhs) == GF_SUCCESS &&
+    gf_entry_count_children(lhs) == gf_entry_count_children(rhs);
+  ok = ok && gf_site_diff(&changes, saved, site) == GF_SUCCESS &&
+    gf_site_change_set_size(changes) == 0;
+  gf_site_change_set_free(changes);
+  ok = ok && gf_site_count_dated_entries(site) == count &&
+    is_dated_entry(site, 0, newest);
+  gf_site_free(site);
+
+  return ok ? GF_SUCCESS : GF_E_DATA;
+}
+
+static void
+journal_database(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site* prev = NULL;
+  gf_path* site_path = NULL;
+  gf_path* db_file = NULL;
+  gf_path* journal = NULL;
+  gf_path* third_dir = NULL;
+  gf_entry* entry = NULL;
+  gf_site_change change = GF_SITE_CHANGE_NONE;
+  FILE* fp = NULL;
+
+  static const char FIRST[] = "/first/index.dbk";
+  static const char SECOND[] = "/second/index.dbk";
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/dated");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&db_file, GFT_TEST_SITE_ROOT "/dated/site.gfdb");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&third_dir, GFT_TEST_SITE_ROOT "/dated/third");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_db_make_journal_path(&journal, db_file);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The first save writes the whole database */
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_save_db(site, NULL, db_file, 50);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(!gf_path_file_exists(journal));
+
+  /* An updated entry is appended to the journal */
+  CU_ASSERT_FATAL(write_text_file(FIRST_PATH, FIRST_UPDATED));
+  rc = gf_site_update_file(site, site_path, FIRST, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_save_db(site, NULL, db_file, 1000);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(gf_path_file_exists(journal));
+  CU_ASSERT_EQUAL(check_journal_database(db_file, site, 2, FIRST), GF_SUCCESS);
+
+  /* A torn batch at the end is ignored */
+  fp = fopen(gf_path_get_string(journal), "ab");
+  CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+  fputs("broken", fp);
+  fclose(fp);
+  CU_ASSERT_EQUAL(check_journal_database(db_file, site, 2, FIRST), GF_SUCCESS);
+
+  /* New and removed entries are journaled against the previous site */
+  rc = gf_shell_make_directory(third_dir);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_FATAL(write_text_file(
+                    GFT_TEST_SITE_ROOT "/dated/third/index.dbk",
+                    FIRST_UPDATED));
+  prev = site;
+  site = NULL;
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_save_db(site, prev, db_file, 1000);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_site_free(prev);
+  CU_ASSERT_EQUAL(check_journal_database(db_file, site, 3, FIRST), GF_SUCCESS);
+  CU_ASSERT(gf_path_file_exists(journal));
+
+  rc = gf_shell_remove_tree(third_dir);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  prev = site;
+  site = NULL;
+  rc = gf_site_scan(&site, site_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_save_db(site, prev, db_file, 1000);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_site_free(prev);
+  CU_ASSERT_EQUAL(check_journal_database(db_file, site, 2, FIRST), GF_SUCCESS);
+
+  /* The journal is compacted once it grows past the ratio */
+  CU_ASSERT_FATAL(write_text_file(FIRST_PATH, FIRST_ORIGINAL));
+  rc = gf_site_update_file(site, site_path, FIRST, &entry, &change);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_save_db(site, NULL, db_file, 1);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(!gf_path_file_exists(journal));
+  CU_ASSERT_EQUAL(check_journal_database(db_file, site, 2, SECOND), GF_SUCCESS);
+
+  gf_shell_remove_file(db_file);
+  gf_site_free(site);
+  gf_path_free(journal);
+  gf_path_free(third_dir);
+  gf_path_free(db_file);
+  gf_path_free(site_path);
+}
+
+static void
+scan_with_entry_cache(void) {
+  gf_status rc = 0;
+  gf_site* first = NULL;
+  gf_site* second = NULL;
+  gf_path* site_path = NULL;
+  gf_path* cache_path = NULL;
+  gf_entry_cache* cache = NULL;
+  gf_entry* lhs = NULL;
+  gf_entry* rhs = NULL;
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&cache_path, GFT_TEST_DATA_PATH "/gf_entry_cache.tmp");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  option.threads = 2;
+
+  /* All the entry files are read and cached */
+  rc = gf_entry_cache_new(&cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan_with_option(&first, site_path, &option, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_hits(cache), 0);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_misses(cache), 2);
+  rc = gf_entry_cache_write_file(cache, cache_path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  gf_entry_cache_free(cache);
+
+  /* No entry file is read with the cache file */
+  rc = gf_entry_cache_new(&cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_entry_cache_read_file(cache, cache_path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_site_scan_with_option(&second, site_path, &option, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_hits(cache), 2);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_misses(cache), 0);
+  gf_entry_cache_free(cache);
+  CU_ASSERT_EQUAL(gf_shell_remove_file(cache_path), GF_SUCCESS);
+  gf_path_free(cache_path);
+  gf_path_free(site_path);
+
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(first, &lhs), GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_get_root_entry(second, &rhs), GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(lhs);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(rhs);
+  CU_ASSERT(are_entries_equal(lhs, rhs));
+  /* The categories are copied from the cache */
+  CU_ASSERT(is_category_of(
+              second, GF_CATEGORY_SUBJECT, "web", "/about-grayfish/index.dbk"));
+
+  gf_site_free(first);
+  gf_site_free(second);
+}
+
+static void
+scan_without_entry_cache(void) {
+  gf_status rc = 0;
+  gf_cmd_base cmd = { 0 };
+  gf_site* site = NULL;
+  gf_path* site_path = NULL;
+  gf_path* cache_path = NULL;
+  gf_entry_cache* cache = NULL;
+  gf_file_info_scan_option option = { 0 };
+
+  rc = gf_path_new(&site_path, GFT_TEST_SITE_ROOT "/sample");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&cmd.conf_path, GFT_TEST_DATA_PATH);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_append_string(&cache_path, cmd.conf_path, "entry-cache.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  option.threads = 2;
+
+  /* The cache file is written as `gf update' does */
+  rc = gf_cmd_update_read_entry_cache(&cmd, GF_TRUE, &cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan_with_option(&site, site_path, &option, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_cmd_update_write_entry_cache(&cmd, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(gf_path_file_exists(cache_path));
+  gf_entry_cache_free(cache);
+  gf_site_free(site);
+  site = NULL;
+
+  /* `--no-cache' reads all the entry files even if the file exists */
+  rc = gf_cmd_update_read_entry_cache(&cmd, GF_FALSE, &cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan_with_option(&site, site_path, &option, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_hits(cache), 0);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_misses(cache), 2);
+  gf_entry_cache_free(cache);
+  gf_site_free(site);
+  site = NULL;
+
+  /* Without `--no-cache', no entry file is read */
+  rc = gf_cmd_update_read_entry_cache(&cmd, GF_TRUE, &cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_scan_with_option(&site, site_path, &option, cache);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_hits(cache), 2);
+  CU_ASSERT_EQUAL(gf_entry_cache_count_misses(cache), 0);
+  gf_entry_cache_free(cache);
+  gf_site_free(site);
+
+  CU_ASSERT_EQUAL(gf_shell_remove_file(cache_path), GF_SUCCESS);
+  gf_path_free(cache_path);
+  gf_path_free(cmd.conf_path);
+  gf_path_free(site_path);
+}
+
+static gf_status
+read_site(gf_site** site, const char* file) {
+  gf_status rc = 0;
+  gf_path* path = NULL;
+
+  rc = gf_path_new(&path, file);
+  if (rc == GF_SUCCESS) {
+    rc = gf_site_read_file(site, path);
+  }
+  gf_path_free(path);
+
+  return rc;
+}
+
+/*!
+** @brief Compare two text files.
+**
+** The files are read in the text mode, as the site file is written.
+*/
+
+static gf_bool
+are_files_equal(const gf_char* lhs, const gf_char* rhs) {
+  FILE* lfp = NULL;
+  FILE* rfp = NULL;
+  int lc = 0;
+  int rc = 0;
+
+  lfp = fopen(lhs, "r");
+  rfp = fopen(rhs, "r");
+  if (lfp && rfp) {
+    do {
+      lc = fgetc(lfp);
+      rc = fgetc(rfp);
+    } while (lc == rc && lc != EOF);
+  } else {
+    lc = 0;
+    rc = 1;
+  }
+  if (lfp) {
+    fclose(lfp);
+  }
+  if (rfp) {
+    fclose(rfp);
+  }
+
+  return lc == rc;
+}
+
+static void
+round_trip_site_file(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_path* path = NULL;
+  gf_entry* entry = NULL;
+  const gf_char* para = NULL;
+
+  static const char GOLDEN[] = GFT_TEST_SITE_ROOT "/roundtrip/site.xml";
+
+  rc = read_site(&site, GOLDEN);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_get_root_entry(site, &entry);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  /* The escaped and the non-ASCII characters are decoded */
+  CU_ASSERT_STRING_EQUAL(gf_entry_get_title_string(entry),
+                         "Tom & Jerry <3 \"Grayfish\" > all");
+  rc = gf_entry_get_paragraph_string(entry, 0, &para);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL(strstr(para, "caf\xc3\xa9 & cr\xc3\xa8me"));
+
+  /* The non-ASCII characters are written as character references */
+  rc = gf_path_new(&path, GFT_TEST_DATA_PATH "/gf_site.tmp");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_site_write_file(site, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT(are_files_equal(GOLDEN, gf_path_get_string(path)));
+
+  remove(gf_path_get_string(path));
+  gf_path_free(path);
+  gf_site_free(site);
+}
+
+static void
+read_malformed_site_file(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+
+  static const char TRUNCATED[] = GFT_TEST_DATA_PATH "/truncated.tmp";
+
+  rc = read_site(&site, GFT_TEST_SITE_ROOT "/roundtrip/malformed.xml");
+  CU_ASSERT_NOT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_NULL(site);
+
+  CU_ASSERT_FATAL(write_text_file(
+                    TRUNCATED,
+                    "<?xml version=\"1.0\"?>\n"
+                    "<site>\n"
+                    "  <entry>\n"
+                    "    <type>2</type>\n"));
+  rc = read_site(&site, TRUNCATED);
+  CU_ASSERT_NOT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_NULL(site);
+  remove(TRUNCATED);
+}
+
+static void
+diff_same_site(void) {
+  gf_status rc = 0;
+  gf_site* site = NULL;
+  gf_site_change_set* changes = NULL;
+
+  rc = read_site(&site, GFT_TEST_SITE_ROOT "/diff/old.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_diff(&changes, site, site);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_site_change_set_size(changes), 0);
+
+  gf_site_change_set_free(changes);
+  gf_site_free(site);
+}
+
+static void
+diff_sites(void) {
+  gf_status rc = 0;
+  gf_site* old_site = NULL;
+  gf_site* new_site = NULL;
+  gf_site_change_set* changes = NULL;
+  const gf_site_diff_item* item = NULL;
+  gf_size_t moved = 0;
+
+  rc = read_site(&old_site, GFT_TEST_SITE_ROOT "/diff/old.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = read_site(&new_site, GFT_TEST_SITE_ROOT "/diff/new.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_diff(&changes, old_site, new_site);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* Empty files are not regarded as moved */
+  CU_ASSERT_EQUAL(gf_site_change_set_size(changes), 9);
+  CU_ASSERT_EQUAL(gf_site_change_set_count(
+                    changes, GF_SITE_DIFF_FILE, GF_SITE_DIFF_ADDED), 2);
+  CU_ASSERT_EQUAL(gf_site_change_set_count(
+                    changes, GF_SITE_DIFF_FILE, GF_SITE_DIFF_REMOVED), 2);
+  CU_ASSERT_EQUAL(gf_site_change_set_count(
+                    changes, GF_SITE_DIFF_FILE, GF_SITE_DIFF_MODIFIED), 2);
+  CU_ASSERT_EQUAL(gf_site_change_set_count(
+                    changes, GF_SITE_DIFF_FILE, GF_SITE_DIFF_MOVED), 1);
+  /* The files of the root entry and the entry file of the other changed */
+  CU_ASSERT_EQUAL(gf_site_change_set_count(
+                    changes, GF_SITE_DIFF_ENTRY, GF_SITE_DIFF_MODIFIED), 2);
+
+  /* The entries are listed first */
+  rc = gf_site_change_set_get(changes, 0, &item);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(item->target, GF_SITE_DIFF_ENTRY);
+  CU_ASSERT_STRING_EQUAL(item->path, "/meta.gf");
+  rc = gf_site_change_set_get(changes, 1, &item);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(item->target, GF_SITE_DIFF_ENTRY);
+  CU_ASSERT_STRING_EQUAL(item->path, "/about/index.dbk");
+
+  for (gf_size_t i = 2; i < gf_site_change_set_size(changes); i++) {
+    rc = gf_site_change_set_get(changes, i, &item);
+    CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+    CU_ASSERT_EQUAL(item->target, GF_SITE_DIFF_FILE);
+    if (item->type == GF_SITE_DIFF_MOVED) {
+      CU_ASSERT_STRING_EQUAL(item->path, "/images/logo.png");
+      CU_ASSERT_STRING_EQUAL(item->old_path, "/img/logo.png");
+      moved = i;
+    } else if (!strcmp(item->path, "/about/index.dbk")) {
+      CU_ASSERT_EQUAL(item->type, GF_SITE_DIFF_MODIFIED);
+      CU_ASSERT(item->entry);
+    } else {
+      CU_ASSERT(!item->entry);
+    }
+  }
+  /* Removed files are listed last */
+  rc = gf_site_change_set_get(changes, 8, &item);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(item->type, GF_SITE_DIFF_REMOVED);
+  CU_ASSERT(moved < 7);
+
+  gf_site_change_set_free(changes);
+  gf_site_free(new_site);
+  gf_site_free(old_site);
+}
+
+static void
+diff_moved_entry(void) {
+  gf_status rc = 0;
+  gf_site* old_site = NULL;
+  gf_site* new_site = NULL;
+  gf_site_change_set* changes = NULL;
+  const gf_site_diff_item* item = NULL;
+
+  rc = read_site(&old_site, GFT_TEST_SITE_ROOT "/diff/old.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = read_site(&new_site, GFT_TEST_SITE_ROOT "/diff/moved.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_site_diff(&changes, old_site, new_site);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The root entry is not modified, since its files are the same */
+  CU_ASSERT_EQUAL_FATAL(gf_site_change_set_size(changes), 2);
+  rc = gf_site_change_set_get(changes, 0, &item);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(item->target, GF_SITE_DIFF_ENTRY);
+  CU_ASSERT_EQUAL(item->type, GF_SITE_DIFF_MOVED);
+  CU_ASSERT_STRING_EQUAL(item->path, "/about-us/index.dbk");
+  CU_ASSERT_STRING_EQUAL(item->old_path, "/about/index.dbk");
+  rc = gf_site_change_set_get(changes, 1, &item);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(item->target, GF_SITE_DIFF_FILE);
+  CU_ASSERT_EQUAL(item->type, GF_SITE_DIFF_MOVED);
+  CU_ASSERT(item->entry);
+
+  gf_site_change_set_free(changes);
+  gf_site_free(new_site);
+  gf_site_free(old_site);
+}
+
 /* -------------------------------------------------------------------------- */
 
 /*!
@@ -69,4 +1072,22 @@ gft_site_add_tests(void) {
   /* new/free */
   CU_add_test(s, "New/free in noraml case",   new_free_normal);
   CU_add_test(s, "Scan a website",            scan_website);
+  CU_add_test(s, "Scan with multiple threads", scan_website_parallel);
+  CU_add_test(s, "Scan a broken website",     scan_broken_website);
+  CU_add_test(s, "Scan with the entry cache", scan_with_entry_cache);
+  CU_add_test(s, "Scan without the entry cache", scan_without_entry_cache);
+  CU_add_test(s, "List the entries of a category", list_category_entries);
+  CU_add_test(s, "Index the entries",         index_entries);
+  CU_add_test(s, "Update the indices",        update_indices);
+  CU_add_test(s, "Update the files",          update_files);
+  CU_add_test(s, "Classify the files",        classify_files);
+  CU_add_test(s, "Read and write a database", read_write_database);
+  CU_add_test(s, "Open a database lazily",    open_database_lazily);
+  CU_add_test(s, "Journal a database",        journal_database);
+  CU_add_test(s, "Round trip a site file",    round_trip_site_file);
+  CU_add_test(s, "Read a malformed site file", read_malformed_site_file);
+  /* diff */
+  CU_add_test(s, "Diff the same site",        diff_same_site);
+  CU_add_test(s, "Diff two sites",            diff_sites);
+  CU_add_test(s, "Diff a moved entry",        diff_moved_entry);
 }
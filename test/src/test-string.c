@@ -56,6 +56,7 @@ test_strdup(void) {
 
   rc = gf_strdup(&s, "sample");
   CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  gf_free(s);
 
   s = NULL;
   rc = gf_strassign(&s, str);
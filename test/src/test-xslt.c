@@ -6,6 +6,8 @@
 ** @file test/test-array.c
 ** @brief Testing module for gf_array.
 */
+#include <string.h>
+
 #include <CUnit/CUnit.h>
 
 #include <libgf/gf_xslt.h>
@@ -50,6 +52,255 @@ test_xslt_proc(void) {
   gf_xslt_free(xslt);
 }
 
+void
+test_xslt_process_doc(void) {
+  gf_status rc = 0;
+  gf_xslt* xslt = NULL;
+  gf_path* path = NULL;
+  xmlDocPtr doc = NULL;
+
+  static const char xsl_path[] = GFT_TEST_SITE_ROOT "/style.xsl";
+  static const char doc_path[] = GFT_TEST_SITE_ROOT "/doc.xml";
+  static const char res_path[] = GFT_TEST_SITE_ROOT "/res-doc.xml";
+
+  rc = gf_xslt_new(&xslt);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&path, xsl_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_read_template(xslt, path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  rc = gf_path_set_string(path, doc_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_read_document(&doc, path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(doc);
+  /* The document is kept by the caller, so it can be transformed again */
+  rc = gf_xslt_process_doc(xslt, doc);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_xslt_process_doc(xslt, doc);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_NOT_NULL(xmlDocGetRootElement(doc));
+  xmlFreeDoc(doc);
+
+  rc = gf_path_set_string(path, res_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_write_file(xslt, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* A missing document */
+  rc = gf_path_set_string(path, GFT_TEST_SITE_ROOT "/none.xml");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  doc = NULL;
+  rc = gf_xslt_read_document(&doc, path);
+  CU_ASSERT_EQUAL(rc, GF_E_READ);
+  CU_ASSERT_PTR_NULL(doc);
+
+  gf_path_free(path);
+  gf_xslt_free(xslt);
+}
+
+void
+test_xslt_cache(void) {
+  gf_status rc = 0;
+  gf_xslt* first = NULL;
+  gf_xslt* second = NULL;
+  gf_xslt_cache* cache = NULL;
+  gf_path* path = NULL;
+  gf_path* other = NULL;
+
+  static const char xsl_path[] = GFT_TEST_SITE_ROOT "/style.xsl";
+  static const char xsl_other[] = GFT_TEST_SITE_ROOT "/../gf_xslt/style.xsl";
+  static const char doc_path[] = GFT_TEST_SITE_ROOT "/doc.xml";
+  static const char res_path[] = GFT_TEST_SITE_ROOT "/res-cache.xml";
+
+  rc = gf_xslt_cache_new(&cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_new(&first);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_new(&second);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&path, xsl_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&other, xsl_other);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The same file is compiled once */
+  rc = gf_xslt_use_template(first, cache, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_xslt_use_template(second, cache, other);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(gf_xslt_cache_count_misses(cache), 1);
+  CU_ASSERT_EQUAL(gf_xslt_cache_count_hits(cache), 1);
+
+  /* The shared stylesheet outlives the context */
+  gf_xslt_free(first);
+  rc = gf_path_set_string(path, doc_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_process(second, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_path_set_string(path, res_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_write_file(second, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+
+  /* A missing file is not cached */
+  rc = gf_path_set_string(path, GFT_TEST_SITE_ROOT "/none.xsl");
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_use_template(second, cache, path);
+  CU_ASSERT_EQUAL(rc, GF_E_READ);
+  CU_ASSERT_EQUAL(gf_xslt_cache_count_misses(cache), 1);
+
+  gf_path_free(other);
+  gf_path_free(path);
+  gf_xslt_free(second);
+  gf_xslt_cache_free(cache);
+}
+
+static gf_status
+count_output(const gf_char* path, gf_ptr data) {
+  CU_ASSERT_PTR_NOT_NULL(strstr(path, "res-output.xml"));
+  (*(int*)data)++;
+
+  return GF_SUCCESS;
+}
+
+void
+test_xslt_output(void) {
+  gf_status rc = 0;
+  gf_xslt* xslt = NULL;
+  gf_xslt_cache* cache = NULL;
+  gf_path* path = NULL;
+  gf_path* other = NULL;
+  const gf_char* fingerprint = NULL;
+  const gf_char* again = NULL;
+  int count = 0;
+
+  static const char xsl_path[] = GFT_TEST_SITE_ROOT "/style.xsl";
+  static const char xsl_other[] = GFT_TEST_SITE_ROOT "/../gf_xslt/style.xsl";
+  static const char doc_path[] = GFT_TEST_SITE_ROOT "/doc.xml";
+  static const char res_path[] = GFT_TEST_SITE_ROOT "/res-output.xml";
+
+  rc = gf_xslt_cache_new(&cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_new(&xslt);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&path, xsl_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_path_new(&other, xsl_other);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The fingerprint is computed once for the stylesheet */
+  rc = gf_xslt_cache_get_fingerprint(cache, path, &fingerprint);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(strspn(fingerprint, "0123456789abcdef"), 32);
+  CU_ASSERT_EQUAL(strlen(fingerprint), 32);
+  rc = gf_xslt_cache_get_fingerprint(cache, other, &again);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_PTR_EQUAL(fingerprint, again);
+  CU_ASSERT_EQUAL(gf_xslt_cache_count_misses(cache), 1);
+
+  /* The written file is reported */
+  rc = gf_xslt_use_template(xslt, cache, path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_set_output_fn(xslt, count_output, &count);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  rc = gf_path_set_string(path, doc_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_process(xslt, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(count, 0);
+  rc = gf_path_set_string(path, res_path);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+  rc = gf_xslt_write_file(xslt, path);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(count, 1);
+
+  gf_path_free(other);
+  gf_path_free(path);
+  gf_xslt_free(xslt);
+  gf_xslt_cache_free(cache);
+}
+
+#define JOB_COUNT 16
+
+typedef struct job_set {
+  gf_xslt_cache* cache;
+  gf_size_t      fail;            ///< The index of the job reading no file
+  gf_bool        done[JOB_COUNT];
+} job_set;
+
+static gf_status
+run_job(gf_size_t index, gf_ptr data) {
+  gf_status rc = 0;
+  job_set* set = data;
+  gf_xslt* xslt = NULL;
+  gf_path* path = NULL;
+
+  set->done[index] = GF_TRUE;
+  rc = gf_xslt_new(&xslt);
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_new(&path, GFT_TEST_SITE_ROOT "/style.xsl");
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_xslt_use_template(xslt, set->cache, path);
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_path_set_string(
+      path, index == set->fail ?
+      GFT_TEST_SITE_ROOT "/none.xml" : GFT_TEST_SITE_ROOT "/doc.xml");
+  }
+  if (rc == GF_SUCCESS) {
+    rc = gf_xslt_process(xslt, path);
+  }
+  gf_path_free(path);
+  gf_xslt_free(xslt);
+
+  return rc;
+}
+
+void
+test_xslt_run_jobs(void) {
+  gf_status rc = 0;
+  job_set set = { 0 };
+  gf_status status[JOB_COUNT] = { 0 };
+
+  rc = gf_xslt_cache_new(&set.cache);
+  CU_ASSERT_EQUAL_FATAL(rc, GF_SUCCESS);
+
+  /* The transforms share the compiled stylesheet */
+  set.fail = JOB_COUNT;
+  rc = gf_xslt_run_jobs(JOB_COUNT, run_job, &set, 4, GF_FALSE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  for (gf_size_t i = 0; i < JOB_COUNT; i++) {
+    CU_ASSERT_EQUAL(set.done[i], GF_TRUE);
+    CU_ASSERT_EQUAL(status[i], GF_SUCCESS);
+  }
+  CU_ASSERT_EQUAL(gf_xslt_cache_count_misses(set.cache), 1);
+
+  /* A failure does not stop the other jobs */
+  memset(set.done, 0, sizeof(set.done));
+  set.fail = 1;
+  rc = gf_xslt_run_jobs(JOB_COUNT, run_job, &set, 4, GF_FALSE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  for (gf_size_t i = 0; i < JOB_COUNT; i++) {
+    CU_ASSERT_EQUAL(set.done[i], GF_TRUE);
+    CU_ASSERT_EQUAL(status[i] == GF_SUCCESS, i != set.fail);
+  }
+
+  /* No job is started after the failure with fail-fast */
+  memset(set.done, 0, sizeof(set.done));
+  rc = gf_xslt_run_jobs(JOB_COUNT, run_job, &set, 1, GF_TRUE, status);
+  CU_ASSERT_EQUAL(rc, GF_SUCCESS);
+  CU_ASSERT_EQUAL(status[0], GF_SUCCESS);
+  CU_ASSERT_NOT_EQUAL(status[1], GF_SUCCESS);
+  for (gf_size_t i = 2; i < JOB_COUNT; i++) {
+    CU_ASSERT_EQUAL(set.done[i], GF_FALSE);
+    CU_ASSERT_EQUAL(status[i], GF_E_STATE);
+  }
+
+  gf_xslt_cache_free(set.cache);
+}
 
 /* -------------------------------------------------------------------------- */
 
@@ -65,4 +316,8 @@ gft_xslt_add_tests(void) {
 
   /* XSLT proc */
   CU_add_test(s, "XSLT proc", test_xslt_proc);
+  CU_add_test(s, "XSLT proc with a document", test_xslt_process_doc);
+  CU_add_test(s, "XSLT cache", test_xslt_cache);
+  CU_add_test(s, "XSLT outputs and fingerprint", test_xslt_output);
+  CU_add_test(s, "XSLT jobs on threads", test_xslt_run_jobs);
 }
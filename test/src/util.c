@@ -12,12 +12,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
 #ifndef INITGUID
 #define INITGUID
 #endif
 
 #include <objbase.h>
 #include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
 
 #include "util.h"
 
@@ -33,6 +41,7 @@ struct gft_test_ctxt {
   char* orig_path;
 };
 
+#if defined(_WIN32)
 static int
 test_ctxt_get_current_path(char** path) {
   DWORD len = 0;
@@ -67,11 +76,53 @@ test_ctxt_set_current_path(const char* path) {
 
   return 0;
 }
+#else
+static int
+test_ctxt_get_current_path(char** path) {
+  size_t len = BUFSIZE;
+  char* tmp = NULL;
+
+  for (;;) {
+    char* buf = realloc(tmp, len * sizeof(char));
+
+    if (!buf) {
+      free(tmp);
+      return 1;
+    }
+    tmp = buf;
+    if (getcwd(tmp, len)) {
+      break;
+    }
+    if (errno != ERANGE) {
+      free(tmp);
+      return 1;
+    }
+    len *= 2;
+  }
+
+  *path = tmp;
+  
+  return 0;
+}
+
+static int
+test_ctxt_set_current_path(const char* path) {
+  if (!path || !path[0]) {
+    return 1;
+  }
+  if (chdir(path)) {
+    return 1;
+  }
+
+  return 0;
+}
+#endif
 
 /*
 ** @brief Check if the specified path exists and is writable
 */
 
+#if defined(_WIN32)
 bool
 test_ctxt_is_path_writable_directory(const char* path) {
   DWORD flags = 0;
@@ -94,7 +145,24 @@ test_ctxt_is_path_writable_directory(const char* path) {
 
   return ret;
 }
+#else
+bool
+test_ctxt_is_path_writable_directory(const char* path) {
+  struct stat st;
 
+  if (!path || !path[0]) {
+    return false;
+  }
+  /* Check if the path is writable directory */
+  if (stat(path, &st) || !S_ISDIR(st.st_mode) || access(path, W_OK)) {
+    return false;
+  }
+
+  return true;
+}
+#endif
+
+#if defined(_WIN32)
 static int
 test_ctxt_get_root_path(char** path) {
   int rc = 0;
@@ -148,7 +216,50 @@ test_ctxt_get_root_path(char** path) {
 
   return 0;
 }
+#else
+static int
+test_ctxt_get_root_path(char** path) {
+  int rc = 0;
+  const char* env = NULL;
+  char* tmp = NULL;
+
+  if (!path) {
+    return 1;
+  }
+  /* Get temporary path of the system */
+  env = getenv("TMPDIR");
+  if (!env || !env[0]) {
+    env = "/tmp";
+  }
+  if (test_ctxt_is_path_writable_directory(env)) {
+    tmp = strdup(env);
+    if (!tmp) {
+      return 1;
+    }
+    /* If the path string ends with '/', we remove it. */
+    if (strlen(tmp) > 1 && tmp[strlen(tmp) - 1] == '/') {
+      tmp[strlen(tmp) - 1] = '\0';
+    }
+  }
+  /* Check if the tmp path is alive */
+  if (!tmp) {
+    rc = test_ctxt_get_current_path(&tmp);
+    if (rc != 0) {
+      return 1;
+    }
+    if (!test_ctxt_is_path_writable_directory(tmp)) {
+      free(tmp);
+      return 1;
+    }
+  }
+
+  *path = tmp;
+
+  return 0;
+}
+#endif
 
+#if defined(_WIN32)
 static int
 test_ctxt_get_work_path(char** path, const char* root) {
   char* tmp = NULL;
@@ -202,6 +313,43 @@ test_ctxt_make_path(const char* path) {
   
   return 0;
 }
+#else
+static int
+test_ctxt_get_work_path(char** path, const char* root) {
+  char* tmp = NULL;
+  size_t len = 0;
+
+  static unsigned int count = 0;
+  static const char prefix[] = "gft-";
+
+  if (!path || !root) {
+    return 1;
+  }
+  /* The process ID and the count instead of GUID */
+  len = strlen(root) + 1 + strlen(prefix) + 64;
+  tmp = malloc(len * sizeof(char));
+  if (!tmp) {
+    return 1;
+  }
+  snprintf(tmp, len, "%s/%s%ld-%u", root, prefix, (long)getpid(), count++);
+
+  *path = tmp;
+  
+  return 0;
+}
+
+static int
+test_ctxt_make_path(const char* path) {
+  if (!path || !path[0]) {
+    return 1;
+  }
+  if (mkdir(path, 0777)) {
+    return 1;
+  }
+  
+  return 0;
+}
+#endif
 
 static int
 test_ctxt_prepare(gft_test_ctxt* ctxt) {
@@ -280,6 +428,7 @@ gft_test_ctxt_new(gft_test_ctxt** ctxt) {
   return 0;
 }
 
+#if defined(_WIN32)
 static int
 test_ctxt_delete_files(const char* root) {
   DWORD attr = 0;
@@ -329,6 +478,53 @@ test_ctxt_delete_files(const char* root) {
   
   return 0;
 }
+#else
+static int
+test_ctxt_delete_files(const char* root) {
+  struct stat st;
+
+  if (!root || !root[0]) {
+    assert(0);
+    return 0;
+  }
+
+  if (lstat(root, &st)) {
+    assert(0);
+    return 0;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    int rc = 0;
+    DIR* dir = NULL;
+    struct dirent* ent = NULL;
+
+    dir = opendir(root);
+    if (!dir) {
+      return 1;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+      char child[BUFSIZE] = { 0 };
+
+      if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
+        continue;
+      }
+      snprintf(child, BUFSIZE, "%s/%s", root, ent->d_name);
+      /* Delete childs */
+      rc = test_ctxt_delete_files(child);
+      if (rc != 0) {
+        closedir(dir);
+        return rc;
+      }
+    }
+    
+    closedir(dir);
+    rmdir(root);
+  } else {
+    unlink(root);
+  }
+  
+  return 0;
+}
+#endif
 
 void
 gft_test_ctxt_free(gft_test_ctxt* ctxt) {